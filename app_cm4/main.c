@@ -60,6 +60,10 @@
 
 /* Local includes. */
 #include "led.h"
+#include "wifi_fw_cfg.h"
+#include "boot_timing.h"
+#include "boot_log.h"
+#include "boot_qspi.h"
 
 /* AWS library includes. */
 #include "iot_system_init.h"
@@ -160,8 +164,14 @@ static void prvMiscInitialization( void )
         configASSERT(0);
     }
 
+    /* Finish the bootloader log before printing anything else. */
+    boot_log_report();
+
     printf( "Retarget IO initialized.\r\n" );
 
+    /* Locate the Wi-Fi firmware before the Wi-Fi is powered on. */
+    wifi_fw_cfg_init();
+
     /* Initialize the User LED. */
     cyhal_gpio_init((cyhal_gpio_t) CYBSP_USER_LED, CYHAL_GPIO_DIR_OUTPUT,
             CYHAL_GPIO_DRIVE_STRONG, CYBSP_LED_STATE_OFF);
@@ -171,6 +181,9 @@ static void prvMiscInitialization( void )
     printf("**Booting to Application.");
     printf("Version: %d.%d.%d ** \r\n \r\n", APP_VERSION_MAJOR, APP_VERSION_MINOR, APP_VERSION_BUILD );
 
+    /* Publish how long the bootloader took. */
+    boot_timing_report();
+
 }
 
 /**
@@ -204,10 +217,12 @@ void vApplicationDaemonTaskStartupHook( void )
     /* Power On Wi-Fi. */
     prvWifiPowerOn();
 
-    /* Initialize the QSPI. */
-    if ( psoc6_qspi_init() != 0 )
+    /* Initialize the QSPI, with the configuration the bootloader detected
+     * when it handed one over.
+     */
+    if ( boot_qspi_init() != 0 )
     {
-       printf("psoc6_qspi_init() FAILED !\r\n");
+       printf("boot_qspi_init() FAILED !\r\n");
     }
 
     /* Connect to the Wi-Fi before running the tests. */
@@ -281,12 +296,18 @@ static void prvWifiPowerOn(void)
     WIFIReturnCode_t wifi_status = eWiFiSuccess;
     const uint32_t bus_frequency = QSPI_FREQ_IN_HZ ;
     cy_rslt_t result = CY_RSLT_SUCCESS;
+    const cy_stc_smif_mem_config_t *mem_config = boot_qspi_mem_config();
+
+    if ( mem_config == NULL )
+    {
+        mem_config = smifMemConfigs [ 0 ];
+    }
 
     /* Idea of this code example is to place the Wi-Fi firmware blob on QSPi memory
      * and access it during the Init. To do so,we need to have QSPI initialized before
      * Wi-Fi module.
      */
-    result = cy_serial_flash_qspi_init (smifMemConfigs [ 0 ], CYBSP_QSPI_D0, CYBSP_QSPI_D1,
+    result = cy_serial_flash_qspi_init (mem_config, CYBSP_QSPI_D0, CYBSP_QSPI_D1,
                                         CYBSP_QSPI_D2, CYBSP_QSPI_D3, NC, NC, NC, NC,
                                         CYBSP_QSPI_SCK, CYBSP_QSPI_SS, bus_frequency);
     configASSERT(result == CY_RSLT_SUCCESS);
@@ -55,6 +55,20 @@ DEFINES+=\
 
 endif
 
+# Block of RAM the bootloader hands over to the app (boot_shared.h).
+INCLUDES+=$(BOOTLOADER_LOCATION)/shared
+DEFINES+=\
+    CY_BOOT_BOOTLOADER_RAM_SIZE=$(BOOTLOADER_APP_RAM_SIZE) \
+    CY_BOOT_SHARED_RAM_SIZE=$(BOOTLOADER_SHARED_RAM_SIZE)
+
+# Run the Wi-Fi firmware from the slot the bootloader chose (config.mk).
+ifeq ($(WIFI_SLOT_FLIP),1)
+DEFINES+=CY_BOOT_WIFI_SLOT_FLIP
+ifeq ($(TAR_COMPRESS_IMAGES),1)
+    $(error TAR_COMPRESS_IMAGES=1 is not supported with WIFI_SLOT_FLIP=1: the Wi-Fi firmware runs in place)
+endif
+endif
+
 ifeq ($(OTA_USE_EXTERNAL_FLASH),1)
     # non-zero for secondary slot in external FLASH
     CY_FLASH_ERASE_VALUE=1
@@ -215,7 +229,8 @@ POSTBUILD+=$(CY_AFR_SIGN_SCRIPT_FILE_PATH) $(CY_OUTPUT_FILE_PATH) $(CY_AFR_BUILD
     $(CY_AFR_MCUBOOT_SCRIPT_FILE_DIR) $(IMGTOOL_SCRIPT_NAME) $(IMGTOOL_COMMAND_ARG) $(CY_FLASH_ERASE_VALUE) $(MCUBOOT_HEADER_SIZE)\
     $(MCUBOOT_MAX_IMG_SECTORS) $(CY_BUILD_VERSION) $(CY_BOOT_PRIMARY_1_START) $(CY_BOOT_PRIMARY_1_SIZE)\
     $(CY_SIGNING_KEY_ARG) $(CY_OBJ_COPY) $(TAR_INC_MAIN_APP) $(TAR_INC_WIFI_BLOB) $(CY_INPUT_WIFI_BLOB) $(CY_WIFI_BLOB_NAME).bin \
-    $(CY_BOOT_PRIMARY_2_SIZE) $(CY_OUTPUT_WIFI_CLM_BLOB_BIN) $(CY_PAD_BYTES) $(CY_WIFI_FW_BLOB_VERSION)
+    $(CY_BOOT_PRIMARY_2_SIZE) $(CY_OUTPUT_WIFI_CLM_BLOB_BIN) $(CY_PAD_BYTES) $(CY_WIFI_FW_BLOB_VERSION)\
+    $(TAR_COMPRESS_IMAGES)
 else
 POSTBUILD+=$(CY_AFR_SIGN_SCRIPT_FILE_PATH) $(CY_OUTPUT_FILE_PATH) $(CY_AFR_BUILD) $(CY_OBJ_COPY)\
     $(CY_AFR_MCUBOOT_SCRIPT_FILE_DIR) $(IMGTOOL_SCRIPT_NAME) $(IMGTOOL_COMMAND_ARG) $(CY_FLASH_ERASE_VALUE) $(MCUBOOT_HEADER_SIZE)\
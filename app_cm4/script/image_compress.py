@@ -0,0 +1,119 @@
+# (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+# Licensed under the Apache License, Version 2.0 (the "License").
+# You may not use this file except in compliance with the License.
+# A copy of the License is located at
+#     http://www.apache.org/licenses/LICENSE-2.0
+# or in the "license" file accompanying this file. This file is distributed
+# on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+# express or implied. See the License for the specific language governing
+# permissions and limitations under the License.
+#
+
+
+# Makes the payload of a compressed image, which the bootloader
+# (bootloader_cm0p/upgrade_compress.c) expands into the primary slot. The
+# input is the signed image to install; the output is a header and an LZ4
+# block of it, to be signed again like an application binary. Upload the
+# signed payload instead of the image; the OTA agent writes it to the
+# secondary slot and marks it pending like an image.
+
+import sys
+import argparse
+import struct
+
+LZ4_MAGIC = 0x5A4C5943
+LZ4_VERSION = 1
+LZ4_HDR_FORMAT = "<IHHII"
+
+MIN_MATCH = 4
+MAX_OFFSET = 0xffff
+# The LZ4 block format ends with at least 5 literals, and the last match
+# starts at least 12 bytes before the end.
+LAST_LITERALS = 5
+MF_LIMIT = 12
+
+def length_bytes(value):
+    out = bytearray()
+    while value >= 255:
+        out.append(255)
+        value -= 255
+    out.append(value)
+    return out
+
+def sequence(out, literals, match_len, offset):
+    lit_len = len(literals)
+    token = min(lit_len, 15) << 4
+    if match_len:
+        token |= min(match_len - MIN_MATCH, 15)
+    out.append(token)
+    if lit_len >= 15:
+        out.extend(length_bytes(lit_len - 15))
+    out.extend(literals)
+    if match_len:
+        out.extend(struct.pack("<H", offset))
+        if match_len - MIN_MATCH >= 15:
+            out.extend(length_bytes(match_len - MIN_MATCH - 15))
+
+def compress(data):
+    # Greedy matching against the latest position of each 4-byte sequence.
+    out = bytearray()
+    table = {}
+    match_limit = len(data) - MF_LIMIT
+    end_limit = len(data) - LAST_LITERALS
+    anchor = 0
+    pos = 0
+
+    while pos < match_limit:
+        key = data[pos:pos + MIN_MATCH]
+        cand = table.get(key)
+        table[key] = pos
+        if (cand is None) or (pos - cand > MAX_OFFSET):
+            pos += 1
+            continue
+
+        length = MIN_MATCH
+        while (pos + length < end_limit) and (data[cand + length] == data[pos + length]):
+            length += 1
+        # Grow the match back into the pending literals.
+        while (pos > anchor) and (cand > 0) and (data[cand - 1] == data[pos - 1]):
+            pos -= 1
+            cand -= 1
+            length += 1
+
+        sequence(out, data[anchor:pos], length, pos - cand)
+        for i in range(pos + 1, min(pos + length, match_limit)):
+            table[data[i:i + MIN_MATCH]] = i
+        pos += length
+        anchor = pos
+
+    sequence(out, data[anchor:], 0, 0)
+    return out
+
+def main():
+    parser = argparse.ArgumentParser(description="Script to make the payload of a compressed image from a signed image")
+
+    parser.add_argument("--image", required=True, metavar="Signed image to install (.bin)")
+
+    parser.add_argument("--out", required=True, metavar="Output payload file, to be signed")
+
+    # Start arg parser.
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+    if not image:
+        sys.exit("image_compress: the image is empty")
+
+    block = compress(image)
+    header = struct.pack(LZ4_HDR_FORMAT, LZ4_MAGIC, LZ4_VERSION,
+                         struct.calcsize(LZ4_HDR_FORMAT), len(image), len(block))
+
+    with open(args.out, "wb") as f:
+        f.write(header)
+        f.write(block)
+
+    print("image_compress: %d byte image, %d byte payload (%.1f%%)" %
+          (len(image), len(header) + len(block), 100.0 * (len(header) + len(block)) / len(image)))
+
+if __name__ == "__main__":
+    main()
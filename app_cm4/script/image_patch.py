@@ -0,0 +1,156 @@
+# (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+# Licensed under the Apache License, Version 2.0 (the "License").
+# You may not use this file except in compliance with the License.
+# A copy of the License is located at
+#     http://www.apache.org/licenses/LICENSE-2.0
+# or in the "license" file accompanying this file. This file is distributed
+# on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+# express or implied. See the License for the specific language governing
+# permissions and limitations under the License.
+#
+
+# Makes a patch that the bootloader (bootloader_cm0p/upgrade_patch.c) applies
+# to the signed image in a primary slot to rebuild a new signed image. Upload
+# the patch instead of the new image; the OTA agent writes it to the secondary
+# slot and marks it pending like an image.
+
+import sys
+import argparse
+import hashlib
+import struct
+
+PATCH_MAGIC = 0x48435450
+PATCH_VERSION = 1
+PATCH_HDR_FORMAT = "<IHHIIII32s32s"
+
+IMAGE_MAGIC = 0x96f3b83d
+IMAGE_TLV_INFO_MAGIC = 0x6907
+IMAGE_TLV_SHA256 = 0x10
+
+# Source blocks indexed for matching, and the shortest copy worth an op.
+BLOCK_SIZE = 16
+MIN_COPY = 8
+
+def image_hash(image):
+    # Returns the SHA-256 TLV of a signed image, which names the image the
+    # bootloader finds in the primary slot.
+    magic, _, hdr_size, protect_tlv_size, img_size = struct.unpack_from("<IIHHI", image)
+    if magic != IMAGE_MAGIC:
+        sys.exit("image_patch: the source is not a signed image")
+
+    off = hdr_size + img_size + protect_tlv_size
+    info_magic, tlv_tot = struct.unpack_from("<HH", image, off)
+    if info_magic != IMAGE_TLV_INFO_MAGIC:
+        sys.exit("image_patch: the source has no TLV area")
+
+    end = off + tlv_tot
+    off += 4
+    while off + 4 <= end:
+        tlv_type, tlv_len = struct.unpack_from("<BxH", image, off)
+        off += 4
+        if tlv_type == IMAGE_TLV_SHA256 and tlv_len == 32:
+            return image[off:off + 32]
+        off += tlv_len
+    sys.exit("image_patch: the source has no SHA-256 TLV")
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7f
+        value >>= 7
+        if value == 0:
+            out.append(byte)
+            return out
+        out.append(byte | 0x80)
+
+def zigzag(value):
+    return (value << 1) if value >= 0 else (((-value - 1) << 1) | 1)
+
+def match_len(src, src_pos, dst, dst_pos):
+    n = 0
+    while (src_pos + n < len(src)) and (dst_pos + n < len(dst)) and (src[src_pos + n] == dst[dst_pos + n]):
+        n += 1
+    return n
+
+def make_body(src, dst):
+    # Greedy matching: a copy continues where the previous one would have
+    # continued if the bytes in between were replaced one for one (changed
+    # addresses and constants), otherwise it comes from the block index.
+    index = {}
+    for i in range(0, len(src) - BLOCK_SIZE + 1, BLOCK_SIZE):
+        index.setdefault(src[i:i + BLOCK_SIZE], i)
+
+    body = bytearray()
+    copied = 0
+    src_pos = 0     # Where the decoder's read position is
+    lit_start = 0   # First destination byte not yet emitted
+    pos = 0
+
+    def emit_insert(end):
+        if end > lit_start:
+            body.extend(varint((end - lit_start) << 1))
+            body.extend(dst[lit_start:end])
+
+    while pos < len(dst):
+        cand = src_pos + (pos - lit_start)
+        length = match_len(src, cand, dst, pos) if cand < len(src) else 0
+
+        if length < MIN_COPY:
+            block = index.get(dst[pos:pos + BLOCK_SIZE])
+            if block is None:
+                pos += 1
+                continue
+            # Grow the match back into the bytes not yet emitted.
+            cand = block
+            start = pos
+            while (start > lit_start) and (cand > 0) and (src[cand - 1] == dst[start - 1]):
+                cand -= 1
+                start -= 1
+            pos = start
+            length = match_len(src, cand, dst, pos)
+            if length < MIN_COPY:
+                pos += 1
+                continue
+
+        emit_insert(pos)
+        body.extend(varint((length << 1) | 1))
+        body.extend(varint(zigzag(cand - src_pos)))
+        copied += length
+        src_pos = cand + length
+        pos += length
+        lit_start = pos
+
+    emit_insert(len(dst))
+    return body, copied
+
+def main():
+    parser = argparse.ArgumentParser(description="Script to make a bootloader patch from two signed images")
+
+    parser.add_argument("--src", required=True, metavar="Signed image in the primary slot (.bin)")
+
+    parser.add_argument("--dst", required=True, metavar="New signed image (.bin)")
+
+    parser.add_argument("--out", required=True, metavar="Output patch file")
+
+    # Start arg parser.
+    args = parser.parse_args()
+
+    with open(args.src, "rb") as f:
+        src = f.read()
+    with open(args.dst, "rb") as f:
+        dst = f.read()
+
+    body, copied = make_body(src, dst)
+    header = struct.pack(PATCH_HDR_FORMAT, PATCH_MAGIC, PATCH_VERSION,
+                         struct.calcsize(PATCH_HDR_FORMAT), len(body), len(src),
+                         len(dst), 0, image_hash(src), hashlib.sha256(dst).digest())
+
+    with open(args.out, "wb") as f:
+        f.write(header)
+        f.write(body)
+
+    print("image_patch: %d byte image, %d byte patch (%d bytes copied, %d inserted)" %
+          (len(dst), len(header) + len(body), copied, len(dst) - copied))
+
+if __name__ == "__main__":
+    main()
@@ -59,6 +59,8 @@ shift
 CY_PAD_BYTES=$1
 shift
 CY_WIFI_FW_BLOB_VERSION=$1
+shift
+CY_COMPRESS_IMAGES=$1
 
 # Export these values for python3 click module
 export LC_ALL=C.UTF-8
@@ -75,6 +77,7 @@ CY_OUTPUT_WIFI_BLOB_LOC=$CY_OUTPUT_PATH/$CY_OUTPUT_WIFI_BLOB_NAME_BIN
 CY_OUTPUT_WIFI_CLM_BLOB_BIN=$CY_WIFI_CLM_BLOB
 
 CY_COMPONENTS_JSON_NAME=components.json
+CY_SCRIPT_DIR=$(cd "$(dirname "$0")" && pwd)
 
 #
 # For elf -> hex conversion
@@ -105,6 +108,23 @@ then
     PYTHON_PATH=python
 fi
 
+# Replaces the signed image $1 with a signed compressed image, which the
+# bootloader expands into the primary slot (see image_compress.py). The image
+# itself is kept as <name>.full.bin. The other arguments are the imgtool
+# arguments the image was signed with.
+compress_image()
+{
+    local image=$1
+    local full=${image%.bin}.full.bin
+    local payload=${image%.bin}.lz.bin
+    shift
+
+    mv $image $full
+    $PYTHON_PATH $CY_SCRIPT_DIR/image_compress.py --image $full --out $payload
+    (cd $MCUBOOT_SCRIPT_FILE_DIR && $PYTHON_PATH $IMGTOOL_SCRIPT_NAME "$@" $payload $image)
+    rm $payload
+}
+
 # Make a copy of input file.
 CY_OUTPUT_WIFI_FW_BLOB_PAD=$CY_OUTPUT_WIFI_BLOB_LOC.input.tmp.bin
 cp $CY_INPUT_WIFI_FW_BLOB $CY_OUTPUT_WIFI_FW_BLOB_PAD
@@ -139,6 +159,13 @@ cd $CY_OUTPUT_PATH
 # Convert signed hex file to Binary for AWS uploading
 "$CY_OBJ_COPY" --input-target=ihex --output-target=binary $CY_OUTPUT_SIGNED_HEX $CY_OUTPUT_BIN
 
+# Compress the images of the tarball. The signed hex file is not compressed.
+if [[ $CY_COMPRESS_IMAGES -eq 1 ]]
+then
+    compress_image $CY_OUTPUT_BIN $IMGTOOL_COMMAND_ARG $FLASH_ERASE_ARG -e little --pad-header --align 8 -H $MCUBOOT_HEADER_SIZE -M $MCUBOOT_MAX_IMG_SECTORS -v $CY_BUILD_VERSION -L $CY_BOOT_PRIMARY_1_START -S $CY_BOOT_PRIMARY_1_SIZE $CY_SIGNING_KEY_ARG
+    compress_image $CY_OUTPUT_WIFI_BLOB_LOC $IMGTOOL_COMMAND_ARG $FLASH_ERASE_ARG -e little --pad-header --align 8 -H $MCUBOOT_HEADER_SIZE -M $MCUBOOT_MAX_IMG_SECTORS -v $CY_WIFI_FW_BLOB_VERSION -S $CY_BOOT_PRIMARY_2_SIZE $CY_SIGNING_KEY_ARG
+fi
+
 echo  " Done."
 
 # get size of binary files for components.json
@@ -176,7 +203,8 @@ echo "Primary 1 Slot Size                      : $CY_BOOT_PRIMARY_1_SIZE"
 echo "Primary 2 Slot Size                      : $CY_BOOT_PRIMARY_2_SIZE"
 echo "FLASH ERASE Value (NOTE: Empty for 0xff) : $FLASH_ERASE_VALUE"
 echo "Cypress MCUBoot Header size              : $MCUBOOT_HEADER_SIZE"
-echo "Max 512 bytes sectors for Application    : $MCUBOOT_MAX_IMG_SECTORS"
+echo "Max sectors per image slot               : $MCUBOOT_MAX_IMG_SECTORS"
+echo "Compressed images                        : $CY_COMPRESS_IMAGES"
 if [ "$SIGNING_KEY_PATH" != "" ]
 then
     echo "Signing key: $SIGNING_KEY_PATH"
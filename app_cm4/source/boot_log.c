@@ -0,0 +1,90 @@
+/******************************************************************************
+* File Name: boot_log.c
+*
+* Description: This file contains the function that prints the bootloader log
+* output the UART had not sent when CM4 started. The bootloader leaves it in
+* the shared RAM block (boot_shared.h) instead of waiting for the UART.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "boot_shared.h"
+#include "boot_log.h"
+
+/* Bytes copied out of the shared block per write. */
+#define BOOT_LOG_CHUNK          (64U)
+
+/*******************************************************************************
+ * Function Name: boot_log_report
+ *******************************************************************************
+ * Summary:
+ * Prints the rest of the bootloader log. The first byte may be in the middle
+ * of a line the bootloader had started to send. Prints nothing if the
+ * bootloader sent all of it.
+ *
+ *******************************************************************************/
+void boot_log_report(void)
+{
+    const volatile boot_shared_t *shared = (const volatile boot_shared_t *) BOOT_SHARED_ADDR;
+    char chunk[BOOT_LOG_CHUNK];
+    uint32_t len;
+    uint32_t done = 0U;
+
+    if ((shared->magic != BOOT_SHARED_MAGIC) || (shared->version < BOOT_SHARED_VERSION) ||
+        (shared->size < (offsetof(boot_shared_t, log) + sizeof(shared->log))))
+    {
+        return;
+    }
+
+    len = (shared->log_len < BOOT_SHARED_LOG_SIZE) ? shared->log_len : BOOT_SHARED_LOG_SIZE;
+    while (done < len)
+    {
+        uint32_t part = ((len - done) < BOOT_LOG_CHUNK) ? (len - done) : BOOT_LOG_CHUNK;
+
+        for (uint32_t i = 0U; i < part; i++)
+        {
+            chunk[i] = (char) shared->log[done + i];
+        }
+        (void) fwrite(chunk, 1U, part, stdout);
+        done += part;
+    }
+
+    if (shared->log_dropped != 0U)
+    {
+        printf("(%u bytes of the bootloader log lost)\r\n", (unsigned int) shared->log_dropped);
+    }
+    (void) fflush(stdout);
+}
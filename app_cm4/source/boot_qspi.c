@@ -0,0 +1,123 @@
+/******************************************************************************
+* File Name: boot_qspi.c
+*
+* Description: This file contains the functions that set up the QSPI memory
+* with the configuration the bootloader left in the shared RAM block
+* (boot_shared.h), so that the application does not run the SFDP detection
+* again. Without one, the memory is detected as before.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "flash_qspi.h"
+#include "cy_smif_psoc6.h"
+#include "boot_shared.h"
+#include "boot_qspi_cfg.h"
+#include "boot_qspi.h"
+
+/* Memory configuration rebuilt from the shared RAM block, and whether the
+ * block was read yet.
+ */
+static boot_qspi_mem_t boot_qspi_mem;
+static cy_stc_smif_block_config_t *boot_qspi_block;
+static bool boot_qspi_loaded;
+
+/*******************************************************************************
+ * Function Name: boot_qspi_load
+ *******************************************************************************
+ * Summary:
+ * Rebuilds the memory configuration the bootloader handed over, once.
+ *
+ * @return The block configuration, or NULL if the bootloader left none.
+ *
+ *******************************************************************************/
+static cy_stc_smif_block_config_t *boot_qspi_load(void)
+{
+    const volatile boot_shared_t *shared = (const volatile boot_shared_t *) BOOT_SHARED_ADDR;
+    boot_qspi_cfg_t cfg;
+
+    if (boot_qspi_loaded)
+    {
+        return boot_qspi_block;
+    }
+    boot_qspi_loaded = true;
+
+    if ((shared->magic != BOOT_SHARED_MAGIC) || (shared->version < BOOT_SHARED_VERSION) ||
+        (shared->size < (offsetof(boot_shared_t, qspi) + sizeof(shared->qspi))))
+    {
+        return NULL;
+    }
+
+    cfg = *(const boot_qspi_cfg_t *) &shared->qspi;
+    boot_qspi_block = boot_qspi_cfg_unpack(&cfg, &boot_qspi_mem);
+    return boot_qspi_block;
+}
+
+/*******************************************************************************
+ * Function Name: boot_qspi_mem_config
+ *******************************************************************************
+ * Summary:
+ * Returns the QSPI memory configuration the bootloader detected, for
+ * cy_serial_flash_qspi_init().
+ *
+ * @return The configuration, or NULL if the bootloader left none.
+ *
+ *******************************************************************************/
+const cy_stc_smif_mem_config_t *boot_qspi_mem_config(void)
+{
+    return (boot_qspi_load() != NULL) ? &boot_qspi_mem.mem : NULL;
+}
+
+/*******************************************************************************
+ * Function Name: boot_qspi_init
+ *******************************************************************************
+ * Summary:
+ * Initializes the QSPI memory for the flash map like psoc6_qspi_init(), from
+ * the configuration the bootloader detected if there is one.
+ *
+ * @return 0 on success, or the error of psoc6_qspi_init().
+ *
+ *******************************************************************************/
+int boot_qspi_init(void)
+{
+    cy_stc_smif_block_config_t *block = boot_qspi_load();
+
+    if ((block != NULL) && (qspi_init(block) == CY_SMIF_SUCCESS))
+    {
+        return 0;
+    }
+    return psoc6_qspi_init();
+}
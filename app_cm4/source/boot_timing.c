@@ -0,0 +1,139 @@
+/******************************************************************************
+* File Name: boot_timing.c
+*
+* Description: This file contains the function that prints the boot phase
+* times the bootloader left in the shared RAM block (boot_shared.h).
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "boot_shared.h"
+#include "boot_timing.h"
+
+/* Names of the BOOT_PHASE_* values. */
+static const char *const boot_phase_names[] =
+{
+    [BOOT_PHASE_HW_INIT]     = "hw init",
+    [BOOT_PHASE_SMIF_INIT]   = "QSPI init",
+    [BOOT_PHASE_PATCH]       = "patch",
+    [BOOT_PHASE_COMPRESS]    = "decompress",
+    [BOOT_PHASE_CONCURRENT]  = "concurrent upgrade",
+    [BOOT_PHASE_SLOT_FLIP]   = "Wi-Fi slot select",
+    [BOOT_PHASE_BOOT_GO]     = "MCUboot",
+    [BOOT_PHASE_VALIDATE]    = "validation",
+    [BOOT_PHASE_UART_FLUSH]  = "UART flush",
+    [BOOT_PHASE_HEADER]      = "header read",
+    [BOOT_PHASE_IMAGE_CHECK] = "hash/signature",
+    [BOOT_PHASE_COPY]        = "copy",
+    [BOOT_PHASE_FAST_CHECK]  = "upgrade check",
+};
+
+/*******************************************************************************
+ * Function Name: boot_ticks_us
+ *******************************************************************************
+ * Summary:
+ * Converts bootloader timer ticks to microseconds.
+ *
+ *******************************************************************************/
+static uint32_t boot_ticks_us(uint32_t ticks, uint32_t timer_hz)
+{
+    return (uint32_t) (((uint64_t) ticks * 1000000U) / timer_hz);
+}
+
+/*******************************************************************************
+ * Function Name: boot_timing_report
+ *******************************************************************************
+ * Summary:
+ * Prints the time the bootloader spent in each boot phase, in the order the
+ * phases started. Phases nest: the header reads, image checks and copies of
+ * an image are also part of the phase that made them. Prints nothing if the
+ * bootloader left no times.
+ *
+ *******************************************************************************/
+void boot_timing_report(void)
+{
+    const volatile boot_shared_t *shared = (const volatile boot_shared_t *) BOOT_SHARED_ADDR;
+    boot_phase_t phases[BOOT_SHARED_PHASES_MAX];
+    uint32_t timer_hz;
+    uint32_t count;
+
+    if ((shared->magic != BOOT_SHARED_MAGIC) || (shared->version < BOOT_SHARED_VERSION) ||
+        (shared->size < (offsetof(boot_shared_t, phases) + sizeof(shared->phases))) ||
+        (shared->timer_hz == 0U))
+    {
+        return;
+    }
+
+    timer_hz = shared->timer_hz;
+    count = (shared->phase_count < BOOT_SHARED_PHASES_MAX) ? shared->phase_count : BOOT_SHARED_PHASES_MAX;
+
+    /* The bootloader adds a phase when it first ends; order them by start. */
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        boot_phase_t entry = shared->phases[i];
+        uint32_t j = i;
+
+        while ((j > 0U) && (phases[j - 1U].start > entry.start))
+        {
+            phases[j] = phases[j - 1U];
+            j--;
+        }
+        phases[j] = entry;
+    }
+
+    printf("Boot took %lu us", (unsigned long) boot_ticks_us(shared->boot_ticks, timer_hz));
+    if (shared->phase_dropped != 0U)
+    {
+        printf(", %u phases not recorded", (unsigned int) shared->phase_dropped);
+    }
+    printf(":\r\n");
+
+    for (uint32_t i = 0U; i < count; i++)
+    {
+        const char *name = (phases[i].phase < (sizeof(boot_phase_names) / sizeof(boot_phase_names[0]))) ?
+                           boot_phase_names[phases[i].phase] : NULL;
+
+        printf("  %-20s", (name != NULL) ? name : "unknown");
+        if (phases[i].image != BOOT_PHASE_NO_IMAGE)
+        {
+            printf(" image %u", (unsigned int) phases[i].image + 1U);
+        }
+        printf(" at %lu us: %lu us, %u calls\r\n",
+               (unsigned long) boot_ticks_us(phases[i].start, timer_hz),
+               (unsigned long) boot_ticks_us(phases[i].ticks, timer_hz),
+               (unsigned int) phases[i].count);
+    }
+}
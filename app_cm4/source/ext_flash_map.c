@@ -41,14 +41,10 @@
 /* Header file for flash configuration. */
 #include "flash_map_backend/flash_map_backend.h"
 #include "sysflash.h"
+#include "wifi_fw_cfg.h"
 
 #if defined(CY_FLASH_MAP_EXT_DESC)
 
-#ifndef CY_EXTERNAL_FLASH_SECTOR_SIZE
-/* Set external flash sector size to 256 KB by default. */
-#define CY_EXTERNAL_FLASH_SECTOR_SIZE           (0x40000)
-#endif
-
 #ifndef CY_BOOTLOADER_START_ADDRESS
 #define CY_BOOTLOADER_START_ADDRESS             (0x10000000)
 #endif
@@ -108,6 +104,28 @@ struct flash_area *boot_area_descs[] =
     NULL
 };
 
+#if defined(CY_BOOT_WIFI_SLOT_FLIP)
+/*******************************************************************************
+ * Function Name: ext_flash_map_set_wifi_slot
+ *******************************************************************************
+ * Summary:
+ * Maps the image 2 primary slot to the slot the Wi-Fi firmware runs from and
+ * the image 2 secondary slot to the other one, so that the OTA agent never
+ * overwrites the running firmware.
+ *
+ * @param[in] slot_addr Address of the slot the bootloader chose.
+ *
+ *******************************************************************************/
+void ext_flash_map_set_wifi_slot(uint32_t slot_addr)
+{
+    const uint32_t primary_addr = CY_FLASH_DEVICE_BASE + CY_BOOT_PRIMARY_2_START;
+    const uint32_t secondary_addr = CY_FLASH_DEVICE_BASE + CY_BOOT_SECONDARY_2_START;
+
+    primary_2.fa_off = slot_addr;
+    secondary_2.fa_off = (slot_addr == secondary_addr) ? primary_addr : secondary_addr;
+}
+#endif
+
 #else
     #error "CY_FLASH_MAP_EXT_DESC not defined !!"
 #endif /* CY_FLASH_MAP_EXT_DESC */
@@ -5,6 +5,7 @@
 * This file defines the Wi-Fi firmware resource structure. Structure points to 
 * a defined location on external memory that contains a valid Wi-Fi firmware. 
 * Firmware will be loaded on to the Wi-Fi module during every power on.
+* With CY_BOOT_WIFI_SLOT_FLIP, the location is the slot the bootloader chose.
 *
 *******************************************************************************
 * (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
@@ -38,17 +39,28 @@
 * indemnify Cypress against all liability.
 *******************************************************************************/
 
+#include <stddef.h>
+
 #include "wiced_resource.h"
 #include "sysflash.h"
 #include "cy_pdl.h"
+#include "boot_shared.h"
+#include "wifi_fw_cfg.h"
+
+/* Location of the image 2 slots in memory. */
+#define CY_WIFI_PRIMARY_SLOT_ADDR   (CY_FLASH_DEVICE_BASE + CY_BOOT_PRIMARY_2_START)
+#define CY_WIFI_SECONDARY_SLOT_ADDR (CY_FLASH_DEVICE_BASE + CY_BOOT_SECONDARY_2_START)
 
 /* Location of Wi-Fi firmware blob in memory. */
-#define CY_WIFI_FW_ADDR             (CY_FLASH_DEVICE_BASE + CY_BOOT_PRIMARY_2_START + MCUBOOT_HEADER_SIZE)
+#define CY_WIFI_FW_ADDR             (CY_WIFI_PRIMARY_SLOT_ADDR + MCUBOOT_HEADER_SIZE)
 
-/* Location of Wi-Fi CLM blob in memory.
+/* Offset of Wi-Fi CLM blob from Wi-Fi firmware blob.
  * Note: CLM blob should be placed immediate next to Wi-Fi blob..
  */
-#define CY_WIFI_CLM_BLOB_ADDR       (CY_WIFI_FW_ADDR + CY_WIFI_BLOB_SIZE + CY_PAD_BYTES)
+#define CY_WIFI_CLM_BLOB_OFFSET     (CY_WIFI_BLOB_SIZE + CY_PAD_BYTES)
+
+/* Location of Wi-Fi CLM blob in memory. */
+#define CY_WIFI_CLM_BLOB_ADDR       (CY_WIFI_FW_ADDR + CY_WIFI_CLM_BLOB_OFFSET)
 
 /* 40 bytes of signature attached by the imgtool. */
 #define IMG_SIGN_SZ                 (0x28)
@@ -75,9 +87,68 @@
  * Please refer the application Makefile for firmware blob selection.
  */
 #ifdef WLAN_MFG_FIRMWARE 
-const resource_hnd_t wifi_mfg_firmware_image    = { RESOURCE_IN_MEMORY, CY_WIFI_BLOB_SIZE, {.mem = { (const char *) CY_WIFI_FW_ADDR }}};
-const resource_hnd_t wifi_mfg_firmware_clm_blob = { RESOURCE_IN_MEMORY, CY_WIFI_CLM_BLOB_SIZE, {.mem = { (const char *) CY_WIFI_CLM_BLOB_ADDR }}};
+#define CY_WIFI_FW_IMAGE            wifi_mfg_firmware_image
+#define CY_WIFI_FW_CLM_BLOB         wifi_mfg_firmware_clm_blob
+#else
+#define CY_WIFI_FW_IMAGE            wifi_firmware_image
+#define CY_WIFI_FW_CLM_BLOB         wifi_firmware_clm_blob
+#endif
+
+/*
+ * With CY_BOOT_WIFI_SLOT_FLIP, the firmware runs from either image 2 slot and
+ * wifi_fw_cfg_init() points the resources at the one the bootloader chose.
+ * WHD only reads them, so they are placed in RAM instead of flash.
+ */
+#if defined(CY_BOOT_WIFI_SLOT_FLIP)
+#define CY_WIFI_FW_RESOURCE         resource_hnd_t
 #else
-const resource_hnd_t wifi_firmware_image    = { RESOURCE_IN_MEMORY, CY_WIFI_BLOB_SIZE, {.mem = { (const char *)CY_WIFI_FW_ADDR }}};
-const resource_hnd_t wifi_firmware_clm_blob = { RESOURCE_IN_MEMORY, CY_WIFI_CLM_BLOB_SIZE, {.mem = { (const char *) CY_WIFI_CLM_BLOB_ADDR }}};
+#define CY_WIFI_FW_RESOURCE         const resource_hnd_t
+#endif
+
+CY_WIFI_FW_RESOURCE CY_WIFI_FW_IMAGE    = { RESOURCE_IN_MEMORY, CY_WIFI_BLOB_SIZE, {.mem = { (const char *) CY_WIFI_FW_ADDR }}};
+CY_WIFI_FW_RESOURCE CY_WIFI_FW_CLM_BLOB = { RESOURCE_IN_MEMORY, CY_WIFI_CLM_BLOB_SIZE, {.mem = { (const char *) CY_WIFI_CLM_BLOB_ADDR }}};
+
+#if defined(CY_BOOT_WIFI_SLOT_FLIP)
+/*******************************************************************************
+ * Function Name: wifi_fw_slot_addr
+ *******************************************************************************
+ * Summary:
+ * Returns the image 2 slot the bootloader left in the shared RAM block, or the
+ * primary slot if the block holds no valid choice.
+ *
+ *******************************************************************************/
+static uint32_t wifi_fw_slot_addr(void)
+{
+    const volatile boot_shared_t *shared = (const volatile boot_shared_t *) BOOT_SHARED_ADDR;
+    uint32_t addr;
+
+    if ((shared->magic != BOOT_SHARED_MAGIC) || (shared->version < BOOT_SHARED_VERSION) ||
+        (shared->size < (offsetof(boot_shared_t, wifi_slot_addr) + sizeof(shared->wifi_slot_addr))))
+    {
+        return CY_WIFI_PRIMARY_SLOT_ADDR;
+    }
+
+    addr = shared->wifi_slot_addr;
+    return (addr == CY_WIFI_SECONDARY_SLOT_ADDR) ? CY_WIFI_SECONDARY_SLOT_ADDR : CY_WIFI_PRIMARY_SLOT_ADDR;
+}
+#endif
+
+/*******************************************************************************
+ * Function Name: wifi_fw_cfg_init
+ *******************************************************************************
+ * Summary:
+ * Points the Wi-Fi firmware resources at the image 2 slot the bootloader chose,
+ * and the image 2 secondary slot of the flash map at the other one so that the
+ * OTA agent writes upgrades there. Does nothing without CY_BOOT_WIFI_SLOT_FLIP.
+ *
+ *******************************************************************************/
+void wifi_fw_cfg_init(void)
+{
+#if defined(CY_BOOT_WIFI_SLOT_FLIP)
+    uint32_t slot_addr = wifi_fw_slot_addr();
+
+    CY_WIFI_FW_IMAGE.val.mem.data = (const char *) (slot_addr + MCUBOOT_HEADER_SIZE);
+    CY_WIFI_FW_CLM_BLOB.val.mem.data = (const char *) (slot_addr + MCUBOOT_HEADER_SIZE + CY_WIFI_CLM_BLOB_OFFSET);
+    ext_flash_map_set_wifi_slot(slot_addr);
 #endif
+}
@@ -0,0 +1,49 @@
+/******************************************************************************
+ * File Name: wifi_fw_cfg.h
+ *
+ * Description: This file contains declaration of functions that locate the
+ * Wi-Fi firmware in the external memory.
+ *
+ *******************************************************************************
+ * (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+ *******************************************************************************
+ * This software, including source code, documentation and related materials
+ * ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+ * subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+ * protection (United States and foreign), United States copyright laws and
+ * international treaty provisions. Therefore, you may use this Software only
+ * as provided in the license agreement accompanying the software package from
+ * which you obtained this Software ("EULA").
+ *
+ * If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+ * non-transferable license to copy, modify, and compile the Software source
+ * code solely for use in connection with Cypress's integrated circuit products.
+ * Any reproduction, modification, translation, compilation, or representation
+ * of this Software except as specified above is prohibited without the express
+ * written permission of Cypress.
+ *
+ * Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+ * reserves the right to make changes to the Software without notice. Cypress
+ * does not assume any liability arising out of the application or use of the
+ * Software or any product or circuit described in the Software. Cypress does
+ * not authorize its products for use in any products where a malfunction or
+ * failure of the Cypress product may reasonably be expected to result in
+ * significant property damage, injury or death ("High Risk Product"). By
+ * including Cypress's product in a High Risk Product, the manufacturer of such
+ * system or application assumes all risk of such use and in doing so agrees to
+ * indemnify Cypress against all liability.
+ *******************************************************************************/
+#ifndef SOURCE_WIFI_FW_CFG_H_
+#define SOURCE_WIFI_FW_CFG_H_
+
+#include <stdint.h>
+
+/* Call before the Wi-Fi is powered on. */
+void wifi_fw_cfg_init(void);
+
+/* Implemented in ext_flash_map.c. */
+void ext_flash_map_set_wifi_slot(uint32_t slot_addr);
+
+#endif /* SOURCE_WIFI_FW_CFG_H_ */
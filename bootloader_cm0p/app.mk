@@ -70,9 +70,39 @@ SOURCES+=\
     $(wildcard $(MCUBOOT_CY_PATH)/libs/cy-mbedtls-acceleration/mbedtls_MXCRYPTO/*.c)\
     $(MCUBOOTAPP_PATH)/cy_security_cnt.c\
     $(MCUBOOT_CY_PATH)/platforms/retarget_io_pdl/cy_retarget_io_pdl.c\
-    $(MCUBOOTAPP_PATH)/image_ec256_mbedtls.c\
     $(MCUBOOTAPP_PATH)/keys.c\
 
+# Crypto backends (BOOT_CRYPTO and BOOT_SIGN in the Makefile). MCUboot's
+# image_ec256.c verifies EC256 signatures with TinyCrypt, image_ec256_mbedtls.c
+# with Mbed TLS.
+ifeq ($(BOOT_CRYPTO), TINYCRYPT)
+ifeq ($(BOOT_CRYPTO_PROFILE), MINIMAL)
+TINYCRYPT_FILES=sha256 utils
+ifeq ($(BOOT_SIGN), EC256)
+TINYCRYPT_FILES+=ecc ecc_dsa ecc_platform_specific
+endif
+SOURCES+=\
+    $(foreach f,$(TINYCRYPT_FILES),$(MCUBOOT_PATH)/ext/tinycrypt/lib/source/$(f).c)
+else
+SOURCES+=\
+    $(wildcard $(MCUBOOT_PATH)/ext/tinycrypt/lib/source/*.c)
+endif
+
+INCLUDES+=\
+    $(MCUBOOT_PATH)/ext/tinycrypt/lib/include
+else
+SOURCES+=\
+    $(MCUBOOTAPP_PATH)/image_ec256_mbedtls.c
+endif
+
+ifeq ($(BOOT_SIGN), ED25519)
+SOURCES+=\
+    $(wildcard $(MCUBOOT_PATH)/ext/fiat/src/*.c)
+
+INCLUDES+=\
+    $(MCUBOOT_PATH)/ext/fiat/include
+endif
+
 # Include QSPI API from flash PAL always.
 SOURCES+=\
     $(wildcard $(MCUBOOT_CY_PATH)/cy_flash_pal/cy_smif_psoc6.c)\
@@ -107,9 +137,31 @@ FILES_TO_EXCLUDE=\
     $(CRYPTO_LIB_PATH)/version.c \
     $(CRYPTO_LIB_PATH)/version_features.c
 
+# The minimal profile builds the modules mcuboot_crypto_min_config.h enables
+# for BOOT_CRYPTO and BOOT_SIGN, the full profile every file.
+ifeq ($(BOOT_CRYPTO_PROFILE), MINIMAL)
+MBEDTLS_FILES=platform platform_util
+ifneq ($(BOOT_CRYPTO), TINYCRYPT)
+MBEDTLS_FILES+=sha256
+endif
+ifneq ($(BOOT_SIGN), NONE)
+MBEDTLS_FILES+=asn1parse
+endif
+ifeq ($(BOOT_CRYPTO)_$(BOOT_SIGN), MBEDTLS_EC256)
+MBEDTLS_FILES+=bignum ecp ecp_curves ecdsa memory_buffer_alloc
+endif
+ifeq ($(BOOT_SIGN), ED25519)
+MBEDTLS_FILES+=sha512
+endif
+
+SOURCES+=\
+    $(foreach f,$(MBEDTLS_FILES),\
+        $(firstword $(wildcard $(MBEDTLS_PATH)/library/$(f).c $(CRYPTO_LIB_PATH)/$(f).c)))
+else
 SOURCES+=\
     $(wildcard $(MBEDTLS_PATH)/library/*.c)\
     $(filter-out $(FILES_TO_EXCLUDE), $(wildcard $(CRYPTO_LIB_PATH)/*.c))
+endif
         
 INCLUDES+=\
     $(MBEDTLS_PATH)/include\
@@ -0,0 +1,218 @@
+/******************************************************************************
+* File Name:   boot_crypto.c
+*
+* Description:
+* This file hashes with the crypto backend MCUboot is built with, so that the
+* upgrade and validation passes use the same SHA-256 code as MCUboot: mbedTLS
+* in software or on the MXCRYPTO block (MCUBOOT_USE_MBED_TLS), or TinyCrypt
+* (MCUBOOT_USE_TINYCRYPT). Signatures are only verified by MCUboot, which
+* takes its verifier from the same choice and MCUBOOT_SIGN_*. With the
+* minimal crypto profile (config/mcuboot_crypto_min_config.h), mbedTLS
+* allocates from a static pool here instead of the heap.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "boot_crypto.h"
+
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+#include "mbedtls/memory_buffer_alloc.h"
+#endif
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#ifndef CY_BOOT_CRYPTO_POOL_SIZE
+/* Memory mbedTLS allocates from when built with MBEDTLS_MEMORY_BUFFER_ALLOC_C:
+ * one ECDSA P-256 verification with the window sizes of the minimal profile,
+ * with margin. mbedtls_memory_buffer_alloc_max_get() gives the peak use when
+ * mbedTLS is built with MBEDTLS_MEMORY_DEBUG.
+ */
+#define CY_BOOT_CRYPTO_POOL_SIZE                (6144U)
+#endif
+
+/* SHA-256 block size, for the HMAC pads. */
+#define BOOT_HMAC_BLOCK_SIZE                    (64U)
+
+#if defined(MCUBOOT_USE_MBED_TLS) && defined(MCUBOOT_USE_TINYCRYPT)
+#error "Define only one of MCUBOOT_USE_MBED_TLS and MCUBOOT_USE_TINYCRYPT"
+#endif
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+static uint8_t boot_crypto_pool[CY_BOOT_CRYPTO_POOL_SIZE] __attribute__((aligned(8)));
+#endif
+
+/******************************************************************************
+ * Function Name: boot_crypto_init
+ ******************************************************************************
+ * Summary:
+ *  Called before anything hashes or verifies. Hands the static pool to
+ *  mbedTLS if it is built to allocate from one.
+ *
+ ******************************************************************************/
+void boot_crypto_init(void)
+{
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+    mbedtls_memory_buffer_alloc_init(boot_crypto_pool, sizeof(boot_crypto_pool));
+#endif
+}
+
+/******************************************************************************
+ * Function Name: boot_sha256_start
+ ******************************************************************************
+ * Summary:
+ *  Starts a SHA-256 computation in `ctx`.
+ *
+ ******************************************************************************/
+int boot_sha256_start(boot_sha256_context *ctx)
+{
+#if defined(MCUBOOT_USE_TINYCRYPT)
+    return (tc_sha256_init(ctx) == TC_CRYPTO_SUCCESS) ? 0 : -1;
+#else
+    mbedtls_sha256_init(ctx);
+    return (mbedtls_sha256_starts_ret(ctx, 0) == 0) ? 0 : -1;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: boot_sha256_update
+ ******************************************************************************
+ * Summary:
+ *  Hashes `len` bytes at `data`.
+ *
+ ******************************************************************************/
+int boot_sha256_update(boot_sha256_context *ctx, const void *data, uint32_t len)
+{
+#if defined(MCUBOOT_USE_TINYCRYPT)
+    return (tc_sha256_update(ctx, (const uint8_t *)data, len) == TC_CRYPTO_SUCCESS) ? 0 : -1;
+#else
+    return (mbedtls_sha256_update_ret(ctx, (const unsigned char *)data, len) == 0) ? 0 : -1;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: boot_sha256_finish
+ ******************************************************************************
+ * Summary:
+ *  Writes the hash of the data to `hash`.
+ *
+ ******************************************************************************/
+int boot_sha256_finish(boot_sha256_context *ctx, uint8_t hash[BOOT_SHA256_SIZE])
+{
+#if defined(MCUBOOT_USE_TINYCRYPT)
+    return (tc_sha256_final(hash, ctx) == TC_CRYPTO_SUCCESS) ? 0 : -1;
+#else
+    return (mbedtls_sha256_finish_ret(ctx, hash) == 0) ? 0 : -1;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: boot_sha256_free
+ ******************************************************************************
+ * Summary:
+ *  Clears `ctx` and releases the hardware it may hold.
+ *
+ ******************************************************************************/
+void boot_sha256_free(boot_sha256_context *ctx)
+{
+#if defined(MCUBOOT_USE_TINYCRYPT)
+    (void)memset(ctx, 0, sizeof(*ctx));
+#else
+    mbedtls_sha256_free(ctx);
+#endif
+}
+
+/******************************************************************************
+ * Function Name: boot_hmac_sha256
+ ******************************************************************************
+ * Summary:
+ *  Computes the HMAC-SHA256 of `len` bytes at `data` under `key` (RFC 2104;
+ *  the key is shorter than a block, so it is only padded).
+ *
+ ******************************************************************************/
+void boot_hmac_sha256(const uint8_t key[BOOT_SHA256_SIZE], const void *data, uint32_t len,
+                      uint8_t mac[BOOT_SHA256_SIZE])
+{
+    boot_sha256_context sha;
+    uint8_t pad[BOOT_HMAC_BLOCK_SIZE];
+    uint8_t inner[BOOT_SHA256_SIZE];
+
+    memset(pad, 0x36, sizeof(pad));
+    for (uint32_t i = 0; i < BOOT_SHA256_SIZE; i++)
+    {
+        pad[i] ^= key[i];
+    }
+    (void)boot_sha256_start(&sha);
+    (void)boot_sha256_update(&sha, pad, sizeof(pad));
+    (void)boot_sha256_update(&sha, data, len);
+    (void)boot_sha256_finish(&sha, inner);
+    boot_sha256_free(&sha);
+
+    memset(pad, 0x5C, sizeof(pad));
+    for (uint32_t i = 0; i < BOOT_SHA256_SIZE; i++)
+    {
+        pad[i] ^= key[i];
+    }
+    (void)boot_sha256_start(&sha);
+    (void)boot_sha256_update(&sha, pad, sizeof(pad));
+    (void)boot_sha256_update(&sha, inner, sizeof(inner));
+    (void)boot_sha256_finish(&sha, mac);
+    boot_sha256_free(&sha);
+}
+
+/******************************************************************************
+ * Function Name: boot_crypto_equal
+ ******************************************************************************
+ * Summary:
+ *  Compares two byte strings in a time that does not depend on where they
+ *  differ.
+ *
+ ******************************************************************************/
+bool boot_crypto_equal(const uint8_t *a, const uint8_t *b, uint32_t len)
+{
+    uint8_t diff = 0U;
+
+    for (uint32_t i = 0; i < len; i++)
+    {
+        diff |= (uint8_t)(a[i] ^ b[i]);
+    }
+    return diff == 0U;
+}
+
+/* [] END OF FILE */
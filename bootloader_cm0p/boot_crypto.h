@@ -0,0 +1,81 @@
+/******************************************************************************
+* File Name:   boot_crypto.h
+*
+* Description:
+* SHA-256 used by the bootloader's own passes, from the crypto backend MCUboot
+* is built with (see BOOT_CRYPTO in the Makefile).
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef BOOT_CRYPTO_H_
+#define BOOT_CRYPTO_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mcuboot_config/mcuboot_config.h"
+
+#if defined(MCUBOOT_USE_TINYCRYPT)
+#include "tinycrypt/constants.h"
+#include "tinycrypt/sha256.h"
+#else
+#include "mbedtls/sha256.h"
+#endif
+
+#define BOOT_SHA256_SIZE                        (32U)
+
+#if defined(MCUBOOT_USE_TINYCRYPT)
+typedef struct tc_sha256_state_struct boot_sha256_context;
+#else
+/* Software mbedTLS, or the MXCRYPTO block with USE_CRYPTO_HW. */
+typedef mbedtls_sha256_context boot_sha256_context;
+#endif
+
+void boot_crypto_init(void);
+
+/* Each of them returns 0 on success. A started context must be freed, also
+ * after an error; it can then be started again.
+ */
+int boot_sha256_start(boot_sha256_context *ctx);
+int boot_sha256_update(boot_sha256_context *ctx, const void *data, uint32_t len);
+int boot_sha256_finish(boot_sha256_context *ctx, uint8_t hash[BOOT_SHA256_SIZE]);
+void boot_sha256_free(boot_sha256_context *ctx);
+
+/* HMAC-SHA256 under a key of BOOT_SHA256_SIZE bytes, for the records the
+ * bootloader keeps in flash.
+ */
+void boot_hmac_sha256(const uint8_t key[BOOT_SHA256_SIZE], const void *data, uint32_t len,
+                      uint8_t mac[BOOT_SHA256_SIZE]);
+bool boot_crypto_equal(const uint8_t *a, const uint8_t *b, uint32_t len);
+
+#endif /* BOOT_CRYPTO_H_ */
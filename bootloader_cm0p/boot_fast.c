@@ -0,0 +1,259 @@
+/******************************************************************************
+* File Name:   boot_fast.c
+*
+* Description:
+* This file implements the fast path of a normal reset. Every pending upgrade,
+* full image, patch or compressed image, is marked by the MCUboot trailer
+* magic at the end of its secondary slot, and so is an upgrade a reset
+* interrupted, as the magic is erased last. Before the upgrade passes and
+* boot_go() run, the bootloader reads the magic of every secondary slot, in
+* one pass over the XIP window. When none is set there is nothing to install:
+* the primary slot headers are read here instead of by boot_go(), which also
+* reads the sector layout and the trailer of every slot on each boot, and the
+* images are validated by boot_validate.c as on the full path.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "flash_map_backend/flash_map_backend.h"
+#include "sysflash.h"
+#include "mcuboot_config/mcuboot_config.h"
+#include "bootutil/bootutil.h"
+#include "bootutil/image.h"
+
+#include "ext_flash_map.h"
+#include "ext_flash_smif.h"
+#include "boot_fast.h"
+#include "boot_timing.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#ifndef CY_BOOT_FAST_PATH
+/* Set to 0 to run the upgrade passes and boot_go() on every boot. */
+#define CY_BOOT_FAST_PATH                       (1)
+#endif
+
+/* MCUboot trailer magic, the last bytes of a slot with an upgrade pending. */
+#define FAST_MAGIC_SIZE                         (16U)
+#define FAST_MAGIC_WORDS                        (FAST_MAGIC_SIZE / sizeof(uint32_t))
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+#if (CY_BOOT_FAST_PATH != 0)
+static const uint32_t fast_magic[FAST_MAGIC_WORDS] =
+{
+    0xf395c277UL, 0x7fefd260UL, 0x0f505235UL, 0x8079b62cUL
+};
+
+/* Primary slot headers, boot_rsp.br_hdr points to the first. */
+static struct image_header fast_hdr[MCUBOOT_IMAGE_NUMBER];
+#endif
+
+static boot_fast_stats_t fast_stats;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+#if (CY_BOOT_FAST_PATH != 0)
+static int fast_read_magics(uint32_t magic[][FAST_MAGIC_WORDS]);
+static int fast_read_header(int image, struct image_header *hdr, const struct flash_area **fa);
+#endif
+
+#if (CY_BOOT_FAST_PATH != 0)
+/******************************************************************************
+ * Function Name: fast_read_magics
+ ******************************************************************************
+ * Summary:
+ *  Reads the trailer magic of the secondary slot of every image. The slots
+ *  on the external memory are read through the XIP window, back to back, so
+ *  the SMIF switches to memory mode once and each read is a single burst.
+ *
+ * Parameters:
+ *  magic - Set to the magic of each image.
+ *
+ * Return:
+ *  0 on success, -1 if a slot could not be read.
+ *
+ ******************************************************************************/
+static int fast_read_magics(uint32_t magic[][FAST_MAGIC_WORDS])
+{
+    for (int image = 0; image < MCUBOOT_IMAGE_NUMBER; image++)
+    {
+        const struct flash_area *fa;
+        uint32_t off;
+        int rc = 0;
+
+        if (flash_area_open(FLASH_AREA_IMAGE_SECONDARY(image), &fa) != 0)
+        {
+            return -1;
+        }
+
+        off = fa->fa_size - FAST_MAGIC_SIZE;
+        if (((fa->fa_device_id & FLASH_DEVICE_EXTERNAL_FLAG) != FLASH_DEVICE_EXTERNAL_FLAG) ||
+            (ext_flash_smif_xip_read(fa->fa_off + off, magic[image], FAST_MAGIC_SIZE) != 0))
+        {
+            rc = flash_area_read(fa, off, magic[image], FAST_MAGIC_SIZE);
+        }
+        flash_area_close(fa);
+
+        if (rc != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: fast_read_header
+ ******************************************************************************
+ * Summary:
+ *  Reads the header of the image in the primary slot of `image`, which is
+ *  what boot_go() checks of a primary slot when it has nothing to install.
+ *
+ * Parameters:
+ *  image - Image index.
+ *  hdr - Set to the header.
+ *  fa - Set to the primary slot, left open.
+ *
+ * Return:
+ *  0 if the slot holds an image header, -1 otherwise.
+ *
+ ******************************************************************************/
+static int fast_read_header(int image, struct image_header *hdr, const struct flash_area **fa)
+{
+    uint32_t start = boot_timing_now();
+    int rc = -1;
+
+    if (flash_area_open(FLASH_AREA_IMAGE_PRIMARY(image), fa) != 0)
+    {
+        return -1;
+    }
+
+    if ((flash_area_read(*fa, 0U, hdr, sizeof(*hdr)) == 0) && (hdr->ih_magic == IMAGE_MAGIC))
+    {
+        rc = 0;
+    }
+    boot_timing_add(BOOT_PHASE_HEADER, (uint8_t)image, start);
+
+    if (rc != 0)
+    {
+        flash_area_close(*fa);
+    }
+    return rc;
+}
+#endif
+
+/******************************************************************************
+ * Function Name: boot_fast_go
+ ******************************************************************************
+ * Summary:
+ *  Called before the upgrade passes. If no secondary slot has an upgrade
+ *  pending and every primary slot holds an image header, fills `rsp` as
+ *  boot_go() would, for the image in the primary slot of image 1.
+ *
+ * Parameters:
+ *  rsp - Set to the image to boot if the fast path is taken.
+ *
+ * Return:
+ *  0 if the fast path is taken, -1 if the upgrade passes and boot_go() must
+ *  run.
+ *
+ ******************************************************************************/
+int boot_fast_go(struct boot_rsp *rsp)
+{
+#if (CY_BOOT_FAST_PATH != 0)
+    uint32_t magic[MCUBOOT_IMAGE_NUMBER][FAST_MAGIC_WORDS];
+    const struct flash_area *fa = NULL;
+
+    if (fast_read_magics(magic) != 0)
+    {
+        return -1;
+    }
+
+    for (int image = 0; image < MCUBOOT_IMAGE_NUMBER; image++)
+    {
+        if (memcmp(magic[image], fast_magic, FAST_MAGIC_SIZE) == 0)
+        {
+            fast_stats.pending++;
+        }
+    }
+    if (fast_stats.pending != 0U)
+    {
+        return -1;
+    }
+
+    /* Image 1 is booted, so its slot is the one left open. */
+    for (int image = MCUBOOT_IMAGE_NUMBER - 1; image >= 0; image--)
+    {
+        if (fast_read_header(image, &fast_hdr[image], &fa) != 0)
+        {
+            return -1;
+        }
+        if (image != 0)
+        {
+            flash_area_close(fa);
+        }
+    }
+
+    rsp->br_hdr = &fast_hdr[0];
+    rsp->br_flash_dev_id = fa->fa_device_id;
+    rsp->br_image_off = fa->fa_off;
+    flash_area_close(fa);
+
+    fast_stats.taken = 1U;
+    return 0;
+#else
+    (void)rsp;
+    return -1;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: boot_fast_get_stats
+ ******************************************************************************
+ * Summary:
+ *  Returns whether this boot took the fast path.
+ *
+ ******************************************************************************/
+const boot_fast_stats_t *boot_fast_get_stats(void)
+{
+    return &fast_stats;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,71 @@
+/******************************************************************************
+* File Name:   boot_handoff.c
+*
+* Description:
+* This file holds the block of RAM in which the bootloader leaves information
+* for the CM4 application. The linker script places it in the last bytes of
+* the bootloader RAM (section .cy_boot_shared), where the application finds it
+* at BOOT_SHARED_ADDR.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <string.h>
+
+#include "cy_pdl.h"
+#include "boot_handoff.h"
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+/* Not initialized by the startup code; boot_handoff_init() fills it in on
+ * every boot.
+ */
+CY_SECTION(".cy_boot_shared") boot_shared_t boot_handoff;
+
+/******************************************************************************
+ * Function Name: boot_handoff_init
+ ******************************************************************************
+ * Summary:
+ *  Clears what a previous boot left in the block and marks it valid for
+ *  this boot. Fields stay 0 until the bootloader decides them.
+ *
+ ******************************************************************************/
+void boot_handoff_init(void)
+{
+    (void)memset(&boot_handoff, 0, sizeof(boot_handoff));
+    boot_handoff.magic = BOOT_SHARED_MAGIC;
+    boot_handoff.version = BOOT_SHARED_VERSION;
+    boot_handoff.size = (uint16_t)sizeof(boot_handoff);
+}
+
+/* [] END OF FILE */
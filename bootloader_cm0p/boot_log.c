@@ -0,0 +1,454 @@
+/******************************************************************************
+* File Name:   boot_log.c
+*
+* Description:
+* This file implements the bootloader log output. Lines go into a ring in the
+* shared RAM block and the UART sends them by DMA while the bootloader goes on
+* (boot_log_dma.c). When CM4 is started, the bytes not yet sent stay in the
+* block and the application prints them, so the bootloader does not wait for
+* the UART. Lines are text, or tokens with CY_BOOT_LOG_TOKENIZED.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cy_pdl.h"
+#include "boot_handoff.h"
+#include "boot_log.h"
+#include "boot_log_dma.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Longest line boot_log_printf() formats; longer lines are cut. */
+#ifndef CY_BOOT_LOG_LINE_MAX
+#define CY_BOOT_LOG_LINE_MAX                    (160U)
+#endif
+
+#define LOG_RING_SIZE                           (BOOT_SHARED_LOG_SIZE)
+
+/* The bytes just behind the tail may still wait in the UART TX FIFO and
+ * are kept for the application until CM4 is started.
+ */
+#define LOG_RING_ROOM                           (LOG_RING_SIZE - BOOT_LOG_DMA_FIFO_SIZE)
+
+/* Longest value in a tokenized line. */
+#define LOG_VARINT_MAX                          (5U)
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+/* The ring is boot_handoff.log. The counts run free; the difference of two
+ * is a length and their remainder by LOG_RING_SIZE is an offset.
+ */
+static uint32_t log_head;           /* Bytes written to the ring */
+static uint32_t log_tail;           /* Bytes moved to the UART */
+static uint32_t log_xfer;           /* Bytes of the transfer from log_tail, 0 if none */
+static bool log_dma_ok;
+static boot_log_stats_t log_stats;
+
+#if (CY_BOOT_LOG_TOKENIZED != 0)
+/* Start of the format strings; the linker defines it (BOOT_LOG_TOKEN()). */
+extern const char __start_boot_log_fmt[];
+#endif
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static void log_kick(void);
+static void log_put(const uint8_t *line, uint32_t len);
+#if (CY_BOOT_LOG_TOKENIZED != 0)
+static uint32_t log_put_varint(uint8_t *buf, uint32_t value);
+#endif
+#if (CY_BOOT_LOG_ASYNC != 0)
+static void log_reverse(uint8_t *buf, uint32_t len);
+#endif
+
+/******************************************************************************
+ * Function Name: log_kick
+ ******************************************************************************
+ * Summary:
+ *  Retires the DMA transfer once it has moved its bytes to the UART, and
+ *  starts the next one from the ring. A transfer ends at the end of the
+ *  ring. Called from the DMA interrupt, and with the interrupt masked.
+ *
+ ******************************************************************************/
+static void log_kick(void)
+{
+    uint32_t len;
+    uint32_t off;
+
+    if (log_xfer != 0U)
+    {
+        if (boot_log_dma_busy())
+        {
+            return;
+        }
+        log_tail += log_xfer;
+        log_stats.sent += log_xfer;
+        log_xfer = 0U;
+    }
+
+    len = log_head - log_tail;
+    if ((len != 0U) && log_dma_ok)
+    {
+        off = log_tail % LOG_RING_SIZE;
+        if (len > (LOG_RING_SIZE - off))
+        {
+            len = LOG_RING_SIZE - off;
+        }
+        if (len > BOOT_LOG_DMA_MAX_LEN)
+        {
+            len = BOOT_LOG_DMA_MAX_LEN;
+        }
+        if (boot_log_dma_start(&boot_handoff.log[off], len) == 0)
+        {
+            log_xfer = len;
+        }
+    }
+}
+
+#if (CY_BOOT_LOG_ASYNC != 0)
+/******************************************************************************
+ * Function Name: log_reverse
+ ******************************************************************************
+ * Summary:
+ *  Reverses the bytes of buf in place.
+ *
+ ******************************************************************************/
+static void log_reverse(uint8_t *buf, uint32_t len)
+{
+    uint32_t i;
+    uint8_t tmp;
+
+    for (i = 0U; i < (len / 2U); i++)
+    {
+        tmp = buf[i];
+        buf[i] = buf[len - 1U - i];
+        buf[len - 1U - i] = tmp;
+    }
+}
+#endif
+
+/******************************************************************************
+ * Function Name: boot_log_init
+ ******************************************************************************
+ * Summary:
+ *  Sets up the DMA transfers to the UART. Called once retarget-io has set
+ *  up the UART; lines logged before are kept and sent from here. Without
+ *  the DMA the ring still fills up and is handed to the application.
+ *
+ ******************************************************************************/
+void boot_log_init(void)
+{
+#if (CY_BOOT_LOG_ASYNC != 0)
+    uint32_t irq = Cy_SysLib_EnterCriticalSection();
+
+    log_dma_ok = (boot_log_dma_init(log_kick) == 0);
+    log_kick();
+    Cy_SysLib_ExitCriticalSection(irq);
+#endif
+}
+
+/******************************************************************************
+ * Function Name: log_put
+ ******************************************************************************
+ * Summary:
+ *  Copies one line into the ring and starts sending it if the UART is idle.
+ *  If the ring is full, waits for the UART while it sends; a line that
+ *  still does not fit is dropped.
+ *
+ ******************************************************************************/
+static void log_put(const uint8_t *line, uint32_t len)
+{
+    uint32_t irq = Cy_SysLib_EnterCriticalSection();
+    uint32_t off;
+    uint32_t part;
+
+    log_stats.written += len;
+    if ((LOG_RING_ROOM - (log_head - log_tail)) < len)
+    {
+        log_stats.full_waits++;
+        log_kick();
+        while (((LOG_RING_ROOM - (log_head - log_tail)) < len) && (log_xfer != 0U))
+        {
+            log_kick();
+        }
+    }
+
+    if ((LOG_RING_ROOM - (log_head - log_tail)) < len)
+    {
+        log_stats.dropped += len;
+    }
+    else
+    {
+        off = log_head % LOG_RING_SIZE;
+        part = LOG_RING_SIZE - off;
+        if (part > len)
+        {
+            part = len;
+        }
+        (void)memcpy(&boot_handoff.log[off], line, part);
+        (void)memcpy(&boot_handoff.log[0], &line[part], len - part);
+        log_head += len;
+
+        if (log_xfer == 0U)
+        {
+            log_kick();
+        }
+    }
+    Cy_SysLib_ExitCriticalSection(irq);
+}
+
+#if (CY_BOOT_LOG_TOKENIZED != 0)
+/******************************************************************************
+ * Function Name: log_put_varint
+ ******************************************************************************
+ * Summary:
+ *  Writes value 7 bits at a time, lowest first, with the top bit set in
+ *  all but the last byte.
+ *
+ * Return:
+ *  Bytes written, at most 5.
+ *
+ ******************************************************************************/
+static uint32_t log_put_varint(uint8_t *buf, uint32_t value)
+{
+    uint32_t len = 0U;
+
+    while (value >= 0x80U)
+    {
+        buf[len] = (uint8_t)(value | 0x80U);
+        len++;
+        value >>= 7;
+    }
+    buf[len] = (uint8_t)value;
+
+    return len + 1U;
+}
+#endif
+
+/******************************************************************************
+ * Function Name: boot_log_printf
+ ******************************************************************************
+ * Summary:
+ *  Logs one line of text. Lines longer than CY_BOOT_LOG_LINE_MAX are cut.
+ *
+ * Return:
+ *  Length of the formatted line, negative on a formatting error.
+ *
+ ******************************************************************************/
+int boot_log_printf(const char *fmt, ...)
+{
+    char line[CY_BOOT_LOG_LINE_MAX];
+    va_list args;
+    int ret;
+    uint32_t len;
+
+    va_start(args, fmt);
+    ret = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    len = (uint32_t)ret;
+    if (len >= sizeof(line))
+    {
+        /* Keep the line end of a cut line. */
+        len = sizeof(line) - 1U;
+        line[len - 2U] = '\n';
+        line[len - 1U] = '\r';
+    }
+    log_put((const uint8_t *)line, len);
+
+    return ret;
+}
+
+/******************************************************************************
+ * Function Name: boot_log_tokenized
+ ******************************************************************************
+ * Summary:
+ *  Logs one line as BOOT_LOG_TOKEN_MARK, the offset of fmt in the
+ *  boot_log_fmt section, and the arguments: values as in
+ *  log_put_varint(), strings with a NUL at the end. Strings are cut so the
+ *  line fits in CY_BOOT_LOG_LINE_MAX.
+ *
+ * Parameters:
+ *  fmt   - Format string, placed in boot_log_fmt by BOOT_LOG_TOKEN().
+ *  types - BOOT_LOG_TYPES() of the arguments.
+ *
+ ******************************************************************************/
+void boot_log_tokenized(const char *fmt, uint32_t types, ...)
+{
+#if (CY_BOOT_LOG_TOKENIZED != 0)
+    uint8_t line[CY_BOOT_LOG_LINE_MAX];
+    uint32_t count = types & BOOT_LOG_TYPES_COUNT_MASK;
+    uint32_t len = 0U;
+    va_list args;
+    const char *str;
+    uint32_t room;
+    uint32_t i;
+
+    line[len] = BOOT_LOG_TOKEN_MARK;
+    len++;
+    len += log_put_varint(&line[len], (uint32_t)(fmt - __start_boot_log_fmt));
+
+    va_start(args, types);
+    for (i = 0U; i < count; i++)
+    {
+        if (((types >> (BOOT_LOG_TYPES_STR_POS + i)) & 1U) != 0U)
+        {
+            /* Leave room for the NUL and the values after the string. */
+            str = va_arg(args, const char *);
+            room = sizeof(line) - 1U - (LOG_VARINT_MAX * (count - i));
+            while ((str != NULL) && (*str != '\0') && (len < room))
+            {
+                line[len] = (uint8_t)*str;
+                len++;
+                str++;
+            }
+            line[len] = 0U;
+            len++;
+        }
+        else
+        {
+            len += log_put_varint(&line[len], va_arg(args, unsigned int));
+        }
+    }
+    va_end(args);
+
+    log_put(line, len);
+#else
+    (void)fmt;
+    (void)types;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: boot_log_flush
+ ******************************************************************************
+ * Summary:
+ *  Waits until the DMA has moved the ring to the UART. For the paths that
+ *  do not start CM4 and so hand nothing over.
+ *
+ ******************************************************************************/
+void boot_log_flush(void)
+{
+#if (CY_BOOT_LOG_ASYNC != 0)
+    uint32_t irq = Cy_SysLib_EnterCriticalSection();
+
+    log_kick();
+    while (log_xfer != 0U)
+    {
+        log_kick();
+    }
+    Cy_SysLib_ExitCriticalSection(irq);
+#endif
+}
+
+/******************************************************************************
+ * Function Name: boot_log_handoff
+ ******************************************************************************
+ * Summary:
+ *  Stops the DMA transfer and leaves the bytes the UART has not sent at the
+ *  start of boot_handoff.log for the application. Called right before CM4
+ *  is started, in place of waiting for the UART.
+ *
+ ******************************************************************************/
+void boot_log_handoff(void)
+{
+#if (CY_BOOT_LOG_ASYNC != 0)
+    uint32_t irq = Cy_SysLib_EnterCriticalSection();
+    uint32_t unsent;
+    uint32_t len;
+    uint32_t off;
+
+    /* The UART had not sent the end of the transfer, and maybe the end of
+     * the ones before it from its FIFO.
+     */
+    unsent = boot_log_dma_stop();
+    if (unsent > (log_xfer + BOOT_LOG_DMA_FIFO_SIZE))
+    {
+        unsent = log_xfer + BOOT_LOG_DMA_FIFO_SIZE;
+    }
+    if (unsent > (log_tail + log_xfer))
+    {
+        unsent = log_tail + log_xfer;
+    }
+    log_tail += log_xfer;
+    log_stats.sent += log_xfer;
+    log_xfer = 0U;
+    log_tail -= unsent;
+    log_stats.sent -= unsent;
+
+    len = log_head - log_tail;
+    off = log_tail % LOG_RING_SIZE;
+    if ((off + len) <= LOG_RING_SIZE)
+    {
+        (void)memmove(&boot_handoff.log[0], &boot_handoff.log[off], len);
+    }
+    else
+    {
+        /* Rotate the ring left by off. */
+        log_reverse(&boot_handoff.log[0], off);
+        log_reverse(&boot_handoff.log[off], LOG_RING_SIZE - off);
+        log_reverse(&boot_handoff.log[0], LOG_RING_SIZE);
+    }
+
+    log_stats.handed = len;
+    boot_handoff.log_len = (uint16_t)len;
+    boot_handoff.log_dropped = (log_stats.dropped > UINT16_MAX) ?
+                               UINT16_MAX : (uint16_t)log_stats.dropped;
+    Cy_SysLib_ExitCriticalSection(irq);
+#endif
+}
+
+/******************************************************************************
+ * Function Name: boot_log_get_stats
+ ******************************************************************************
+ * Summary:
+ *  Returns the log output of this boot.
+ *
+ ******************************************************************************/
+const boot_log_stats_t *boot_log_get_stats(void)
+{
+    return &log_stats;
+}
+
+/* [] END OF FILE */
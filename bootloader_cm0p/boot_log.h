@@ -0,0 +1,125 @@
+/******************************************************************************
+* File Name:   boot_log.h
+*
+* Description:
+* This file declares the bootloader log output, which the UART sends by DMA
+* while the bootloader runs (boot_log.c), as text or as tokens.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef BOOT_LOG_H_
+#define BOOT_LOG_H_
+
+#include <stdint.h>
+
+/* Log through boot_log_printf(): the UART sends by DMA from a ring in the
+ * shared RAM block, and what it has not sent when CM4 starts is handed to
+ * the application. Set to 0 to print with the blocking retarget-io output
+ * and wait for it before starting CM4.
+ */
+#ifndef CY_BOOT_LOG_ASYNC
+#define CY_BOOT_LOG_ASYNC                       (1)
+#endif
+
+/* Log tokens instead of text: a line is the token of its format string and
+ * its arguments in binary, and the format strings are left out of the flash
+ * image (section boot_log_fmt). script/boot_log_decode.py turns the output
+ * back into text with the bootloader ELF file.
+ */
+#ifndef CY_BOOT_LOG_TOKENIZED
+#define CY_BOOT_LOG_TOKENIZED                   (0)
+#endif
+
+#if (CY_BOOT_LOG_TOKENIZED != 0) && (CY_BOOT_LOG_ASYNC == 0)
+#error "CY_BOOT_LOG_TOKENIZED needs CY_BOOT_LOG_ASYNC"
+#endif
+
+/* First byte of a tokenized line, followed by the token and the arguments.
+ * Never part of the text output.
+ */
+#define BOOT_LOG_TOKEN_MARK                     (0xC0U)
+
+/* boot_log_tokenized() `types`: the argument count, and one bit per
+ * argument that is a string.
+ */
+#define BOOT_LOG_TYPES_COUNT_MASK               (0x0FU)
+#define BOOT_LOG_TYPES_STR_POS                  (4U)
+
+/* Up to 8 arguments. Strings are sent as text, anything else as a 32-bit
+ * value.
+ */
+#define BOOT_LOG_ARG_STR(_x)    _Generic((_x), char *: 1U, const char *: 1U, default: 0U)
+#define BOOT_LOG_NARGS(...)     BOOT_LOG_NARGS_(0, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define BOOT_LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _n, ...) _n
+#define BOOT_LOG_STRS_0()       (0U)
+#define BOOT_LOG_STRS_1(_a)     (BOOT_LOG_ARG_STR(_a))
+#define BOOT_LOG_STRS_2(_a, ...) (BOOT_LOG_ARG_STR(_a) | (BOOT_LOG_STRS_1(__VA_ARGS__) << 1))
+#define BOOT_LOG_STRS_3(_a, ...) (BOOT_LOG_ARG_STR(_a) | (BOOT_LOG_STRS_2(__VA_ARGS__) << 1))
+#define BOOT_LOG_STRS_4(_a, ...) (BOOT_LOG_ARG_STR(_a) | (BOOT_LOG_STRS_3(__VA_ARGS__) << 1))
+#define BOOT_LOG_STRS_5(_a, ...) (BOOT_LOG_ARG_STR(_a) | (BOOT_LOG_STRS_4(__VA_ARGS__) << 1))
+#define BOOT_LOG_STRS_6(_a, ...) (BOOT_LOG_ARG_STR(_a) | (BOOT_LOG_STRS_5(__VA_ARGS__) << 1))
+#define BOOT_LOG_STRS_7(_a, ...) (BOOT_LOG_ARG_STR(_a) | (BOOT_LOG_STRS_6(__VA_ARGS__) << 1))
+#define BOOT_LOG_STRS_8(_a, ...) (BOOT_LOG_ARG_STR(_a) | (BOOT_LOG_STRS_7(__VA_ARGS__) << 1))
+#define BOOT_LOG_CAT_(_a, _b)   _a##_b
+#define BOOT_LOG_CAT(_a, _b)    BOOT_LOG_CAT_(_a, _b)
+#define BOOT_LOG_TYPES(...)                                                         \
+    (BOOT_LOG_NARGS(__VA_ARGS__) |                                                  \
+     (BOOT_LOG_CAT(BOOT_LOG_STRS_, BOOT_LOG_NARGS(__VA_ARGS__))(__VA_ARGS__) <<     \
+      BOOT_LOG_TYPES_STR_POS))
+
+/* Logs one line as a token. The format string only goes to the ELF file. */
+#define BOOT_LOG_TOKEN(_fmt, ...)                                                   \
+    do {                                                                            \
+        static const char boot_log_fmt_[]                                           \
+            __attribute__((section("boot_log_fmt"), used)) = _fmt;                  \
+        boot_log_tokenized(boot_log_fmt_, BOOT_LOG_TYPES(__VA_ARGS__), ##__VA_ARGS__); \
+    } while (0)
+
+/* Log output of this boot, in bytes. */
+typedef struct
+{
+    uint32_t written;               /* Bytes logged */
+    uint32_t sent;                  /* Bytes the UART sent */
+    uint32_t handed;                /* Bytes handed to the application */
+    uint32_t dropped;               /* Bytes lost for lack of room */
+    uint32_t full_waits;            /* Lines that waited for room in the ring */
+} boot_log_stats_t;
+
+void boot_log_init(void);
+int boot_log_printf(const char *fmt, ...);
+void boot_log_tokenized(const char *fmt, uint32_t types, ...);
+void boot_log_flush(void);
+void boot_log_handoff(void);
+const boot_log_stats_t *boot_log_get_stats(void);
+
+#endif /* BOOT_LOG_H_ */
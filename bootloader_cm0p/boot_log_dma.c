@@ -0,0 +1,297 @@
+/******************************************************************************
+* File Name:   boot_log_dma.c
+*
+* Description:
+* This file feeds the bootloader log to the UART with a DataWire channel. The
+* UART TX FIFO requests a byte whenever it has room, so the CPU only starts a
+* transfer; the channel interrupt starts the next one (boot_log.c).
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cy_pdl.h"
+#include "cycfg_peripherals.h"
+
+#include "boot_log_dma.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* DataWire channel the TX request of the debug UART (SCB5 on the kits)
+ * triggers through the one-to-one trigger group. Override all three for a
+ * board with its debug UART on another SCB.
+ */
+#ifndef CY_BOOT_LOG_DMA_HW
+#define CY_BOOT_LOG_DMA_HW                      (DW0)
+#endif
+#ifndef CY_BOOT_LOG_DMA_CHANNEL
+#define CY_BOOT_LOG_DMA_CHANNEL                 (26UL)
+#endif
+#ifndef CY_BOOT_LOG_DMA_TRIGGER
+#define CY_BOOT_LOG_DMA_TRIGGER                 (TRIG_OUT_1TO1_0_SCB5_TX_TO_PDMA0_TR_IN26)
+#endif
+#ifndef CY_BOOT_LOG_DMA_IRQ
+#define CY_BOOT_LOG_DMA_IRQ                     (cpuss_interrupts_dw0_26_IRQn)
+#endif
+
+/* CM0+ NVIC line the channel interrupt is routed to. */
+#ifndef CY_BOOT_LOG_DMA_NVIC_MUX
+#define CY_BOOT_LOG_DMA_NVIC_MUX                (NvicMux3_IRQn)
+#endif
+
+/* Longest wait for the character in the TX shifter when a transfer is
+ * stopped: 10 bits at 115200 baud take 87 us.
+ */
+#define LOG_DMA_SHIFTER_TIMEOUT_US              (200UL)
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+static cy_stc_dma_descriptor_t log_dma_descr;
+static uint32_t log_dma_len;        /* Bytes of the transfer started last, 0 if none */
+static boot_log_dma_done_t log_dma_done;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static bool log_dma_retire(void);
+static void log_dma_isr(void);
+
+/******************************************************************************
+ * Function Name: log_dma_retire
+ ******************************************************************************
+ * Summary:
+ *  Releases the channel once the transfer has moved all its bytes to the
+ *  TX FIFO.
+ *
+ * Return:
+ *  true if no transfer is running any more.
+ *
+ ******************************************************************************/
+static bool log_dma_retire(void)
+{
+    if (log_dma_len == 0UL)
+    {
+        return true;
+    }
+    if ((Cy_DMA_Channel_GetInterruptStatus(CY_BOOT_LOG_DMA_HW, CY_BOOT_LOG_DMA_CHANNEL) &
+         CY_DMA_INTR_MASK) == 0UL)
+    {
+        return false;
+    }
+
+    Cy_DMA_Channel_Disable(CY_BOOT_LOG_DMA_HW, CY_BOOT_LOG_DMA_CHANNEL);
+    Cy_DMA_Channel_ClearInterrupt(CY_BOOT_LOG_DMA_HW, CY_BOOT_LOG_DMA_CHANNEL);
+    log_dma_len = 0UL;
+
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: log_dma_isr
+ ******************************************************************************
+ * Summary:
+ *  Channel interrupt: lets boot_log.c start the next transfer.
+ *
+ ******************************************************************************/
+static void log_dma_isr(void)
+{
+    if ((log_dma_len != 0UL) && log_dma_retire() && (log_dma_done != NULL))
+    {
+        log_dma_done();
+    }
+}
+
+/******************************************************************************
+ * Function Name: boot_log_dma_init
+ ******************************************************************************
+ * Summary:
+ *  Routes the UART TX request to the DataWire channel, lets the UART
+ *  request data as long as its TX FIFO has room, and hooks the channel
+ *  interrupt.
+ *
+ * Parameters:
+ *  done - Called from the interrupt of each finished transfer.
+ *
+ * Return:
+ *  0 on success, -1 if the trigger or the interrupt cannot be set up.
+ *
+ ******************************************************************************/
+int boot_log_dma_init(boot_log_dma_done_t done)
+{
+    const cy_stc_sysint_t irq =
+    {
+        .intrSrc = CY_BOOT_LOG_DMA_NVIC_MUX,
+        .cm0pSrc = CY_BOOT_LOG_DMA_IRQ,
+        .intrPriority = 3UL,
+    };
+
+    if (Cy_TrigMux_Select(CY_BOOT_LOG_DMA_TRIGGER, false, TRIGGER_TYPE_LEVEL) != CY_TRIGMUX_SUCCESS)
+    {
+        return -1;
+    }
+    if (Cy_SysInt_Init(&irq, log_dma_isr) != CY_SYSINT_SUCCESS)
+    {
+        return -1;
+    }
+    log_dma_done = done;
+
+    Cy_SCB_UART_SetTxFifoLevel(CYBSP_UART_HW, Cy_SCB_GetFifoSize(CYBSP_UART_HW) - 1UL);
+    Cy_DMA_Enable(CY_BOOT_LOG_DMA_HW);
+    log_dma_len = 0UL;
+    NVIC_EnableIRQ(CY_BOOT_LOG_DMA_NVIC_MUX);
+
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: boot_log_dma_start
+ ******************************************************************************
+ * Summary:
+ *  Starts sending len bytes from src, one byte per UART request. The bytes
+ *  must stay in place until boot_log_dma_busy() returns false or the done
+ *  callback runs.
+ *
+ * Return:
+ *  0 on success, -1 if a transfer is still running or len does not fit.
+ *
+ ******************************************************************************/
+int boot_log_dma_start(const uint8_t *src, uint32_t len)
+{
+    cy_stc_dma_descriptor_config_t config = {0};
+    cy_stc_dma_channel_config_t channel = {0};
+
+    if ((len == 0UL) || (len > BOOT_LOG_DMA_MAX_LEN) || boot_log_dma_busy())
+    {
+        return -1;
+    }
+
+    /* The request is a level: wait 4 cycles after each write for the FIFO
+     * level to update.
+     */
+    config.retrigger = CY_DMA_RETRIG_4CYC;
+    config.interruptType = CY_DMA_DESCR;
+    config.triggerOutType = CY_DMA_DESCR;
+    config.channelState = CY_DMA_CHANNEL_DISABLED;
+    config.triggerInType = CY_DMA_1ELEMENT;
+    config.dataSize = CY_DMA_BYTE;
+    config.srcTransferSize = CY_DMA_TRANSFER_SIZE_DATA;
+    config.dstTransferSize = CY_DMA_TRANSFER_SIZE_WORD;
+    config.descriptorType = CY_DMA_1D_TRANSFER;
+    config.srcAddress = (void *)src;
+    config.dstAddress = (void *)&SCB_TX_FIFO_WR(CYBSP_UART_HW);
+    config.srcXincrement = 1L;
+    config.dstXincrement = 0L;
+    config.xCount = len;
+    config.nextDescriptor = NULL;
+
+    channel.descriptor = &log_dma_descr;
+    channel.preemptable = false;
+    channel.priority = 3UL;
+    channel.enable = false;
+    channel.bufferable = false;
+
+    if ((Cy_DMA_Descriptor_Init(&log_dma_descr, &config) != CY_DMA_SUCCESS) ||
+        (Cy_DMA_Channel_Init(CY_BOOT_LOG_DMA_HW, CY_BOOT_LOG_DMA_CHANNEL, &channel) != CY_DMA_SUCCESS))
+    {
+        return -1;
+    }
+
+    Cy_DMA_Channel_ClearInterrupt(CY_BOOT_LOG_DMA_HW, CY_BOOT_LOG_DMA_CHANNEL);
+    Cy_DMA_Channel_SetInterruptMask(CY_BOOT_LOG_DMA_HW, CY_BOOT_LOG_DMA_CHANNEL, CY_DMA_INTR_MASK);
+    log_dma_len = len;
+    Cy_DMA_Channel_Enable(CY_BOOT_LOG_DMA_HW, CY_BOOT_LOG_DMA_CHANNEL);
+
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: boot_log_dma_busy
+ ******************************************************************************
+ * Summary:
+ *  Checks whether the transfer started last still reads its bytes.
+ *
+ * Return:
+ *  true while the bytes of the transfer are needed.
+ *
+ ******************************************************************************/
+bool boot_log_dma_busy(void)
+{
+    return !log_dma_retire();
+}
+
+/******************************************************************************
+ * Function Name: boot_log_dma_stop
+ ******************************************************************************
+ * Summary:
+ *  Stops the transfer, drops what is left in the TX FIFO, and lets the
+ *  character in the shifter finish so the line does not get a broken byte.
+ *  Leaves the DataWire block and its interrupt disabled for the
+ *  application.
+ *
+ * Return:
+ *  Bytes the UART has not sent: the rest of the transfer and the TX FIFO.
+ *
+ ******************************************************************************/
+uint32_t boot_log_dma_stop(void)
+{
+    uint32_t unsent = 0UL;
+    uint32_t waited = 0UL;
+
+    NVIC_DisableIRQ(CY_BOOT_LOG_DMA_NVIC_MUX);
+    Cy_DMA_Channel_Disable(CY_BOOT_LOG_DMA_HW, CY_BOOT_LOG_DMA_CHANNEL);
+    if (!log_dma_retire())
+    {
+        unsent = log_dma_len -
+                 Cy_DMA_Channel_GetCurrentXloopIndex(CY_BOOT_LOG_DMA_HW, CY_BOOT_LOG_DMA_CHANNEL);
+    }
+    unsent += Cy_SCB_GetNumInTxFifo(CYBSP_UART_HW);
+    Cy_SCB_ClearTxFifo(CYBSP_UART_HW);
+
+    while (!Cy_SCB_IsTxComplete(CYBSP_UART_HW) && (waited < LOG_DMA_SHIFTER_TIMEOUT_US))
+    {
+        Cy_SysLib_DelayUs(1U);
+        waited++;
+    }
+
+    Cy_DMA_Channel_SetInterruptMask(CY_BOOT_LOG_DMA_HW, CY_BOOT_LOG_DMA_CHANNEL, 0UL);
+    Cy_DMA_Channel_ClearInterrupt(CY_BOOT_LOG_DMA_HW, CY_BOOT_LOG_DMA_CHANNEL);
+    log_dma_len = 0UL;
+    Cy_DMA_Disable(CY_BOOT_LOG_DMA_HW);
+
+    return unsent;
+}
+
+/* [] END OF FILE */
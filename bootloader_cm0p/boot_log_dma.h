@@ -0,0 +1,62 @@
+/******************************************************************************
+* File Name:   boot_log_dma.h
+*
+* Description:
+* This file declares the DMA transfers that feed the bootloader log to the
+* UART (boot_log_dma.c).
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef BOOT_LOG_DMA_H_
+#define BOOT_LOG_DMA_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Longest transfer: the X loop count of a DataWire descriptor. */
+#define BOOT_LOG_DMA_MAX_LEN                    (256U)
+
+/* Most bytes the UART TX FIFO holds: bytes a finished transfer moved out of
+ * the ring that may not have been sent yet.
+ */
+#define BOOT_LOG_DMA_FIFO_SIZE                  (128U)
+
+/* Called from the interrupt of a finished transfer. */
+typedef void (*boot_log_dma_done_t)(void);
+
+int boot_log_dma_init(boot_log_dma_done_t done);
+int boot_log_dma_start(const uint8_t *src, uint32_t len);
+bool boot_log_dma_busy(void);
+uint32_t boot_log_dma_stop(void);
+
+#endif /* BOOT_LOG_DMA_H_ */
@@ -0,0 +1,252 @@
+/******************************************************************************
+* File Name:   boot_timing.c
+*
+* Description:
+* This file times the boot phases with the CM0+ SysTick timer and records
+* them in the shared RAM block (shared/boot_shared.h), where the CM4
+* application can read and publish them. main() times its own steps; the
+* fast path, the slot validation and the slot flip time their parsing of the
+* headers of the images to boot; the flash backend times primary slot erases
+* and writes; and the checks MCUboot makes through bootutil_img_validate()
+* are timed by wrapping that function at link time (--wrap), as MCUboot
+* itself is not modified. The header reads inside boot_go() count towards
+* that phase.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cy_pdl.h"
+#include "flash_map_backend/flash_map_backend.h"
+#include "sysflash.h"
+#include "bootutil/image.h"
+
+#include "boot_handoff.h"
+#include "boot_timing.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#ifndef CY_BOOT_PHASE_TIMING
+#define CY_BOOT_PHASE_TIMING                    (1)
+#endif
+
+/* SysTick counts down through all 24 bits, then wraps. */
+#define TIMING_PERIOD                           (0x1000000UL)
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+#if (CY_BOOT_PHASE_TIMING != 0)
+static volatile uint32_t timing_wraps;
+#endif
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+#if (CY_BOOT_PHASE_TIMING != 0)
+static void timing_wrap(void);
+#endif
+int __real_bootutil_img_validate(struct enc_key_data *enc_state, int image_index,
+                                 struct image_header *hdr, const struct flash_area *fap,
+                                 uint8_t *tmp_buf, uint32_t tmp_buf_sz, uint8_t *seed,
+                                 int seed_len, uint8_t *out_hash);
+int __wrap_bootutil_img_validate(struct enc_key_data *enc_state, int image_index,
+                                 struct image_header *hdr, const struct flash_area *fap,
+                                 uint8_t *tmp_buf, uint32_t tmp_buf_sz, uint8_t *seed,
+                                 int seed_len, uint8_t *out_hash);
+
+#if (CY_BOOT_PHASE_TIMING != 0)
+/******************************************************************************
+ * Function Name: timing_wrap
+ ******************************************************************************
+ * Summary:
+ *  SysTick callback: counts the wraps of the 24-bit counter.
+ *
+ ******************************************************************************/
+static void timing_wrap(void)
+{
+    timing_wraps++;
+}
+#endif
+
+/******************************************************************************
+ * Function Name: boot_timing_init
+ ******************************************************************************
+ * Summary:
+ *  Starts the SysTick timer from the CPU clock. Called first thing in
+ *  main(), after boot_handoff_init(); the CM0+ clock is not changed by the
+ *  bootloader, so the rate stays valid until CM4 starts.
+ *
+ ******************************************************************************/
+void boot_timing_init(void)
+{
+#if (CY_BOOT_PHASE_TIMING != 0)
+    SystemCoreClockUpdate();
+    timing_wraps = 0U;
+    Cy_SysTick_Init(CY_SYSTICK_CLOCK_SOURCE_CLK_CPU, TIMING_PERIOD - 1U);
+    (void)Cy_SysTick_SetCallback(0U, timing_wrap);
+    boot_handoff.timer_hz = SystemCoreClock;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: boot_timing_now
+ ******************************************************************************
+ * Summary:
+ *  Returns the ticks since boot_timing_init().
+ *
+ ******************************************************************************/
+uint32_t boot_timing_now(void)
+{
+#if (CY_BOOT_PHASE_TIMING != 0)
+    uint32_t wraps;
+    uint32_t value;
+
+    /* Read again if the counter wrapped in between. */
+    do
+    {
+        wraps = timing_wraps;
+        value = Cy_SysTick_GetValue();
+    } while (wraps != timing_wraps);
+
+    return (wraps * TIMING_PERIOD) + ((TIMING_PERIOD - 1U) - value);
+#else
+    return 0U;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: boot_timing_image
+ ******************************************************************************
+ * Summary:
+ *  Returns the image whose slot is the area `fa_id`, BOOT_PHASE_NO_IMAGE if
+ *  it is not a slot.
+ *
+ ******************************************************************************/
+uint8_t boot_timing_image(uint8_t fa_id)
+{
+    if ((fa_id == FLASH_AREA_IMAGE_PRIMARY(0)) || (fa_id == FLASH_AREA_IMAGE_SECONDARY(0)))
+    {
+        return 0U;
+    }
+    if ((fa_id == FLASH_AREA_IMAGE_2) || (fa_id == FLASH_AREA_IMAGE_3))
+    {
+        return 1U;
+    }
+    return BOOT_PHASE_NO_IMAGE;
+}
+
+/******************************************************************************
+ * Function Name: boot_timing_add
+ ******************************************************************************
+ * Summary:
+ *  Adds the time from `start` to now to the entry of `phase` and `image`,
+ *  creating it if this is the first time the phase ran.
+ *
+ ******************************************************************************/
+void boot_timing_add(uint8_t phase, uint8_t image, uint32_t start)
+{
+#if (CY_BOOT_PHASE_TIMING != 0)
+    uint32_t now = boot_timing_now();
+    boot_phase_t *entry = NULL;
+
+    for (uint32_t i = 0; i < boot_handoff.phase_count; i++)
+    {
+        if ((boot_handoff.phases[i].phase == phase) && (boot_handoff.phases[i].image == image))
+        {
+            entry = &boot_handoff.phases[i];
+            break;
+        }
+    }
+
+    if (entry == NULL)
+    {
+        if (boot_handoff.phase_count >= BOOT_SHARED_PHASES_MAX)
+        {
+            boot_handoff.phase_dropped++;
+            return;
+        }
+        entry = &boot_handoff.phases[boot_handoff.phase_count++];
+        entry->phase = phase;
+        entry->image = image;
+        entry->start = start;
+    }
+    entry->count++;
+    entry->ticks += now - start;
+#else
+    (void)phase;
+    (void)image;
+    (void)start;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: boot_timing_deinit
+ ******************************************************************************
+ * Summary:
+ *  Records the total boot time and stops the timer, just before CM4 starts.
+ *
+ ******************************************************************************/
+void boot_timing_deinit(void)
+{
+#if (CY_BOOT_PHASE_TIMING != 0)
+    boot_handoff.boot_ticks = boot_timing_now();
+    Cy_SysTick_Disable();
+#endif
+}
+
+/******************************************************************************
+ * Function Name: __wrap_bootutil_img_validate
+ ******************************************************************************
+ * Summary:
+ *  Link-time wrapper of bootutil_img_validate() (see the Makefile), which
+ *  MCUboot and the upgrade passes call to check the hash and signature of
+ *  an image. Times each call as a check of the image in `fap`.
+ *
+ ******************************************************************************/
+int __wrap_bootutil_img_validate(struct enc_key_data *enc_state, int image_index,
+                                 struct image_header *hdr, const struct flash_area *fap,
+                                 uint8_t *tmp_buf, uint32_t tmp_buf_sz, uint8_t *seed,
+                                 int seed_len, uint8_t *out_hash)
+{
+    uint32_t start = boot_timing_now();
+    int rc = __real_bootutil_img_validate(enc_state, image_index, hdr, fap, tmp_buf,
+                                          tmp_buf_sz, seed, seed_len, out_hash);
+
+    boot_timing_add(BOOT_PHASE_IMAGE_CHECK, boot_timing_image(fap->fa_id), start);
+    return rc;
+}
+
+/* [] END OF FILE */
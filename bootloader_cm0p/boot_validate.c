@@ -0,0 +1,714 @@
+/******************************************************************************
+* File Name:   boot_validate.c
+*
+* Description:
+* This file validates the images in the primary slots before they are booted,
+* which MCUboot does on every boot when built with
+* MCUBOOT_VALIDATE_PRIMARY_SLOT, at the cost of hashing both slots each time.
+* Here an image is hashed in full (bootutil_img_validate()) only when no
+* record of it exists, i.e. once after it is installed. A record then holds
+* the image header, its SHA-256 TLV and a keyed digest of every block of the
+* image, and ends with an HMAC-SHA256 under a key derived from
+* CY_BOOT_VALIDATE_KEY and the device unique ID. Later boots check the
+* header and the TLV against the record, and re-hash CY_BOOT_VALIDATE_SAMPLES
+* blocks; the sampled blocks move on every boot, so the whole image is
+* covered over successive boots. With the Wi-Fi slot flip, the image 2 slot
+* the bootloader picks is checked the same way (upgrade_slot_flip.c).
+*
+* The key is built into the bootloader, whose flash the CM4 application can
+* read, and the unique ID is readable too. The record therefore detects a
+* corrupted image or record, not tampering: code on CM4 that can write a
+* primary slot and the validation area can also write a record that makes
+* a modified image pass.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "flash_map_backend/flash_map_backend.h"
+#include "sysflash.h"
+#include "mcuboot_config/mcuboot_config.h"
+#include "bootutil/bootutil.h"
+#include "bootutil/image.h"
+#include "bootutil/bootutil_log.h"
+
+#include "cy_pdl.h"
+#include "ext_flash_map.h"
+#include "boot_crypto.h"
+#include "boot_timing.h"
+#include "boot_validate.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#ifndef CY_BOOT_VALIDATE_CACHED
+#if defined(MCUBOOT_VALIDATE_PRIMARY_SLOT)
+/* MCUboot hashes the primary slots on every boot already. */
+#define CY_BOOT_VALIDATE_CACHED                 (0)
+#else
+#define CY_BOOT_VALIDATE_CACHED                 (1)
+#endif
+#endif
+
+#ifndef CY_BOOT_VALIDATE_KEY
+/* Value the record key is derived from. It is not secret from the CM4
+ * application, see the file header.
+ */
+#define CY_BOOT_VALIDATE_KEY                    "CE231678 sample validation key"
+#endif
+
+#ifndef CY_BOOT_VALIDATE_SAMPLES
+/* Blocks of each image re-hashed on a boot with a valid record. */
+#define CY_BOOT_VALIDATE_SAMPLES                (4U)
+#endif
+
+#ifndef CY_BOOT_VALIDATE_BREG
+/* Backup register counting boots, which selects the sampled blocks. It keeps
+ * its value across resets; the count restarts at 0 when the backup domain
+ * loses power, which only repeats some samples.
+ */
+#define CY_BOOT_VALIDATE_BREG                   (15U)
+#endif
+
+#define VALIDATE_MAGIC                          (0x444C4156UL)
+
+#define VALIDATE_HASH_SIZE                      (32U)
+
+/* Blocks per record; block sizes are powers of two of at least 4 KB. */
+#define VALIDATE_BLOCKS_MAX                     (96U)
+#define VALIDATE_BLOCK_SHIFT_MIN                (12U)
+
+/* Same size as the buffer MCUboot validates images with. */
+#define VALIDATE_TMP_BUF_SIZE                   (256U)
+
+/* Row index meaning no record. */
+#define VALIDATE_NO_ROW                         (0xFFFFFFFFUL)
+
+/* Slots with a record: the primary slot of each image MCUboot manages and,
+ * with the Wi-Fi slot flip, both image 2 slots.
+ */
+#if defined(CY_BOOT_WIFI_SLOT_FLIP)
+#define VALIDATE_SLOTS                          (MCUBOOT_IMAGE_NUMBER + 2U)
+#else
+#define VALIDATE_SLOTS                          (MCUBOOT_IMAGE_NUMBER)
+#endif
+
+/*******************************************************************************
+* Data types
+********************************************************************************/
+/* Validation record of one slot, stored at the start of a row of the
+ * validation area (500 bytes).
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t seq;                                   /* Incremented per record */
+    uint32_t fa_id;                                 /* Slot validated */
+    uint32_t size;                                  /* Header, image and TLVs */
+    uint32_t block_shift;                           /* log2 of the block size */
+    struct image_header hdr;                        /* Header of the image */
+    uint8_t hash[VALIDATE_HASH_SIZE];               /* Its SHA-256 TLV */
+    uint32_t digest[VALIDATE_BLOCKS_MAX];           /* Keyed digest per block */
+    uint8_t mac[VALIDATE_HASH_SIZE];                /* HMAC of the fields above */
+} validate_rec_t;
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+#if (CY_BOOT_VALIDATE_CACHED != 0)
+static struct
+{
+    bool loaded;                /* Records read and key derived this boot */
+    uint32_t boot_count;        /* Selects the sampled blocks */
+    uint32_t seq;               /* Sequence number of the latest record */
+    uint32_t row;               /* Row holding it */
+    validate_rec_t rec[VALIDATE_SLOTS];         /* Latest per slot, magic 0 if none */
+    uint32_t rec_row[VALIDATE_SLOTS];           /* Rows holding them */
+} validate;
+
+static uint8_t validate_key[VALIDATE_HASH_SIZE];
+static uint32_t validate_row_buf[CY_FLASH_SIZEOF_ROW / sizeof(uint32_t)];
+#endif
+/* Shared by the full validations of all upgrade passes. */
+static uint8_t validate_tmp_buf[VALIDATE_TMP_BUF_SIZE];
+static boot_validate_stats_t validate_stats;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+#if (CY_BOOT_VALIDATE_CACHED != 0)
+static void validate_key_init(void);
+static uint32_t validate_slot_index(uint32_t fa_id);
+static void validate_load(void);
+static uint32_t validate_block_len(uint32_t block_shift, uint32_t size, uint32_t block);
+static int validate_block_digest(const struct flash_area *fa, uint32_t block_shift,
+                                 uint32_t size, uint32_t block, uint32_t *digest);
+static bool validate_sampled(const struct flash_area *fa, const validate_rec_t *rec,
+                             uint32_t boot_count);
+static void validate_record(uint32_t slot, const struct flash_area *fa,
+                            const struct image_header *hdr, const uint8_t *hash, uint32_t size);
+static void validate_init(void);
+#endif
+
+#if (CY_BOOT_VALIDATE_CACHED != 0)
+/******************************************************************************
+ * Function Name: validate_key_init
+ ******************************************************************************
+ * Summary:
+ *  Derives the record key of this device: the SHA-256 of
+ *  CY_BOOT_VALIDATE_KEY followed by the unique ID, so that a record copied
+ *  from another device does not verify.
+ *
+ ******************************************************************************/
+static void validate_key_init(void)
+{
+    boot_sha256_context sha;
+    uint64_t uid = Cy_SysLib_GetUniqueId();
+
+    (void)boot_sha256_start(&sha);
+    (void)boot_sha256_update(&sha, CY_BOOT_VALIDATE_KEY, sizeof(CY_BOOT_VALIDATE_KEY) - 1U);
+    (void)boot_sha256_update(&sha, &uid, sizeof(uid));
+    (void)boot_sha256_finish(&sha, validate_key);
+    boot_sha256_free(&sha);
+}
+
+/******************************************************************************
+ * Function Name: validate_slot_index
+ ******************************************************************************
+ * Summary:
+ *  Returns the index of the record of the slot `fa_id`, or VALIDATE_SLOTS if
+ *  the slot has none.
+ *
+ ******************************************************************************/
+static uint32_t validate_slot_index(uint32_t fa_id)
+{
+    for (uint32_t i = 0; i < MCUBOOT_IMAGE_NUMBER; i++)
+    {
+        if (fa_id == (uint32_t)FLASH_AREA_IMAGE_PRIMARY(i))
+        {
+            return i;
+        }
+    }
+#if defined(CY_BOOT_WIFI_SLOT_FLIP)
+    if (fa_id == FLASH_AREA_IMAGE_2)
+    {
+        return MCUBOOT_IMAGE_NUMBER;
+    }
+    if (fa_id == FLASH_AREA_IMAGE_3)
+    {
+        return MCUBOOT_IMAGE_NUMBER + 1U;
+    }
+#endif
+    return VALIDATE_SLOTS;
+}
+
+/******************************************************************************
+ * Function Name: validate_load
+ ******************************************************************************
+ * Summary:
+ *  Finds the latest authentic record of each slot in the rows of the
+ *  validation area, and the latest record overall.
+ *
+ ******************************************************************************/
+static void validate_load(void)
+{
+    const struct flash_area *fa;
+    const validate_rec_t *rec = (const validate_rec_t *)validate_row_buf;
+    uint8_t mac[VALIDATE_HASH_SIZE];
+    uint32_t i;
+
+    validate.seq = 0U;
+    validate.row = VALIDATE_NO_ROW;
+    for (i = 0; i < VALIDATE_SLOTS; i++)
+    {
+        validate.rec[i].magic = 0U;
+        validate.rec_row[i] = VALIDATE_NO_ROW;
+    }
+
+    if (flash_area_open(FLASH_AREA_VALIDATION, &fa) != 0)
+    {
+        return;
+    }
+
+    for (uint32_t row = 0; row < (fa->fa_size / CY_FLASH_SIZEOF_ROW); row++)
+    {
+        if ((flash_area_read(fa, row * CY_FLASH_SIZEOF_ROW, validate_row_buf,
+                             sizeof(validate_rec_t)) != 0) ||
+            (rec->magic != VALIDATE_MAGIC))
+        {
+            continue;
+        }
+        boot_hmac_sha256(validate_key, rec, offsetof(validate_rec_t, mac), mac);
+        if (!boot_crypto_equal(mac, rec->mac, sizeof(mac)))
+        {
+            continue;
+        }
+
+        if ((validate.row == VALIDATE_NO_ROW) || ((int32_t)(rec->seq - validate.seq) > 0))
+        {
+            validate.seq = rec->seq;
+            validate.row = row;
+        }
+
+        i = validate_slot_index(rec->fa_id);
+        if ((i < VALIDATE_SLOTS) &&
+            ((validate.rec[i].magic == 0U) || ((int32_t)(rec->seq - validate.rec[i].seq) > 0)))
+        {
+            validate.rec[i] = *rec;
+            validate.rec_row[i] = row;
+        }
+    }
+    flash_area_close(fa);
+}
+
+/******************************************************************************
+ * Function Name: validate_block_len
+ ******************************************************************************
+ * Summary:
+ *  Returns the length of block `block` of an image spanning `size` bytes;
+ *  the last block may be short.
+ *
+ ******************************************************************************/
+static uint32_t validate_block_len(uint32_t block_shift, uint32_t size, uint32_t block)
+{
+    uint32_t off = block << block_shift;
+
+    return ((size - off) < (1UL << block_shift)) ? (size - off) : (1UL << block_shift);
+}
+
+/******************************************************************************
+ * Function Name: validate_block_digest
+ ******************************************************************************
+ * Summary:
+ *  Computes the digest of block `block` of the image in `fa`: the first word
+ *  of the SHA-256 of the record key, the slot, the block index and the block
+ *  contents. Without the key, a block cannot be changed to match it.
+ *
+ * Return:
+ *  0 on success, -1 if the slot could not be read.
+ *
+ ******************************************************************************/
+static int validate_block_digest(const struct flash_area *fa, uint32_t block_shift,
+                                 uint32_t size, uint32_t block, uint32_t *digest)
+{
+    boot_sha256_context sha;
+    uint8_t hash[VALIDATE_HASH_SIZE];
+    uint32_t prefix[2] = { fa->fa_id, block };
+    uint32_t off = block << block_shift;
+    uint32_t end = off + validate_block_len(block_shift, size, block);
+    int rc;
+
+    rc = boot_sha256_start(&sha);
+    if (rc == 0)
+    {
+        rc = boot_sha256_update(&sha, validate_key, sizeof(validate_key));
+    }
+    if (rc == 0)
+    {
+        rc = boot_sha256_update(&sha, prefix, sizeof(prefix));
+    }
+    while ((rc == 0) && (off < end))
+    {
+        uint32_t chunk = ((end - off) < sizeof(validate_tmp_buf)) ? (end - off) :
+                         sizeof(validate_tmp_buf);
+
+        rc = flash_area_read(fa, off, validate_tmp_buf, chunk);
+        if (rc == 0)
+        {
+            rc = boot_sha256_update(&sha, validate_tmp_buf, chunk);
+        }
+        off += chunk;
+    }
+    if (rc == 0)
+    {
+        rc = boot_sha256_finish(&sha, hash);
+    }
+    boot_sha256_free(&sha);
+
+    memcpy(digest, hash, sizeof(*digest));
+    return (rc == 0) ? 0 : -1;
+}
+
+/******************************************************************************
+ * Function Name: validate_sampled
+ ******************************************************************************
+ * Summary:
+ *  Re-hashes CY_BOOT_VALIDATE_SAMPLES consecutive blocks of the image in `fa`
+ *  and compares them with the digests of its record. `boot_count` selects
+ *  the blocks, so that successive boots check successive blocks.
+ *
+ ******************************************************************************/
+static bool validate_sampled(const struct flash_area *fa, const validate_rec_t *rec,
+                             uint32_t boot_count)
+{
+    uint32_t blocks = ((rec->size - 1U) >> rec->block_shift) + 1U;
+    uint32_t samples = (blocks < CY_BOOT_VALIDATE_SAMPLES) ? blocks : CY_BOOT_VALIDATE_SAMPLES;
+    uint32_t first = (uint32_t)(((uint64_t)boot_count * CY_BOOT_VALIDATE_SAMPLES) % blocks);
+
+    for (uint32_t n = 0; n < samples; n++)
+    {
+        uint32_t block = (first + n) % blocks;
+        uint32_t digest;
+
+        if ((validate_block_digest(fa, rec->block_shift, rec->size, block, &digest) != 0) ||
+            (digest != rec->digest[block]))
+        {
+            BOOT_LOG_WRN("Primary slot %d: block %u does not match its record",
+                         (int)fa->fa_id, (unsigned int)block);
+            return false;
+        }
+        validate_stats.sampled_bytes += validate_block_len(rec->block_shift, rec->size, block);
+    }
+    return true;
+}
+
+/******************************************************************************
+ * Function Name: validate_record
+ ******************************************************************************
+ * Summary:
+ *  Records that the image in `fa`, record index `slot`, passed full
+ *  validation: `hdr`, `hash` and `size` come from boot_image_tlv().
+ *  With `hdr` NULL, the record matches no image instead, revoking the
+ *  previous one. The record goes to the row after the latest record,
+ *  skipping the latest record of each slot, so that a record is never
+ *  overwritten in place.
+ *
+ ******************************************************************************/
+static void validate_record(uint32_t slot, const struct flash_area *fa,
+                            const struct image_header *hdr, const uint8_t *hash, uint32_t size)
+{
+    const struct flash_area *area;
+    validate_rec_t *rec = (validate_rec_t *)validate_row_buf;
+    uint32_t block_shift = VALIDATE_BLOCK_SHIFT_MIN;
+    uint32_t blocks;
+    uint32_t rows;
+    uint32_t row;
+
+    /* The row buffer may still be programming the previous record. */
+    if ((flash_area_sync() != 0) || (flash_area_open(FLASH_AREA_VALIDATION, &area) != 0))
+    {
+        return;
+    }
+
+    memset(validate_row_buf, flash_area_erased_val(area), sizeof(validate_row_buf));
+    memset(rec, 0, sizeof(*rec));
+    rec->magic = VALIDATE_MAGIC;
+    rec->seq = validate.seq + 1U;
+    rec->fa_id = fa->fa_id;
+
+    if (hdr != NULL)
+    {
+        while ((((size - 1U) >> block_shift) + 1U) > VALIDATE_BLOCKS_MAX)
+        {
+            block_shift++;
+        }
+        blocks = ((size - 1U) >> block_shift) + 1U;
+
+        rec->size = size;
+        rec->block_shift = block_shift;
+        rec->hdr = *hdr;
+        memcpy(rec->hash, hash, sizeof(rec->hash));
+        for (uint32_t block = 0; block < blocks; block++)
+        {
+            if (validate_block_digest(fa, block_shift, size, block, &rec->digest[block]) != 0)
+            {
+                flash_area_close(area);
+                return;
+            }
+        }
+    }
+    boot_hmac_sha256(validate_key, rec, offsetof(validate_rec_t, mac), rec->mac);
+
+    rows = area->fa_size / CY_FLASH_SIZEOF_ROW;
+    row = (validate.row == VALIDATE_NO_ROW) ? 0U : ((validate.row + 1U) % rows);
+    for (uint32_t n = 0; n < rows; n++)
+    {
+        bool used = false;
+
+        for (uint32_t i = 0; i < VALIDATE_SLOTS; i++)
+        {
+            used = used || (validate.rec_row[i] == row);
+        }
+        if (!used)
+        {
+            break;
+        }
+        row = (row + 1U) % rows;
+    }
+
+    if (flash_area_write(area, row * CY_FLASH_SIZEOF_ROW, validate_row_buf,
+                         CY_FLASH_SIZEOF_ROW) == 0)
+    {
+        validate.rec[slot] = *rec;
+        validate.rec_row[slot] = row;
+        validate.seq = rec->seq;
+        validate.row = row;
+        validate_stats.records++;
+    }
+    flash_area_close(area);
+}
+
+/******************************************************************************
+ * Function Name: validate_init
+ ******************************************************************************
+ * Summary:
+ *  Counts the boot, derives the record key and loads the records, once per
+ *  boot.
+ *
+ ******************************************************************************/
+static void validate_init(void)
+{
+    if (!validate.loaded)
+    {
+        validate.boot_count = BACKUP->BREG[CY_BOOT_VALIDATE_BREG];
+        BACKUP->BREG[CY_BOOT_VALIDATE_BREG] = validate.boot_count + 1U;
+
+        validate_key_init();
+        validate_load();
+        validate.loaded = true;
+    }
+}
+#endif
+
+/******************************************************************************
+ * Function Name: boot_image_tlv
+ ******************************************************************************
+ * Summary:
+ *  Reads the header of the image in `fa` and how many bytes the image spans
+ *  up to the end of its TLVs. If `data` is not NULL, also reads the value of
+ *  its first unprotected TLV of type `type` that is `len` bytes long.
+ *
+ * Return:
+ *  0 on success, -1 if the slot holds no image, or no such TLV.
+ *
+ ******************************************************************************/
+int boot_image_tlv(const struct flash_area *fa, struct image_header *hdr, uint32_t *size,
+                   uint16_t type, void *data, uint16_t len)
+{
+    struct image_tlv_info info;
+    struct image_tlv tlv;
+    uint32_t off;
+    uint32_t end;
+
+    if ((flash_area_read(fa, 0U, hdr, sizeof(*hdr)) != 0) || (hdr->ih_magic != IMAGE_MAGIC))
+    {
+        return -1;
+    }
+
+    /* The protected TLVs, if any, come first. */
+    off = (uint32_t)hdr->ih_hdr_size + hdr->ih_img_size + hdr->ih_protect_tlv_size;
+    if ((off >= fa->fa_size) || (flash_area_read(fa, off, &info, sizeof(info)) != 0) ||
+        (info.it_magic != IMAGE_TLV_INFO_MAGIC))
+    {
+        return -1;
+    }
+
+    end = off + info.it_tlv_tot;
+    if (end > fa->fa_size)
+    {
+        return -1;
+    }
+    *size = end;
+    if (data == NULL)
+    {
+        return 0;
+    }
+
+    off += sizeof(info);
+    while ((off + sizeof(tlv)) <= end)
+    {
+        if (flash_area_read(fa, off, &tlv, sizeof(tlv)) != 0)
+        {
+            return -1;
+        }
+        off += sizeof(tlv);
+        if ((tlv.it_type == type) && (tlv.it_len == len))
+        {
+            return flash_area_read(fa, off, data, len);
+        }
+        off += tlv.it_len;
+    }
+    return -1;
+}
+
+/******************************************************************************
+ * Function Name: boot_image_validate
+ ******************************************************************************
+ * Summary:
+ *  Checks the hash and signature of the image in `fa` for image `image` in
+ *  full, the way MCUboot does.
+ *
+ * Return:
+ *  0 if the image is valid.
+ *
+ ******************************************************************************/
+int boot_image_validate(int image, const struct flash_area *fa)
+{
+    struct image_header hdr;
+
+    if ((flash_area_read(fa, 0U, &hdr, sizeof(hdr)) != 0) || (hdr.ih_magic != IMAGE_MAGIC))
+    {
+        return -1;
+    }
+    return bootutil_img_validate(NULL, image, &hdr, fa, validate_tmp_buf,
+                                 sizeof(validate_tmp_buf), NULL, 0, NULL);
+}
+
+/******************************************************************************
+ * Function Name: boot_validate_image
+ ******************************************************************************
+ * Summary:
+ *  Validates the image in `fa` for image `image`: against the record of the
+ *  slot if the record matches the header and the SHA-256 TLV of the image
+ *  and the sampled blocks match their digests, otherwise in full, writing a
+ *  new record if it is valid. Slots without a record, or a build without
+ *  cached validation, are validated in full.
+ *
+ * Return:
+ *  0 if the image is valid, -1 otherwise.
+ *
+ ******************************************************************************/
+int boot_validate_image(int image, const struct flash_area *fa)
+{
+#if (CY_BOOT_VALIDATE_CACHED != 0)
+    struct image_header hdr;
+    const validate_rec_t *rec;
+    uint8_t hash[VALIDATE_HASH_SIZE];
+    uint32_t slot = validate_slot_index(fa->fa_id);
+    uint32_t size;
+    uint32_t start;
+    bool recorded;
+    int rc;
+
+    validate_init();
+
+    start = boot_timing_now();
+    rc = boot_image_tlv(fa, &hdr, &size, IMAGE_TLV_SHA256, hash, sizeof(hash));
+    boot_timing_add(BOOT_PHASE_HEADER, boot_timing_image(fa->fa_id), start);
+    if (rc != 0)
+    {
+        validate_stats.failed++;
+        return -1;
+    }
+
+    rec = (slot < VALIDATE_SLOTS) ? &validate.rec[slot] : NULL;
+    recorded = (rec != NULL) && (rec->magic == VALIDATE_MAGIC) && (rec->size == size) &&
+               (memcmp(&rec->hdr, &hdr, sizeof(hdr)) == 0) &&
+               (memcmp(rec->hash, hash, sizeof(hash)) == 0);
+    if (recorded && validate_sampled(fa, rec, validate.boot_count))
+    {
+        validate_stats.cached++;
+        return 0;
+    }
+    if (boot_image_validate(image, fa) == 0)
+    {
+        validate_stats.full++;
+        if (slot < VALIDATE_SLOTS)
+        {
+            validate_record(slot, fa, &hdr, hash, size);
+        }
+        return 0;
+    }
+
+    validate_stats.failed++;
+
+    /* The image changed after its record was written; without the record
+     * the next boots hash it in full, not just other blocks. The caller may
+     * boot nothing, so the row write is waited for here.
+     */
+    if (recorded)
+    {
+        validate_record(slot, fa, NULL, NULL, 0U);
+        (void)flash_area_sync();
+    }
+    return -1;
+#else
+    return boot_image_validate(image, fa);
+#endif
+}
+
+/******************************************************************************
+ * Function Name: boot_validate_primaries
+ ******************************************************************************
+ * Summary:
+ *  Called after boot_go(). Validates the image in the primary slot of every
+ *  image MCUboot manages with boot_validate_image().
+ *
+ * Return:
+ *  0 if every primary image is valid or cached validation is not enabled,
+ *  -1 otherwise.
+ *
+ ******************************************************************************/
+int boot_validate_primaries(void)
+{
+#if (CY_BOOT_VALIDATE_CACHED != 0)
+    int rc = 0;
+
+    for (uint32_t image = 0; image < MCUBOOT_IMAGE_NUMBER; image++)
+    {
+        const struct flash_area *fa;
+
+        if (flash_area_open(FLASH_AREA_IMAGE_PRIMARY(image), &fa) != 0)
+        {
+            return -1;
+        }
+
+        if (boot_validate_image((int)image, fa) != 0)
+        {
+            BOOT_LOG_ERR("Image %u: primary slot image is not valid", (unsigned int)image);
+            rc = -1;
+        }
+        flash_area_close(fa);
+    }
+    return rc;
+#else
+    return 0;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: boot_validate_get_stats
+ ******************************************************************************
+ * Summary:
+ *  Returns the primary slot validation counters of this boot.
+ *
+ ******************************************************************************/
+const boot_validate_stats_t *boot_validate_get_stats(void)
+{
+    return &validate_stats;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,66 @@
+/******************************************************************************
+* File Name:   boot_validate.h
+*
+* Description:
+* Primary slot validation with a per-image record, so that images are hashed
+* in full once after they are installed and checked cheaply on later boots.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef BOOT_VALIDATE_H_
+#define BOOT_VALIDATE_H_
+
+#include <stdint.h>
+
+#include "flash_map_backend/flash_map_backend.h"
+
+struct image_header;
+
+/* Slot validation of this boot. */
+typedef struct
+{
+    uint32_t full;              /* Images hashed in full, record missing or stale */
+    uint32_t cached;            /* Images accepted on their validation record */
+    uint32_t failed;            /* Images that failed validation */
+    uint32_t sampled_bytes;     /* Bytes hashed by the checks against records */
+    uint32_t records;           /* Validation records written */
+} boot_validate_stats_t;
+
+int boot_image_tlv(const struct flash_area *fa, struct image_header *hdr, uint32_t *size,
+                   uint16_t type, void *data, uint16_t len);
+int boot_image_validate(int image, const struct flash_area *fa);
+int boot_validate_image(int image, const struct flash_area *fa);
+int boot_validate_primaries(void);
+const boot_validate_stats_t *boot_validate_get_stats(void);
+
+#endif /* BOOT_VALIDATE_H_ */
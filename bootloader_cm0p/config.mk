@@ -41,8 +41,31 @@ BOOTLOADER_APP_FLASH_SIZE=0x18000
 # RAM size of MCUBoot Bootloader app run by CM0+
 BOOTLOADER_APP_RAM_SIZE=0x20000
 
+# Last bytes of the bootloader RAM, left out of its stack and heap. The
+# bootloader hands information to the CM4 app there (shared/boot_shared.h).
+BOOTLOADER_SHARED_RAM_SIZE=0x800
+
 # Scratchpad area.
 MCUBOOT_SCRATCH_SIZE=0x1000
+# Scratchpad start offset w.r.t. beginning of internal flash. Overwrite-only
+# upgrades do not swap through it; the bootloader keeps the progress journal
+# of an interrupted upgrade there. The default is the last 4 KB of the 32 KB
+# work flash (em_eeprom region at 0x14000000), which is written in 512-byte
+# rows and is not used by the applications.
+MCUBOOT_SCRATCH_START_OFFSET=0x4007000
+
+# Primary slot validation records (boot_validate.c): one 512-byte row per
+# record, and a spare row so a record is never overwritten in place. With
+# WIFI_SLOT_FLIP, both image 2 slots have records too. The default is the
+# 2 KB of work flash just below the scratch area.
+BOOTLOADER_VALIDATION_SIZE=0x800
+BOOTLOADER_VALIDATION_START_OFFSET=0x4006800
+
+# External memory configuration found by SFDP detection, kept across boots
+# (ext_flash_sfdp_cache.c): two 512-byte rows used in turn, just below the
+# validation records.
+BOOTLOADER_SFDP_CACHE_SIZE=0x400
+BOOTLOADER_SFDP_CACHE_START_OFFSET=0x4006400
 
 # MCUBoot header size
 # Header size is used in two places. 
@@ -59,10 +82,21 @@ MCUBOOT_HEADER_SIZE=0x400
 MCUBOOT_APP1_SLOT_SIZE=0x1C0000
 # Defines the MCUBoot slot sizes for app2 (slot1 and Slot-2), 768KB.
 MCUBOOT_APP2_SLOT_SIZE=0x80000
-# MCUBOOT_SLOT_SIZE/FLASH_SECTOR_SIZE. Value is configured for larget slot size.
-MAX_IMG_SECTORS=3584
-# External flash sector size, 1 erase sector is 256KB for the selected flash. Change this as per your external memory part selected.
-EXTERNAL_FLASH_SECTOR_SIZE=0x40000
+# Maximum number of sectors in a slot, derived from the slot sizes. The flash
+# map reports 512-byte rows as the sectors of the internal App1 primary slot
+# and at least 4 KB as the sectors of the external slots, so that MCUboot
+# finds every pair of slots compatible. ext_flash_map.c fails the build if a
+# slot has more sectors than this.
+FLASH_ROW_SIZE=512
+FLASH_EXT_SECTOR_MIN=4096
+MAX_IMG_SECTORS:=$(shell echo $$(( $(MCUBOOT_APP1_SLOT_SIZE) / $(FLASH_ROW_SIZE) > $(MCUBOOT_APP2_SLOT_SIZE) / $(FLASH_EXT_SECTOR_MIN) ?\
+                                  $(MCUBOOT_APP1_SLOT_SIZE) / $(FLASH_ROW_SIZE) : $(MCUBOOT_APP2_SLOT_SIZE) / $(FLASH_EXT_SECTOR_MIN) )))
+
+# Set to 1 to run the Wi-Fi firmware (App2) from whichever of its two slots
+# holds the newest valid image instead of copying upgrades into the primary
+# slot. MCUboot then manages App1 only; the bootloader passes the App2 slot
+# address to the CM4 app, which writes upgrades to the other slot.
+WIFI_SLOT_FLIP?=0
 
 
 # Define the offset of each slot w.r.t. beginning of internal flash.
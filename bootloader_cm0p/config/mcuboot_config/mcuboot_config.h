@@ -28,7 +28,8 @@
 /*
  * Signature types
  *
- * You must choose exactly one signature type.
+ * You must choose exactly one signature type. The Makefile defines
+ * MCUBOOT_SIGN_EC256 or MCUBOOT_SIGN_ED25519 from BOOT_SIGN.
  */
 
 /* Uncomment for RSA signature support */
@@ -65,10 +66,12 @@
  * available.
  */
 
-/* Uncomment to use ARM's mbedTLS cryptographic primitives */
+/* The Makefile defines one of them from BOOT_CRYPTO. Without it, use ARM's
+ * mbedTLS cryptographic primitives.
+ */
+#if !defined(MCUBOOT_USE_MBED_TLS) && !defined(MCUBOOT_USE_TINYCRYPT)
 #define MCUBOOT_USE_MBED_TLS
-/* Uncomment to use Tinycrypt's. */
-/* #define MCUBOOT_USE_TINYCRYPT */
+#endif
 
 /*
  * Always check the signature of the image in slot 0 before booting,
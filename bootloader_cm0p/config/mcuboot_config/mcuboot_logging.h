@@ -30,6 +30,8 @@
 
 #include <stdio.h>
 
+#include "boot_log.h"
+
 #define MCUBOOT_LOG_LEVEL_OFF      0
 #define MCUBOOT_LOG_LEVEL_ERROR    1
 #define MCUBOOT_LOG_LEVEL_WARNING  2
@@ -50,11 +52,22 @@ int sim_log_enabled(int level);
 
 #define sim_log_enabled(x) 1
 
+/* Lines go to the DMA log output (boot_log.c) as tokens or text, or to the
+ * blocking retarget-io output.
+ */
+#if (CY_BOOT_LOG_TOKENIZED != 0)
+#define MCUBOOT_LOG_PRINT(_line, ...)   BOOT_LOG_TOKEN(_line, ##__VA_ARGS__)
+#elif (CY_BOOT_LOG_ASYNC != 0)
+#define MCUBOOT_LOG_PRINT(_line, ...)   (void)boot_log_printf(_line, ##__VA_ARGS__)
+#else
+#define MCUBOOT_LOG_PRINT(_line, ...)   (void)fprintf(stderr, _line, ##__VA_ARGS__)
+#endif
+
 #if MCUBOOT_LOG_LEVEL >= MCUBOOT_LOG_LEVEL_ERROR
 #define MCUBOOT_LOG_ERR(_fmt, ...)                                      \
     do {                                                                \
         if (sim_log_enabled(MCUBOOT_LOG_LEVEL_ERROR)) {                 \
-            fprintf(stderr, "[ERR] " _fmt "\n\r", ##__VA_ARGS__);         \
+            MCUBOOT_LOG_PRINT("[ERR] " _fmt "\n\r", ##__VA_ARGS__);     \
         }                                                               \
     } while (0)
 #else
@@ -65,7 +78,7 @@ int sim_log_enabled(int level);
 #define MCUBOOT_LOG_WRN(_fmt, ...)                                      \
     do {                                                                \
         if (sim_log_enabled(MCUBOOT_LOG_LEVEL_WARNING)) {               \
-            fprintf(stderr, "[WRN] " _fmt "\n\r", ##__VA_ARGS__);         \
+            MCUBOOT_LOG_PRINT("[WRN] " _fmt "\n\r", ##__VA_ARGS__);     \
         }                                                               \
     } while (0)
 #else
@@ -76,7 +89,7 @@ int sim_log_enabled(int level);
 #define MCUBOOT_LOG_INF(_fmt, ...)                                      \
     do {                                                                \
         if (sim_log_enabled(MCUBOOT_LOG_LEVEL_INFO)) {                  \
-            fprintf(stderr, "[INF] " _fmt "\n\r", ##__VA_ARGS__);         \
+            MCUBOOT_LOG_PRINT("[INF] " _fmt "\n\r", ##__VA_ARGS__);     \
         }                                                               \
     } while (0)
 #else
@@ -87,7 +100,7 @@ int sim_log_enabled(int level);
 #define MCUBOOT_LOG_DBG(_fmt, ...)                                      \
     do {                                                                \
         if (sim_log_enabled(MCUBOOT_LOG_LEVEL_DEBUG)) {                 \
-            fprintf(stderr, "[DBG] " _fmt "\n\r", ##__VA_ARGS__);         \
+            MCUBOOT_LOG_PRINT("[DBG] " _fmt "\n\r", ##__VA_ARGS__);     \
         }                                                               \
     } while (0)
 #else
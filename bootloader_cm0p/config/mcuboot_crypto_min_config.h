@@ -0,0 +1,108 @@
+/******************************************************************************
+* File Name:   mcuboot_crypto_min_config.h
+*
+* Description:
+* This file is the mbedTLS configuration of the minimal crypto profile
+* (BOOT_CRYPTO_PROFILE=MINIMAL in the Makefile). The bootloader only hashes
+* with SHA-256 and verifies one kind of signature, so only those modules are
+* enabled, picked from MCUBOOT_USE_MBED_TLS and MCUBOOT_SIGN_*; app.mk builds
+* the matching sources only. The modules that allocate (bignum, ECP) take
+* their memory from a static pool sized for one verification, see
+* boot_crypto.c. mcuboot_crypto_config.h is the full configuration, used
+* with BOOT_CRYPTO_PROFILE=FULL.
+*
+* This profile is experimental: it has only been built for the host
+* simulator, not compiled, linked or run on the CM0+.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef MBEDTLS_CONFIG_H
+#define MBEDTLS_CONFIG_H
+
+/* System support: no entropy source and no file system are needed to
+ * verify an image.
+ */
+#define MBEDTLS_HAVE_ASM
+#define MBEDTLS_NO_PLATFORM_ENTROPY
+#define MBEDTLS_PLATFORM_C
+
+/* SHA-256 of the images and of the validation records, unless TinyCrypt
+ * hashes.
+ */
+#if !defined(MCUBOOT_USE_TINYCRYPT)
+#define MBEDTLS_SHA256_C
+#endif
+
+/* MCUboot parses the public keys with the ASN.1 reader of mbedTLS, whatever
+ * the verifier.
+ */
+#if defined(MCUBOOT_SIGN_EC256) || defined(MCUBOOT_SIGN_ED25519)
+#define MBEDTLS_ASN1_PARSE_C
+#endif
+
+/* ECDSA P-256 verification with mbedTLS (image_ec256_mbedtls.c). */
+#if defined(MCUBOOT_SIGN_EC256) && !defined(MCUBOOT_USE_TINYCRYPT)
+#define MBEDTLS_BIGNUM_C
+#define MBEDTLS_ECP_C
+#define MBEDTLS_ECDSA_C
+#define MBEDTLS_ECP_DP_SECP256R1_ENABLED
+#define MBEDTLS_ECP_NIST_OPTIM
+
+/* Sized for P-256 only. The ECP window and the fixed-point tables trade
+ * speed for pool memory; a signature is only verified when an image is
+ * installed or validated in full.
+ */
+#define MBEDTLS_MPI_WINDOW_SIZE                 (1)
+#define MBEDTLS_MPI_MAX_SIZE                    (32)
+#define MBEDTLS_ECP_MAX_BITS                    (256)
+#define MBEDTLS_ECP_WINDOW_SIZE                 (2)
+#define MBEDTLS_ECP_FIXED_POINT_OPTIM           (0)
+
+/* bignum and ECP allocate from the static pool of boot_crypto.c. */
+#define MBEDTLS_PLATFORM_MEMORY
+#define MBEDTLS_MEMORY_BUFFER_ALLOC_C
+#endif
+
+/* Ed25519 verification (fiat curve25519.c) hashes with SHA-512. */
+#if defined(MCUBOOT_SIGN_ED25519)
+#define MBEDTLS_SHA512_C
+#endif
+
+/* The MXCRYPTO block with USE_CRYPTO_HW, see mcuboot_crypto_acc_config.h. */
+#if defined(MBEDTLS_USER_CONFIG_FILE)
+#include MBEDTLS_USER_CONFIG_FILE
+#endif
+
+#include "mbedtls/check_config.h"
+
+#endif /* MBEDTLS_CONFIG_H */
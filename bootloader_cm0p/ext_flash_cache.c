@@ -0,0 +1,511 @@
+/******************************************************************************
+* File Name:   ext_flash_cache.c
+*
+* Description:
+* This file implements a small set-associative read cache in front of the
+* command mode reads of the external QSPI memory. Every psoc6_smif_read() is
+* a separate command transaction, and MCUboot reads image headers, TLVs and
+* trailer fields a few bytes at a time; reads shorter than a cache line are
+* served from whole lines read once. Longer reads go straight to the memory,
+* through the memory mapped (XIP) window when it is enabled: the chunks
+* MCUboot hashes and copies then stream with the read instruction and
+* prefetch of the SMIF instead of a command transaction each. Sequential
+* long reads are streamed through two buffers: while the caller hashes or
+* copies one chunk, the DMA fills the other with the chunk that follows, so
+* the QSPI bus and the CPU or crypto block no longer take turns. The flash
+* map invalidates the lines and buffers a write or erase touches.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cy_smif_psoc6.h"
+#include "ext_flash_cache.h"
+#include "ext_flash_smif.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#ifndef CY_BOOT_SMIF_READ_CACHE
+/* Serve short external reads from the read cache. */
+#define CY_BOOT_SMIF_READ_CACHE                 (1)
+#endif
+
+#ifndef CY_BOOT_SMIF_CACHE_LINE_SIZE
+/* Bytes read per miss; a power of two. Covers a trailer's fields or a few
+ * TLVs, while a miss costs little more than the read it replaces.
+ */
+#define CY_BOOT_SMIF_CACHE_LINE_SIZE            (64U)
+#endif
+
+#ifndef CY_BOOT_SMIF_CACHE_SETS
+/* Number of sets; a power of two. */
+#define CY_BOOT_SMIF_CACHE_SETS                 (16U)
+#endif
+
+#ifndef CY_BOOT_SMIF_CACHE_WAYS
+/* Lines per set, replaced least recently used first. */
+#define CY_BOOT_SMIF_CACHE_WAYS                 (2U)
+#endif
+
+#ifndef CY_BOOT_SMIF_XIP_READ
+/* Read long ranges through the memory mapped window, switching back to
+ * command mode for every other transaction.
+ */
+#define CY_BOOT_SMIF_XIP_READ                   (1)
+#endif
+
+#ifndef CY_BOOT_SMIF_XIP_MIN_READ
+/* Shortest read served by the XIP window. MCUboot hashes in 256 byte and
+ * copies in 1 KB chunks.
+ */
+#define CY_BOOT_SMIF_XIP_MIN_READ               (256U)
+#endif
+
+#ifndef CY_BOOT_SMIF_STREAM
+/* Read ahead of sequential XIP reads with the DMA. */
+#define CY_BOOT_SMIF_STREAM                     (CY_BOOT_SMIF_XIP_READ)
+#endif
+
+#ifndef CY_BOOT_SMIF_STREAM_CHUNK
+/* Bytes per DMA transfer, and size of each of the two stream buffers; a
+ * multiple of 4. Larger chunks amortize the transfer setup, smaller ones
+ * shorten the first, unoverlapped read of a stream.
+ */
+#define CY_BOOT_SMIF_STREAM_CHUNK               (2048U)
+#endif
+
+/* Lines hold XIP addresses, which are never 0. */
+#define SMIF_CACHE_NO_LINE                      (0UL)
+
+/* Stream buffer index meaning none. */
+#define SMIF_STREAM_NONE                        (2U)
+
+/*******************************************************************************
+* Data types
+********************************************************************************/
+typedef struct
+{
+    uint32_t addr;              /* XIP address of the line, SMIF_CACHE_NO_LINE if free */
+    uint32_t used;              /* smif_cache_clock at the last access */
+    uint32_t data[CY_BOOT_SMIF_CACHE_LINE_SIZE / sizeof(uint32_t)];
+} smif_cache_line_t;
+
+#if (CY_BOOT_SMIF_STREAM != 0)
+typedef struct
+{
+    uint32_t addr;              /* XIP address of the chunk, SMIF_CACHE_NO_LINE if empty */
+    uint32_t len;               /* Bytes in the chunk, short at the end of an area */
+    uint32_t data[CY_BOOT_SMIF_STREAM_CHUNK / sizeof(uint32_t)];
+} smif_stream_buf_t;
+#endif
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+#if (CY_BOOT_SMIF_READ_CACHE != 0)
+static smif_cache_line_t smif_cache[CY_BOOT_SMIF_CACHE_SETS][CY_BOOT_SMIF_CACHE_WAYS];
+static uint32_t smif_cache_clock;
+#endif
+#if (CY_BOOT_SMIF_STREAM != 0)
+static smif_stream_buf_t smif_stream[2];
+static uint32_t smif_stream_filling = SMIF_STREAM_NONE;
+#endif
+static ext_flash_cache_stats_t smif_cache_stats;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static int smif_read(const struct flash_area *fa, uint32_t addr, void *dst, uint32_t len);
+#if (CY_BOOT_SMIF_READ_CACHE != 0)
+static int smif_cache_line(const struct flash_area *fa, uint32_t line_addr,
+                           const smif_cache_line_t **line);
+#endif
+#if (CY_BOOT_SMIF_STREAM != 0)
+static int smif_stream_wait(void);
+static int smif_stream_fill(const struct flash_area *fa, uint32_t idx, uint32_t addr);
+static int smif_stream_read(const struct flash_area *fa, uint32_t addr, void *dst, uint32_t len);
+#endif
+
+/******************************************************************************
+ * Function Name: smif_read
+ ******************************************************************************
+ * Summary:
+ *  Reads the memory directly: through the XIP window if the read is long
+ *  enough and the window is available, in command mode otherwise.
+ *
+ * Return:
+ *  0 on success, the psoc6_smif_read() error otherwise.
+ *
+ ******************************************************************************/
+static int smif_read(const struct flash_area *fa, uint32_t addr, void *dst, uint32_t len)
+{
+#if (CY_BOOT_SMIF_XIP_READ != 0)
+    if ((len >= CY_BOOT_SMIF_XIP_MIN_READ) && (ext_flash_smif_xip_read(addr, dst, len) == 0))
+    {
+        smif_cache_stats.xip++;
+        return 0;
+    }
+#endif
+
+    ext_flash_smif_cmd_mode();
+    return psoc6_smif_read(fa, (off_t)addr, dst, len);
+}
+
+#if (CY_BOOT_SMIF_READ_CACHE != 0)
+/******************************************************************************
+ * Function Name: smif_cache_line
+ ******************************************************************************
+ * Summary:
+ *  Looks up the line at `line_addr`, reading it into the least recently used
+ *  way of its set on a miss. Lines that are not entirely inside `fa` are not
+ *  cached.
+ *
+ * Parameters:
+ *  fa - Flash area the line belongs to.
+ *  line_addr - XIP address of the line, aligned to the line size.
+ *  line - Set to the cached line, or NULL if the line is not cacheable.
+ *
+ * Return:
+ *  0 on success, the smif_read() error otherwise.
+ *
+ ******************************************************************************/
+static int smif_cache_line(const struct flash_area *fa, uint32_t line_addr,
+                           const smif_cache_line_t **line)
+{
+    smif_cache_line_t *set;
+    smif_cache_line_t *victim;
+    int rc;
+
+    *line = NULL;
+
+    if ((line_addr < fa->fa_off) ||
+        ((line_addr - fa->fa_off) > (fa->fa_size - CY_BOOT_SMIF_CACHE_LINE_SIZE)))
+    {
+        return 0;
+    }
+
+    set = smif_cache[(line_addr / CY_BOOT_SMIF_CACHE_LINE_SIZE) & (CY_BOOT_SMIF_CACHE_SETS - 1U)];
+    victim = &set[0];
+    smif_cache_clock++;
+
+    for (uint32_t way = 0; way < CY_BOOT_SMIF_CACHE_WAYS; way++)
+    {
+        if (set[way].addr == line_addr)
+        {
+            smif_cache_stats.hits++;
+            set[way].used = smif_cache_clock;
+            *line = &set[way];
+            return 0;
+        }
+        if ((set[way].addr == SMIF_CACHE_NO_LINE) ||
+            ((victim->addr != SMIF_CACHE_NO_LINE) && (set[way].used < victim->used)))
+        {
+            victim = &set[way];
+        }
+    }
+
+    smif_cache_stats.misses++;
+    victim->addr = SMIF_CACHE_NO_LINE;
+    rc = smif_read(fa, line_addr, victim->data, CY_BOOT_SMIF_CACHE_LINE_SIZE);
+    if (rc == 0)
+    {
+        victim->addr = line_addr;
+        victim->used = smif_cache_clock;
+        *line = victim;
+    }
+    return rc;
+}
+#endif
+
+#if (CY_BOOT_SMIF_STREAM != 0)
+/******************************************************************************
+ * Function Name: smif_stream_wait
+ ******************************************************************************
+ * Summary:
+ *  Waits for the stream buffer being filled, if any. The buffer is dropped
+ *  if the transfer failed.
+ *
+ * Return:
+ *  0 on success, -1 if the transfer failed.
+ *
+ ******************************************************************************/
+static int smif_stream_wait(void)
+{
+    int rc = 0;
+
+    if (smif_stream_filling != SMIF_STREAM_NONE)
+    {
+        rc = ext_flash_smif_xip_read_wait();
+        if (rc != 0)
+        {
+            smif_stream[smif_stream_filling].addr = SMIF_CACHE_NO_LINE;
+        }
+        smif_stream_filling = SMIF_STREAM_NONE;
+    }
+    return rc;
+}
+
+/******************************************************************************
+ * Function Name: smif_stream_fill
+ ******************************************************************************
+ * Summary:
+ *  Starts filling stream buffer `idx` with the chunk at XIP address `addr`,
+ *  cut short at the end of `fa`. No other fill may be in flight.
+ *
+ * Return:
+ *  0 if the fill was started, the ext_flash_smif_xip_read_start() error
+ *  otherwise.
+ *
+ ******************************************************************************/
+static int smif_stream_fill(const struct flash_area *fa, uint32_t idx, uint32_t addr)
+{
+    smif_stream_buf_t *buf = &smif_stream[idx];
+    uint32_t len = fa->fa_off + fa->fa_size - addr;
+
+    if (len > CY_BOOT_SMIF_STREAM_CHUNK)
+    {
+        len = CY_BOOT_SMIF_STREAM_CHUNK;
+    }
+
+    buf->addr = SMIF_CACHE_NO_LINE;
+    if (ext_flash_smif_xip_read_start(addr, buf->data, len) != 0)
+    {
+        return -1;
+    }
+
+    buf->addr = addr;
+    buf->len = len;
+    smif_stream_filling = idx;
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: smif_stream_read
+ ******************************************************************************
+ * Summary:
+ *  Serves `len` bytes at XIP address `addr` of `fa` from the stream buffers.
+ *  A read that does not continue the stream restarts it at `addr`. Before a
+ *  buffer is handed out, the DMA is started on the chunk that follows it, so
+ *  that the next sequential read finds its data ready or in flight.
+ *
+ * Return:
+ *  0 on success, -1 if the stream cannot be used; the caller then reads the
+ *  memory directly.
+ *
+ ******************************************************************************/
+static int smif_stream_read(const struct flash_area *fa, uint32_t addr, void *dst, uint32_t len)
+{
+    uint8_t *out = (uint8_t *)dst;
+
+    while (len > 0U)
+    {
+        uint32_t idx = SMIF_STREAM_NONE;
+        smif_stream_buf_t *buf;
+        uint32_t next;
+        uint32_t pos;
+        uint32_t chunk;
+
+        for (uint32_t i = 0; i < 2U; i++)
+        {
+            if ((smif_stream[i].addr != SMIF_CACHE_NO_LINE) &&
+                ((addr - smif_stream[i].addr) < smif_stream[i].len))
+            {
+                idx = i;
+            }
+        }
+
+        if (idx == SMIF_STREAM_NONE)
+        {
+            /* Not a continuation: the read ahead in flight is wasted. */
+            (void)smif_stream_wait();
+            idx = 0U;
+            if (smif_stream_fill(fa, idx, addr) != 0)
+            {
+                return -1;
+            }
+        }
+        if ((idx == smif_stream_filling) && (smif_stream_wait() != 0))
+        {
+            return -1;
+        }
+
+        buf = &smif_stream[idx];
+        next = buf->addr + buf->len;
+        if ((smif_stream_filling == SMIF_STREAM_NONE) &&
+            (smif_stream[idx ^ 1U].addr != next) && ((next - fa->fa_off) < fa->fa_size))
+        {
+            (void)smif_stream_fill(fa, idx ^ 1U, next);
+        }
+
+        pos = addr - buf->addr;
+        chunk = buf->len - pos;
+        if (chunk > len)
+        {
+            chunk = len;
+        }
+        memcpy(out, (const uint8_t *)buf->data + pos, chunk);
+
+        out += chunk;
+        addr += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+#endif
+
+/******************************************************************************
+ * Function Name: ext_flash_cache_read
+ ******************************************************************************
+ * Summary:
+ *  Reads `len` bytes of external flash at XIP address `addr` of area `fa`.
+ *  Reads shorter than a line are served from the cache, long ones from the
+ *  stream buffers, and the rest read the memory directly, see smif_read().
+ *
+ * Return:
+ *  0 on success, the psoc6_smif_read() error otherwise.
+ *
+ ******************************************************************************/
+int ext_flash_cache_read(const struct flash_area *fa, uint32_t addr, void *dst, uint32_t len)
+{
+#if (CY_BOOT_SMIF_READ_CACHE != 0)
+    uint8_t *out = (uint8_t *)dst;
+    int rc = 0;
+
+    if (len < CY_BOOT_SMIF_CACHE_LINE_SIZE)
+    {
+        while ((len > 0U) && (rc == 0))
+        {
+            uint32_t line_addr = addr & ~(CY_BOOT_SMIF_CACHE_LINE_SIZE - 1U);
+            uint32_t pos = addr - line_addr;
+            uint32_t chunk = CY_BOOT_SMIF_CACHE_LINE_SIZE - pos;
+            const smif_cache_line_t *line;
+
+            if (chunk > len)
+            {
+                chunk = len;
+            }
+
+            rc = smif_cache_line(fa, line_addr, &line);
+            if ((rc == 0) && (line != NULL))
+            {
+                memcpy(out, (const uint8_t *)line->data + pos, chunk);
+            }
+            else if (rc == 0)
+            {
+                smif_cache_stats.bypassed++;
+                rc = smif_read(fa, addr, out, chunk);
+            }
+            else
+            {
+                /* Line read failed, rc is returned. */
+            }
+
+            out += chunk;
+            addr += chunk;
+            len -= chunk;
+        }
+        return rc;
+    }
+#endif
+
+    smif_cache_stats.bypassed++;
+#if (CY_BOOT_SMIF_STREAM != 0)
+    if ((len >= CY_BOOT_SMIF_XIP_MIN_READ) && (smif_stream_read(fa, addr, dst, len) == 0))
+    {
+        smif_cache_stats.streamed++;
+        return 0;
+    }
+#endif
+    return smif_read(fa, addr, dst, len);
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_cache_invalidate
+ ******************************************************************************
+ * Summary:
+ *  Drops every cached line and stream buffer that overlaps `len` bytes at
+ *  XIP address `addr`. Must be called for every external program and erase.
+ *
+ ******************************************************************************/
+void ext_flash_cache_invalidate(uint32_t addr, uint32_t len)
+{
+#if (CY_BOOT_SMIF_STREAM != 0)
+    (void)smif_stream_wait();
+    for (uint32_t i = 0; i < 2U; i++)
+    {
+        smif_stream_buf_t *buf = &smif_stream[i];
+
+        if ((buf->addr != SMIF_CACHE_NO_LINE) &&
+            (((buf->addr - addr) < len) || ((addr - buf->addr) < buf->len)))
+        {
+            buf->addr = SMIF_CACHE_NO_LINE;
+        }
+    }
+#endif
+#if (CY_BOOT_SMIF_READ_CACHE != 0)
+    for (uint32_t set = 0; set < CY_BOOT_SMIF_CACHE_SETS; set++)
+    {
+        for (uint32_t way = 0; way < CY_BOOT_SMIF_CACHE_WAYS; way++)
+        {
+            smif_cache_line_t *line = &smif_cache[set][way];
+
+            if ((line->addr != SMIF_CACHE_NO_LINE) &&
+                (((line->addr - addr) < len) ||
+                 ((addr - line->addr) < CY_BOOT_SMIF_CACHE_LINE_SIZE)))
+            {
+                line->addr = SMIF_CACHE_NO_LINE;
+            }
+        }
+    }
+#else
+    (void)addr;
+    (void)len;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_cache_get_stats
+ ******************************************************************************
+ * Summary:
+ *  Returns the read cache counters since reset.
+ *
+ ******************************************************************************/
+const ext_flash_cache_stats_t *ext_flash_cache_get_stats(void)
+{
+    return &smif_cache_stats;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,62 @@
+/******************************************************************************
+* File Name:   ext_flash_cache.h
+*
+* Description:
+* This file declares the read path of the external QSPI memory: a read cache
+* in front of command mode reads, and memory mapped (XIP) reads for long
+* ranges, read ahead by DMA while they are sequential.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef EXT_FLASH_CACHE_H_
+#define EXT_FLASH_CACHE_H_
+
+#include <stdint.h>
+
+#include "flash_map_backend/flash_map_backend.h"
+
+/* Read cache activity since reset. */
+typedef struct
+{
+    uint32_t hits;              /* Line lookups served from RAM */
+    uint32_t misses;            /* Line lookups that read a line from flash */
+    uint32_t bypassed;          /* Reads passed straight to the memory */
+    uint32_t xip;               /* Bypassed reads served by the XIP window */
+    uint32_t streamed;          /* Bypassed reads served by the DMA stream */
+} ext_flash_cache_stats_t;
+
+int ext_flash_cache_read(const struct flash_area *fa, uint32_t addr, void *dst, uint32_t len);
+void ext_flash_cache_invalidate(uint32_t addr, uint32_t len);
+const ext_flash_cache_stats_t *ext_flash_cache_get_stats(void);
+
+#endif /* EXT_FLASH_CACHE_H_ */
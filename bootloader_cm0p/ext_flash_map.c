@@ -42,6 +42,9 @@
 #include "flash_map_backend/flash_map_backend.h"
 #include "sysflash.h"
 #include "mcuboot_config/mcuboot_config.h"
+#include "ext_flash_map.h"
+#include "boot_timing.h"
+#include "upgrade_journal.h"
 
 #ifndef CY_BOOTLOADER_START_ADDRESS
 #define CY_BOOTLOADER_START_ADDRESS        (0x10000000)
@@ -58,11 +61,15 @@
 #include <stdint.h>
 
 #include "bootutil/bootutil_log.h"
+#include "bootutil/image.h"
 
 #include "cy_pdl.h"
 
 #ifdef CY_BOOT_USE_EXTERNAL_FLASH
 #include "cy_smif_psoc6.h"
+#include "ext_flash_cache.h"
+#include "ext_flash_sfdp.h"
+#include "ext_flash_smif.h"
 #endif
 
 /*
@@ -90,11 +97,100 @@
 #define CY_BOOT_EXTERNAL_FLASH_ERASE_VALUE      (0xff)
 #endif
 
-#ifndef CY_EXTERNAL_FLASH_SECTOR_SIZE
-/* Set external flash sector size to 256 KB by default. */
-#define CY_EXTERNAL_FLASH_SECTOR_SIZE           (0x40000)
+/* Internal flash erase granules: 8-row subsector and 512-row sector. */
+#define CY_FLASH_SIZEOF_SUBSECTOR               (8UL * CY_FLASH_SIZEOF_ROW)
+#define CY_FLASH_SIZEOF_SECTOR                  (512UL * CY_FLASH_SIZEOF_ROW)
+
+#ifndef CY_BOOT_BLANK_CHECK_BUF_SIZE
+/* Size of the stack buffer used to blank-check external flash ranges. */
+#define CY_BOOT_BLANK_CHECK_BUF_SIZE            (256U)
+#endif
+
+#ifndef CY_BOOT_FLASH_PIPELINED_WRITE
+/* Program internal flash rows with the non-blocking SROM API and leave the
+ * last row of every flash_area_write() programming in the background, so
+ * that the caller can fetch the next chunk (typically a QSPI read of the
+ * secondary slot) meanwhile. The overlap is only real while the CPU does not
+ * fetch from the flash sector being programmed; otherwise the bus stalls
+ * until the row is done, which is no slower than the blocking API.
+ */
+#define CY_BOOT_FLASH_PIPELINED_WRITE           (1)
+#endif
+
+#ifndef CY_BOOT_FLASH_ERASE_SKIP_BLANK
+/* Blank-check every erase granule before erasing it and leave it alone if it
+ * already reads as erased. This saves erase time and wear when a slot is
+ * overwritten again, at the cost of a read (early exit on programmed data).
+ */
+#define CY_BOOT_FLASH_ERASE_SKIP_BLANK          (1)
+#endif
+
+/* Smallest sector reported for an external area. Smaller SFDP erase blocks
+ * are erased several at a time, so a slot never has more sectors than
+ * its size over this.
+ */
+#define FLASH_EXT_SECTOR_MIN                    (4096UL)
+
+#ifdef MCUBOOT_USE_FLASH_AREA_GET_SECTORS
+/* MCUboot keeps MCUBOOT_MAX_IMG_SECTORS sectors per slot, see
+ * flash_area_sectors().
+ */
+#if ((CY_BOOT_PRIMARY_1_SIZE / CY_FLASH_SIZEOF_ROW) > MCUBOOT_MAX_IMG_SECTORS)
+#error "MCUBOOT_MAX_IMG_SECTORS is smaller than the rows of the App1 primary slot"
+#endif
+#if ((CY_BOOT_SECONDARY_1_SIZE / FLASH_EXT_SECTOR_MIN) > MCUBOOT_MAX_IMG_SECTORS) || \
+    ((CY_BOOT_PRIMARY_2_SIZE / FLASH_EXT_SECTOR_MIN) > MCUBOOT_MAX_IMG_SECTORS)
+#error "MCUBOOT_MAX_IMG_SECTORS is smaller than the 4 KB sectors of an external slot"
+#endif
+#endif
+
+/* One past the largest fa_id of the flash map; sizes the tables indexed by
+ * fa_id. The image 2 areas use their fixed ids, which stay in the map when
+ * MCUboot is built for image 1 only (CY_BOOT_WIFI_SLOT_FLIP).
+ */
+#define FLASH_AREA_ID_COUNT                     (FLASH_AREA_SFDP_CACHE + 1)
+
+/* Index of the erase counters of a device. */
+#define FLASH_ERASE_STATS_INTERNAL              (0U)
+#define FLASH_ERASE_STATS_EXTERNAL              (1U)
+#define FLASH_ERASE_STATS_COUNT                 (2U)
+
+/* 32-bit word with every byte set to the erased value `val`. */
+#define FLASH_ERASED_WORD(val)                  ((uint32_t)(val) * 0x01010101UL)
+
+/* Word type allowed to alias the byte buffers it is used to scan. */
+typedef uint32_t __attribute__((__may_alias__)) flash_word_t;
+
+#if (CY_BOOT_FLASH_PIPELINED_WRITE != 0)
+/* Row left programming by flash_area_write(). Its data is staged here as the
+ * SROM reads the source while programming and the caller reuses its buffer.
+ */
+static struct
+{
+    bool busy;
+    uint32_t addr;
+    uint32_t data[CY_FLASH_SIZEOF_ROW / sizeof(uint32_t)];
+} flash_row_pending;
 #endif
 
+#ifdef CY_BOOT_USE_EXTERNAL_FLASH
+/* Set while the last erase command flash_area_erase_start() sent to the
+ * external memory may still run. Every other external access waits for it.
+ */
+static bool flash_ext_erase_pending;
+#endif
+
+/* Sector layout of one flash area, built on first use. */
+typedef struct
+{
+    bool valid;
+    uint32_t sector_count;
+    uint32_t sector_size;
+} flash_area_sectors_t;
+
+/* Erase counters since reset, see flash_area_get_erase_stats(). */
+static flash_erase_stats_t flash_erase_stats[FLASH_ERASE_STATS_COUNT];
+
 #if defined(CY_FLASH_MAP_EXT_DESC) 
 
 /* External flash map definition. */
@@ -106,6 +202,36 @@ static struct flash_area bootloader =
     .fa_size = CY_BOOT_BOOTLOADER_SIZE
 };
 
+/* Holds the upgrade progress journal, see upgrade_journal.c. */
+static struct flash_area scratch =
+{
+    .fa_id = FLASH_AREA_IMAGE_SCRATCH,
+    .fa_device_id = FLASH_DEVICE_INTERNAL_FLASH,
+    .fa_off = CY_FLASH_DEVICE_BASE + \
+              CY_BOOT_SCRATCH_START,
+    .fa_size = CY_BOOT_SCRATCH_SIZE
+};
+
+/* Holds the primary slot validation records, see boot_validate.c. */
+static struct flash_area validation =
+{
+    .fa_id = FLASH_AREA_VALIDATION,
+    .fa_device_id = FLASH_DEVICE_INTERNAL_FLASH,
+    .fa_off = CY_FLASH_DEVICE_BASE + \
+              CY_BOOT_VALIDATION_START,
+    .fa_size = CY_BOOT_VALIDATION_SIZE
+};
+
+/* Holds the external memory configuration records, see ext_flash_sfdp_cache.c. */
+static struct flash_area sfdp_cache =
+{
+    .fa_id = FLASH_AREA_SFDP_CACHE,
+    .fa_device_id = FLASH_DEVICE_INTERNAL_FLASH,
+    .fa_off = CY_FLASH_DEVICE_BASE + \
+              CY_BOOT_SFDP_CACHE_START,
+    .fa_size = CY_BOOT_SFDP_CACHE_SIZE
+};
+
 static struct flash_area primary_1 =
 {
     .fa_id = FLASH_AREA_IMAGE_PRIMARY(0),
@@ -126,7 +252,7 @@ static struct flash_area secondary_1 =
 
 static struct flash_area primary_2 =
 {
-    .fa_id = FLASH_AREA_IMAGE_PRIMARY(1),
+    .fa_id = FLASH_AREA_IMAGE_2,
     .fa_device_id = FLASH_DEVICE_EXTERNAL_FLASH(CY_BOOT_EXTERNAL_DEVICE_INDEX),
     .fa_off = CY_FLASH_DEVICE_BASE + \
               CY_BOOT_PRIMARY_2_START,
@@ -135,7 +261,7 @@ static struct flash_area primary_2 =
 
 static struct flash_area secondary_2 =
 {
-    .fa_id = FLASH_AREA_IMAGE_SECONDARY(1),
+    .fa_id = FLASH_AREA_IMAGE_3,
     .fa_device_id = FLASH_DEVICE_EXTERNAL_FLASH(CY_BOOT_EXTERNAL_DEVICE_INDEX),
     .fa_off = CY_FLASH_DEVICE_BASE + \
               CY_BOOT_SECONDARY_2_START,
@@ -149,9 +275,30 @@ struct flash_area *boot_area_descs[] =
     &secondary_1,
     &primary_2,
     &secondary_2,
+    &scratch,
+    &validation,
+    &sfdp_cache,
     NULL
 };
 
+/* The same descriptors indexed by fa_id, for constant-time lookup. */
+static struct flash_area *const boot_area_by_id[FLASH_AREA_ID_COUNT] =
+{
+    [FLASH_AREA_BOOTLOADER]         = &bootloader,
+    [FLASH_AREA_IMAGE_PRIMARY(0)]   = &primary_1,
+    [FLASH_AREA_IMAGE_SECONDARY(0)] = &secondary_1,
+    [FLASH_AREA_IMAGE_2]            = &primary_2,
+    [FLASH_AREA_IMAGE_3]            = &secondary_2,
+    [FLASH_AREA_IMAGE_SCRATCH]      = &scratch,
+    [FLASH_AREA_VALIDATION]         = &validation,
+    [FLASH_AREA_SFDP_CACHE]         = &sfdp_cache,
+};
+
+#ifdef MCUBOOT_USE_FLASH_AREA_GET_SECTORS
+/* Sector layout of every area, indexed by fa_id. */
+static flash_area_sectors_t boot_area_sectors[FLASH_AREA_ID_COUNT];
+#endif
+
 #else
     #error "CY_FLASH_MAP_EXT_DESC not defined !!"
 #endif /* CY_FLASH_MAP_EXT_DESC */
@@ -168,21 +315,26 @@ int flash_device_base(uint8_t fd_id, uintptr_t *ret)
     return 0;
 }
 
+/* Returns the descriptor of area `id`, or NULL if there is none. */
+static struct flash_area *flash_area_lookup(int id)
+{
+    if ((id < 0) || (id >= FLASH_AREA_ID_COUNT))
+    {
+        return NULL;
+    }
+    return boot_area_by_id[id];
+}
+
 /* Opens the area for use. id is one of the `fa_id`s */
 int flash_area_open(uint8_t id, const struct flash_area **fa)
 {
     int ret = -1;
-    uint32_t i = 0;
+    struct flash_area *area = flash_area_lookup(id);
 
-    while(NULL != boot_area_descs[i])
+    if(NULL != area)
     {
-        if(id == boot_area_descs[i]->fa_id)
-        {
-            *fa = boot_area_descs[i];
-            ret = 0;
-            break;
-        }
-        i++;
+        *fa = area;
+        ret = 0;
     }
     return ret;
 }
@@ -192,6 +344,245 @@ void flash_area_close(const struct flash_area *fa)
     (void)fa;/* Nothing to do there */
 }
 
+/*
+* Returns true if the internal flash row at `row_addr` is erased, in which
+* case it can be programmed without the erase phase of a row write.
+*/
+static bool flash_row_is_erased(uint32_t row_addr)
+{
+    const flash_word_t *w = (const flash_word_t *)(uintptr_t)row_addr;
+    const uint32_t pattern = FLASH_ERASED_WORD(CY_BOOT_INTERNAL_FLASH_ERASE_VALUE);
+
+    for (uint32_t i = 0; i < CY_FLASH_SIZEOF_ROW / sizeof(flash_word_t); i++)
+    {
+        if (w[i] != pattern)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+* Returns the largest internal flash erase granule that starts at `addr` and
+* fits in `len` bytes. `addr` and `len` are row aligned.
+*/
+static uint32_t flash_int_erase_size(uint32_t addr, uint32_t len)
+{
+    if (((addr % CY_FLASH_SIZEOF_SECTOR) == 0u) && (len >= CY_FLASH_SIZEOF_SECTOR))
+    {
+        return CY_FLASH_SIZEOF_SECTOR;
+    }
+    if (((addr % CY_FLASH_SIZEOF_SUBSECTOR) == 0u) && (len >= CY_FLASH_SIZEOF_SUBSECTOR))
+    {
+        return CY_FLASH_SIZEOF_SUBSECTOR;
+    }
+    return CY_FLASH_SIZEOF_ROW;
+}
+
+/*
+* Decides whether the granule of `size` bytes at absolute address `addr` must
+* be erased and counts the decision in `stats`. With
+* CY_BOOT_FLASH_ERASE_SKIP_BLANK, granules that are already blank are skipped.
+*/
+static bool flash_erase_is_needed(const struct flash_area *fa, uint32_t addr,
+                                  uint32_t size, flash_erase_stats_t *stats)
+{
+#if (CY_BOOT_FLASH_ERASE_SKIP_BLANK != 0)
+    if ((addr >= fa->fa_off) && (flash_area_is_blank(fa, addr - fa->fa_off, size) == 1))
+    {
+        stats->skipped++;
+        stats->skipped_bytes += size;
+        return false;
+    }
+#else
+    (void)fa;
+    (void)addr;
+#endif
+    stats->erased++;
+    return true;
+}
+
+/*
+* Returns the erase counters of the flash device `fa_device_id`, or NULL for
+* an unknown device.
+*/
+const flash_erase_stats_t *flash_area_get_erase_stats(uint8_t fa_device_id)
+{
+    if (fa_device_id == FLASH_DEVICE_INTERNAL_FLASH)
+    {
+        return &flash_erase_stats[FLASH_ERASE_STATS_INTERNAL];
+    }
+    if ((fa_device_id & FLASH_DEVICE_EXTERNAL_FLAG) == FLASH_DEVICE_EXTERNAL_FLAG)
+    {
+        return &flash_erase_stats[FLASH_ERASE_STATS_EXTERNAL];
+    }
+    return NULL;
+}
+
+/*
+* Waits until no internal flash row is being programmed in the background.
+* Returns the status of the row that was in flight, if any.
+*/
+static cy_en_flashdrv_status_t flash_row_wait(void)
+{
+    cy_en_flashdrv_status_t rc = CY_FLASH_DRV_SUCCESS;
+
+#if (CY_BOOT_FLASH_PIPELINED_WRITE != 0)
+    if (flash_row_pending.busy)
+    {
+        do
+        {
+            rc = Cy_Flash_IsOperationComplete();
+        } while (rc == CY_FLASH_DRV_OPCODE_BUSY);
+
+        flash_row_pending.busy = false;
+
+        if (rc != CY_FLASH_DRV_SUCCESS)
+        {
+            BOOT_LOG_ERR("Flash row write error at 0x%08x, rc = 0x%08x",
+                         (unsigned int)flash_row_pending.addr, (unsigned int)rc);
+        }
+    }
+#endif
+    return rc;
+}
+
+/*
+* Programs one internal flash row. Rows that are already erased only get the
+* program phase. With CY_BOOT_FLASH_PIPELINED_WRITE the row is started
+* without waiting for it; `last` marks the row that stays in flight after
+* flash_area_write() returns, whose data must be staged.
+*/
+static cy_en_flashdrv_status_t flash_row_write(uint32_t row_addr,
+                                               const uint32_t *data, bool last)
+{
+    cy_en_flashdrv_status_t rc;
+    bool erased;
+
+    rc = flash_row_wait();
+    if (rc != CY_FLASH_DRV_SUCCESS)
+    {
+        return rc;
+    }
+
+    erased = flash_row_is_erased(row_addr);
+
+#if (CY_BOOT_FLASH_PIPELINED_WRITE != 0)
+    if (last)
+    {
+        memcpy(flash_row_pending.data, data, CY_FLASH_SIZEOF_ROW);
+        data = flash_row_pending.data;
+    }
+
+    rc = erased ? Cy_Flash_StartProgram(row_addr, data) :
+                  Cy_Flash_StartWrite(row_addr, data);
+    if (rc == CY_FLASH_DRV_OPERATION_STARTED)
+    {
+        flash_row_pending.busy = true;
+        flash_row_pending.addr = row_addr;
+        rc = CY_FLASH_DRV_SUCCESS;
+    }
+#else
+    (void)last;
+    rc = erased ? Cy_Flash_ProgramRow(row_addr, data) :
+                  Cy_Flash_WriteRow(row_addr, data);
+#endif
+
+    if (rc != CY_FLASH_DRV_SUCCESS)
+    {
+        BOOT_LOG_ERR("Flash row write error at 0x%08x, rc = 0x%08x",
+                     (unsigned int)row_addr, (unsigned int)rc);
+    }
+    return rc;
+}
+
+/*
+* Waits for the row flash_area_write() left programming in the background.
+* Returns 0, or -1 if that row failed.
+*/
+int flash_area_sync(void)
+{
+    return (flash_row_wait() == CY_FLASH_DRV_SUCCESS) ? 0 : -1;
+}
+
+#ifdef CY_BOOT_USE_EXTERNAL_FLASH
+/*
+* Waits for the external erase flash_area_erase_start() left running.
+* Returns 0, or -1 if the memory did not become ready.
+*/
+static int flash_ext_wait(void)
+{
+    int rc = 0;
+
+    if (flash_ext_erase_pending)
+    {
+        rc = ext_flash_smif_wait();
+        flash_ext_erase_pending = false;
+    }
+    return rc;
+}
+#endif
+
+/*
+* Returns true while the device of `fa` still runs the row write
+* flash_area_write() or the erase flash_area_erase_start() left in the
+* background. Polls the device once and does not wait.
+*/
+bool flash_area_busy(const struct flash_area *fa)
+{
+    bool busy = false;
+
+    if (fa->fa_device_id == FLASH_DEVICE_INTERNAL_FLASH)
+    {
+#if (CY_BOOT_FLASH_PIPELINED_WRITE != 0)
+        busy = flash_row_pending.busy &&
+               (Cy_Flash_IsOperationComplete() == CY_FLASH_DRV_OPCODE_BUSY);
+#endif
+    }
+#ifdef CY_BOOT_USE_EXTERNAL_FLASH
+    else if ((fa->fa_device_id & FLASH_DEVICE_EXTERNAL_FLAG) == FLASH_DEVICE_EXTERNAL_FLAG)
+    {
+        busy = flash_ext_erase_pending && ext_flash_smif_busy();
+        flash_ext_erase_pending = busy;
+    }
+#endif
+    return busy;
+}
+
+/*
+* Waits for the row write or the erase left running in the background on the
+* device of `fa`, within the timeout of the device. Returns 0, or -1 if the
+* operation failed or the memory did not become ready.
+*/
+int flash_area_wait(const struct flash_area *fa)
+{
+    int rc = -1;
+
+    if (fa->fa_device_id == FLASH_DEVICE_INTERNAL_FLASH)
+    {
+        rc = flash_area_sync();
+    }
+#ifdef CY_BOOT_USE_EXTERNAL_FLASH
+    else if ((fa->fa_device_id & FLASH_DEVICE_EXTERNAL_FLAG) == FLASH_DEVICE_EXTERNAL_FLAG)
+    {
+        rc = flash_ext_wait();
+    }
+#endif
+    return rc;
+}
+
+/*
+* Times the copy of an image: the erases and writes of a primary slot.
+*/
+static void flash_timing_copy(const struct flash_area *fa, uint32_t start)
+{
+    if ((fa->fa_id == FLASH_AREA_IMAGE_PRIMARY(0)) || (fa->fa_id == FLASH_AREA_IMAGE_2))
+    {
+        boot_timing_add(BOOT_PHASE_COPY, boot_timing_image(fa->fa_id), start);
+    }
+}
+
 /*
 * Reads `len` bytes of flash memory at `off` to the buffer at `dst`
 */
@@ -210,12 +601,20 @@ int flash_area_read(const struct flash_area *fa, uint32_t off, void *dst,
     if (fa->fa_device_id == FLASH_DEVICE_INTERNAL_FLASH)
     {
         /* flash read by simple memory copying */
-        memcpy((void *)dst, (const void*)addr, (size_t)len);
+        rc = flash_area_sync();
+        if (rc == 0)
+        {
+            memcpy((void *)dst, (const void*)addr, (size_t)len);
+        }
     }
 #ifdef CY_BOOT_USE_EXTERNAL_FLASH
     else if ((fa->fa_device_id & FLASH_DEVICE_EXTERNAL_FLAG) == FLASH_DEVICE_EXTERNAL_FLAG)
     {
-        rc = psoc6_smif_read(fa, addr, dst, len);
+        rc = flash_ext_wait();
+        if (rc == 0)
+        {
+            rc = ext_flash_cache_read(fa, addr, dst, len);
+        }
     }
 #endif
     else
@@ -240,10 +639,17 @@ int flash_area_write(const struct flash_area *fa, uint32_t off,
     size_t write_start_addr;
     size_t write_end_addr;
     const uint32_t * row_ptr = NULL;
+    uint32_t start = boot_timing_now();
 
     assert(off < fa->fa_off);
     assert(off + len < fa->fa_off);
 
+    /* Data an interrupted upgrade already copied is not written again. */
+    if (upgrade_journal_holds(fa, off, src, len))
+    {
+        return 0;
+    }
+
     /* convert to absolute address inside a device */
     write_start_addr = fa->fa_off + off;
     write_end_addr = fa->fa_off + off + len;
@@ -261,9 +667,10 @@ int flash_area_write(const struct flash_area *fa, uint32_t off,
 
         row_ptr = (uint32_t *) src;
 
-        for (uint32_t i = 0; i < row_number; i++)
+        /* Stop at the first failing row so that its status is returned. */
+        for (uint32_t i = 0; (i < row_number) && (rc == CY_FLASH_DRV_SUCCESS); i++)
         {
-            rc = Cy_Flash_WriteRow(row_addr, row_ptr);
+            rc = flash_row_write(row_addr, row_ptr, (i + 1u) == row_number);
 
             row_addr += (uint32_t) CY_FLASH_SIZEOF_ROW;
             row_ptr = row_ptr + CY_FLASH_SIZEOF_ROW / 4;
@@ -272,7 +679,13 @@ int flash_area_write(const struct flash_area *fa, uint32_t off,
 #ifdef CY_BOOT_USE_EXTERNAL_FLASH
     else if ((fa->fa_device_id & FLASH_DEVICE_EXTERNAL_FLAG) == FLASH_DEVICE_EXTERNAL_FLAG)
     {
-        rc = psoc6_smif_write(fa, write_start_addr, src, len);
+        rc = flash_ext_wait();
+        if (rc == 0)
+        {
+            ext_flash_smif_cmd_mode();
+            rc = psoc6_smif_write(fa, write_start_addr, src, len);
+            ext_flash_cache_invalidate(write_start_addr, len);
+        }
     }
 #endif
     else
@@ -281,42 +694,132 @@ int flash_area_write(const struct flash_area *fa, uint32_t off,
         rc = -1;
     }
 
+    if (rc == CY_FLASH_DRV_SUCCESS)
+    {
+        upgrade_journal_progress(fa, off, len);
+    }
+    flash_timing_copy(fa, start);
     return (int) rc;
 }
 
-/*< Erases `len` bytes of flash memory at `off` */
-int flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t len)
+/*
+* Erases `len` bytes of flash memory at `off` like flash_area_erase(), but
+* returns without waiting for the last external flash erase command. See
+* flash_area_busy(); any later access of the external flash waits for it.
+*/
+int flash_area_erase_start(const struct flash_area *fa, uint32_t off, uint32_t len)
 {
     cy_en_flashdrv_status_t rc = CY_FLASH_DRV_SUCCESS;
     size_t erase_start_addr;
     size_t erase_end_addr;
+    uint32_t keep;
+    uint32_t start = boot_timing_now();
 
     assert(off < fa->fa_off);
     assert(off + len < fa->fa_off);
     assert(!(len % CY_FLASH_SIZEOF_ROW));
 
+    /* Leave the part of a primary slot an interrupted upgrade already
+     * copied; the journal only reports sector-aligned progress.
+     */
+    keep = upgrade_journal_kept(fa, off, len);
+    off += keep;
+    len -= keep;
+    if (len == 0u)
+    {
+        return 0;
+    }
+
     /* convert to absolute address inside a device*/
     erase_start_addr = fa->fa_off + off;
     erase_end_addr = fa->fa_off + off + len;
 
     if (fa->fa_device_id == FLASH_DEVICE_INTERNAL_FLASH)
     {
-        int row_number = 0;
-        uint32_t row_addr = 0;
-
-        row_number = (erase_end_addr - erase_start_addr) / CY_FLASH_SIZEOF_ROW;
-
-        while (row_number != 0)
+        uint32_t erase_addr = erase_start_addr;
+        uint32_t erase_size = 0;
+
+        /* Use the largest aligned granule at each position: sectors in the
+         * middle of the range, subsectors and rows at the unaligned ends.
+         */
+        rc = flash_row_wait();
+        while ((erase_addr < erase_end_addr) && (rc == CY_FLASH_DRV_SUCCESS))
         {
-            row_number--;
-            row_addr = erase_start_addr + row_number * (uint32_t) CY_FLASH_SIZEOF_ROW;
-            rc = Cy_Flash_EraseRow(row_addr);
+            erase_size = flash_int_erase_size(erase_addr, erase_end_addr - erase_addr);
+
+            if (!flash_erase_is_needed(fa, erase_addr, erase_size,
+                                       &flash_erase_stats[FLASH_ERASE_STATS_INTERNAL]))
+            {
+                /* Already blank. */
+            }
+            else if (erase_size == CY_FLASH_SIZEOF_SECTOR)
+            {
+                rc = Cy_Flash_EraseSector(erase_addr);
+            }
+            else if (erase_size == CY_FLASH_SIZEOF_SUBSECTOR)
+            {
+                rc = Cy_Flash_EraseSubsector(erase_addr);
+            }
+            else
+            {
+                rc = Cy_Flash_EraseRow(erase_addr);
+            }
+            erase_addr += erase_size;
         }
     }
 #ifdef CY_BOOT_USE_EXTERNAL_FLASH
     else if ((fa->fa_device_id & FLASH_DEVICE_EXTERNAL_FLAG) == FLASH_DEVICE_EXTERNAL_FLAG)
     {
-        rc = psoc6_smif_erase(erase_start_addr, len);
+        const ext_flash_geometry_t *geo = ext_flash_get_geometry();
+        flash_erase_stats_t *stats = &flash_erase_stats[FLASH_ERASE_STATS_EXTERNAL];
+        uint32_t erase_addr = erase_start_addr - CY_XIP_BASE;
+        uint32_t erase_end = erase_addr + len;
+
+        if (geo == NULL)
+        {
+            rc = -1;
+        }
+        else if ((erase_addr == 0u) && (len >= geo->mem_size))
+        {
+            stats->erased++;
+            rc = flash_ext_wait();
+            if (rc == 0)
+            {
+                rc = ext_flash_smif_erase_chip();
+            }
+            ext_flash_cache_invalidate(CY_XIP_BASE, geo->mem_size);
+        }
+        else
+        {
+            /* Largest aligned erase block from the SFDP tables at each
+             * position; an unaligned end widens to the smallest block.
+             */
+            while ((erase_addr < erase_end) && (rc == CY_FLASH_DRV_SUCCESS))
+            {
+                const ext_flash_erase_type_t *type =
+                    ext_flash_erase_type(erase_addr, erase_end - erase_addr);
+
+                if (type == NULL)
+                {
+                    rc = -1;
+                }
+                else
+                {
+                    erase_addr &= ~(type->size - 1u);
+                    if (flash_erase_is_needed(fa, erase_addr + CY_XIP_BASE, type->size, stats))
+                    {
+                        rc = flash_ext_wait();
+                        if (rc == 0)
+                        {
+                            rc = ext_flash_smif_erase_start(type->cmd, erase_addr);
+                            flash_ext_erase_pending = (rc == 0);
+                        }
+                        ext_flash_cache_invalidate(erase_addr + CY_XIP_BASE, type->size);
+                    }
+                    erase_addr += type->size;
+                }
+            }
+        }
     }
 #endif
     else
@@ -324,9 +827,24 @@ int flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t len)
         /* incorrect/non-existing flash device id */
         rc = -1;
     }
+    flash_timing_copy(fa, start);
     return (int) rc;
 }
 
+/*< Erases `len` bytes of flash memory at `off` */
+int flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t len)
+{
+    int rc = flash_area_erase_start(fa, off, len);
+
+#ifdef CY_BOOT_USE_EXTERNAL_FLASH
+    if ((flash_ext_wait() != 0) && (rc == 0))
+    {
+        rc = -1;
+    }
+#endif
+    return rc;
+}
+
 /*< Returns this `flash_area`s alignment */
 size_t flash_area_align(const struct flash_area *fa)
 {
@@ -438,87 +956,294 @@ uint8_t flash_area_erased_val(const struct flash_area *fap)
     return ret ;
 }
 
+/*
+* Returns true if all `len` bytes at `data` hold the erased value `val`.
+* The unaligned head and tail are compared byte by byte, the body four
+* 32-bit words at a time, and the scan stops at the first programmed word.
+*/
+static bool flash_mem_is_erased(const void *data, uint32_t len, uint8_t val)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    const flash_word_t *w;
+    const uint32_t pattern = FLASH_ERASED_WORD(val);
+
+    while ((len > 0u) && (((uintptr_t)p & (sizeof(flash_word_t) - 1u)) != 0u))
+    {
+        if (*p != val)
+        {
+            return false;
+        }
+        p++;
+        len--;
+    }
+
+    w = (const flash_word_t *)p;
+    while (len >= 4u * sizeof(flash_word_t))
+    {
+        if (((w[0] ^ pattern) | (w[1] ^ pattern) |
+             (w[2] ^ pattern) | (w[3] ^ pattern)) != 0u)
+        {
+            return false;
+        }
+        w += 4;
+        len -= 4u * sizeof(flash_word_t);
+    }
+    while (len >= sizeof(flash_word_t))
+    {
+        if (*w != pattern)
+        {
+            return false;
+        }
+        w++;
+        len -= sizeof(flash_word_t);
+    }
+
+    p = (const uint8_t *)w;
+    while (len > 0u)
+    {
+        if (*p != val)
+        {
+            return false;
+        }
+        p++;
+        len--;
+    }
+    return true;
+}
+
 int flash_area_read_is_empty(const struct flash_area *fa, uint32_t off,
         void *dst, uint32_t len)
 {
-    uint8_t *mem_dest;
     int rc;
 
-    mem_dest = (uint8_t *)dst;
     rc = flash_area_read(fa, off, dst, len);
     if (rc) {
         return -1;
     }
 
-    for (uint8_t i = 0; i < len; i++) {
-        if (mem_dest[i] != flash_area_erased_val(fa)) {
-            return 0;
-        }
-    }
-    return 1;
+    return flash_mem_is_erased(dst, len, flash_area_erased_val(fa)) ? 1 : 0;
 }
 
-#ifdef MCUBOOT_USE_FLASH_AREA_GET_SECTORS
-int flash_area_get_sectors(int idx, uint32_t *cnt, struct flash_sector *ret)
+/*
+* Checks whether `len` bytes at `off` are in the erased state without
+* copying them to a caller buffer. Internal flash is checked in place,
+* external flash is streamed through a small stack buffer.
+* Returns 1 if blank, 0 if not, -1 on error.
+*/
+int flash_area_is_blank(const struct flash_area *fa, uint32_t off, uint32_t len)
 {
-    int rc = 0;
-    uint32_t i = 0;
-    struct flash_area *fa = NULL;
+    int rc = 1;
 
-    while(NULL != boot_area_descs[i])
+    if ((off > fa->fa_size) || (len > (fa->fa_size - off)))
     {
-        if(idx == boot_area_descs[i]->fa_id)
+        rc = -1;
+    }
+    else if (fa->fa_device_id == FLASH_DEVICE_INTERNAL_FLASH)
+    {
+        if (flash_area_sync() != 0)
+        {
+            rc = -1;
+        }
+        else if (!flash_mem_is_erased((const void *)(uintptr_t)(fa->fa_off + off), len,
+                                 CY_BOOT_INTERNAL_FLASH_ERASE_VALUE))
         {
-            fa = boot_area_descs[i];
-            break;
+            rc = 0;
         }
-        i++;
     }
-
-    if(NULL != boot_area_descs[i])
+#ifdef CY_BOOT_USE_EXTERNAL_FLASH
+    else if ((fa->fa_device_id & FLASH_DEVICE_EXTERNAL_FLAG) == FLASH_DEVICE_EXTERNAL_FLAG)
     {
-        size_t sector_size = 0;
+        uint32_t buf[CY_BOOT_BLANK_CHECK_BUF_SIZE / sizeof(uint32_t)];
+        uint32_t chunk;
 
-        if(fa->fa_device_id == FLASH_DEVICE_INTERNAL_FLASH)
+        while ((len > 0u) && (rc == 1))
         {
-            sector_size = CY_FLASH_SIZEOF_ROW;
+            chunk = (len < sizeof(buf)) ? len : sizeof(buf);
+
+            if (flash_area_read(fa, off, buf, chunk) != 0)
+            {
+                rc = -1;
+            }
+            else if (!flash_mem_is_erased(buf, chunk, CY_BOOT_EXTERNAL_FLASH_ERASE_VALUE))
+            {
+                rc = 0;
+            }
+            off += chunk;
+            len -= chunk;
         }
+    }
+#endif
+    else
+    {
+        /* incorrect/non-existing flash device id */
+        rc = -1;
+    }
+    return rc;
+}
+
+/*
+* Returns the largest erase granule of `fa` that starts at `off` and fits in
+* the area, in *size. Returns 0, or -1 if the granule is not known. Callers
+* that erase a whole area step by step use it to send as few erase commands
+* as possible; flash_area_erase_start() splits any range the same way.
+*/
+int flash_area_erase_granule(const struct flash_area *fa, uint32_t off, uint32_t *size)
+{
+    int rc = -1;
+
+    if (off >= fa->fa_size)
+    {
+        rc = -1;
+    }
+    else if (fa->fa_device_id == FLASH_DEVICE_INTERNAL_FLASH)
+    {
+        *size = flash_int_erase_size(fa->fa_off + off, fa->fa_size - off);
+        rc = 0;
+    }
 #ifdef CY_BOOT_USE_EXTERNAL_FLASH
-        else if((fa->fa_device_id & FLASH_DEVICE_EXTERNAL_FLAG) == FLASH_DEVICE_EXTERNAL_FLAG)
+    else if ((fa->fa_device_id & FLASH_DEVICE_EXTERNAL_FLAG) == FLASH_DEVICE_EXTERNAL_FLAG)
+    {
+        const ext_flash_erase_type_t *type =
+            ext_flash_erase_type(fa->fa_off + off - CY_XIP_BASE, fa->fa_size - off);
+
+        if (type != NULL)
         {
-            /* Implement for SMIF. */
-            sector_size = CY_EXTERNAL_FLASH_SECTOR_SIZE;
+            *size = type->size;
+            rc = 0;
         }
+    }
 #endif
-        else
-        {
-            rc = -1;
-        }
+    else
+    {
+        /* incorrect/non-existing flash device id */
+        rc = -1;
+    }
+    return rc;
+}
 
-        if(0 == rc)
-        {
-            uint32_t addr = 0;
-            size_t sectors_n = 0;
+#ifdef MCUBOOT_USE_FLASH_AREA_GET_SECTORS
+/*
+* Returns the sector layout of `fa`, computing it on first use. All sectors
+* of an area have one size, a power of two, so that MCUboot finds any two
+* slots compatible; with MCUBOOT_OVERWRITE_ONLY, boot_slots_compatible()
+* rejects slots where neither side's sectors always nest in the other's.
+* Internal sectors are rows. External sectors are the largest of the
+* smallest erase blocks of the regions the area crosses, and at least
+* FLASH_EXT_SECTOR_MIN, so every sector can be erased on its own and the
+* count stays within the build-time check above. flash_area_erase_start() still uses the largest
+* granules inside each range it is given.
+*/
+static const flash_area_sectors_t *flash_area_sectors(const struct flash_area *fa)
+{
+    flash_area_sectors_t *sectors = &boot_area_sectors[fa->fa_id];
+    uint32_t size = 0;
 
-            sectors_n = (fa->fa_size + (sector_size - 1)) / sector_size;
-            assert(sectors_n <= *cnt);
+    if (sectors->valid)
+    {
+        return sectors;
+    }
 
-            addr = fa->fa_off;
-            for(i = 0; i < sectors_n; i++)
+    if (fa->fa_device_id == FLASH_DEVICE_INTERNAL_FLASH)
+    {
+        size = CY_FLASH_SIZEOF_ROW;
+    }
+#ifdef CY_BOOT_USE_EXTERNAL_FLASH
+    else if ((fa->fa_device_id & FLASH_DEVICE_EXTERNAL_FLAG) == FLASH_DEVICE_EXTERNAL_FLAG)
+    {
+        uint32_t addr = fa->fa_off - CY_XIP_BASE;
+        uint32_t end = addr + fa->fa_size;
+
+        size = FLASH_EXT_SECTOR_MIN;
+
+        while (addr < end)
+        {
+            /* With a length of 1, the smallest block of the region. */
+            const ext_flash_erase_type_t *type = ext_flash_erase_type(addr, 1u);
+
+            if (type == NULL)
             {
-                ret[i].fs_size = sector_size ;
-                ret[i].fs_off = addr ;
-                addr += sector_size ;
+                return NULL;
             }
-
-            *cnt = sectors_n;
+            if (type->size > size)
+            {
+                size = type->size;
+            }
+            addr = (addr & ~(type->size - 1u)) + type->size;
         }
     }
+#endif
     else
     {
-        rc = -1;
+        return NULL;
+    }
+
+    sectors->sector_size = size;
+    sectors->sector_count = (fa->fa_size + size - 1u) / size;
+    sectors->valid = true;
+    return sectors;
+}
+
+/*
+* Returns true if `off` is the start or end of a sector of `fa` as reported
+* by flash_area_get_sectors().
+*/
+bool flash_area_is_sector_boundary(const struct flash_area *fa, uint32_t off)
+{
+    const flash_area_sectors_t *sectors = flash_area_sectors(fa);
+
+    return (sectors != NULL) && (off <= fa->fa_size) && ((off % sectors->sector_size) == 0u);
+}
+
+/*
+* Finds the sector of `fa` holding offset `off`; sets its offset within the
+* area and its size. Returns 0, or -1 if `off` is outside the area.
+*/
+int flash_area_sector_of(const struct flash_area *fa, uint32_t off,
+                         uint32_t *start, uint32_t *size)
+{
+    const flash_area_sectors_t *sectors = flash_area_sectors(fa);
+
+    if ((sectors == NULL) || (off >= fa->fa_size))
+    {
+        return -1;
+    }
+
+    *start = off - (off % sectors->sector_size);
+    *size = sectors->sector_size;
+    return 0;
+}
+
+int flash_area_get_sectors(int idx, uint32_t *cnt, struct flash_sector *ret)
+{
+    int rc = -1;
+    const struct flash_area *fa = flash_area_lookup(idx);
+    const flash_area_sectors_t *sectors = NULL;
+
+    if (NULL != fa)
+    {
+        sectors = flash_area_sectors(fa);
+    }
+
+    if ((NULL != sectors) && (sectors->sector_count > *cnt))
+    {
+        BOOT_LOG_ERR("Flash area %d has %u sectors, only %u fit",
+                     idx, (unsigned int)sectors->sector_count, (unsigned int)*cnt);
+    }
+    else if (NULL != sectors)
+    {
+        uint32_t addr = fa->fa_off;
+
+        for (uint32_t i = 0; i < sectors->sector_count; i++)
+        {
+            ret[i].fs_off = addr;
+            ret[i].fs_size = sectors->sector_size;
+            addr += sectors->sector_size;
+        }
+
+        *cnt = sectors->sector_count;
+        rc = 0;
     }
 
     return rc;
 }
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,96 @@
+/******************************************************************************
+* File Name:   ext_flash_map.h
+*
+* Description:
+* This file declares the flash backend services that ext_flash_map.c provides
+* in addition to the MCUboot flash map API.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef EXT_FLASH_MAP_H_
+#define EXT_FLASH_MAP_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "flash_map_backend/flash_map_backend.h"
+
+/* Area holding the primary slot validation records (boot_validate.c). It is
+ * not an MCUboot area, so its id follows the ones MCUboot uses.
+ */
+#define FLASH_AREA_VALIDATION                   (FLASH_AREA_IMAGE_3 + 1)
+
+/* Area holding the external memory configuration of the last boots
+ * (ext_flash_sfdp_cache.c).
+ */
+#define FLASH_AREA_SFDP_CACHE                   (FLASH_AREA_VALIDATION + 1)
+
+/* Erase activity of one flash device since reset. */
+typedef struct
+{
+    uint32_t erased;            /* Erase commands issued */
+    uint32_t skipped;           /* Granules not erased because already blank */
+    uint32_t skipped_bytes;     /* Size of the skipped granules */
+} flash_erase_stats_t;
+
+/* Returns 1 if `len` bytes at `off` are erased, 0 if not, -1 on error. */
+int flash_area_is_blank(const struct flash_area *fa, uint32_t off, uint32_t len);
+
+/* Waits for a background internal flash row write. Returns 0 or -1 on error. */
+int flash_area_sync(void);
+
+/* Starts an erase; the last external erase command runs in the background. */
+int flash_area_erase_start(const struct flash_area *fa, uint32_t off, uint32_t len);
+
+/* Returns true while a background write or erase occupies the device of `fa`. */
+bool flash_area_busy(const struct flash_area *fa);
+
+/* Waits, with the device timeout, for the background write or erase of the
+ * device of `fa`. Returns 0 or -1 on error.
+ */
+int flash_area_wait(const struct flash_area *fa);
+
+/* Returns the erase counters of a flash device, NULL if unknown. */
+const flash_erase_stats_t *flash_area_get_erase_stats(uint8_t fa_device_id);
+
+/* Largest erase granule of `fa` at `off`. Returns 0, or -1 if unknown. */
+int flash_area_erase_granule(const struct flash_area *fa, uint32_t off, uint32_t *size);
+
+/* Returns true if `off` is a sector boundary of `fa`. */
+bool flash_area_is_sector_boundary(const struct flash_area *fa, uint32_t off);
+
+/* Finds the sector of `fa` holding `off`. Returns 0, or -1 if there is none. */
+int flash_area_sector_of(const struct flash_area *fa, uint32_t off,
+                         uint32_t *start, uint32_t *size);
+
+#endif /* EXT_FLASH_MAP_H_ */
@@ -0,0 +1,644 @@
+/******************************************************************************
+* File Name:   ext_flash_sfdp.c
+*
+* Description:
+* This file reads the erase geometry of the external QSPI memory from its SFDP
+* tables, so that ranges can be erased with the largest aligned blocks the
+* memory supports instead of always the single sector erase the PDL
+* configures. Hybrid memories are described by the Sector Map Parameter
+* Table, which gives the erase types valid in each address region.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bootutil/bootutil_log.h"
+
+#include "ext_flash_smif.h"
+#include "ext_flash_sfdp.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define SFDP_SIGNATURE                  (0x50444653UL)  /* "SFDP" */
+#define SFDP_HEADER_SIZE                (8U)
+#define SFDP_PARAM_HEADER_SIZE          (8U)
+#define SFDP_MAX_PARAM_HEADERS          (8U)
+
+/* Parameter IDs: Basic Flash Parameter Table and Sector Map Parameter Table. */
+#define SFDP_PARAM_ID_BFPT              (0xFF00U)
+#define SFDP_PARAM_ID_SECTOR_MAP        (0xFF81U)
+
+/* BFPT DWORDs 8 and 9 hold the size exponent and instruction of the four
+ * erase types.
+ */
+#define SFDP_BFPT_ERASE_DWORD           (7U)
+#define SFDP_BFPT_DWORDS                (9U)
+
+/* BFPT DWORD 15 (JESD216B) describes quad I/O (0-4-4) continuous read. The
+ * bootloader enters it with mode bits A5h and leaves it by driving Fh on
+ * DQ0-DQ3, see ext_flash_smif_mode_reset(); other methods are not used.
+ */
+#define SFDP_BFPT_044_DWORD             (14U)
+#define SFDP_BFPT_DWORDS_MAX            (15U)
+#define SFDP_BFPT_044_SUPPORT           (1UL << 9)
+#define SFDP_BFPT_044_EXIT_MODE_RESET   (1UL << 11)
+#define SFDP_BFPT_044_ENTRY_A5          (1UL << 16)
+#define SFDP_044_MODE_BITS              (0xA5U)
+
+/* Sector Map Parameter Table: optional detection command descriptors (two
+ * DWORDs each) followed by map descriptors, each a header DWORD and one DWORD
+ * per region.
+ */
+#define SFDP_SMPT_DWORDS_MAX            (32U)
+#define SMPT_DESC_END                   (0x01UL)
+#define SMPT_DESC_MAP                   (0x02UL)
+#define SMPT_CMD_INSTR(d)               ((uint8_t)((d) >> 8))
+#define SMPT_CMD_LATENCY(d)             (((d) >> 16) & 0x0FUL)
+#define SMPT_CMD_ADDR_LEN(d)            (((d) >> 22) & 0x03UL)
+#define SMPT_CMD_READ_MASK(d)           ((uint8_t)((d) >> 24))
+#define SMPT_MAP_ID(d)                  (((d) >> 8) & 0xFFUL)
+#define SMPT_MAP_REGIONS(d)             ((((d) >> 16) & 0xFFUL) + 1U)
+#define SMPT_REGION_SIZE(d)             ((((d) >> 8) + 1UL) * 256UL)
+#define SMPT_REGION_ERASE_TYPES(d)      ((d) & 0x0FUL)
+
+/* Detection command latency meaning "current setting" of the memory. */
+#define SMPT_CMD_LATENCY_VARIABLE       (0x0FUL)
+#define SMPT_CMD_DEFAULT_DUMMY_CYCLES   (8U)
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+static ext_flash_geometry_t ext_flash_geometry;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static uint32_t sfdp_get_u32(const uint8_t *p);
+static uint8_t sfdp_erase_cmd_4b(uint8_t cmd);
+static void geometry_add_erase_type(uint32_t size, uint8_t cmd);
+static void geometry_set_uniform(void);
+static void geometry_set_cont_read(void);
+static uint32_t sfdp_smpt_addr_bytes(uint32_t desc, const ext_flash_smif_info_t *info);
+static int sfdp_set_regions(const uint8_t *map, uint32_t count, const uint32_t *bfpt_size);
+static int sfdp_read_sector_map(const ext_flash_smif_info_t *info, uint32_t ptr,
+                                uint32_t dwords, const uint32_t *bfpt_size);
+static int sfdp_read_tables(const ext_flash_smif_info_t *info);
+static const ext_flash_region_t *ext_flash_region(const ext_flash_geometry_t *geo,
+                                                  uint32_t addr);
+
+/******************************************************************************
+ * Function Name: sfdp_get_u32
+ ******************************************************************************
+ * Summary:
+ *  Returns the little-endian SFDP DWORD at `p`.
+ *
+ ******************************************************************************/
+static uint32_t sfdp_get_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/******************************************************************************
+ * Function Name: sfdp_erase_cmd_4b
+ ******************************************************************************
+ * Summary:
+ *  Returns the 4-byte address variant of a BFPT erase instruction, or 0 if
+ *  there is no standard one.
+ *
+ ******************************************************************************/
+static uint8_t sfdp_erase_cmd_4b(uint8_t cmd)
+{
+    switch (cmd)
+    {
+    case 0x20U: return 0x21U;   /* 4 KB */
+    case 0x52U: return 0x5CU;   /* 32 KB */
+    case 0xD8U: return 0xDCU;   /* 64 KB or 256 KB sector */
+    default:    return 0U;
+    }
+}
+
+/******************************************************************************
+ * Function Name: geometry_add_erase_type
+ ******************************************************************************
+ * Summary:
+ *  Adds an erase type to the geometry, keeping the list sorted largest first
+ *  and ignoring sizes that are already known.
+ *
+ ******************************************************************************/
+static void geometry_add_erase_type(uint32_t size, uint8_t cmd)
+{
+    ext_flash_geometry_t *geo = &ext_flash_geometry;
+    uint32_t i;
+
+    if ((cmd == 0U) || (geo->erase_type_count >= EXT_FLASH_ERASE_TYPES_MAX))
+    {
+        return;
+    }
+
+    for (i = 0; i < geo->erase_type_count; i++)
+    {
+        if (geo->erase_type[i].size == size)
+        {
+            return;
+        }
+        if (geo->erase_type[i].size < size)
+        {
+            break;
+        }
+    }
+
+    for (uint32_t j = geo->erase_type_count; j > i; j--)
+    {
+        geo->erase_type[j] = geo->erase_type[j - 1U];
+    }
+    geo->erase_type[i].size = size;
+    geo->erase_type[i].cmd = cmd;
+    geo->erase_type_count++;
+}
+
+/******************************************************************************
+ * Function Name: geometry_set_uniform
+ ******************************************************************************
+ * Summary:
+ *  Describes the memory as a single region in which every erase type is
+ *  valid.
+ *
+ ******************************************************************************/
+static void geometry_set_uniform(void)
+{
+    ext_flash_geometry_t *geo = &ext_flash_geometry;
+
+    geo->region_count = 1U;
+    geo->region[0].start = 0U;
+    geo->region[0].size = geo->mem_size;
+    geo->region[0].erase_types = (uint8_t)((1UL << geo->erase_type_count) - 1U);
+}
+
+/******************************************************************************
+ * Function Name: geometry_set_cont_read
+ ******************************************************************************
+ * Summary:
+ *  Lets the XIP window keep the memory in continuous read if the geometry
+ *  allows it, and clears it from the geometry if the configured read
+ *  instruction does not.
+ *
+ ******************************************************************************/
+static void geometry_set_cont_read(void)
+{
+    if (ext_flash_smif_set_cont_read((uint8_t)ext_flash_geometry.cont_read_mode) != 0)
+    {
+        ext_flash_geometry.cont_read_mode = 0U;
+        (void)ext_flash_smif_set_cont_read(0U);
+    }
+}
+
+/******************************************************************************
+ * Function Name: sfdp_smpt_addr_bytes
+ ******************************************************************************
+ * Summary:
+ *  Returns the number of address bytes of a sector map detection command.
+ *
+ ******************************************************************************/
+static uint32_t sfdp_smpt_addr_bytes(uint32_t desc, const ext_flash_smif_info_t *info)
+{
+    switch (SMPT_CMD_ADDR_LEN(desc))
+    {
+    case 0U:  return 0U;
+    case 1U:  return 3U;
+    case 2U:  return 4U;
+    default:  return info->addr_bytes;
+    }
+}
+
+/******************************************************************************
+ * Function Name: sfdp_set_regions
+ ******************************************************************************
+ * Summary:
+ *  Sets the regions from the `count` region DWORDs of a sector map. The map
+ *  refers to erase types by their BFPT index, `bfpt_size` gives the size of
+ *  each so that they can be found in the sorted list.
+ *
+ * Return:
+ *  0 on success, -1 if the map does not describe the whole memory.
+ *
+ ******************************************************************************/
+static int sfdp_set_regions(const uint8_t *map, uint32_t count, const uint32_t *bfpt_size)
+{
+    ext_flash_geometry_t *geo = &ext_flash_geometry;
+    uint32_t start = 0U;
+
+    if (count > EXT_FLASH_REGIONS_MAX)
+    {
+        return -1;
+    }
+
+    for (uint32_t r = 0; r < count; r++)
+    {
+        uint32_t desc = sfdp_get_u32(&map[4U * r]);
+        uint8_t types = 0U;
+
+        for (uint32_t t = 0; t < EXT_FLASH_ERASE_TYPES_MAX; t++)
+        {
+            if ((SMPT_REGION_ERASE_TYPES(desc) & (1UL << t)) == 0U)
+            {
+                continue;
+            }
+            for (uint32_t i = 0; i < geo->erase_type_count; i++)
+            {
+                if (geo->erase_type[i].size == bfpt_size[t])
+                {
+                    types |= (uint8_t)(1U << i);
+                }
+            }
+        }
+
+        if (types == 0U)
+        {
+            return -1;
+        }
+
+        geo->region[r].start = start;
+        geo->region[r].size = SMPT_REGION_SIZE(desc);
+        geo->region[r].erase_types = types;
+        start += geo->region[r].size;
+    }
+
+    if (start != geo->mem_size)
+    {
+        return -1;
+    }
+
+    geo->region_count = count;
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: sfdp_read_sector_map
+ ******************************************************************************
+ * Summary:
+ *  Reads the Sector Map Parameter Table at `ptr`, runs its detection
+ *  commands to find the current configuration and sets the regions of the
+ *  matching map.
+ *
+ * Return:
+ *  0 on success, -1 if the table cannot be read or has no matching map.
+ *
+ ******************************************************************************/
+static int sfdp_read_sector_map(const ext_flash_smif_info_t *info, uint32_t ptr,
+                                uint32_t dwords, const uint32_t *bfpt_size)
+{
+    uint8_t smpt[SFDP_SMPT_DWORDS_MAX * 4U];
+    uint32_t map_id = 0U;
+    uint32_t i = 0U;
+
+    if ((dwords > SFDP_SMPT_DWORDS_MAX) ||
+        (ext_flash_smif_read_sfdp(ptr, smpt, dwords * 4U) != 0))
+    {
+        return -1;
+    }
+
+    /* Each detection command reads one bit of the configuration ID, the
+     * first command giving the most significant bit.
+     */
+    while ((i + 1U < dwords) && ((sfdp_get_u32(&smpt[4U * i]) & SMPT_DESC_MAP) == 0U))
+    {
+        uint32_t desc = sfdp_get_u32(&smpt[4U * i]);
+        uint32_t dummy = SMPT_CMD_LATENCY(desc);
+        uint8_t val;
+
+        if (dummy == SMPT_CMD_LATENCY_VARIABLE)
+        {
+            dummy = SMPT_CMD_DEFAULT_DUMMY_CYCLES;
+        }
+        if (ext_flash_smif_read_cmd(SMPT_CMD_INSTR(desc), sfdp_get_u32(&smpt[4U * (i + 1U)]),
+                                    sfdp_smpt_addr_bytes(desc, info), dummy, &val, 1U) != 0)
+        {
+            return -1;
+        }
+        map_id = (map_id << 1) | (((val & SMPT_CMD_READ_MASK(desc)) != 0U) ? 1U : 0U);
+        i += 2U;
+    }
+
+    while (i < dwords)
+    {
+        uint32_t desc = sfdp_get_u32(&smpt[4U * i]);
+        uint32_t count = SMPT_MAP_REGIONS(desc);
+
+        if (((desc & SMPT_DESC_MAP) == 0U) || ((i + 1U + count) > dwords))
+        {
+            break;
+        }
+        if (SMPT_MAP_ID(desc) == map_id)
+        {
+            return sfdp_set_regions(&smpt[4U * (i + 1U)], count, bfpt_size);
+        }
+        if ((desc & SMPT_DESC_END) != 0U)
+        {
+            break;
+        }
+        i += 1U + count;
+    }
+    return -1;
+}
+
+/******************************************************************************
+ * Function Name: sfdp_read_tables
+ ******************************************************************************
+ * Summary:
+ *  Adds the erase types of the Basic Flash Parameter Table and, for hybrid
+ *  memories, reads the regions from the Sector Map Parameter Table. Also
+ *  notes whether the memory supports quad I/O continuous read.
+ *
+ * Return:
+ *  0 on success, -1 if the SFDP tables cannot be read.
+ *
+ ******************************************************************************/
+static int sfdp_read_tables(const ext_flash_smif_info_t *info)
+{
+    uint8_t hdr[SFDP_HEADER_SIZE + SFDP_MAX_PARAM_HEADERS * SFDP_PARAM_HEADER_SIZE];
+    uint8_t bfpt[SFDP_BFPT_DWORDS_MAX * 4U];
+    uint32_t bfpt_size[EXT_FLASH_ERASE_TYPES_MAX] = { 0U };
+    uint32_t nph;
+    uint32_t bfpt_ptr = 0;
+    uint32_t bfpt_dwords = 0;
+    uint32_t smpt_ptr = 0;
+    uint32_t smpt_dwords = 0;
+
+    if ((ext_flash_smif_read_sfdp(0U, hdr, sizeof(hdr)) != 0) ||
+        (sfdp_get_u32(hdr) != SFDP_SIGNATURE))
+    {
+        return -1;
+    }
+
+    nph = (uint32_t)hdr[6] + 1U;
+    if (nph > SFDP_MAX_PARAM_HEADERS)
+    {
+        nph = SFDP_MAX_PARAM_HEADERS;
+    }
+
+    for (uint32_t i = 0; i < nph; i++)
+    {
+        const uint8_t *ph = &hdr[SFDP_HEADER_SIZE + i * SFDP_PARAM_HEADER_SIZE];
+        uint32_t id = ((uint32_t)ph[7] << 8) | ph[0];
+
+        if ((id == SFDP_PARAM_ID_BFPT) && (bfpt_dwords == 0U))
+        {
+            bfpt_dwords = ph[3];
+            bfpt_ptr = sfdp_get_u32(&ph[4]) & 0x00FFFFFFUL;
+        }
+        else if ((id == SFDP_PARAM_ID_SECTOR_MAP) && (smpt_dwords == 0U))
+        {
+            smpt_dwords = ph[3];
+            smpt_ptr = sfdp_get_u32(&ph[4]) & 0x00FFFFFFUL;
+        }
+        else
+        {
+            /* Vendor tables are not used. */
+        }
+    }
+
+    if (bfpt_dwords < SFDP_BFPT_DWORDS)
+    {
+        return -1;
+    }
+    if (bfpt_dwords > SFDP_BFPT_DWORDS_MAX)
+    {
+        bfpt_dwords = SFDP_BFPT_DWORDS_MAX;
+    }
+    if (ext_flash_smif_read_sfdp(bfpt_ptr, bfpt, bfpt_dwords * 4U) != 0)
+    {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < EXT_FLASH_ERASE_TYPES_MAX; i++)
+    {
+        uint8_t exp = bfpt[SFDP_BFPT_ERASE_DWORD * 4U + 2U * i];
+        uint8_t cmd = bfpt[SFDP_BFPT_ERASE_DWORD * 4U + 2U * i + 1U];
+
+        if ((exp == 0U) || (exp >= 32U))
+        {
+            continue;
+        }
+        if (info->addr_bytes == 4U)
+        {
+            cmd = sfdp_erase_cmd_4b(cmd);
+        }
+        bfpt_size[i] = 1UL << exp;
+        geometry_add_erase_type(bfpt_size[i], cmd);
+    }
+
+    if (bfpt_dwords > SFDP_BFPT_044_DWORD)
+    {
+        uint32_t dw = sfdp_get_u32(&bfpt[SFDP_BFPT_044_DWORD * 4U]);
+        uint32_t need = SFDP_BFPT_044_SUPPORT | SFDP_BFPT_044_EXIT_MODE_RESET |
+                        SFDP_BFPT_044_ENTRY_A5;
+
+        if ((dw & need) == need)
+        {
+            ext_flash_geometry.cont_read_mode = SFDP_044_MODE_BITS;
+        }
+    }
+
+    geometry_set_uniform();
+    if (smpt_dwords != 0U)
+    {
+        return sfdp_read_sector_map(info, smpt_ptr, smpt_dwords, bfpt_size);
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_sfdp_init
+ ******************************************************************************
+ * Summary:
+ *  Builds the external memory geometry. Must be called after
+ *  qspi_init_sfdp(); ext_flash_get_geometry() calls it on first use.
+ *
+ * Return:
+ *  0 on success, -1 if the memory is not initialized.
+ *
+ ******************************************************************************/
+int ext_flash_sfdp_init(void)
+{
+    ext_flash_smif_info_t info;
+
+    ext_flash_geometry.erase_type_count = 0;
+    ext_flash_geometry.region_count = 0;
+    ext_flash_geometry.cont_read_mode = 0U;
+
+    if (ext_flash_smif_info(&info) != 0)
+    {
+        return -1;
+    }
+
+    ext_flash_geometry.mem_size = info.mem_size;
+    geometry_add_erase_type(info.erase_size, info.erase_cmd);
+
+    if (sfdp_read_tables(&info) != 0)
+    {
+        /* Without a usable sector map the erase types the BFPT lists may not
+         * be valid everywhere; the configured sector erase always is.
+         */
+        BOOT_LOG_WRN("SFDP erase geometry not available, using %u byte sectors",
+                     (unsigned int)info.erase_size);
+        ext_flash_geometry.erase_type_count = 0;
+        ext_flash_geometry.cont_read_mode = 0U;
+        geometry_add_erase_type(info.erase_size, info.erase_cmd);
+        geometry_set_uniform();
+    }
+
+    geometry_set_cont_read();
+    if (ext_flash_geometry.cont_read_mode != 0U)
+    {
+        BOOT_LOG_DBG("External memory XIP reads use continuous read");
+    }
+    return (ext_flash_geometry.erase_type_count != 0U) ? 0 : -1;
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_get_geometry
+ ******************************************************************************
+ * Summary:
+ *  Returns the external memory geometry, or NULL if it is not available.
+ *
+ ******************************************************************************/
+const ext_flash_geometry_t *ext_flash_get_geometry(void)
+{
+    if ((ext_flash_geometry.erase_type_count == 0U) && (ext_flash_sfdp_init() != 0))
+    {
+        return NULL;
+    }
+    return &ext_flash_geometry;
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_set_geometry
+ ******************************************************************************
+ * Summary:
+ *  Uses `geo`, built by a previous boot for the same memory, instead of
+ *  reading the SFDP tables again, including its continuous read setting.
+ *
+ * Return:
+ *  0 on success, -1 if `geo` does not describe a usable memory.
+ *
+ ******************************************************************************/
+int ext_flash_set_geometry(const ext_flash_geometry_t *geo)
+{
+    if ((geo->erase_type_count == 0U) || (geo->erase_type_count > EXT_FLASH_ERASE_TYPES_MAX) ||
+        (geo->region_count == 0U) || (geo->region_count > EXT_FLASH_REGIONS_MAX))
+    {
+        return -1;
+    }
+
+    ext_flash_geometry = *geo;
+    geometry_set_cont_read();
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_region
+ ******************************************************************************
+ * Summary:
+ *  Returns the region that contains offset `addr`, or NULL if `addr` is
+ *  outside the memory.
+ *
+ ******************************************************************************/
+static const ext_flash_region_t *ext_flash_region(const ext_flash_geometry_t *geo,
+                                                  uint32_t addr)
+{
+    for (uint32_t r = 0; r < geo->region_count; r++)
+    {
+        if ((addr - geo->region[r].start) < geo->region[r].size)
+        {
+            return &geo->region[r];
+        }
+    }
+    return NULL;
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_erase_type
+ ******************************************************************************
+ * Summary:
+ *  Returns the largest erase type valid in the region of offset `addr` whose
+ *  block starts at `addr` and fits in `len` bytes and in the region. If none
+ *  does, returns the smallest one of the region: like
+ *  Cy_SMIF_MemEraseSector(), the caller then erases the whole block that
+ *  contains `addr`.
+ *
+ * Return:
+ *  The erase type, or NULL if the geometry is not available or `addr` is
+ *  outside the memory.
+ *
+ ******************************************************************************/
+const ext_flash_erase_type_t *ext_flash_erase_type(uint32_t addr, uint32_t len)
+{
+    const ext_flash_geometry_t *geo = ext_flash_get_geometry();
+    const ext_flash_region_t *region = NULL;
+    const ext_flash_erase_type_t *smallest = NULL;
+    uint32_t room;
+
+    if (geo != NULL)
+    {
+        region = ext_flash_region(geo, addr);
+    }
+    if (region == NULL)
+    {
+        return NULL;
+    }
+
+    room = region->start + region->size - addr;
+    if (len > room)
+    {
+        len = room;
+    }
+
+    for (uint32_t i = 0; i < geo->erase_type_count; i++)
+    {
+        if ((region->erase_types & (1U << i)) == 0U)
+        {
+            continue;
+        }
+        smallest = &geo->erase_type[i];
+        if (((addr & (smallest->size - 1U)) == 0U) && (smallest->size <= len))
+        {
+            return smallest;
+        }
+    }
+    return smallest;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,89 @@
+/******************************************************************************
+* File Name:   ext_flash_sfdp.h
+*
+* Description:
+* This file declares the external flash geometry read from the SFDP tables of
+* the QSPI memory.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef EXT_FLASH_SFDP_H_
+#define EXT_FLASH_SFDP_H_
+
+#include <stdint.h>
+
+/* JESD216 defines up to four erase types. */
+#define EXT_FLASH_ERASE_TYPES_MAX       (4U)
+
+/* Sector map regions supported; hybrid memories typically have two or
+ * three (parameter sectors at the bottom and/or top, uniform sectors in
+ * between).
+ */
+#define EXT_FLASH_REGIONS_MAX           (4U)
+
+/* One erase instruction and the size of the block it erases. */
+typedef struct
+{
+    uint32_t size;
+    uint8_t cmd;
+} ext_flash_erase_type_t;
+
+/* Address range of the memory with its own set of erase types. */
+typedef struct
+{
+    uint32_t start;
+    uint32_t size;
+    uint8_t erase_types;    /* Bit i set: erase_type[i] is valid here */
+} ext_flash_region_t;
+
+/* External memory geometry. Erase types are sorted largest first; regions
+ * are sorted by address and cover the whole memory. cont_read_mode holds the
+ * mode bits that keep the memory in quad I/O continuous read, or 0 if the
+ * SFDP tables do not describe a continuous read the bootloader can use.
+ */
+typedef struct
+{
+    uint32_t mem_size;
+    uint32_t erase_type_count;
+    ext_flash_erase_type_t erase_type[EXT_FLASH_ERASE_TYPES_MAX];
+    uint32_t region_count;
+    ext_flash_region_t region[EXT_FLASH_REGIONS_MAX];
+    uint32_t cont_read_mode;
+} ext_flash_geometry_t;
+
+int ext_flash_sfdp_init(void);
+const ext_flash_geometry_t *ext_flash_get_geometry(void);
+int ext_flash_set_geometry(const ext_flash_geometry_t *geo);
+const ext_flash_erase_type_t *ext_flash_erase_type(uint32_t addr, uint32_t len);
+
+#endif /* EXT_FLASH_SFDP_H_ */
@@ -0,0 +1,384 @@
+/******************************************************************************
+* File Name:   ext_flash_sfdp_cache.c
+*
+* Description:
+* This file sets up the external memory without reading its SFDP tables on
+* every boot. The first boot runs qspi_init_sfdp() and keeps what it found,
+* the SMIF memory configuration and the erase geometry (ext_flash_sfdp.c), in
+* a record in the SFDP cache area together with the JEDEC ID of the memory,
+* checked like a validation record (boot_validate.c). Later boots set the SMIF
+* up from the record and only read the JEDEC ID to check that the memory is
+* still the same; if it is not, they detect it again and write a new record.
+* Either way the configuration in use is handed to the CM4 application
+* (boot_shared.h), which then skips its own detection.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "flash_map_backend/flash_map_backend.h"
+#include "sysflash.h"
+#include "bootutil/bootutil_log.h"
+
+#include "cy_pdl.h"
+#include "ext_flash_map.h"
+#include "ext_flash_sfdp.h"
+#include "ext_flash_smif.h"
+#include "boot_crypto.h"
+#include "boot_handoff.h"
+#include "ext_flash_sfdp_cache.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#ifndef CY_BOOT_SFDP_CACHE
+/* Set to 0 to detect the memory on every boot. */
+#define CY_BOOT_SFDP_CACHE                      (1)
+#endif
+
+#ifndef CY_BOOT_SFDP_CACHE_KEY
+/* Value the record key is derived from; see CY_BOOT_VALIDATE_KEY. */
+#define CY_BOOT_SFDP_CACHE_KEY                  "CE231678 sample SFDP cache key"
+#endif
+
+#define SFDP_CACHE_MAGIC                        (0x43504653UL)  /* "SFPC" */
+
+/* Row index meaning no record. */
+#define SFDP_CACHE_NO_ROW                       (0xFFFFFFFFUL)
+
+/*******************************************************************************
+* Data types
+********************************************************************************/
+/* Configuration of the memory on one chip select, stored at the start of a
+ * row of the SFDP cache area (228 bytes).
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t seq;                                   /* Incremented per record */
+    uint32_t smif_id;                               /* Chip select, see qspi_init_sfdp() */
+    boot_qspi_cfg_t cfg;                            /* SMIF configuration and JEDEC ID */
+    ext_flash_geometry_t geometry;                  /* Erase geometry */
+    uint8_t mac[BOOT_SHA256_SIZE];                  /* HMAC of the fields above */
+} sfdp_cache_rec_t;
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+#if (CY_BOOT_SFDP_CACHE != 0)
+static struct
+{
+    uint32_t seq;               /* Sequence number of the latest record */
+    uint32_t row;               /* Row holding it */
+    sfdp_cache_rec_t rec;       /* Latest record of the chip select, magic 0 if none */
+} sfdp_cache;
+
+static uint8_t sfdp_cache_key[BOOT_SHA256_SIZE];
+static uint32_t sfdp_cache_row_buf[CY_FLASH_SIZEOF_ROW / sizeof(uint32_t)];
+#endif
+static ext_flash_sfdp_cache_stats_t sfdp_cache_stats;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+#if (CY_BOOT_SFDP_CACHE != 0)
+static bool sfdp_cache_id_valid(const uint8_t *id);
+static void sfdp_cache_key_init(void);
+static void sfdp_cache_load(uint32_t smif_id);
+static int sfdp_cache_use(uint32_t smif_id);
+static void sfdp_cache_store(uint32_t smif_id, const boot_qspi_cfg_t *cfg);
+#endif
+
+#if (CY_BOOT_SFDP_CACHE != 0)
+/******************************************************************************
+ * Function Name: sfdp_cache_id_valid
+ ******************************************************************************
+ * Summary:
+ *  Returns false for the JEDEC IDs read when no memory answers: all bits
+ *  set or all clear.
+ *
+ ******************************************************************************/
+static bool sfdp_cache_id_valid(const uint8_t *id)
+{
+    uint8_t all_set = 0xFFU;
+    uint8_t any_set = 0U;
+
+    for (uint32_t i = 0; i < BOOT_QSPI_ID_SIZE; i++)
+    {
+        all_set &= id[i];
+        any_set |= id[i];
+    }
+    return (all_set != 0xFFU) && (any_set != 0U);
+}
+
+/******************************************************************************
+ * Function Name: sfdp_cache_key_init
+ ******************************************************************************
+ * Summary:
+ *  Derives the record key of this device: the SHA-256 of
+ *  CY_BOOT_SFDP_CACHE_KEY followed by the unique ID.
+ *
+ ******************************************************************************/
+static void sfdp_cache_key_init(void)
+{
+    boot_sha256_context sha;
+    uint64_t uid = Cy_SysLib_GetUniqueId();
+
+    (void)boot_sha256_start(&sha);
+    (void)boot_sha256_update(&sha, CY_BOOT_SFDP_CACHE_KEY, sizeof(CY_BOOT_SFDP_CACHE_KEY) - 1U);
+    (void)boot_sha256_update(&sha, &uid, sizeof(uid));
+    (void)boot_sha256_finish(&sha, sfdp_cache_key);
+    boot_sha256_free(&sha);
+}
+
+/******************************************************************************
+ * Function Name: sfdp_cache_load
+ ******************************************************************************
+ * Summary:
+ *  Finds the latest authentic record in the rows of the SFDP cache area,
+ *  and keeps it if it is for chip select `smif_id`.
+ *
+ ******************************************************************************/
+static void sfdp_cache_load(uint32_t smif_id)
+{
+    const struct flash_area *fa;
+    const sfdp_cache_rec_t *rec = (const sfdp_cache_rec_t *)sfdp_cache_row_buf;
+    uint8_t mac[BOOT_SHA256_SIZE];
+
+    sfdp_cache.seq = 0U;
+    sfdp_cache.row = SFDP_CACHE_NO_ROW;
+    sfdp_cache.rec.magic = 0U;
+
+    if (flash_area_open(FLASH_AREA_SFDP_CACHE, &fa) != 0)
+    {
+        return;
+    }
+
+    for (uint32_t row = 0; row < (fa->fa_size / CY_FLASH_SIZEOF_ROW); row++)
+    {
+        if ((flash_area_read(fa, row * CY_FLASH_SIZEOF_ROW, sfdp_cache_row_buf,
+                             sizeof(sfdp_cache_rec_t)) != 0) ||
+            (rec->magic != SFDP_CACHE_MAGIC))
+        {
+            continue;
+        }
+        boot_hmac_sha256(sfdp_cache_key, rec, offsetof(sfdp_cache_rec_t, mac), mac);
+        if (!boot_crypto_equal(mac, rec->mac, sizeof(mac)))
+        {
+            continue;
+        }
+
+        if ((sfdp_cache.row == SFDP_CACHE_NO_ROW) || ((int32_t)(rec->seq - sfdp_cache.seq) > 0))
+        {
+            sfdp_cache.seq = rec->seq;
+            sfdp_cache.row = row;
+            sfdp_cache.rec = *rec;
+        }
+    }
+    flash_area_close(fa);
+
+    if (sfdp_cache.rec.smif_id != smif_id)
+    {
+        sfdp_cache.rec.magic = 0U;
+    }
+}
+
+/******************************************************************************
+ * Function Name: sfdp_cache_use
+ ******************************************************************************
+ * Summary:
+ *  Sets the memory up from the record, if there is one and the memory
+ *  still reports the JEDEC ID it holds. qspi_init_sfdp() detects the memory
+ *  and then initializes it with qspi_init(); here only the second step runs.
+ *
+ * Return:
+ *  0 on success, -1 if the memory must be detected. The SMIF is then
+ *  disabled again.
+ *
+ ******************************************************************************/
+static int sfdp_cache_use(uint32_t smif_id)
+{
+    const sfdp_cache_rec_t *rec = &sfdp_cache.rec;
+
+    if (rec->magic != SFDP_CACHE_MAGIC)
+    {
+        return -1;
+    }
+
+    /* A reset during XIP reads leaves the memory in continuous read. */
+    if ((ext_flash_smif_init_cfg(&rec->cfg) == 0) &&
+        ((rec->geometry.cont_read_mode == 0U) || (ext_flash_smif_mode_reset() == 0)) &&
+        (ext_flash_smif_read_id(sfdp_cache_stats.id) == 0) &&
+        (memcmp(sfdp_cache_stats.id, rec->cfg.id, BOOT_QSPI_ID_SIZE) == 0) &&
+        (ext_flash_set_geometry(&rec->geometry) == 0))
+    {
+        return 0;
+    }
+
+    BOOT_LOG_WRN("External memory %02x%02x%02x does not match its SFDP record",
+                 sfdp_cache_stats.id[0], sfdp_cache_stats.id[1], sfdp_cache_stats.id[2]);
+    sfdp_cache_stats.stale++;
+    qspi_deinit(smif_id);
+    return -1;
+}
+
+/******************************************************************************
+ * Function Name: sfdp_cache_store
+ ******************************************************************************
+ * Summary:
+ *  Records the configuration `cfg` that the SFDP detection found for chip
+ *  select `smif_id` and the erase geometry read from the SFDP tables, unless
+ *  the latest record holds them already. The record goes to the row after
+ *  the latest record, so that a record is never overwritten in place.
+ *
+ ******************************************************************************/
+static void sfdp_cache_store(uint32_t smif_id, const boot_qspi_cfg_t *cfg)
+{
+    const ext_flash_geometry_t *geo = ext_flash_get_geometry();
+    const struct flash_area *area;
+    sfdp_cache_rec_t *rec = (sfdp_cache_rec_t *)sfdp_cache_row_buf;
+    uint32_t row;
+
+    if ((geo == NULL) || !sfdp_cache_id_valid(cfg->id))
+    {
+        return;
+    }
+    if ((sfdp_cache.rec.magic == SFDP_CACHE_MAGIC) &&
+        (memcmp(&sfdp_cache.rec.cfg, cfg, sizeof(*cfg)) == 0) &&
+        (memcmp(&sfdp_cache.rec.geometry, geo, sizeof(*geo)) == 0))
+    {
+        return;
+    }
+
+    /* The row buffer may still be programming the previous record. */
+    if ((flash_area_sync() != 0) || (flash_area_open(FLASH_AREA_SFDP_CACHE, &area) != 0))
+    {
+        return;
+    }
+
+    memset(sfdp_cache_row_buf, flash_area_erased_val(area), sizeof(sfdp_cache_row_buf));
+    memset(rec, 0, sizeof(*rec));
+    rec->magic = SFDP_CACHE_MAGIC;
+    rec->seq = sfdp_cache.seq + 1U;
+    rec->smif_id = smif_id;
+    memcpy(&rec->cfg, cfg, sizeof(rec->cfg));
+    memcpy(&rec->geometry, geo, sizeof(rec->geometry));
+    boot_hmac_sha256(sfdp_cache_key, rec, offsetof(sfdp_cache_rec_t, mac), rec->mac);
+
+    row = (sfdp_cache.row == SFDP_CACHE_NO_ROW) ?
+          0U : ((sfdp_cache.row + 1U) % (area->fa_size / CY_FLASH_SIZEOF_ROW));
+    if (flash_area_write(area, row * CY_FLASH_SIZEOF_ROW, sfdp_cache_row_buf,
+                         CY_FLASH_SIZEOF_ROW) == 0)
+    {
+        sfdp_cache.rec = *rec;
+        sfdp_cache.seq = rec->seq;
+        sfdp_cache.row = row;
+        sfdp_cache_stats.records++;
+    }
+    flash_area_close(area);
+}
+#endif
+
+/******************************************************************************
+ * Function Name: ext_flash_sfdp_cache_init
+ ******************************************************************************
+ * Summary:
+ *  Initializes the memory on chip select `smif_id` like qspi_init_sfdp(),
+ *  from the record of an earlier boot if it is still valid, and leaves the
+ *  configuration in use for the CM4 application.
+ *
+ * Return:
+ *  CY_SMIF_SUCCESS, or the error of qspi_init_sfdp().
+ *
+ ******************************************************************************/
+cy_en_smif_status_t ext_flash_sfdp_cache_init(uint32_t smif_id)
+{
+    boot_qspi_cfg_t *cfg = &boot_handoff.qspi;
+    cy_en_smif_status_t status;
+
+#if (CY_BOOT_SFDP_CACHE != 0)
+    sfdp_cache_key_init();
+    sfdp_cache_load(smif_id);
+    if (sfdp_cache_use(smif_id) == 0)
+    {
+        *cfg = sfdp_cache.rec.cfg;
+        sfdp_cache_stats.cached = 1U;
+        return CY_SMIF_SUCCESS;
+    }
+#endif
+
+    status = qspi_init_sfdp(smif_id);
+    if ((status != CY_SMIF_SUCCESS) && (ext_flash_smif_mode_reset() == 0))
+    {
+        /* The memory may still be in continuous read from before a reset,
+         * taking the SFDP read instruction for an address.
+         */
+        qspi_deinit(smif_id);
+        status = qspi_init_sfdp(smif_id);
+    }
+    if (status != CY_SMIF_SUCCESS)
+    {
+        return status;
+    }
+    sfdp_cache_stats.detected = 1U;
+
+    /* Without a configuration the application detects the memory itself. */
+    if ((ext_flash_smif_get_cfg(cfg) != 0) || (ext_flash_smif_read_id(cfg->id) != 0))
+    {
+        (void)memset(cfg, 0, sizeof(*cfg));
+        return CY_SMIF_SUCCESS;
+    }
+    (void)memcpy(sfdp_cache_stats.id, cfg->id, sizeof(sfdp_cache_stats.id));
+
+#if (CY_BOOT_SFDP_CACHE != 0)
+    sfdp_cache_store(smif_id, cfg);
+#endif
+    return CY_SMIF_SUCCESS;
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_sfdp_cache_get_stats
+ ******************************************************************************
+ * Summary:
+ *  Returns how the external memory was set up during this boot.
+ *
+ ******************************************************************************/
+const ext_flash_sfdp_cache_stats_t *ext_flash_sfdp_cache_get_stats(void)
+{
+    return &sfdp_cache_stats;
+}
+
+/* [] END OF FILE */
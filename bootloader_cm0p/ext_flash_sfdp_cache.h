@@ -0,0 +1,61 @@
+/******************************************************************************
+* File Name:   ext_flash_sfdp_cache.h
+*
+* Description:
+* This file declares the external memory set up from the configuration the
+* SFDP detection found on an earlier boot.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef EXT_FLASH_SFDP_CACHE_H_
+#define EXT_FLASH_SFDP_CACHE_H_
+
+#include <stdint.h>
+
+#include "flash_qspi.h"
+#include "boot_shared.h"
+
+/* External memory setup of this boot. */
+typedef struct
+{
+    uint32_t cached;                /* 1 if set up from the record */
+    uint32_t detected;              /* 1 if the SFDP detection ran */
+    uint32_t stale;                 /* Records rejected: other memory or setup failed */
+    uint32_t records;               /* Records written */
+    uint8_t id[BOOT_QSPI_ID_SIZE];  /* JEDEC ID of the memory, 0 if not read */
+} ext_flash_sfdp_cache_stats_t;
+
+cy_en_smif_status_t ext_flash_sfdp_cache_init(uint32_t smif_id);
+const ext_flash_sfdp_cache_stats_t *ext_flash_sfdp_cache_get_stats(void);
+
+#endif /* EXT_FLASH_SFDP_CACHE_H_ */
@@ -0,0 +1,865 @@
+/******************************************************************************
+* File Name:   ext_flash_smif.c
+*
+* Description:
+* This file implements the raw SMIF memory commands declared in
+* ext_flash_smif.h with the PDL SMIF driver, using the memory configuration
+* and driver context set up by qspi_init_sfdp(), or by
+* ext_flash_smif_init_cfg() from a configuration detected before.
+* Asynchronous reads of the XIP window use one DMAC channel. Where the memory
+* supports it, the XIP window keeps the memory in quad I/O continuous read,
+* so that its reads omit the instruction.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "cy_pdl.h"
+#include "flash_qspi.h"
+#include "boot_qspi_cfg.h"
+#include "ext_flash_smif.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Read SFDP instruction: 3 address bytes and 8 dummy cycles, single I/O. */
+#define SMIF_SFDP_READ_CMD              (0x5AU)
+#define SMIF_SFDP_ADDR_BYTES            (3U)
+#define SMIF_SFDP_DUMMY_CYCLES          (8U)
+
+/* Read JEDEC ID instruction: no address, single I/O. */
+#define SMIF_READ_ID_CMD                (0x9FU)
+
+/* Continuous read exit (JESD216 0-4-4 mode exit): Fh on DQ0-DQ3 for 10
+ * clocks, sent as an instruction and four parameter bytes at quad width.
+ * The mode bits of a 3-byte address read are clocks 7 and 8, those of a
+ * 4-byte address read clocks 9 and 10.
+ */
+#define SMIF_MODE_RESET_CMD             (0xFFU)
+#define SMIF_MODE_RESET_PARAM_SIZE      (4U)
+
+#ifndef CY_BOOT_SMIF_ERASE_TIMEOUT_US
+/* Upper bound for a single block erase; covers 256 KB NOR sectors. */
+#define CY_BOOT_SMIF_ERASE_TIMEOUT_US   (5000000UL)
+#endif
+
+/* Interval at which the status register is polled during an erase. */
+#define SMIF_BUSY_POLL_US               (100U)
+
+/* Memory slot the flash map uses. */
+#define SMIF_MEM_INDEX                  (0)
+
+#ifndef CY_BOOT_SMIF_DMA_CHANNEL
+/* DMAC channel of the asynchronous XIP reads. */
+#define CY_BOOT_SMIF_DMA_CHANNEL        (0UL)
+#endif
+
+#ifndef CY_BOOT_SMIF_DMA_TRIGGER
+/* Trigger multiplexer output of that channel, driven by software. */
+#define CY_BOOT_SMIF_DMA_TRIGGER        (TRIG_OUT_MUX_10_MDMA_TR_IN0)
+#endif
+
+#ifndef CY_BOOT_SMIF_DMA_TIMEOUT_US
+/* Upper bound for one asynchronous read; 64 KB single I/O at 50 MHz take 11 ms. */
+#define CY_BOOT_SMIF_DMA_TIMEOUT_US     (50000UL)
+#endif
+
+/* Longest memory copy a single DMAC descriptor performs. */
+#define SMIF_DMA_MAX_LEN                (65536UL)
+
+/* DMAC channel interrupt causes other than completion. */
+#define SMIF_DMA_INTR_ERRORS            (CY_DMAC_INTR_MASK & ~CY_DMAC_INTR_COMPLETION)
+
+/*******************************************************************************
+* Data types
+********************************************************************************/
+/* Memory mapped read state, see ext_flash_smif_xip_read(). */
+typedef enum
+{
+    SMIF_XIP_UNCONFIGURED = 0,  /* XIP device not set up yet */
+    SMIF_XIP_OFF,               /* Set up, SMIF in command mode */
+    SMIF_XIP_ON,                /* SMIF in memory mode */
+    SMIF_XIP_UNAVAILABLE        /* Set up failed, command mode only */
+} smif_xip_state_t;
+
+/* Asynchronous read state, see ext_flash_smif_xip_read_start(). */
+typedef enum
+{
+    SMIF_DMA_IDLE = 0,          /* No transfer started or its result collected */
+    SMIF_DMA_BUSY,              /* Transfer in flight */
+    SMIF_DMA_DONE,              /* Transfer completed */
+    SMIF_DMA_FAILED             /* Transfer failed or timed out */
+} smif_dma_state_t;
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+static smif_xip_state_t smif_xip_state;
+static cy_stc_smif_mem_config_t *smif_xip_mem[1];
+static smif_dma_state_t smif_dma_state;
+/* Memory configuration set up by ext_flash_smif_init_cfg(). */
+static boot_qspi_mem_t smif_cfg_mem;
+/* Continuous read mode bits, 0 if the XIP window sends the instruction. */
+static uint8_t smif_cont_mode;
+/* XIP window configuration without the read instruction. */
+static cy_stc_smif_mem_config_t smif_cont_mem;
+static cy_stc_smif_mem_device_cfg_t smif_cont_dev;
+static cy_stc_smif_mem_cmd_t smif_cont_read;
+#if defined(CY_IP_M4CPUSS_DMAC)
+static cy_stc_dmac_descriptor_t smif_dma_descr;
+#endif
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static void smif_put_addr(uint8_t *buf, uint32_t addr, uint32_t addr_bytes);
+static int smif_xip_configure(void);
+static int smif_cont_enter(void);
+static int smif_xip_enter(void);
+static void smif_dma_complete(void);
+
+/******************************************************************************
+ * Function Name: smif_put_addr
+ ******************************************************************************
+ * Summary:
+ *  Stores an address most significant byte first, as the memory expects it
+ *  after the instruction.
+ *
+ ******************************************************************************/
+static void smif_put_addr(uint8_t *buf, uint32_t addr, uint32_t addr_bytes)
+{
+    for (uint32_t i = 0; i < addr_bytes; i++)
+    {
+        buf[i] = (uint8_t)(addr >> (8U * (addr_bytes - 1U - i)));
+    }
+}
+
+/******************************************************************************
+ * Function Name: smif_xip_configure
+ ******************************************************************************
+ * Summary:
+ *  Sets up the memory mapped window of the memory detected by
+ *  qspi_init_sfdp(), with the read instruction the SFDP detection selected,
+ *  and enables the SMIF cache and prefetch for it. Writes through the window
+ *  stay disabled. In continuous read, the window sends only the address, the
+ *  mode bits that keep the memory in continuous read, and the dummy cycles.
+ *
+ * Return:
+ *  0 on success, -1 if the memory cannot be mapped.
+ *
+ ******************************************************************************/
+static int smif_xip_configure(void)
+{
+    SMIF_Type *base = qspi_get_device();
+    cy_stc_smif_mem_config_t *mem = qspi_get_memory_config(SMIF_MEM_INDEX);
+    cy_stc_smif_block_config_t block = { 0 };
+    uint32_t flags;
+
+    if ((mem == NULL) || (mem->deviceCfg == NULL) ||
+        (mem->baseAddress != CY_XIP_BASE) || (mem->memMappedSize == 0U))
+    {
+        return -1;
+    }
+
+    /* The device is already detected; only map it. */
+    flags = mem->flags;
+    mem->flags = (flags & ~CY_SMIF_FLAG_DETECT_SFDP) | CY_SMIF_FLAG_MEMORY_MAPPED;
+    smif_xip_mem[0] = mem;
+    if (smif_cont_mode != 0U)
+    {
+        smif_cont_read = *mem->deviceCfg->readCmd;
+        smif_cont_read.command = CY_SMIF_NO_COMMAND_OR_MODE;
+        smif_cont_read.mode = smif_cont_mode;
+        smif_cont_dev = *mem->deviceCfg;
+        smif_cont_dev.readCmd = &smif_cont_read;
+        smif_cont_mem = *mem;
+        smif_cont_mem.deviceCfg = &smif_cont_dev;
+        smif_xip_mem[0] = &smif_cont_mem;
+    }
+    block.memCount = 1U;
+    block.memConfig = smif_xip_mem;
+
+    if (Cy_SMIF_Memslot_Init(base, &block, qspi_get_context()) != CY_SMIF_SUCCESS)
+    {
+        mem->flags = flags;
+        return -1;
+    }
+
+    Cy_SMIF_CacheEnable(base, CY_SMIF_CACHE_BOTH);
+    Cy_SMIF_CachePrefetchingEnable(base, CY_SMIF_CACHE_BOTH);
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: smif_cont_enter
+ ******************************************************************************
+ * Summary:
+ *  Puts the memory into continuous read with one command mode read of the
+ *  first byte, sending the continuous read mode bits. The memory then takes
+ *  the next read without the instruction, until ext_flash_smif_mode_reset().
+ *
+ * Return:
+ *  0 on success, -1 on a SMIF error.
+ *
+ ******************************************************************************/
+static int smif_cont_enter(void)
+{
+    SMIF_Type *base = qspi_get_device();
+    cy_stc_smif_context_t *context = qspi_get_context();
+    cy_stc_smif_mem_config_t *mem = qspi_get_memory_config(SMIF_MEM_INDEX);
+    const cy_stc_smif_mem_cmd_t *read = mem->deviceCfg->readCmd;
+    uint32_t addr_bytes = mem->deviceCfg->numOfAddrBytes;
+    uint8_t param[5];
+    uint8_t data;
+    cy_en_smif_status_t status;
+
+    if (addr_bytes >= sizeof(param))
+    {
+        return -1;
+    }
+
+    /* The mode bits follow the address at the same width. */
+    smif_put_addr(param, 0U, addr_bytes);
+    param[addr_bytes] = smif_cont_mode;
+
+    status = Cy_SMIF_TransmitCommand(base, (uint8_t)read->command, read->cmdWidth,
+                                     param, addr_bytes + 1U, read->addrWidth,
+                                     mem->slaveSelect, CY_SMIF_TX_NOT_LAST_BYTE, context);
+    if ((status == CY_SMIF_SUCCESS) && (read->dummyCycles != 0U))
+    {
+        status = Cy_SMIF_SendDummyCycles(base, read->dummyCycles);
+    }
+    if (status == CY_SMIF_SUCCESS)
+    {
+        status = Cy_SMIF_ReceiveDataBlocking(base, &data, 1U, read->dataWidth, context);
+    }
+
+    return (status == CY_SMIF_SUCCESS) ? 0 : -1;
+}
+
+/******************************************************************************
+ * Function Name: smif_xip_enter
+ ******************************************************************************
+ * Summary:
+ *  Switches the SMIF to memory mode, setting up the window on first use,
+ *  and puts the memory into continuous read if it is used. The SMIF cache
+ *  is invalidated on every switch, as the memory may have been programmed
+ *  or erased in command mode since.
+ *
+ * Return:
+ *  0 on success, -1 if the memory cannot be mapped.
+ *
+ ******************************************************************************/
+static int smif_xip_enter(void)
+{
+    SMIF_Type *base = qspi_get_device();
+
+    if (smif_xip_state == SMIF_XIP_UNCONFIGURED)
+    {
+        smif_xip_state = (smif_xip_configure() == 0) ? SMIF_XIP_OFF : SMIF_XIP_UNAVAILABLE;
+    }
+    if (smif_xip_state == SMIF_XIP_UNAVAILABLE)
+    {
+        return -1;
+    }
+    if (smif_xip_state == SMIF_XIP_OFF)
+    {
+        if ((smif_cont_mode != 0U) && (smif_cont_enter() != 0))
+        {
+            (void)ext_flash_smif_mode_reset();
+            return -1;
+        }
+        (void)Cy_SMIF_CacheInvalidate(base, CY_SMIF_CACHE_BOTH);
+        Cy_SMIF_SetMode(base, CY_SMIF_MEMORY);
+        smif_xip_state = SMIF_XIP_ON;
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: smif_dma_complete
+ ******************************************************************************
+ * Summary:
+ *  Waits for the asynchronous read in flight, if any, and records whether
+ *  it succeeded. The channel is disabled again either way.
+ *
+ ******************************************************************************/
+static void smif_dma_complete(void)
+{
+#if defined(CY_IP_M4CPUSS_DMAC)
+    uint32_t waited_us = 0;
+    uint32_t intr;
+
+    if (smif_dma_state != SMIF_DMA_BUSY)
+    {
+        return;
+    }
+
+    for (;;)
+    {
+        intr = Cy_DMAC_Channel_GetInterruptStatus(DMAC, CY_BOOT_SMIF_DMA_CHANNEL);
+        if ((intr & SMIF_DMA_INTR_ERRORS) != 0U)
+        {
+            smif_dma_state = SMIF_DMA_FAILED;
+            break;
+        }
+        if ((intr & CY_DMAC_INTR_COMPLETION) != 0U)
+        {
+            smif_dma_state = SMIF_DMA_DONE;
+            break;
+        }
+        if (waited_us >= CY_BOOT_SMIF_DMA_TIMEOUT_US)
+        {
+            smif_dma_state = SMIF_DMA_FAILED;
+            break;
+        }
+        Cy_SysLib_DelayUs(1U);
+        waited_us++;
+    }
+
+    Cy_DMAC_Channel_Disable(DMAC, CY_BOOT_SMIF_DMA_CHANNEL);
+    Cy_DMAC_Channel_ClearInterrupt(DMAC, CY_BOOT_SMIF_DMA_CHANNEL, CY_DMAC_INTR_MASK);
+#endif
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_smif_info
+ ******************************************************************************
+ * Summary:
+ *  Returns the memory size, address width and sector erase the PDL selected
+ *  from the SFDP tables.
+ *
+ * Parameters:
+ *  info - Filled with the memory parameters.
+ *
+ * Return:
+ *  0 on success, -1 if the memory is not initialized.
+ *
+ ******************************************************************************/
+int ext_flash_smif_info(ext_flash_smif_info_t *info)
+{
+    cy_stc_smif_mem_config_t *mem = qspi_get_memory_config(SMIF_MEM_INDEX);
+
+    if ((mem == NULL) || (mem->deviceCfg == NULL) || (mem->deviceCfg->eraseCmd == NULL))
+    {
+        return -1;
+    }
+
+    info->mem_size = mem->deviceCfg->memSize;
+    info->erase_size = mem->deviceCfg->eraseSize;
+    info->erase_cmd = (uint8_t)mem->deviceCfg->eraseCmd->command;
+    info->addr_bytes = (uint8_t)mem->deviceCfg->numOfAddrBytes;
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_smif_get_cfg
+ ******************************************************************************
+ * Summary:
+ *  Packs the memory configuration in use, for ext_flash_smif_init_cfg() on
+ *  a later boot and for the CM4 application. The JEDEC ID is not set.
+ *
+ * Return:
+ *  0 on success, -1 if the memory is not initialized or its configuration
+ *  cannot be packed.
+ *
+ ******************************************************************************/
+int ext_flash_smif_get_cfg(boot_qspi_cfg_t *cfg)
+{
+    return boot_qspi_cfg_pack(qspi_get_memory_config(SMIF_MEM_INDEX), cfg);
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_smif_init_cfg
+ ******************************************************************************
+ * Summary:
+ *  Initializes the SMIF and the memory with a configuration packed by
+ *  ext_flash_smif_get_cfg(), instead of qspi_init_sfdp(): the SFDP tables
+ *  are not read again.
+ *
+ * Return:
+ *  0 on success, -1 on a SMIF error.
+ *
+ ******************************************************************************/
+int ext_flash_smif_init_cfg(const boot_qspi_cfg_t *cfg)
+{
+    cy_stc_smif_block_config_t *block = boot_qspi_cfg_unpack(cfg, &smif_cfg_mem);
+
+    smif_xip_state = SMIF_XIP_UNCONFIGURED;
+    smif_cont_mode = 0U;
+    if ((block == NULL) || (qspi_init(block) != CY_SMIF_SUCCESS))
+    {
+        return -1;
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_smif_read_id
+ ******************************************************************************
+ * Summary:
+ *  Reads the JEDEC manufacturer and device ID of the memory.
+ *
+ * Return:
+ *  0 on success, -1 on a SMIF error.
+ *
+ ******************************************************************************/
+int ext_flash_smif_read_id(uint8_t id[BOOT_QSPI_ID_SIZE])
+{
+    return ext_flash_smif_read_cmd(SMIF_READ_ID_CMD, 0U, 0U, 0U, id, BOOT_QSPI_ID_SIZE);
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_smif_set_cont_read
+ ******************************************************************************
+ * Summary:
+ *  Makes memory mode reads keep the memory in continuous read with the mode
+ *  bits `mode`, so that consecutive reads of the XIP window omit the read
+ *  instruction, or sends the instruction again if `mode` is 0. The memory
+ *  must support continuous read of quad I/O reads (SFDP BFPT DWORD 15), and
+ *  the configured read instruction must be one with a quad address and mode
+ *  bits phase.
+ *
+ * Return:
+ *  0 on success, -1 if the configured read instruction has no mode bits.
+ *
+ ******************************************************************************/
+int ext_flash_smif_set_cont_read(uint8_t mode)
+{
+    cy_stc_smif_mem_config_t *mem = qspi_get_memory_config(SMIF_MEM_INDEX);
+    const cy_stc_smif_mem_cmd_t *read;
+
+    if (mode == smif_cont_mode)
+    {
+        return 0;
+    }
+
+    ext_flash_smif_cmd_mode();
+    smif_cont_mode = 0U;
+    if (smif_xip_state == SMIF_XIP_OFF)
+    {
+        /* Set the window up again with or without the instruction. */
+        smif_xip_state = SMIF_XIP_UNCONFIGURED;
+    }
+    if (mode == 0U)
+    {
+        return 0;
+    }
+
+    if ((mem == NULL) || (mem->deviceCfg == NULL) || (mem->deviceCfg->readCmd == NULL))
+    {
+        return -1;
+    }
+    read = mem->deviceCfg->readCmd;
+    if ((read->addrWidth != CY_SMIF_WIDTH_QUAD) || (read->modeWidth != CY_SMIF_WIDTH_QUAD) ||
+        (read->dataWidth != CY_SMIF_WIDTH_QUAD) || (read->mode == CY_SMIF_NO_COMMAND_OR_MODE))
+    {
+        return -1;
+    }
+
+    smif_cont_mode = mode;
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_smif_mode_reset
+ ******************************************************************************
+ * Summary:
+ *  Takes the memory out of continuous read, so that it accepts instructions
+ *  again. A memory that is not in continuous read ignores the sequence. Also
+ *  used after a reset, which may have left the memory in continuous read.
+ *
+ * Return:
+ *  0 on success, -1 on a SMIF error.
+ *
+ ******************************************************************************/
+int ext_flash_smif_mode_reset(void)
+{
+    static const uint8_t param[SMIF_MODE_RESET_PARAM_SIZE] = { 0xFFU, 0xFFU, 0xFFU, 0xFFU };
+    cy_stc_smif_mem_config_t *mem = qspi_get_memory_config(SMIF_MEM_INDEX);
+    cy_en_smif_status_t status;
+
+    if (mem == NULL)
+    {
+        return -1;
+    }
+
+    status = Cy_SMIF_TransmitCommand(qspi_get_device(), SMIF_MODE_RESET_CMD, CY_SMIF_WIDTH_QUAD,
+                                     param, SMIF_MODE_RESET_PARAM_SIZE, CY_SMIF_WIDTH_QUAD,
+                                     mem->slaveSelect, CY_SMIF_TX_LAST_BYTE,
+                                     qspi_get_context());
+    return (status == CY_SMIF_SUCCESS) ? 0 : -1;
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_smif_read_sfdp
+ ******************************************************************************
+ * Summary:
+ *  Reads `len` bytes of the SFDP area starting at `addr`.
+ *
+ * Return:
+ *  0 on success, -1 on a SMIF error.
+ *
+ ******************************************************************************/
+int ext_flash_smif_read_sfdp(uint32_t addr, void *buf, uint32_t len)
+{
+    return ext_flash_smif_read_cmd(SMIF_SFDP_READ_CMD, addr, SMIF_SFDP_ADDR_BYTES,
+                                   SMIF_SFDP_DUMMY_CYCLES, buf, len);
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_smif_read_cmd
+ ******************************************************************************
+ * Summary:
+ *  Sends the single I/O read instruction `cmd`, followed by `addr_bytes` of
+ *  `addr` (none if 0) and `dummy_cycles`, and reads `len` bytes of response.
+ *  Used for the SFDP area, the JEDEC ID and the register reads of the SFDP
+ *  sector map detection commands.
+ *
+ * Return:
+ *  0 on success, -1 on a SMIF error.
+ *
+ ******************************************************************************/
+int ext_flash_smif_read_cmd(uint8_t cmd, uint32_t addr, uint32_t addr_bytes,
+                            uint32_t dummy_cycles, void *buf, uint32_t len)
+{
+    SMIF_Type *base = qspi_get_device();
+    cy_stc_smif_context_t *context = qspi_get_context();
+    cy_stc_smif_mem_config_t *mem = qspi_get_memory_config(SMIF_MEM_INDEX);
+    uint8_t param[4];
+    cy_en_smif_status_t status;
+
+    if ((mem == NULL) || (addr_bytes > sizeof(param)))
+    {
+        return -1;
+    }
+
+    ext_flash_smif_cmd_mode();
+
+    smif_put_addr(param, addr, addr_bytes);
+
+    status = Cy_SMIF_TransmitCommand(base, cmd, CY_SMIF_WIDTH_SINGLE,
+                                     (addr_bytes != 0U) ? param : NULL, addr_bytes,
+                                     CY_SMIF_WIDTH_SINGLE, mem->slaveSelect,
+                                     CY_SMIF_TX_NOT_LAST_BYTE, context);
+    if ((status == CY_SMIF_SUCCESS) && (dummy_cycles != 0U))
+    {
+        status = Cy_SMIF_SendDummyCycles(base, dummy_cycles);
+    }
+    if (status == CY_SMIF_SUCCESS)
+    {
+        status = Cy_SMIF_ReceiveDataBlocking(base, (uint8_t *)buf, len,
+                                             CY_SMIF_WIDTH_SINGLE, context);
+    }
+
+    return (status == CY_SMIF_SUCCESS) ? 0 : -1;
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_smif_erase_start
+ ******************************************************************************
+ * Summary:
+ *  Starts erasing the block at `addr` with the erase instruction `cmd`
+ *  without waiting for it. `addr` is an offset into the memory and must be
+ *  aligned to the size of the block `cmd` erases. The memory accepts no
+ *  other command until ext_flash_smif_busy() returns false.
+ *
+ * Return:
+ *  0 on success, -1 on a SMIF error.
+ *
+ ******************************************************************************/
+int ext_flash_smif_erase_start(uint8_t cmd, uint32_t addr)
+{
+    SMIF_Type *base = qspi_get_device();
+    cy_stc_smif_context_t *context = qspi_get_context();
+    cy_stc_smif_mem_config_t *mem = qspi_get_memory_config(SMIF_MEM_INDEX);
+    uint8_t param[4];
+    uint32_t addr_bytes;
+    cy_en_smif_status_t status;
+
+    if ((mem == NULL) || (mem->deviceCfg == NULL))
+    {
+        return -1;
+    }
+
+    addr_bytes = mem->deviceCfg->numOfAddrBytes;
+    smif_put_addr(param, addr, addr_bytes);
+
+    ext_flash_smif_cmd_mode();
+    status = Cy_SMIF_MemCmdWriteEnable(base, mem, context);
+    if (status == CY_SMIF_SUCCESS)
+    {
+        status = Cy_SMIF_TransmitCommand(base, cmd, CY_SMIF_WIDTH_SINGLE,
+                                         param, addr_bytes, CY_SMIF_WIDTH_SINGLE,
+                                         mem->slaveSelect, CY_SMIF_TX_LAST_BYTE, context);
+    }
+    return (status == CY_SMIF_SUCCESS) ? 0 : -1;
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_smif_busy
+ ******************************************************************************
+ * Summary:
+ *  Reads the status register once and returns true while the memory is
+ *  still erasing or programming.
+ *
+ ******************************************************************************/
+bool ext_flash_smif_busy(void)
+{
+    cy_stc_smif_mem_config_t *mem = qspi_get_memory_config(SMIF_MEM_INDEX);
+
+    if (mem == NULL)
+    {
+        return false;
+    }
+
+    ext_flash_smif_cmd_mode();
+    return Cy_SMIF_MemIsBusy(qspi_get_device(), mem, qspi_get_context());
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_smif_wait
+ ******************************************************************************
+ * Summary:
+ *  Waits for the memory to become ready after an erase.
+ *
+ * Return:
+ *  0 on success, -1 on a timeout.
+ *
+ ******************************************************************************/
+int ext_flash_smif_wait(void)
+{
+    uint32_t waited_us = 0;
+
+    while (ext_flash_smif_busy())
+    {
+        if (waited_us >= CY_BOOT_SMIF_ERASE_TIMEOUT_US)
+        {
+            return -1;
+        }
+        Cy_SysLib_DelayUs(SMIF_BUSY_POLL_US);
+        waited_us += SMIF_BUSY_POLL_US;
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_smif_erase
+ ******************************************************************************
+ * Summary:
+ *  Erases the block at `addr` with the erase instruction `cmd` and waits for
+ *  the memory to become ready. `addr` is an offset into the memory and must
+ *  be aligned to the size of the block `cmd` erases.
+ *
+ * Return:
+ *  0 on success, -1 on a SMIF error or timeout.
+ *
+ ******************************************************************************/
+int ext_flash_smif_erase(uint8_t cmd, uint32_t addr)
+{
+    if (ext_flash_smif_erase_start(cmd, addr) != 0)
+    {
+        return -1;
+    }
+    return ext_flash_smif_wait();
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_smif_erase_chip
+ ******************************************************************************
+ * Summary:
+ *  Erases the whole memory with the chip erase instruction from the SFDP
+ *  tables and waits for completion.
+ *
+ * Return:
+ *  0 on success, -1 on a SMIF error or timeout.
+ *
+ ******************************************************************************/
+int ext_flash_smif_erase_chip(void)
+{
+    cy_stc_smif_mem_config_t *mem = qspi_get_memory_config(SMIF_MEM_INDEX);
+
+    if (mem == NULL)
+    {
+        return -1;
+    }
+
+    ext_flash_smif_cmd_mode();
+    return (Cy_SMIF_MemEraseChip(qspi_get_device(), mem, qspi_get_context()) ==
+            CY_SMIF_SUCCESS) ? 0 : -1;
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_smif_xip_read
+ ******************************************************************************
+ * Summary:
+ *  Reads `len` bytes at XIP address `addr` through the memory mapped window,
+ *  switching the SMIF to memory mode if needed, see smif_xip_enter().
+ *
+ * Return:
+ *  0 on success, -1 if the memory cannot be mapped; the caller then reads in
+ *  command mode.
+ *
+ ******************************************************************************/
+int ext_flash_smif_xip_read(uint32_t addr, void *dst, uint32_t len)
+{
+    if (smif_xip_enter() != 0)
+    {
+        return -1;
+    }
+
+    memcpy(dst, (const void *)(uintptr_t)addr, len);
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_smif_xip_read_start
+ ******************************************************************************
+ * Summary:
+ *  Starts copying `len` bytes at XIP address `addr` to `dst` with the DMAC
+ *  and returns without waiting. Only one read may be in flight; its result
+ *  must be collected with ext_flash_smif_xip_read_wait() before the next one
+ *  is started and before `dst` is used.
+ *
+ * Return:
+ *  0 if the transfer was started, -1 if the memory cannot be mapped, there
+ *  is no DMAC or a read is still outstanding.
+ *
+ ******************************************************************************/
+int ext_flash_smif_xip_read_start(uint32_t addr, void *dst, uint32_t len)
+{
+#if defined(CY_IP_M4CPUSS_DMAC)
+    cy_stc_dmac_descriptor_config_t config = { 0 };
+    cy_stc_dmac_channel_config_t channel = { 0 };
+
+    if ((smif_dma_state != SMIF_DMA_IDLE) || (len == 0U) || (len > SMIF_DMA_MAX_LEN) ||
+        (smif_xip_enter() != 0))
+    {
+        return -1;
+    }
+
+    config.retrigger = CY_DMAC_RETRIG_IM;
+    config.interruptType = CY_DMAC_DESCR;
+    config.triggerOutType = CY_DMAC_DESCR;
+    config.channelState = CY_DMAC_CHANNEL_DISABLED;
+    config.triggerInType = CY_DMAC_DESCR;
+    config.dataSize = CY_DMAC_BYTE;
+    config.srcTransferSize = CY_DMAC_TRANSFER_SIZE_DATA;
+    config.dstTransferSize = CY_DMAC_TRANSFER_SIZE_DATA;
+    config.descriptorType = CY_DMAC_MEMORY_COPY;
+    config.srcAddress = (void *)(uintptr_t)addr;
+    config.dstAddress = dst;
+    config.xCount = len;
+    config.nextDescriptor = NULL;
+
+    channel.descriptor = &smif_dma_descr;
+    channel.priority = 3U;
+    channel.enable = false;
+    channel.bufferable = false;
+
+    if ((Cy_DMAC_Descriptor_Init(&smif_dma_descr, &config) != CY_DMAC_SUCCESS) ||
+        (Cy_DMAC_Channel_Init(DMAC, CY_BOOT_SMIF_DMA_CHANNEL, &channel) != CY_DMAC_SUCCESS))
+    {
+        return -1;
+    }
+
+    Cy_DMAC_Channel_ClearInterrupt(DMAC, CY_BOOT_SMIF_DMA_CHANNEL, CY_DMAC_INTR_MASK);
+    Cy_DMAC_Enable(DMAC);
+    Cy_DMAC_Channel_Enable(DMAC, CY_BOOT_SMIF_DMA_CHANNEL);
+
+    if (Cy_TrigMux_SwTrigger(CY_BOOT_SMIF_DMA_TRIGGER, CY_TRIGGER_TWO_CYCLES) != CY_TRIGMUX_SUCCESS)
+    {
+        Cy_DMAC_Channel_Disable(DMAC, CY_BOOT_SMIF_DMA_CHANNEL);
+        return -1;
+    }
+
+    smif_dma_state = SMIF_DMA_BUSY;
+    return 0;
+#else
+    (void)addr;
+    (void)dst;
+    (void)len;
+    return -1;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_smif_xip_read_wait
+ ******************************************************************************
+ * Summary:
+ *  Waits for the read started by ext_flash_smif_xip_read_start() and
+ *  collects its result. Returns immediately if no read was started.
+ *
+ * Return:
+ *  0 on success, -1 if the transfer failed or timed out.
+ *
+ ******************************************************************************/
+int ext_flash_smif_xip_read_wait(void)
+{
+    int rc;
+
+    smif_dma_complete();
+    rc = (smif_dma_state == SMIF_DMA_FAILED) ? -1 : 0;
+    smif_dma_state = SMIF_DMA_IDLE;
+    return rc;
+}
+
+/******************************************************************************
+ * Function Name: ext_flash_smif_cmd_mode
+ ******************************************************************************
+ * Summary:
+ *  Switches the SMIF back to command mode after memory mapped reads, letting
+ *  an asynchronous read finish first, and takes the memory out of continuous
+ *  read. Must be called before any command mode transaction, including the
+ *  QSPI flash PAL reads, programs and erases, and before the SMIF is
+ *  deinitialized.
+ *
+ ******************************************************************************/
+void ext_flash_smif_cmd_mode(void)
+{
+    smif_dma_complete();
+
+    if (smif_xip_state == SMIF_XIP_ON)
+    {
+        Cy_SMIF_SetMode(qspi_get_device(), CY_SMIF_NORMAL);
+        smif_xip_state = SMIF_XIP_OFF;
+        if (smif_cont_mode != 0U)
+        {
+            (void)ext_flash_smif_mode_reset();
+        }
+    }
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,79 @@
+/******************************************************************************
+* File Name:   ext_flash_smif.h
+*
+* Description:
+* This file declares the raw SMIF memory commands the external flash services
+* use on top of the memory configuration set up by qspi_init_sfdp(): reading
+* the SFDP tables and configuration registers, erasing a single block with a
+* given erase instruction, and reading through the memory mapped (XIP)
+* window, either by the CPU or asynchronously by DMA.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef EXT_FLASH_SMIF_H_
+#define EXT_FLASH_SMIF_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "boot_shared.h"
+
+/* Memory parameters as configured by the SFDP detection of the PDL. */
+typedef struct
+{
+    uint32_t mem_size;      /* Memory size in bytes */
+    uint32_t erase_size;    /* Size of the configured sector erase */
+    uint8_t erase_cmd;      /* Configured sector erase instruction */
+    uint8_t addr_bytes;     /* Number of address bytes (3 or 4) */
+} ext_flash_smif_info_t;
+
+int ext_flash_smif_info(ext_flash_smif_info_t *info);
+int ext_flash_smif_get_cfg(boot_qspi_cfg_t *cfg);
+int ext_flash_smif_init_cfg(const boot_qspi_cfg_t *cfg);
+int ext_flash_smif_read_id(uint8_t id[BOOT_QSPI_ID_SIZE]);
+int ext_flash_smif_set_cont_read(uint8_t mode);
+int ext_flash_smif_mode_reset(void);
+int ext_flash_smif_read_sfdp(uint32_t addr, void *buf, uint32_t len);
+int ext_flash_smif_read_cmd(uint8_t cmd, uint32_t addr, uint32_t addr_bytes,
+                            uint32_t dummy_cycles, void *buf, uint32_t len);
+int ext_flash_smif_erase(uint8_t cmd, uint32_t addr);
+int ext_flash_smif_erase_start(uint8_t cmd, uint32_t addr);
+bool ext_flash_smif_busy(void);
+int ext_flash_smif_wait(void);
+int ext_flash_smif_erase_chip(void);
+int ext_flash_smif_xip_read(uint32_t addr, void *dst, uint32_t len);
+int ext_flash_smif_xip_read_start(uint32_t addr, void *dst, uint32_t len);
+int ext_flash_smif_xip_read_wait(void);
+void ext_flash_smif_cmd_mode(void);
+
+#endif /* EXT_FLASH_SMIF_H_ */
@@ -0,0 +1,135 @@
+/******************************************************************************
+* File Name:   bench.c
+*
+* Description:
+* This file implements the helpers shared by the host flash simulator
+* microbenchmarks: a host clock, a freshly erased set of simulated devices and
+* the front end hooks the device model expects.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bench.h"
+#include "boot_timing.h"
+
+#define BENCH_STATE_DIR             "build/bench_state"
+
+bool sim_verbose;
+
+void sim_boot_exit(uint32_t app_addr)
+{
+    fprintf(stderr, "bench: unexpected boot exit (0x%08x)\n", (unsigned int)app_addr);
+    exit(EXIT_FAILURE);
+}
+
+void sim_power_lost(void)
+{
+    fprintf(stderr, "bench: unexpected power loss\n");
+    exit(EXIT_FAILURE);
+}
+
+void sim_system_reset(void)
+{
+    fprintf(stderr, "bench: unexpected reset\n");
+    exit(EXIT_FAILURE);
+}
+
+/* The flash backend times boot phases for the CM4 application; there are
+ * none to time here.
+ */
+uint32_t boot_timing_now(void)
+{
+    return 0U;
+}
+
+uint8_t boot_timing_image(uint8_t fa_id)
+{
+    (void)fa_id;
+    return 0U;
+}
+
+void boot_timing_add(uint8_t phase, uint8_t image, uint32_t start)
+{
+    (void)phase;
+    (void)image;
+    (void)start;
+}
+
+/* Bootloader log output is accounted but not shown. */
+int sim_log_fprintf(FILE *stream, const char *fmt, ...)
+{
+    va_list ap;
+    int len;
+
+    (void)stream;
+
+    va_start(ap, fmt);
+    len = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+
+    if (len > 0)
+    {
+        sim_account_uart((uint64_t)len);
+    }
+    return len;
+}
+
+uint64_t bench_host_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* Maps factory-erased devices, see sim_flash_init(). */
+int bench_init(void)
+{
+    return sim_flash_init(BENCH_STATE_DIR, true);
+}
+
+const struct flash_area *bench_area(uint8_t fa_id)
+{
+    const struct flash_area *fa = NULL;
+
+    if (flash_area_open(fa_id, &fa) != 0)
+    {
+        fprintf(stderr, "bench: no flash area %u\n", (unsigned int)fa_id);
+        exit(EXIT_FAILURE);
+    }
+    return fa;
+}
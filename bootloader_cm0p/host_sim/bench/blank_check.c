@@ -0,0 +1,202 @@
+/******************************************************************************
+* File Name:   blank_check.c
+*
+* Description:
+* Microbenchmark of the flash backend blank check. Compares the original
+* byte-by-byte check against flash_area_read_is_empty() and
+* flash_area_is_blank() on trailer-sized and sector-sized ranges, both for
+* erased ranges (full scan) and for ranges with a programmed first or last
+* byte (early exit). Reports host CPU time per call and, for the external
+* flash, the simulated bus time per call.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sysflash.h"
+#include "ext_flash_map.h"
+
+#include "bench.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define BENCH_MAX_LEN               (0x40000U)
+#define BENCH_BYTES_PER_CASE        (64U * 1024U * 1024U)
+
+/*******************************************************************************
+* Data types
+********************************************************************************/
+typedef enum
+{
+    CONTENT_ERASED = 0,
+    CONTENT_DIRTY_FIRST,
+    CONTENT_DIRTY_LAST,
+    CONTENT_COUNT
+} content_t;
+
+typedef int (*check_fn_t)(const struct flash_area *fa, uint32_t len);
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+static const uint32_t sizes[] = { 16U, 64U, 512U, 4096U, 0x40000U };
+static const char *const content_names[CONTENT_COUNT] = { "erased", "dirty@0", "dirty@end" };
+static uint8_t buf[BENCH_MAX_LEN];
+
+/*******************************************************************************
+* Checks under test
+********************************************************************************/
+/* Blank check as originally implemented, with the loop counter widened so
+ * that ranges above 255 bytes terminate.
+ */
+static int check_legacy(const struct flash_area *fa, uint32_t len)
+{
+    if (flash_area_read(fa, 0, buf, len) != 0)
+    {
+        return -1;
+    }
+    for (uint32_t i = 0; i < len; i++)
+    {
+        if (buf[i] != flash_area_erased_val(fa))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int check_read_is_empty(const struct flash_area *fa, uint32_t len)
+{
+    return flash_area_read_is_empty(fa, 0, buf, len);
+}
+
+static int check_is_blank(const struct flash_area *fa, uint32_t len)
+{
+    return flash_area_is_blank(fa, 0, len);
+}
+
+/*******************************************************************************
+* Benchmark
+********************************************************************************/
+static void prepare(const struct flash_area *fa, uint32_t len, content_t content)
+{
+    uint8_t erased = flash_area_erased_val(fa);
+    uint8_t dirty = (uint8_t)~erased;
+
+    memset(buf, erased, len);
+    sim_flash_poke(fa->fa_off, buf, len);
+
+    if (content == CONTENT_DIRTY_FIRST)
+    {
+        sim_flash_poke(fa->fa_off, &dirty, 1U);
+    }
+    else if (content == CONTENT_DIRTY_LAST)
+    {
+        sim_flash_poke(fa->fa_off + len - 1U, &dirty, 1U);
+    }
+}
+
+/* Returns the host time per call in ns, and the simulated time of one call. */
+static double run(check_fn_t fn, const struct flash_area *fa, uint32_t len,
+                  int expected, uint64_t *sim_ns)
+{
+    uint32_t iterations = BENCH_BYTES_PER_CASE / len;
+    uint64_t start;
+    uint64_t host;
+
+    start = sim_now_ns();
+    if (fn(fa, len) != expected)
+    {
+        printf("bench: wrong result\n");
+    }
+    *sim_ns = sim_now_ns() - start;
+
+    host = bench_host_ns();
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        (void)fn(fa, len);
+    }
+    return (double)(bench_host_ns() - host) / iterations;
+}
+
+int main(void)
+{
+    const uint8_t areas[] = { FLASH_AREA_IMAGE_PRIMARY(0), FLASH_AREA_IMAGE_SECONDARY(0) };
+
+    if (bench_init() != 0)
+    {
+        return 1;
+    }
+
+    printf("%-9s %8s %-10s %14s %14s %14s %14s %14s\n", "device", "size", "content",
+           "legacy [ns]", "rd_empty [ns]", "is_blank [ns]", "legacy [us]*", "is_blank [us]*");
+
+    for (size_t a = 0; a < sizeof(areas); a++)
+    {
+        const struct flash_area *fa = bench_area(areas[a]);
+        bool internal = (fa->fa_device_id == FLASH_DEVICE_INTERNAL_FLASH);
+
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+        {
+            for (uint32_t c = 0; c < CONTENT_COUNT; c++)
+            {
+                int expected = (c == CONTENT_ERASED) ? 1 : 0;
+                uint64_t sim_legacy;
+                uint64_t sim_empty;
+                uint64_t sim_blank;
+                double legacy;
+                double empty;
+                double blank;
+
+                prepare(fa, sizes[s], (content_t)c);
+                legacy = run(check_legacy, fa, sizes[s], expected, &sim_legacy);
+                empty = run(check_read_is_empty, fa, sizes[s], expected, &sim_empty);
+                blank = run(check_is_blank, fa, sizes[s], expected, &sim_blank);
+
+                printf("%-9s %8" PRIu32 " %-10s %14.1f %14.1f %14.1f %14.2f %14.2f\n",
+                       internal ? "internal" : "external", sizes[s], content_names[c],
+                       legacy, empty, blank,
+                       (double)sim_legacy / 1000.0, (double)sim_blank / 1000.0);
+            }
+        }
+    }
+
+    printf("\n* Simulated flash bus time of one call (external flash only; internal\n"
+           "  flash reads are memory mapped and not modeled here).\n");
+
+    sim_flash_deinit();
+    return 0;
+}
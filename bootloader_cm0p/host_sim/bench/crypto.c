@@ -0,0 +1,372 @@
+/******************************************************************************
+* File Name:   crypto.c
+*
+* Description:
+* Compares the software crypto backends the bootloader can be built with
+* (BOOT_CRYPTO and BOOT_SIGN in ../Makefile): the host time to hash a header
+* sized block and each image slot with SHA-256 in the 256 byte chunks MCUboot
+* hashes, the time to verify one image signature, and the code size of each
+* backend (host objects, so only comparable with each other) with the full
+* and with the minimal mbedTLS configuration (BOOT_CRYPTO_PROFILE). A backend
+* is included when its sources are in the MCUboot tree: Mbed TLS, TinyCrypt
+* and the fiat Ed25519 code. The MXCRYPTO path cannot run on the host; its SHA-256
+* cost is the hash_ps_per_byte latency model parameter.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "mbedtls/sha256.h"
+#if defined(BENCH_MBEDTLS_ECDSA)
+#include "mbedtls/ecdsa.h"
+#endif
+#if defined(BENCH_TINYCRYPT)
+#include "tinycrypt/constants.h"
+#include "tinycrypt/sha256.h"
+#include "tinycrypt/ecc_dsa.h"
+#endif
+#if defined(BENCH_ED25519)
+#include "curve25519.h"
+#endif
+
+#include "bench.h"
+#include "crypto_size.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Chunk size of MCUboot's bootutil_img_hash() (BOOT_TMPBUF_SZ). */
+#define BENCH_CHUNK                 (256U)
+
+/* Repeat each measurement for at least this long. */
+#define BENCH_MIN_NS                (200000000ULL)
+
+#define BENCH_HASH_SIZE             (32U)
+
+/*******************************************************************************
+* Data types
+********************************************************************************/
+typedef struct
+{
+    const char *name;
+    int (*sha256)(const uint8_t *data, uint32_t len, uint8_t *hash);
+    uint32_t code_size;         /* Full profile */
+    uint32_t min_size;          /* Minimal profile */
+} hash_backend_t;
+
+typedef struct
+{
+    const char *name;
+    int (*verify)(void);
+    uint32_t code_size;         /* Full profile */
+    uint32_t min_size;          /* Minimal profile */
+} sig_backend_t;
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+static uint8_t data[CY_BOOT_PRIMARY_1_SIZE];
+
+/* Test vectors: SHA-256 of bench_msg, signed with a P-256 and an Ed25519
+ * key made with OpenSSL for this benchmark. MCUboot signs the image hash.
+ */
+static const char bench_msg[] = "CE231678 crypto benchmark";
+
+static const uint8_t bench_hash[BENCH_HASH_SIZE] =
+{
+    0x15, 0x9c, 0x5e, 0xa6, 0xab, 0x29, 0xec, 0xcd, 0x48, 0x69, 0x8b, 0xcf, 0xe7, 0x76, 0x65, 0x59,
+    0x3b, 0xf1, 0xc1, 0x5f, 0x7e, 0x87, 0x3e, 0xe0, 0x2a, 0x48, 0xdf, 0x72, 0x29, 0x29, 0x08, 0xcf,
+};
+
+#if defined(BENCH_MBEDTLS_ECDSA) || defined(BENCH_TINYCRYPT)
+/* Uncompressed point without the 0x04 prefix, and r followed by s. */
+static const uint8_t p256_pub[64] =
+{
+    0xde, 0xb3, 0xfc, 0xd4, 0xea, 0x6c, 0xb0, 0x59, 0x8e, 0xc6, 0x33, 0x6b, 0x13, 0x85, 0xe5, 0x15,
+    0xe3, 0x94, 0x96, 0x0d, 0xdb, 0x97, 0x6f, 0xbe, 0x5d, 0x2b, 0x9b, 0xa6, 0xc0, 0x91, 0x82, 0x5b,
+    0x7a, 0x1b, 0x0d, 0x58, 0x9f, 0x84, 0x00, 0x30, 0xcc, 0x6d, 0xef, 0x8f, 0x4e, 0x51, 0x85, 0x52,
+    0x85, 0x3d, 0xc6, 0x6a, 0x02, 0x44, 0xba, 0x6d, 0xa7, 0xdc, 0x5a, 0xa1, 0xae, 0x76, 0x28, 0x9f,
+};
+
+static const uint8_t p256_sig[64] =
+{
+    0x20, 0x4a, 0x6c, 0x62, 0x3f, 0x51, 0xe5, 0xdb, 0x1d, 0x02, 0x82, 0x79, 0x6a, 0x9d, 0xe7, 0x2e,
+    0xf1, 0x77, 0xf5, 0x9c, 0xc7, 0x2e, 0x71, 0x15, 0xbd, 0x2b, 0x64, 0xf4, 0x55, 0xa3, 0x2f, 0x7d,
+    0x2b, 0x03, 0xeb, 0x1d, 0x5d, 0x25, 0x7a, 0x1a, 0x33, 0x18, 0x46, 0x05, 0xb8, 0x85, 0x7d, 0xbc,
+    0x4e, 0xd0, 0xe4, 0x1a, 0xeb, 0xe6, 0x56, 0x2d, 0xb6, 0x92, 0x9e, 0x9d, 0x55, 0x0d, 0xb5, 0x34,
+};
+#endif
+
+#if defined(BENCH_ED25519)
+static const uint8_t ed25519_pub[32] =
+{
+    0xc1, 0x2b, 0x9a, 0x9d, 0xe8, 0x9d, 0x09, 0x6f, 0x8f, 0x37, 0xf0, 0x12, 0xaf, 0xfa, 0x42, 0xb6,
+    0xb3, 0x96, 0x6e, 0xd1, 0x83, 0xca, 0x57, 0x7f, 0x54, 0xad, 0x73, 0x0e, 0x8a, 0x82, 0x85, 0x91,
+};
+
+static const uint8_t ed25519_sig[64] =
+{
+    0xc6, 0x83, 0x35, 0x98, 0xec, 0x8b, 0xbf, 0x81, 0x79, 0x2a, 0x82, 0x76, 0x6c, 0xde, 0xe1, 0xe2,
+    0x7c, 0xbb, 0x61, 0x05, 0xdf, 0xcb, 0x35, 0xc9, 0x1b, 0x30, 0xbf, 0x9b, 0x61, 0x43, 0x7f, 0x12,
+    0x5a, 0x6f, 0x84, 0x44, 0xc5, 0xb8, 0x54, 0x46, 0xbb, 0xd4, 0x91, 0x5f, 0x6a, 0xd8, 0x94, 0xc5,
+    0x5b, 0x0a, 0x9a, 0x46, 0xf5, 0xc3, 0xf4, 0x48, 0x91, 0x1c, 0x72, 0x3d, 0x02, 0x1c, 0x9b, 0x0a,
+};
+#endif
+
+/*******************************************************************************
+* Backends under test
+********************************************************************************/
+static int sha256_mbedtls(const uint8_t *buf, uint32_t len, uint8_t *hash)
+{
+    mbedtls_sha256_context sha;
+    int rc;
+
+    mbedtls_sha256_init(&sha);
+    rc = mbedtls_sha256_starts_ret(&sha, 0);
+    for (uint32_t off = 0; (rc == 0) && (off < len); off += BENCH_CHUNK)
+    {
+        rc = mbedtls_sha256_update_ret(&sha, &buf[off], ((len - off) < BENCH_CHUNK) ? (len - off) :
+                                       BENCH_CHUNK);
+    }
+    if (rc == 0)
+    {
+        rc = mbedtls_sha256_finish_ret(&sha, hash);
+    }
+    mbedtls_sha256_free(&sha);
+    return rc;
+}
+
+#if defined(BENCH_MBEDTLS_ECDSA)
+/* As MCUboot's image_ec256_mbedtls.c: the key is a point on P-256. */
+static int verify_mbedtls(void)
+{
+    mbedtls_ecp_group grp;
+    mbedtls_ecp_point q;
+    mbedtls_mpi r;
+    mbedtls_mpi s;
+    uint8_t point[1U + sizeof(p256_pub)] = { 0x04 };
+    int rc;
+
+    memcpy(&point[1], p256_pub, sizeof(p256_pub));
+    mbedtls_ecp_group_init(&grp);
+    mbedtls_ecp_point_init(&q);
+    mbedtls_mpi_init(&r);
+    mbedtls_mpi_init(&s);
+
+    rc = mbedtls_ecp_group_load(&grp, MBEDTLS_ECP_DP_SECP256R1);
+    if (rc == 0)
+    {
+        rc = mbedtls_ecp_point_read_binary(&grp, &q, point, sizeof(point));
+    }
+    if (rc == 0)
+    {
+        rc = mbedtls_mpi_read_binary(&r, p256_sig, 32U);
+    }
+    if (rc == 0)
+    {
+        rc = mbedtls_mpi_read_binary(&s, &p256_sig[32], 32U);
+    }
+    if (rc == 0)
+    {
+        rc = mbedtls_ecdsa_verify(&grp, bench_hash, sizeof(bench_hash), &q, &r, &s);
+    }
+
+    mbedtls_mpi_free(&s);
+    mbedtls_mpi_free(&r);
+    mbedtls_ecp_point_free(&q);
+    mbedtls_ecp_group_free(&grp);
+    return rc;
+}
+#endif
+
+#if defined(BENCH_TINYCRYPT)
+static int sha256_tinycrypt(const uint8_t *buf, uint32_t len, uint8_t *hash)
+{
+    struct tc_sha256_state_struct sha;
+    int ok = tc_sha256_init(&sha);
+
+    for (uint32_t off = 0; (ok == TC_CRYPTO_SUCCESS) && (off < len); off += BENCH_CHUNK)
+    {
+        ok = tc_sha256_update(&sha, &buf[off], ((len - off) < BENCH_CHUNK) ? (len - off) :
+                              BENCH_CHUNK);
+    }
+    if (ok == TC_CRYPTO_SUCCESS)
+    {
+        ok = tc_sha256_final(hash, &sha);
+    }
+    return (ok == TC_CRYPTO_SUCCESS) ? 0 : -1;
+}
+
+/* As MCUboot's image_ec256.c. */
+static int verify_tinycrypt(void)
+{
+    return (uECC_verify(p256_pub, bench_hash, sizeof(bench_hash), p256_sig,
+                        uECC_secp256r1()) == 1) ? 0 : -1;
+}
+#endif
+
+#if defined(BENCH_ED25519)
+/* As MCUboot's image_ed25519.c. */
+static int verify_ed25519(void)
+{
+    return (ED25519_verify(bench_hash, sizeof(bench_hash), ed25519_sig, ed25519_pub) == 1) ? 0 : -1;
+}
+#endif
+
+static const hash_backend_t hash_backends[] =
+{
+    { "mbedtls", sha256_mbedtls, BENCH_SIZE_MBEDTLS_SHA256, BENCH_SIZE_MIN_MBEDTLS_SHA256 },
+#if defined(BENCH_TINYCRYPT)
+    { "tinycrypt", sha256_tinycrypt, BENCH_SIZE_TINYCRYPT_SHA256, BENCH_SIZE_TINYCRYPT_SHA256 },
+#endif
+};
+
+static const sig_backend_t sig_backends[] =
+{
+#if defined(BENCH_MBEDTLS_ECDSA)
+    { "mbedtls EC256", verify_mbedtls, BENCH_SIZE_MBEDTLS_EC256, BENCH_SIZE_MIN_MBEDTLS_EC256 },
+#endif
+#if defined(BENCH_TINYCRYPT)
+    { "tinycrypt EC256", verify_tinycrypt, BENCH_SIZE_TINYCRYPT_EC256, BENCH_SIZE_TINYCRYPT_EC256 },
+#endif
+#if defined(BENCH_ED25519)
+    { "fiat ED25519", verify_ed25519, BENCH_SIZE_ED25519, BENCH_SIZE_MIN_ED25519 },
+#endif
+};
+
+/*******************************************************************************
+* Benchmark
+********************************************************************************/
+/* Returns the host time of one hash of `len` bytes, 0 if it failed. */
+static uint64_t run_hash(const hash_backend_t *backend, uint32_t len)
+{
+    uint8_t hash[BENCH_HASH_SIZE];
+    uint64_t start = bench_host_ns();
+    uint64_t elapsed;
+    uint32_t runs = 0U;
+
+    do
+    {
+        if (backend->sha256(data, len, hash) != 0)
+        {
+            return 0U;
+        }
+        runs++;
+        elapsed = bench_host_ns() - start;
+    } while (elapsed < BENCH_MIN_NS);
+
+    return elapsed / runs;
+}
+
+/* Returns the host time of one verification, 0 if it failed. */
+static uint64_t run_verify(const sig_backend_t *backend)
+{
+    uint64_t start = bench_host_ns();
+    uint64_t elapsed;
+    uint32_t runs = 0U;
+
+    do
+    {
+        if (backend->verify() != 0)
+        {
+            return 0U;
+        }
+        runs++;
+        elapsed = bench_host_ns() - start;
+    } while (elapsed < BENCH_MIN_NS);
+
+    return elapsed / runs;
+}
+
+static void print_hashes(void)
+{
+    const uint32_t sizes[] = { 0x1000U, CY_BOOT_PRIMARY_2_SIZE, CY_BOOT_PRIMARY_1_SIZE };
+
+    printf("%-16s %9s %9s %5s", "SHA-256", "code [B]", "min [B]", "ok");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        printf(" %5" PRIu32 " KB [ms]", sizes[i] / 1024U);
+    }
+    printf(" %9s\n", "ns/B");
+
+    for (size_t b = 0; b < sizeof(hash_backends) / sizeof(hash_backends[0]); b++)
+    {
+        const hash_backend_t *backend = &hash_backends[b];
+        uint8_t hash[BENCH_HASH_SIZE];
+        bool ok = (backend->sha256((const uint8_t *)bench_msg, sizeof(bench_msg) - 1U, hash) == 0) &&
+                  (memcmp(hash, bench_hash, sizeof(hash)) == 0);
+        uint64_t ns = 0U;
+
+        printf("%-16s %9" PRIu32 " %9" PRIu32 " %5s", backend->name, backend->code_size,
+               backend->min_size, ok ? "yes" : "NO");
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+        {
+            ns = run_hash(backend, sizes[i]);
+            printf(" %13.3f", (double)ns / 1e6);
+        }
+        printf(" %9.2f\n", (double)ns / (double)sizes[(sizeof(sizes) / sizeof(sizes[0])) - 1U]);
+    }
+}
+
+static void print_signatures(void)
+{
+    printf("\n%-16s %9s %9s %5s %13s\n", "Signature", "code [B]", "min [B]", "ok", "verify [ms]");
+    if ((sizeof(sig_backends) / sizeof(sig_backends[0])) == 0U)
+    {
+        printf("(no verifier sources in the MCUboot tree)\n");
+    }
+
+    for (size_t b = 0; b < sizeof(sig_backends) / sizeof(sig_backends[0]); b++)
+    {
+        const sig_backend_t *backend = &sig_backends[b];
+        uint64_t ns = run_verify(backend);
+
+        printf("%-16s %9" PRIu32 " %9" PRIu32 " %5s %13.3f\n", backend->name, backend->code_size,
+               backend->min_size, (ns != 0U) ? "yes" : "NO", (double)ns / 1e6);
+    }
+}
+
+int main(void)
+{
+    for (uint32_t i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (uint8_t)((i * 2654435761U) >> 24);
+    }
+
+    print_hashes();
+    print_signatures();
+    return 0;
+}
@@ -0,0 +1,207 @@
+/******************************************************************************
+* File Name:   erase_plan.c
+*
+* Description:
+* Benchmark of the flash backend erase. Compares the original erase (row by
+* row on the internal flash, the configured sector erase on the QSPI memory)
+* against flash_area_erase(), which splits the range into the largest aligned
+* blocks each device can erase and skips blocks that are already blank.
+* Reports the number of erase commands and the simulated erase time for whole
+* slots and for unaligned ranges holding data, and for the same ranges when
+* already blank, on the default QSPI memory model and on one with 4, 32 and
+* 64 KB erase types.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sysflash.h"
+#include "cy_smif_psoc6.h"
+#include "ext_flash_sfdp.h"
+
+#include "bench.h"
+
+/*******************************************************************************
+* Data types
+********************************************************************************/
+typedef int (*erase_fn_t)(const struct flash_area *fa, uint32_t off, uint32_t len);
+
+typedef struct
+{
+    const char *name;
+    uint8_t fa_id;
+    uint32_t off;
+    uint32_t len;
+} bench_case_t;
+
+typedef struct
+{
+    const char *name;
+    const char *params[4][2];
+} bench_model_t;
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+static const bench_case_t cases[] =
+{
+    { "primary_1 slot",      FLASH_AREA_IMAGE_PRIMARY(0),   0U,       CY_BOOT_PRIMARY_1_SIZE },
+    { "primary_1 20K@1.5K",  FLASH_AREA_IMAGE_PRIMARY(0),   0x600U,   0x5000U },
+    { "secondary_1 slot",    FLASH_AREA_IMAGE_SECONDARY(0), 0U,       CY_BOOT_SECONDARY_1_SIZE },
+    { "secondary_1 36K@4K",  FLASH_AREA_IMAGE_SECONDARY(0), 0x1000U,  0x9000U },
+    { "secondary_2 slot",    FLASH_AREA_IMAGE_3,            0U,       CY_BOOT_SECONDARY_2_SIZE },
+};
+
+static const bench_model_t models[] =
+{
+    { "S25FL512S, 256 KB sectors", { { NULL, NULL } } },
+    { "64 KB blocks, 32 KB and 4 KB erase",
+      { { "ext_sector_size", "0x10000" }, { "ext_sector_erase_ns", "250000000" },
+        { "ext_erase_32k_ns", "150000000" }, { "ext_erase_4k_ns", "45000000" } } },
+};
+
+/*******************************************************************************
+* Erase under test
+********************************************************************************/
+/* Erase as originally implemented. */
+static int erase_legacy(const struct flash_area *fa, uint32_t off, uint32_t len)
+{
+    uint32_t start = fa->fa_off + off;
+    int rc = 0;
+
+    if (fa->fa_device_id == FLASH_DEVICE_INTERNAL_FLASH)
+    {
+        uint32_t row_number = len / CY_FLASH_SIZEOF_ROW;
+
+        while (row_number != 0U)
+        {
+            row_number--;
+            rc = (int)Cy_Flash_EraseRow(start + row_number * CY_FLASH_SIZEOF_ROW);
+        }
+    }
+    else
+    {
+        rc = psoc6_smif_erase(start, len);
+    }
+    return rc;
+}
+
+/*******************************************************************************
+* Benchmark
+********************************************************************************/
+/* Programs the whole range, including the blocks it partially covers. */
+static void prepare(const bench_case_t *c)
+{
+    const struct flash_area *fa = bench_area(c->fa_id);
+    uint32_t start = (fa->fa_off + c->off) & ~(0x40000U - 1U);
+    uint32_t end = fa->fa_off + c->off + c->len;
+    uint8_t data[CY_FLASH_SIZEOF_ROW];
+
+    memset(data, 0x5A, sizeof(data));
+    for (uint32_t addr = start; addr < end; addr += sizeof(data))
+    {
+        sim_flash_poke(addr, data, sizeof(data));
+    }
+}
+
+/* Returns the simulated time and number of erase commands of one erase. */
+static uint64_t run(erase_fn_t fn, const bench_case_t *c, uint64_t *cmds)
+{
+    const struct flash_area *fa = bench_area(c->fa_id);
+    sim_dev_t dev = (fa->fa_device_id == FLASH_DEVICE_INTERNAL_FLASH) ?
+                    SIM_DEV_INTERNAL : SIM_DEV_EXTERNAL;
+    uint64_t start;
+
+    sim_report_reset();
+    sim_phase_begin("erase");
+
+    start = sim_now_ns();
+    if (fn(fa, c->off, c->len) != 0)
+    {
+        printf("bench: erase failed\n");
+    }
+    *cmds = sim_report.phase[0].dev[dev].ops[SIM_OP_ERASE];
+    return sim_now_ns() - start;
+}
+
+int main(void)
+{
+    if (bench_init() != 0)
+    {
+        return 1;
+    }
+
+    for (size_t m = 0; m < sizeof(models) / sizeof(models[0]); m++)
+    {
+        for (size_t p = 0; (p < 4U) && (models[m].params[p][0] != NULL); p++)
+        {
+            sim_param_set(models[m].params[p][0], models[m].params[p][1]);
+        }
+        ext_flash_sfdp_init();
+
+        printf("QSPI model: %s\n", models[m].name);
+        printf("%-20s %10s %12s %10s %12s %10s %12s\n", "range",
+               "legacy cmd", "legacy [ms]", "plan cmd", "plan [ms]",
+               "blank cmd", "blank [ms]");
+
+        for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+        {
+            uint64_t legacy_cmds;
+            uint64_t plan_cmds;
+            uint64_t blank_cmds;
+            uint64_t legacy;
+            uint64_t plan;
+            uint64_t blank;
+
+            prepare(&cases[c]);
+            legacy = run(erase_legacy, &cases[c], &legacy_cmds);
+            prepare(&cases[c]);
+            plan = run(flash_area_erase, &cases[c], &plan_cmds);
+            blank = run(flash_area_erase, &cases[c], &blank_cmds);
+
+            printf("%-20s %10" PRIu64 " %12.1f %10" PRIu64 " %12.1f %10" PRIu64 " %12.1f\n",
+                   cases[c].name, legacy_cmds, (double)legacy / 1e6,
+                   plan_cmds, (double)plan / 1e6, blank_cmds, (double)blank / 1e6);
+        }
+        printf("\n");
+    }
+
+    printf("Blank checks of the internal flash read it memory mapped and are not\n"
+           "modeled; they stop at the first programmed word.\n");
+
+    sim_flash_deinit();
+    return 0;
+}
@@ -0,0 +1,400 @@
+/******************************************************************************
+* File Name:   lz_copy.c
+*
+* Description:
+* Compares installing an image by copying it from the secondary slot with
+* expanding an LZ4 compressed image with upgrade_lz4_expand(), for code-like
+* and incompressible data and for any files given on the command line. The
+* expand time includes the modelled CPU time of the decoder.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sysflash.h"
+#include "ext_flash_map.h"
+#include "upgrade_lz4.h"
+
+#include "bench.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Copy chunk size of MCUboot's boot_copy_region(). */
+#define BENCH_CHUNK_SIZE            (1024U)
+
+/* Largest image; fits both primary slots. */
+#define BENCH_MAX_SIZE              (CY_BOOT_PRIMARY_2_SIZE - 0x1000U)
+#define BENCH_SYNTH_SIZE            (0x40000U)
+
+/* Compressor: hash table of 4-byte sequences and the end-of-block rules. */
+#define LZ_HASH_BITS                (14U)
+#define LZ_MIN_MATCH                (4U)
+#define LZ_MAX_OFFSET               (0xFFFFU)
+#define LZ_LAST_LITERALS            (5U)
+#define LZ_MF_LIMIT                 (12U)
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+static uint8_t chunk[BENCH_CHUNK_SIZE];
+static uint8_t data[BENCH_MAX_SIZE];
+static uint8_t block[BENCH_MAX_SIZE + (BENCH_MAX_SIZE / 255U) + 16U];
+static uint32_t lz_table[1U << LZ_HASH_BITS];
+static const struct flash_area *lz_dst;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+int __real_flash_area_write(const struct flash_area *fa, uint32_t off, const void *src, uint32_t len);
+
+/*******************************************************************************
+* Decoder CPU time
+********************************************************************************/
+/* Charges each chunk of the decode before it is written, so that it overlaps
+ * the program of the previous internal flash row.
+ */
+int __wrap_flash_area_write(const struct flash_area *fa, uint32_t off, const void *src, uint32_t len)
+{
+    if (fa == lz_dst)
+    {
+        sim_account_lz4(len);
+    }
+    return __real_flash_area_write(fa, off, src, len);
+}
+
+/*******************************************************************************
+* Compressor (the greedy matching of app_cm4/script/image_compress.py)
+********************************************************************************/
+static uint32_t lz_hash(const uint8_t *p)
+{
+    uint32_t v;
+
+    memcpy(&v, p, sizeof(v));
+    return (v * 2654435761U) >> (32U - LZ_HASH_BITS);
+}
+
+static uint8_t *lz_length(uint8_t *out, uint32_t len)
+{
+    while (len >= 255U)
+    {
+        *out++ = 255U;
+        len -= 255U;
+    }
+    *out++ = (uint8_t)len;
+    return out;
+}
+
+static uint8_t *lz_sequence(uint8_t *out, const uint8_t *lit, uint32_t lit_len,
+                            uint32_t match_len, uint32_t offset)
+{
+    uint8_t *token = out++;
+
+    *token = (uint8_t)(((lit_len < 15U) ? lit_len : 15U) << 4);
+    if (lit_len >= 15U)
+    {
+        out = lz_length(out, lit_len - 15U);
+    }
+    memcpy(out, lit, lit_len);
+    out += lit_len;
+
+    if (match_len != 0U)
+    {
+        uint32_t extra = match_len - LZ_MIN_MATCH;
+
+        *token |= (uint8_t)((extra < 15U) ? extra : 15U);
+        *out++ = (uint8_t)offset;
+        *out++ = (uint8_t)(offset >> 8);
+        if (extra >= 15U)
+        {
+            out = lz_length(out, extra - 15U);
+        }
+    }
+    return out;
+}
+
+/* Greedy LZ4 block compression; returns the block size. */
+static uint32_t lz_compress(const uint8_t *src, uint32_t len, uint8_t *dst)
+{
+    uint8_t *out = dst;
+    uint32_t anchor = 0;
+    uint32_t pos = 0;
+
+    memset(lz_table, 0xFF, sizeof(lz_table));
+
+    while ((len > LZ_MF_LIMIT) && (pos < (len - LZ_MF_LIMIT)))
+    {
+        uint32_t h = lz_hash(&src[pos]);
+        uint32_t cand = lz_table[h];
+        uint32_t match;
+
+        lz_table[h] = pos;
+        if ((cand == UINT32_MAX) || ((pos - cand) > LZ_MAX_OFFSET) ||
+            (memcmp(&src[cand], &src[pos], LZ_MIN_MATCH) != 0))
+        {
+            pos++;
+            continue;
+        }
+
+        match = LZ_MIN_MATCH;
+        while (((pos + match) < (len - LZ_LAST_LITERALS)) && (src[cand + match] == src[pos + match]))
+        {
+            match++;
+        }
+        while ((pos > anchor) && (cand > 0U) && (src[cand - 1U] == src[pos - 1U]))
+        {
+            pos--;
+            cand--;
+            match++;
+        }
+
+        out = lz_sequence(out, &src[anchor], pos - anchor, match, pos - cand);
+        pos += match;
+        anchor = pos;
+    }
+
+    out = lz_sequence(out, &src[anchor], len - anchor, 0U, 0U);
+    return (uint32_t)(out - dst);
+}
+
+/*******************************************************************************
+* Data
+********************************************************************************/
+/* Stand-in for Thumb-2 code: a skewed mix of a few hundred instruction
+ * sequences, with a changed operand byte now and then, and literal pools
+ * of nearby addresses.
+ */
+static uint32_t synth_code(uint8_t *dst, uint32_t len)
+{
+    uint8_t snippets[256][8];
+
+    srand(1);
+    for (uint32_t i = 0; i < 256U; i++)
+    {
+        for (uint32_t j = 0; j < 8U; j++)
+        {
+            snippets[i][j] = (uint8_t)rand();
+        }
+    }
+
+    for (uint32_t off = 0; off < len; )
+    {
+        uint32_t n;
+
+        if ((rand() % 16) == 0)
+        {
+            uint32_t addr = 0x10018400U + ((uint32_t)rand() % 0x40000U);
+
+            n = 4U;
+            memcpy(chunk, &addr, n);
+        }
+        else
+        {
+            uint32_t r = (uint32_t)rand() % 256U;
+
+            /* Squaring skews the choice towards the first snippets. */
+            n = 2U + 2U * ((uint32_t)rand() % 4U);
+            memcpy(chunk, snippets[(r * r) / 256U], n);
+            if ((rand() % 4) == 0)
+            {
+                chunk[0] = (uint8_t)rand();
+            }
+        }
+        n = ((len - off) < n) ? (len - off) : n;
+        memcpy(&dst[off], chunk, n);
+        off += n;
+    }
+    return len;
+}
+
+static uint32_t synth_blob(uint8_t *dst, uint32_t len)
+{
+    srand(2);
+    for (uint32_t i = 0; i < len; i++)
+    {
+        dst[i] = (uint8_t)rand();
+    }
+    return len;
+}
+
+static uint32_t load_file(const char *name, uint8_t *dst)
+{
+    FILE *f = fopen(name, "rb");
+    size_t len;
+
+    if (f == NULL)
+    {
+        perror(name);
+        return 0U;
+    }
+    len = fread(dst, 1U, BENCH_MAX_SIZE, f);
+    fclose(f);
+    return (uint32_t)len;
+}
+
+/*******************************************************************************
+* Benchmark
+********************************************************************************/
+/* Erases the first `len` bytes of `dst` and puts `src_len` bytes in `src`. */
+static void prepare(const struct flash_area *dst, uint32_t len, const struct flash_area *src,
+                    const uint8_t *image, uint32_t src_len)
+{
+    memset(chunk, flash_area_erased_val(dst), sizeof(chunk));
+    for (uint32_t off = 0; off < (len + sizeof(chunk)); off += sizeof(chunk))
+    {
+        sim_flash_poke(dst->fa_off + off, chunk, sizeof(chunk));
+    }
+    sim_flash_poke(src->fa_off, image, src_len);
+}
+
+static bool check(const struct flash_area *dst, uint32_t len)
+{
+    for (uint32_t off = 0; off < len; off += sizeof(chunk))
+    {
+        uint32_t n = ((len - off) < sizeof(chunk)) ? (len - off) : sizeof(chunk);
+
+        if ((flash_area_read(dst, off, chunk, n) != 0) || (memcmp(chunk, &data[off], n) != 0))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Copies the image the way MCUboot does; returns the simulated time. */
+static uint64_t run_copy(const struct flash_area *dst, const struct flash_area *src, uint32_t len)
+{
+    uint32_t align = flash_area_align(dst);
+    uint64_t start;
+    int rc = 0;
+
+    prepare(dst, len, src, data, len);
+    start = sim_now_ns();
+    for (uint32_t off = 0; (off < len) && (rc == 0); off += sizeof(chunk))
+    {
+        uint32_t n = ((len - off) < sizeof(chunk)) ? (len - off) : sizeof(chunk);
+
+        rc = flash_area_read(src, off, chunk, n);
+        n = (n + align - 1U) / align * align;
+        if (rc == 0)
+        {
+            rc = flash_area_write(dst, off, chunk, n);
+        }
+    }
+    if ((flash_area_sync() != 0) || (rc != 0))
+    {
+        printf("bench: copy failed\n");
+        return 0U;
+    }
+    return sim_now_ns() - start;
+}
+
+/* Expands the compressed image; returns the simulated time and the host
+ * time of the decoder call.
+ */
+static uint64_t run_expand(const struct flash_area *dst, const struct flash_area *src,
+                           uint32_t len, uint32_t block_len, uint64_t *host_ns)
+{
+    uint64_t start;
+    uint64_t host_start;
+    int rc;
+
+    prepare(dst, len, src, block, block_len);
+    start = sim_now_ns();
+    host_start = bench_host_ns();
+    lz_dst = dst;
+    rc = upgrade_lz4_expand(src, 0U, block_len, dst, len);
+    lz_dst = NULL;
+    *host_ns = bench_host_ns() - host_start;
+    if ((flash_area_sync() != 0) || (rc != 0) || !check(dst, len))
+    {
+        printf("bench: expand failed\n");
+        return 0U;
+    }
+    return sim_now_ns() - start;
+}
+
+static void print_rows(const char *name, uint32_t len)
+{
+    const uint8_t areas[][2] =
+    {
+        { FLASH_AREA_IMAGE_PRIMARY(0), FLASH_AREA_IMAGE_SECONDARY(0) },
+        { FLASH_AREA_IMAGE_2, FLASH_AREA_IMAGE_3 },
+    };
+    uint32_t block_len = lz_compress(data, len, block);
+
+    for (size_t a = 0; a < sizeof(areas) / sizeof(areas[0]); a++)
+    {
+        const struct flash_area *dst = bench_area(areas[a][0]);
+        const struct flash_area *src = bench_area(areas[a][1]);
+        uint64_t host_ns;
+        uint64_t copy = run_copy(dst, src, len);
+        uint64_t expand = run_expand(dst, src, len, block_len, &host_ns);
+
+        printf("%-12.12s %-9s %8" PRIu32 " %8" PRIu32 " %6.1f%% %10.1f %10.1f %7.2fx %8.1f\n",
+               name, (a == 0U) ? "internal" : "external", len, block_len,
+               100.0 * (double)block_len / (double)len, (double)copy / 1e6,
+               (double)expand / 1e6, (expand != 0U) ? (double)copy / (double)expand : 0.0,
+               (double)host_ns / (double)len);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (bench_init() != 0)
+    {
+        return 1;
+    }
+
+    printf("%-12s %-9s %8s %8s %7s %10s %10s %8s %8s\n", "data", "primary", "size",
+           "lz4", "ratio", "copy [ms]", "lz4 [ms]", "speedup", "host ns/B");
+
+    print_rows("code", synth_code(data, BENCH_SYNTH_SIZE));
+    print_rows("blob", synth_blob(data, BENCH_SYNTH_SIZE));
+    for (int i = 1; i < argc; i++)
+    {
+        uint32_t len = load_file(argv[i], data);
+        const char *name = strrchr(argv[i], '/');
+
+        if (len != 0U)
+        {
+            print_rows((name != NULL) ? (name + 1) : argv[i], len);
+        }
+    }
+
+    sim_flash_deinit();
+    return 0;
+}
@@ -0,0 +1,165 @@
+/******************************************************************************
+* File Name:   read_cache.c
+*
+* Description:
+* Benchmark of the external flash read cache. Replays the metadata reads
+* MCUboot issues for one image in an external slot (trailer fields, image
+* header and TLV walk), once straight through psoc6_smif_read() and once
+* through flash_area_read() with a cold cache. Reports the number of QSPI
+* transactions and the simulated time for two command overheads: the
+* default model and one closer to a PDL command mode read on CM0+.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "sysflash.h"
+#include "cy_smif_psoc6.h"
+#include "ext_flash_cache.h"
+
+#include "bench.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* TLV area of a 300 KB image behind a 1 KB header. */
+#define BENCH_TLV_OFF               (0x400U + 0x4B000U)
+
+/*******************************************************************************
+* Data types
+********************************************************************************/
+typedef int (*read_fn_t)(const struct flash_area *fa, uint32_t off, void *dst, uint32_t len);
+
+typedef struct
+{
+    int32_t off;                /* Negative: from the end of the slot */
+    uint32_t len;
+} bench_read_t;
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+static const bench_read_t trace[] =
+{
+    /* boot_read_swap_state(): magic, swap info, copy done, image ok */
+    { -16, 16U }, { -48, 1U }, { -40, 1U }, { -32, 1U },
+    /* boot_read_image_header() */
+    { 0, 32U },
+    /* TLV info, then key hash, SHA-256 and ECDSA signature TLVs */
+    { BENCH_TLV_OFF, 4U },
+    { BENCH_TLV_OFF + 4, 4U }, { BENCH_TLV_OFF + 8, 32U },
+    { BENCH_TLV_OFF + 40, 4U }, { BENCH_TLV_OFF + 44, 32U },
+    { BENCH_TLV_OFF + 76, 4U }, { BENCH_TLV_OFF + 80, 72U },
+};
+
+static const uint64_t cmd_ns[] = { 0U, 15000U };
+
+/*******************************************************************************
+* Reads under test
+********************************************************************************/
+/* One command mode transaction per read, as before the cache. */
+static int read_direct(const struct flash_area *fa, uint32_t off, void *dst, uint32_t len)
+{
+    return psoc6_smif_read(fa, (off_t)(fa->fa_off + off), dst, len);
+}
+
+/*******************************************************************************
+* Benchmark
+********************************************************************************/
+/* Returns the simulated time and number of QSPI reads of one trace replay. */
+static uint64_t run(read_fn_t fn, const struct flash_area *fa, uint64_t *reads)
+{
+    uint8_t buf[128];
+    uint64_t start;
+
+    ext_flash_cache_invalidate(0U, UINT32_MAX);
+    sim_report_reset();
+    sim_phase_begin("read");
+
+    start = sim_now_ns();
+    for (size_t i = 0; i < sizeof(trace) / sizeof(trace[0]); i++)
+    {
+        uint32_t off = (trace[i].off < 0) ? (fa->fa_size - (uint32_t)(-trace[i].off)) :
+                                            (uint32_t)trace[i].off;
+
+        if (fn(fa, off, buf, trace[i].len) != 0)
+        {
+            printf("bench: read failed\n");
+        }
+    }
+    *reads = sim_report.phase[0].dev[SIM_DEV_EXTERNAL].ops[SIM_OP_READ];
+    return sim_now_ns() - start;
+}
+
+int main(void)
+{
+    const struct flash_area *fa;
+    char value[24];
+
+    if (bench_init() != 0)
+    {
+        return 1;
+    }
+    fa = bench_area(FLASH_AREA_IMAGE_SECONDARY(0));
+
+    printf("%-14s %12s %12s %12s %12s %8s %8s\n", "cmd overhead",
+           "direct rd", "direct [us]", "cached rd", "cached [us]", "hits", "misses");
+
+    for (size_t c = 0; c < sizeof(cmd_ns) / sizeof(cmd_ns[0]); c++)
+    {
+        const ext_flash_cache_stats_t *stats = ext_flash_cache_get_stats();
+        uint32_t hits = stats->hits;
+        uint32_t misses = stats->misses;
+        uint64_t direct_reads;
+        uint64_t cached_reads;
+        uint64_t direct;
+        uint64_t cached;
+
+        if (cmd_ns[c] != 0U)
+        {
+            snprintf(value, sizeof(value), "%" PRIu64, cmd_ns[c]);
+            sim_param_set("ext_cmd_ns", value);
+        }
+
+        direct = run(read_direct, fa, &direct_reads);
+        cached = run(flash_area_read, fa, &cached_reads);
+
+        printf("%-14s %12" PRIu64 " %12.2f %12" PRIu64 " %12.2f %8" PRIu32 " %8" PRIu32 "\n",
+               (cmd_ns[c] != 0U) ? "15 us" : "default", direct_reads, (double)direct / 1e3,
+               cached_reads, (double)cached / 1e3, stats->hits - hits, stats->misses - misses);
+    }
+
+    sim_flash_deinit();
+    return 0;
+}
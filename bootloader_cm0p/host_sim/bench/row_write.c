@@ -0,0 +1,181 @@
+/******************************************************************************
+* File Name:   row_write.c
+*
+* Description:
+* Benchmark of the internal flash row programming used to copy an image from
+* the external secondary slot to the internal primary slot. Compares the
+* original loop (blocking Cy_Flash_WriteRow() per row) against
+* flash_area_write(), which programs rows without waiting and skips the erase
+* phase of rows that are already erased, copying in 1 KB chunks like MCUboot
+* does. Reports the simulated copy time for an erased and for a programmed
+* destination.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sysflash.h"
+#include "ext_flash_map.h"
+
+#include "bench.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Copy chunk size of MCUboot's boot_copy_region(). */
+#define BENCH_CHUNK_SIZE            (1024U)
+
+/*******************************************************************************
+* Data types
+********************************************************************************/
+typedef int (*write_fn_t)(const struct flash_area *fa, uint32_t off,
+                          const void *src, uint32_t len);
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+static const uint32_t sizes[] = { 0x10000U, 0x4B000U, CY_BOOT_PRIMARY_1_SIZE };
+static uint8_t chunk[BENCH_CHUNK_SIZE];
+static uint8_t pattern[CY_BOOT_PRIMARY_1_SIZE];
+
+/*******************************************************************************
+* Writers under test
+********************************************************************************/
+/* Internal flash branch of flash_area_write() as originally implemented. */
+static int write_legacy(const struct flash_area *fa, uint32_t off,
+                        const void *src, uint32_t len)
+{
+    cy_en_flashdrv_status_t rc = CY_FLASH_DRV_SUCCESS;
+    uint32_t row_addr = fa->fa_off + off;
+    const uint32_t *row_ptr = (const uint32_t *)src;
+
+    for (uint32_t i = 0; i < len / CY_FLASH_SIZEOF_ROW; i++)
+    {
+        rc = Cy_Flash_WriteRow(row_addr, row_ptr);
+
+        row_addr += (uint32_t)CY_FLASH_SIZEOF_ROW;
+        row_ptr = row_ptr + CY_FLASH_SIZEOF_ROW / 4;
+    }
+    return (int)rc;
+}
+
+/*******************************************************************************
+* Benchmark
+********************************************************************************/
+static void prepare(const struct flash_area *dst, const struct flash_area *src,
+                    uint32_t len, bool erased)
+{
+    memset(chunk, erased ? flash_area_erased_val(dst) : 0x5A, sizeof(chunk));
+    for (uint32_t off = 0; off < len; off += sizeof(chunk))
+    {
+        sim_flash_poke(dst->fa_off + off, chunk, sizeof(chunk));
+    }
+    sim_flash_poke(src->fa_off, pattern, len);
+}
+
+/* Copies `len` bytes from `src` to `dst` and returns the simulated time in
+ * ns, or 0 if the copy failed or the destination does not match.
+ */
+static uint64_t run(write_fn_t fn, const struct flash_area *dst,
+                    const struct flash_area *src, uint32_t len)
+{
+    uint64_t start = sim_now_ns();
+    int rc = 0;
+
+    for (uint32_t off = 0; (off < len) && (rc == 0); off += sizeof(chunk))
+    {
+        rc = flash_area_read(src, off, chunk, sizeof(chunk));
+        if (rc == 0)
+        {
+            rc = fn(dst, off, chunk, sizeof(chunk));
+        }
+    }
+    if (rc == 0)
+    {
+        rc = flash_area_sync();
+    }
+    if ((rc != 0) || (memcmp((const void *)(uintptr_t)dst->fa_off, pattern, len) != 0))
+    {
+        printf("bench: copy failed\n");
+        return 0U;
+    }
+    return sim_now_ns() - start;
+}
+
+int main(void)
+{
+    const struct flash_area *dst;
+    const struct flash_area *src;
+
+    if (bench_init() != 0)
+    {
+        return 1;
+    }
+
+    dst = bench_area(FLASH_AREA_IMAGE_PRIMARY(0));
+    src = bench_area(FLASH_AREA_IMAGE_SECONDARY(0));
+
+    for (uint32_t i = 0; i < sizeof(pattern); i++)
+    {
+        pattern[i] = (uint8_t)((i * 2654435761U) >> 24);
+    }
+
+    printf("%8s %-12s %14s %14s %8s\n", "size", "destination",
+           "legacy [ms]", "pipelined [ms]", "speedup");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        for (uint32_t e = 0; e < 2U; e++)
+        {
+            bool erased = (e == 0U);
+            uint64_t legacy;
+            uint64_t pipelined;
+
+            prepare(dst, src, sizes[s], erased);
+            legacy = run(write_legacy, dst, src, sizes[s]);
+            prepare(dst, src, sizes[s], erased);
+            pipelined = run(flash_area_write, dst, src, sizes[s]);
+
+            printf("%8" PRIu32 " %-12s %14.1f %14.1f %7.2fx\n", sizes[s],
+                   erased ? "erased" : "programmed",
+                   (double)legacy / 1e6, (double)pipelined / 1e6,
+                   (pipelined != 0U) ? (double)legacy / (double)pipelined : 0.0);
+        }
+    }
+
+    sim_flash_deinit();
+    return 0;
+}
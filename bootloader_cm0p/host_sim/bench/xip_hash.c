@@ -0,0 +1,156 @@
+/******************************************************************************
+* File Name:   xip_hash.c
+*
+* Description:
+* Benchmark of the external flash read path used for image hashing. Reads
+* both secondary slots (1.75 MB and 512 KB) in the 256 byte chunks MCUboot
+* hashes: with SMIF command mode reads, through the XIP window in memory
+* mode, and through flash_area_read(), which streams the slot with DMA into
+* two buffers, with and without the SHA-256 cost. Reports the simulated
+* time and throughput of each.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include "sysflash.h"
+#include "cy_smif_psoc6.h"
+#include "ext_flash_cache.h"
+#include "ext_flash_smif.h"
+
+#include "bench.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Chunk size of MCUboot's bootutil_img_hash() (BOOT_TMPBUF_SZ). */
+#define BENCH_CHUNK                 (256U)
+
+/* Continuous read mode bits the SFDP tables of the modeled memory give. */
+#define BENCH_CONT_MODE             (0xA5U)
+
+/*******************************************************************************
+* Data types
+********************************************************************************/
+typedef int (*read_fn_t)(const struct flash_area *fa, uint32_t off, void *dst, uint32_t len);
+
+/*******************************************************************************
+* Reads under test
+********************************************************************************/
+static int read_cmd(const struct flash_area *fa, uint32_t off, void *dst, uint32_t len)
+{
+    ext_flash_smif_cmd_mode();
+    return psoc6_smif_read(fa, (off_t)(fa->fa_off + off), dst, len);
+}
+
+static int read_xip(const struct flash_area *fa, uint32_t off, void *dst, uint32_t len)
+{
+    return ext_flash_smif_xip_read(fa->fa_off + off, dst, len);
+}
+
+static int read_stream(const struct flash_area *fa, uint32_t off, void *dst, uint32_t len)
+{
+    return flash_area_read(fa, off, dst, len);
+}
+
+/*******************************************************************************
+* Benchmark
+********************************************************************************/
+/* Returns the simulated time of reading (and hashing) the whole slot. */
+static uint64_t run(read_fn_t fn, const struct flash_area *fa, bool hash)
+{
+    uint8_t buf[BENCH_CHUNK];
+    uint64_t start;
+
+    ext_flash_smif_cmd_mode();
+    ext_flash_cache_invalidate(0U, UINT32_MAX);
+
+    start = sim_now_ns();
+    for (uint32_t off = 0; off < fa->fa_size; off += BENCH_CHUNK)
+    {
+        if (fn(fa, off, buf, BENCH_CHUNK) != 0)
+        {
+            printf("bench: read failed\n");
+            break;
+        }
+        if (hash)
+        {
+            sim_account_hash(BENCH_CHUNK);
+        }
+    }
+    return sim_now_ns() - start;
+}
+
+static void print_row(const char *name, const struct flash_area *fa, bool hash)
+{
+    const read_fn_t fns[] = { read_cmd, read_xip, read_stream };
+    double mb = (double)fa->fa_size / (1024.0 * 1024.0);
+
+    printf("%-10s %8" PRIu32, name, fa->fa_size / 1024U);
+    for (size_t f = 0; f < sizeof(fns) / sizeof(fns[0]); f++)
+    {
+        uint64_t ns = run(fns[f], fa, hash);
+
+        printf(" %10.2f %8.2f", (double)ns / 1e6, mb / ((double)ns / 1e9));
+    }
+    printf("\n");
+}
+
+int main(void)
+{
+    const uint8_t areas[] = { FLASH_AREA_IMAGE_SECONDARY(0), FLASH_AREA_IMAGE_3 };
+
+    if (bench_init() != 0)
+    {
+        return 1;
+    }
+
+    printf("%-10s %8s %10s %8s %10s %8s %10s %8s\n", "pass", "KB",
+           "cmd [ms]", "MB/s", "XIP [ms]", "MB/s", "DMA [ms]", "MB/s");
+
+    for (size_t a = 0; a < sizeof(areas); a++)
+    {
+        const struct flash_area *fa = bench_area(areas[a]);
+
+        (void)ext_flash_smif_set_cont_read(0U);
+        print_row("read", fa, false);
+        print_row("read+hash", fa, true);
+        (void)ext_flash_smif_set_cont_read(BENCH_CONT_MODE);
+        print_row("cont read", fa, false);
+        print_row("cont+hash", fa, true);
+    }
+
+    sim_flash_deinit();
+    return 0;
+}
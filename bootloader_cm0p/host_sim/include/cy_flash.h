@@ -0,0 +1,79 @@
+/******************************************************************************
+* File Name:   cy_flash.h
+*
+* Description:
+* Host stand-in for the PDL internal flash driver. The functions are implemented
+* by the host flash simulator (sim_pdl.c).
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef CY_FLASH_H
+#define CY_FLASH_H
+
+#include <stdint.h>
+
+#include "sim_flash.h"
+
+#define CY_FLASH_BASE               (SIM_INT_FLASH_BASE)
+#define CY_FLASH_SIZE               (SIM_INT_FLASH_SIZE)
+#define CY_FLASH_SIZEOF_ROW         (512UL)
+
+#define CY_FLASH_ID                 (0x14UL << 16U)
+#define CY_FLASH_ID_INFO            ((1UL << 30U) | CY_FLASH_ID)
+#define CY_FLASH_ID_ERROR           ((2UL << 30U) | CY_FLASH_ID)
+
+typedef enum cy_en_flashdrv_status
+{
+    CY_FLASH_DRV_SUCCESS                  = 0x00UL,
+    CY_FLASH_DRV_INV_PROT                 = (CY_FLASH_ID_ERROR + 0x0UL),
+    CY_FLASH_DRV_INVALID_FM_PL            = (CY_FLASH_ID_ERROR + 0x1UL),
+    CY_FLASH_DRV_INVALID_FLASH_ADDR       = (CY_FLASH_ID_ERROR + 0x2UL),
+    CY_FLASH_DRV_ROW_PROTECTED            = (CY_FLASH_ID_ERROR + 0x3UL),
+    CY_FLASH_DRV_IPC_BUSY                 = (CY_FLASH_ID_ERROR + 0x5UL),
+    CY_FLASH_DRV_INVALID_INPUT_PARAMETERS = (CY_FLASH_ID_ERROR + 0x6UL),
+    CY_FLASH_DRV_ERR_UNC                  = (CY_FLASH_ID_ERROR + 0xFFUL),
+    CY_FLASH_DRV_PROGRESS_NO_ERROR        = (CY_FLASH_ID_INFO + 0x0UL),
+    CY_FLASH_DRV_OPERATION_STARTED        = (CY_FLASH_ID_INFO + 0x1UL),
+    CY_FLASH_DRV_OPCODE_BUSY              = (CY_FLASH_ID_INFO + 0x2UL)
+} cy_en_flashdrv_status_t;
+
+cy_en_flashdrv_status_t Cy_Flash_WriteRow(uint32_t rowAddr, const uint32_t *data);
+cy_en_flashdrv_status_t Cy_Flash_ProgramRow(uint32_t rowAddr, const uint32_t *data);
+cy_en_flashdrv_status_t Cy_Flash_EraseRow(uint32_t rowAddr);
+cy_en_flashdrv_status_t Cy_Flash_EraseSubsector(uint32_t subSectorAddr);
+cy_en_flashdrv_status_t Cy_Flash_EraseSector(uint32_t sectorAddr);
+cy_en_flashdrv_status_t Cy_Flash_StartWrite(uint32_t rowAddr, const uint32_t *data);
+cy_en_flashdrv_status_t Cy_Flash_StartProgram(uint32_t rowAddr, const uint32_t *data);
+cy_en_flashdrv_status_t Cy_Flash_IsOperationComplete(void);
+
+#endif /* CY_FLASH_H */
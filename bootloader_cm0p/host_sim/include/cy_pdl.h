@@ -0,0 +1,81 @@
+/******************************************************************************
+* File Name:   cy_pdl.h
+*
+* Description:
+* Host stand-in for the PDL umbrella header, used by the host flash simulator.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef CY_PDL_H
+#define CY_PDL_H
+
+#include "cy_syslib.h"
+#include "cy_flash.h"
+#include "cy_result.h"
+
+/* Base of the SMIF XIP window. */
+#define CY_XIP_BASE                 (SIM_EXT_FLASH_BASE)
+
+/* Opaque peripheral register blocks. */
+typedef struct { uint32_t reserved; } CySCB_Type;
+typedef struct { uint32_t reserved; } GPIO_PRT_Type;
+
+/* Backup domain registers, kept across resets but not across power loss. */
+typedef struct { volatile uint32_t BREG[16]; } BACKUP_Type;
+
+extern BACKUP_Type *sim_backup;
+#define BACKUP                      (sim_backup)
+
+void Cy_GPIO_Port_Deinit(GPIO_PRT_Type *base);
+
+/* CPU clock and the SysTick timer. */
+typedef enum
+{
+    CY_SYSTICK_CLOCK_SOURCE_CLK_LF    = 0U,
+    CY_SYSTICK_CLOCK_SOURCE_CLK_IMO   = 1U,
+    CY_SYSTICK_CLOCK_SOURCE_CLK_ECO   = 2U,
+    CY_SYSTICK_CLOCK_SOURCE_CLK_TIMER = 3U,
+    CY_SYSTICK_CLOCK_SOURCE_CLK_CPU   = 4U,
+} cy_en_systick_clock_source_t;
+
+typedef void (*Cy_SysTick_Callback)(void);
+
+extern uint32_t SystemCoreClock;
+
+void SystemCoreClockUpdate(void);
+void Cy_SysTick_Init(cy_en_systick_clock_source_t clockSource, uint32_t interval);
+Cy_SysTick_Callback Cy_SysTick_SetCallback(uint32_t number, Cy_SysTick_Callback function);
+uint32_t Cy_SysTick_GetValue(void);
+void Cy_SysTick_Disable(void);
+
+#endif /* CY_PDL_H */
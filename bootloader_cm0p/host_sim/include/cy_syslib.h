@@ -0,0 +1,67 @@
+/******************************************************************************
+* File Name:   cy_syslib.h
+*
+* Description:
+* Host stand-in for the PDL system library, used by the host flash simulator.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef CY_SYSLIB_H
+#define CY_SYSLIB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define CY_ASSERT(x)                do { if (!(x)) { sim_assert_failed(__FILE__, __LINE__); } } while (0)
+#define CY_SECTION(name)
+#define CY_UNUSED_PARAMETER(x)      ((void)(x))
+
+#define CY_SYSPM_WAIT_FOR_INTERRUPT (0U)
+
+void sim_assert_failed(const char *file, int line);
+
+void __enable_irq(void);
+void __disable_irq(void);
+void __WFI(void);
+void NVIC_SystemReset(void) __attribute__((noreturn));
+uint32_t Cy_SysLib_EnterCriticalSection(void);
+void Cy_SysLib_ExitCriticalSection(uint32_t savedIntrStatus);
+void Cy_SysEnableCM4(uint32_t vectorTableOffset);
+uint32_t Cy_SysPm_CpuEnterDeepSleep(uint32_t waitFor);
+void Cy_SysLib_Delay(uint32_t milliseconds);
+void Cy_SysLib_DelayUs(uint16_t microseconds);
+uint64_t Cy_SysLib_GetUniqueId(void);
+
+#endif /* CY_SYSLIB_H */
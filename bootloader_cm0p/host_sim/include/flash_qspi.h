@@ -0,0 +1,63 @@
+/******************************************************************************
+* File Name:   flash_qspi.h
+*
+* Description:
+* Host stand-in for the MCUboot QSPI flash PAL. The functions are implemented by
+* the host flash simulator (sim_pdl.c).
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef FLASH_QSPI_H
+#define FLASH_QSPI_H
+
+#include <stdint.h>
+
+typedef enum
+{
+    CY_SMIF_SUCCESS = 0x00U,
+    CY_SMIF_CMD_FIFO_FULL,
+    CY_SMIF_EXCEED_TIMEOUT,
+    CY_SMIF_NO_QE_BIT,
+    CY_SMIF_BAD_PARAM,
+    CY_SMIF_NO_SFDP_SUPPORT,
+    CY_SMIF_SFDP_SS0_FAILED,
+    CY_SMIF_BUSY
+} cy_en_smif_status_t;
+
+cy_en_smif_status_t qspi_init_sfdp(uint32_t smif_id);
+uint32_t qspi_get_prog_size(void);
+uint32_t qspi_get_erase_size(void);
+uint32_t qspi_get_mem_size(void);
+void qspi_deinit(uint32_t smif_id);
+
+#endif /* FLASH_QSPI_H */
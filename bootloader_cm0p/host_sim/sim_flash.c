@@ -0,0 +1,786 @@
+/******************************************************************************
+* File Name:   sim_flash.c
+*
+* Description:
+* This file implements the host (Linux) model of the internal flash and the
+* SMIF/QSPI NOR device. Device contents live in files that are mapped at the
+* addresses the bootloader uses on the target, so the unmodified flash backend
+* can access them. Accesses advance a simulated clock and are accounted per
+* boot phase and per flash area.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sim_flash.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE                 (0x100000)
+#endif
+
+/* Value of the flash bytes after an erase, see CY_BOOT_*_FLASH_ERASE_VALUE. */
+#define SIM_INT_ERASE_VALUE                 (0x00U)
+#define SIM_EXT_ERASE_VALUE                 (0xFFU)
+
+#define SIM_PARAM(field, desc)              { #field, offsetof(sim_params_t, field), desc }
+
+/* Index of the work flash in sim_devices[]; it is accessed as part of
+ * SIM_DEV_INTERNAL.
+ */
+#define SIM_WORK_FLASH                      (SIM_DEV_COUNT)
+#define SIM_DEVICE_COUNT                    (SIM_DEV_COUNT + 1U)
+
+/* sim_flash_restore() only copies the blocks that changed. */
+#define SIM_RESTORE_BLOCK                   (4096U)
+
+/*******************************************************************************
+* Data types
+********************************************************************************/
+typedef struct
+{
+    const char *name;
+    size_t offset;
+    const char *desc;
+} sim_param_desc_t;
+
+typedef struct
+{
+    const char *file;
+    uintptr_t base;
+    size_t size;
+    uint8_t erased_val;
+    uint8_t *mem;
+} sim_device_t;
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+/* Defaults model a PSoC 6 2M device with CM0+ at 50 MHz and the S25FL512S
+ * NOR flash on the kit, accessed in quad mode at 50 MHz.
+ */
+sim_params_t sim_params =
+{
+    .int_read_ps_per_byte   = 25000,
+    .int_row_write_ns       = 16000000,
+    .int_row_program_ns     = 5000000,
+    .int_row_erase_ns       = 11000000,
+    .int_subsector_erase_ns = 11000000,
+    .int_sector_erase_ns    = 11000000,
+    .int_poll_ns            = 1000,
+
+    .ext_size               = 0x4000000,
+    .ext_cmd_ns             = 1000,
+    .ext_read_ps_per_byte   = 40000,
+    .ext_write_ps_per_byte  = 40000,
+    .ext_page_size          = 512,
+    .ext_page_program_ns    = 340000,
+    .ext_sector_size        = 0x40000,
+    .ext_sector_erase_ns    = 520000000,
+    .ext_erase_4k_ns        = 0,
+    .ext_erase_32k_ns       = 0,
+    .ext_param_size         = 0,
+    .ext_param_top          = 0,
+    .ext_chip_erase_ns      = 103000000000ULL,
+    .ext_sfdp_init_ns       = 500000,
+    .ext_smif_init_ns       = 20000,
+    .ext_jedec_id           = 0x010220,
+    .ext_xip_ps_per_byte    = 25000,
+    .ext_xip_switch_ns      = 2000,
+    .ext_dma_setup_ns       = 1000,
+    .ext_cont_read          = 1,
+    .ext_xip_cmd_ps_per_byte = 3800,
+
+    .hash_ps_per_byte       = 10000,
+    .lz4_ps_per_byte        = 400000,
+    .uart_baud              = 115200,
+    .uart_fifo_size         = 128,
+    .uart_dma_setup_ns      = 1000,
+    .uart_poll_ns           = 100,
+    .irq_ns                 = 500,
+};
+
+sim_report_t sim_report;
+
+static const sim_param_desc_t sim_param_descs[] =
+{
+    SIM_PARAM(int_read_ps_per_byte,   "internal flash read cost per byte [ps]"),
+    SIM_PARAM(int_row_write_ns,       "internal row erase + program (Cy_Flash_WriteRow) [ns]"),
+    SIM_PARAM(int_row_program_ns,     "internal row program (Cy_Flash_ProgramRow) [ns]"),
+    SIM_PARAM(int_row_erase_ns,       "internal row erase [ns]"),
+    SIM_PARAM(int_subsector_erase_ns, "internal subsector (8 rows) erase [ns]"),
+    SIM_PARAM(int_sector_erase_ns,    "internal sector (256 KB) erase [ns]"),
+    SIM_PARAM(int_poll_ns,            "one Cy_Flash_IsOperationComplete() poll [ns]"),
+    SIM_PARAM(ext_size,               "external NOR size [bytes]"),
+    SIM_PARAM(ext_cmd_ns,             "external command/address/dummy overhead per transaction [ns]"),
+    SIM_PARAM(ext_read_ps_per_byte,   "external read transfer cost per byte [ps]"),
+    SIM_PARAM(ext_write_ps_per_byte,  "external program transfer cost per byte [ps]"),
+    SIM_PARAM(ext_page_size,          "external program page size [bytes]"),
+    SIM_PARAM(ext_page_program_ns,    "external page program time [ns]"),
+    SIM_PARAM(ext_sector_size,        "external erase sector size [bytes]"),
+    SIM_PARAM(ext_sector_erase_ns,    "external sector erase time [ns]"),
+    SIM_PARAM(ext_erase_4k_ns,        "external 4 KB erase time [ns], 0 if not supported"),
+    SIM_PARAM(ext_erase_32k_ns,       "external 32 KB erase time [ns], 0 if not supported"),
+    SIM_PARAM(ext_param_size,         "hybrid: region where 4/32 KB erases are valid [bytes], 0 if uniform"),
+    SIM_PARAM(ext_param_top,          "hybrid: 1 if that region is at the top, 0 if at the bottom"),
+    SIM_PARAM(ext_chip_erase_ns,      "external chip erase time [ns]"),
+    SIM_PARAM(ext_sfdp_init_ns,       "external SFDP discovery time [ns]"),
+    SIM_PARAM(ext_smif_init_ns,       "external SMIF init from a known configuration [ns]"),
+    SIM_PARAM(ext_jedec_id,           "external JEDEC ID (manufacturer, type, density bytes)"),
+    SIM_PARAM(ext_xip_ps_per_byte,    "external XIP (memory mode) read time per byte [ps], 0 = no XIP"),
+    SIM_PARAM(ext_xip_switch_ns,      "external command to memory mode switch time [ns]"),
+    SIM_PARAM(ext_dma_setup_ns,       "CPU time to start one DMA read of the XIP window [ns]"),
+    SIM_PARAM(ext_cont_read,          "1 if the SFDP tables advertise quad I/O continuous read"),
+    SIM_PARAM(ext_xip_cmd_ps_per_byte, "part of the XIP read time per byte spent on the instruction [ps]"),
+    SIM_PARAM(hash_ps_per_byte,       "SHA-256 cost per byte [ps]"),
+    SIM_PARAM(lz4_ps_per_byte,        "LZ4 decode CPU cost per expanded byte, without flash access [ps]"),
+    SIM_PARAM(uart_baud,              "debug UART baud rate"),
+    SIM_PARAM(uart_fifo_size,         "debug UART TX FIFO depth [bytes]"),
+    SIM_PARAM(uart_dma_setup_ns,      "CPU time to start a DMA transfer to the UART"),
+    SIM_PARAM(uart_poll_ns,           "CPU time to check whether a DMA transfer to the UART is done"),
+    SIM_PARAM(irq_ns,                 "CPU time to enter and leave an interrupt handler"),
+};
+
+static sim_device_t sim_devices[SIM_DEVICE_COUNT] =
+{
+    [SIM_DEV_INTERNAL] = { "internal.bin", SIM_INT_FLASH_BASE, SIM_INT_FLASH_SIZE, SIM_INT_ERASE_VALUE, NULL },
+    [SIM_DEV_EXTERNAL] = { "external.bin", SIM_EXT_FLASH_BASE, 0, SIM_EXT_ERASE_VALUE, NULL },
+    [SIM_WORK_FLASH]   = { "work.bin", SIM_WORK_FLASH_BASE, SIM_WORK_FLASH_SIZE, SIM_INT_ERASE_VALUE, NULL },
+};
+
+static const char *const sim_op_names[SIM_OP_COUNT] = { "read", "program", "erase" };
+
+static uint64_t sim_clock_ns;
+static uint64_t sim_power_cut_ns;
+static uint64_t sim_power_cut_ops;
+static uint64_t sim_write_ops;
+static uint64_t sim_uart_idle_ns;
+static uint64_t sim_irq_ns;
+static void (*sim_irq_isr)(void);
+static uint32_t sim_irq_masked;
+static sim_phase_t *sim_cur_phase;
+
+/*******************************************************************************
+* Function Name: sim_device_map
+********************************************************************************
+* Summary:
+*  Opens (creating it when needed) the backing file of a device and maps it at
+*  the address the bootloader uses on the target.
+*
+*******************************************************************************/
+static int sim_device_map(sim_device_t *dev, const char *state_dir, bool reset)
+{
+    char path[512];
+    struct stat st;
+    bool fresh;
+    int fd;
+    void *mem;
+
+    snprintf(path, sizeof(path), "%s/%s", state_dir, dev->file);
+
+    fd = open(path, O_RDWR | O_CREAT | (reset ? O_TRUNC : 0), 0644);
+    if ((fd < 0) || (fstat(fd, &st) != 0))
+    {
+        fprintf(stderr, "sim: cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    fresh = ((size_t)st.st_size != dev->size);
+    if (fresh && (ftruncate(fd, (off_t)dev->size) != 0))
+    {
+        fprintf(stderr, "sim: cannot size %s: %s\n", path, strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    mem = mmap((void *)dev->base, dev->size, PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_FIXED_NOREPLACE, fd, 0);
+    close(fd);
+
+    if ((mem == MAP_FAILED) || (mem != (void *)dev->base))
+    {
+        fprintf(stderr, "sim: cannot map %s at 0x%08" PRIxPTR "\n", path, dev->base);
+        return -1;
+    }
+
+    dev->mem = mem;
+
+    /* A new device leaves the factory erased. */
+    if (fresh)
+    {
+        memset(dev->mem, dev->erased_val, dev->size);
+    }
+
+    return 0;
+}
+
+/*******************************************************************************
+* Function Name: sim_flash_init
+********************************************************************************
+* Summary:
+*  Maps the flash devices. The latency parameters that affect the geometry
+*  (ext_size) must be set before calling this function.
+*
+* Parameters:
+*  state_dir - Directory holding internal.bin, external.bin and work.bin.
+*  reset     - Start from factory-erased devices.
+*
+*******************************************************************************/
+int sim_flash_init(const char *state_dir, bool reset)
+{
+    mkdir(state_dir, 0755);
+
+    sim_devices[SIM_DEV_EXTERNAL].size = (size_t)sim_params.ext_size;
+
+    for (uint32_t i = 0; i < SIM_DEVICE_COUNT; i++)
+    {
+        if (sim_device_map(&sim_devices[i], state_dir, reset) != 0)
+        {
+            sim_flash_deinit();
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void sim_flash_deinit(void)
+{
+    for (uint32_t i = 0; i < SIM_DEVICE_COUNT; i++)
+    {
+        if (sim_devices[i].mem != NULL)
+        {
+            msync(sim_devices[i].mem, sim_devices[i].size, MS_SYNC);
+            munmap(sim_devices[i].mem, sim_devices[i].size);
+            sim_devices[i].mem = NULL;
+        }
+    }
+}
+
+/* Sets one latency parameter from its textual name and value. */
+int sim_param_set(const char *name, const char *value)
+{
+    char *end;
+    unsigned long long v = strtoull(value, &end, 0);
+
+    if ((*value == '\0') || (*end != '\0'))
+    {
+        return -1;
+    }
+
+    for (size_t i = 0; i < sizeof(sim_param_descs) / sizeof(sim_param_descs[0]); i++)
+    {
+        if (strcmp(sim_param_descs[i].name, name) == 0)
+        {
+            *(uint64_t *)((uint8_t *)&sim_params + sim_param_descs[i].offset) = v;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void sim_param_list(void)
+{
+    for (size_t i = 0; i < sizeof(sim_param_descs) / sizeof(sim_param_descs[0]); i++)
+    {
+        const uint64_t *v = (const uint64_t *)((const uint8_t *)&sim_params +
+                                               sim_param_descs[i].offset);
+        printf("  %-24s %12" PRIu64 "  %s\n", sim_param_descs[i].name, *v,
+               sim_param_descs[i].desc);
+    }
+}
+
+/* Returns the host pointer backing [addr, addr + len), or NULL when the range
+ * is not inside the device.
+ */
+uint8_t *sim_flash_ptr(sim_dev_t dev, uint32_t addr, uint32_t len)
+{
+    const sim_device_t *d = &sim_devices[dev];
+
+    if ((dev == SIM_DEV_INTERNAL) && (addr >= SIM_WORK_FLASH_BASE) &&
+        (addr < SIM_WORK_FLASH_BASE + SIM_WORK_FLASH_SIZE))
+    {
+        d = &sim_devices[SIM_WORK_FLASH];
+    }
+
+    if ((d->mem == NULL) || (addr < d->base) ||
+        ((uint64_t)addr - d->base + len > d->size))
+    {
+        return NULL;
+    }
+    return d->mem + (addr - d->base);
+}
+
+uint8_t sim_flash_erased_val(sim_dev_t dev)
+{
+    return sim_devices[dev].erased_val;
+}
+
+/* Copies data into a device without accounting any time, e.g. to install the
+ * images that a programmer or the CM4 OTA agent would have written.
+ */
+int sim_flash_poke(uint32_t addr, const void *src, uint32_t len)
+{
+    for (uint32_t i = 0; i < SIM_DEVICE_COUNT; i++)
+    {
+        uint8_t *p = sim_flash_ptr((sim_dev_t)i, addr, len);
+
+        if (p != NULL)
+        {
+            memcpy(p, src, len);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* Returns a copy of the contents of all devices, to be freed by the caller. */
+void *sim_flash_save(void)
+{
+    size_t total = 0;
+    uint8_t *state;
+
+    for (uint32_t i = 0; i < SIM_DEVICE_COUNT; i++)
+    {
+        total += sim_devices[i].size;
+    }
+
+    state = malloc(total);
+    if (state != NULL)
+    {
+        uint8_t *p = state;
+
+        for (uint32_t i = 0; i < SIM_DEVICE_COUNT; i++)
+        {
+            memcpy(p, sim_devices[i].mem, sim_devices[i].size);
+            p += sim_devices[i].size;
+        }
+    }
+    return state;
+}
+
+/* Puts back the contents saved by sim_flash_save(). */
+void sim_flash_restore(const void *state)
+{
+    const uint8_t *p = (const uint8_t *)state;
+
+    for (uint32_t i = 0; i < SIM_DEVICE_COUNT; i++)
+    {
+        for (size_t off = 0; off < sim_devices[i].size; off += SIM_RESTORE_BLOCK)
+        {
+            size_t len = sim_devices[i].size - off;
+
+            if (len > SIM_RESTORE_BLOCK)
+            {
+                len = SIM_RESTORE_BLOCK;
+            }
+            if (memcmp(sim_devices[i].mem + off, p + off, len) != 0)
+            {
+                memcpy(sim_devices[i].mem + off, p + off, len);
+            }
+        }
+        p += sim_devices[i].size;
+    }
+}
+
+int sim_flash_load(uint32_t addr, const char *file)
+{
+    FILE *f = fopen(file, "rb");
+    uint8_t *buf;
+    long len;
+    int rc = -1;
+
+    if (f == NULL)
+    {
+        fprintf(stderr, "sim: cannot open %s: %s\n", file, strerror(errno));
+        return -1;
+    }
+
+    fseek(f, 0, SEEK_END);
+    len = ftell(f);
+    rewind(f);
+
+    buf = malloc((size_t)len);
+    if ((buf != NULL) && (fread(buf, 1, (size_t)len, f) == (size_t)len))
+    {
+        rc = sim_flash_poke(addr, buf, (uint32_t)len);
+        if (rc != 0)
+        {
+            fprintf(stderr, "sim: %s does not fit at 0x%08" PRIx32 "\n", file, addr);
+        }
+    }
+
+    free(buf);
+    fclose(f);
+    return rc;
+}
+
+uint64_t sim_now_ns(void)
+{
+    return sim_clock_ns;
+}
+
+/* Advances the clock; the power fails once it reaches sim_power_cut_ns.
+ * The operation that crossed it has completed.
+ */
+/* Runs the interrupt handler once its time has come and it is not masked. */
+static void sim_irq_check(void)
+{
+    void (*isr)(void) = sim_irq_isr;
+
+    if ((isr != NULL) && (sim_irq_masked == 0U) && (sim_clock_ns >= sim_irq_ns))
+    {
+        sim_irq_isr = NULL;
+        sim_irq_masked++;
+        sim_clock_ns += sim_params.irq_ns;
+        isr();
+        sim_irq_masked--;
+    }
+}
+
+static void sim_clock_add(uint64_t ns)
+{
+    sim_clock_ns += ns;
+    sim_irq_check();
+
+    if ((sim_power_cut_ns != 0U) && (sim_clock_ns >= sim_power_cut_ns))
+    {
+        sim_power_cut_ns = 0U;
+        sim_power_lost();
+    }
+}
+
+void sim_advance_ns(uint64_t ns)
+{
+    sim_clock_add(ns);
+}
+
+/* Cuts the power once the clock reaches `ns`; 0 disables the cut. */
+void sim_power_cut_at(uint64_t ns)
+{
+    sim_power_cut_ns = ns;
+}
+
+/* Cuts the power right after the `ops`-th program or erase operation of the
+ * boot; 0 disables the cut. An operation that the device only completes
+ * later, such as a row write started with Cy_Flash_StartWrite(), is lost.
+ */
+void sim_power_cut_after(uint64_t ops)
+{
+    sim_power_cut_ops = ops;
+    sim_write_ops = 0U;
+}
+
+/* Accounts one device operation that kept the CPU busy for `ns`. */
+void sim_account(sim_dev_t dev, sim_op_t op, uint64_t bytes, uint64_t ns)
+{
+    if (sim_cur_phase != NULL)
+    {
+        sim_cur_phase->dev[dev].ops[op]++;
+        sim_cur_phase->dev[dev].bytes[op] += bytes;
+        sim_cur_phase->dev[dev].time_ns[op] += ns;
+    }
+    sim_report.dev[dev].ops[op]++;
+    sim_report.dev[dev].bytes[op] += bytes;
+    sim_report.dev[dev].time_ns[op] += ns;
+    sim_clock_add(ns);
+
+    if ((op != SIM_OP_READ) && (sim_power_cut_ops != 0U) &&
+        (++sim_write_ops >= sim_power_cut_ops))
+    {
+        sim_power_cut_ops = 0U;
+        sim_power_lost();
+    }
+}
+
+/* Accounts time spent waiting for an operation already counted. */
+void sim_account_wait(sim_dev_t dev, sim_op_t op, uint64_t ns)
+{
+    if (sim_cur_phase != NULL)
+    {
+        sim_cur_phase->dev[dev].time_ns[op] += ns;
+    }
+    sim_report.dev[dev].time_ns[op] += ns;
+    sim_clock_add(ns);
+}
+
+/* Accounts one flash_area_* call. `ns` is the simulated time the call took. */
+void sim_account_area(uint8_t fa_id, sim_op_t op, uint64_t bytes, uint64_t ns)
+{
+    if (fa_id < SIM_MAX_AREAS)
+    {
+        sim_report.area[fa_id].ops[op]++;
+        sim_report.area[fa_id].bytes[op] += bytes;
+        sim_report.area[fa_id].time_ns[op] += ns;
+    }
+}
+
+void sim_account_hash(uint64_t bytes)
+{
+    if (sim_cur_phase != NULL)
+    {
+        sim_cur_phase->hash_bytes += bytes;
+    }
+    sim_clock_add(bytes * sim_params.hash_ps_per_byte / 1000U);
+}
+
+/* Decoder CPU time; its flash accesses are accounted where they happen. */
+void sim_account_lz4(uint64_t bytes)
+{
+    sim_clock_add(bytes * sim_params.lz4_ps_per_byte / 1000U);
+}
+
+/* Blocking UART transmit: the CPU only stalls once the TX FIFO is full. */
+void sim_account_uart(uint64_t bytes)
+{
+    uint64_t char_ns = (sim_params.uart_baud != 0U) ?
+                       (10U * 1000000000ULL / sim_params.uart_baud) : 0U;
+    uint64_t fifo_ns = sim_params.uart_fifo_size * char_ns;
+
+    if (sim_uart_idle_ns < sim_clock_ns)
+    {
+        sim_uart_idle_ns = sim_clock_ns;
+    }
+    sim_uart_idle_ns += bytes * char_ns;
+
+    if (sim_uart_idle_ns > sim_clock_ns + fifo_ns)
+    {
+        sim_clock_ns = sim_uart_idle_ns - fifo_ns;
+    }
+
+    if (sim_cur_phase != NULL)
+    {
+        sim_cur_phase->uart_bytes += bytes;
+    }
+}
+
+/* Waits until the UART went idle or the timeout expired. */
+void sim_uart_flush(uint64_t timeout_ns)
+{
+    if (sim_uart_idle_ns > sim_clock_ns)
+    {
+        uint64_t wait = sim_uart_idle_ns - sim_clock_ns;
+
+        sim_clock_ns += (wait < timeout_ns) ? wait : timeout_ns;
+    }
+}
+
+/* DMA driven UART transmit: the CPU only starts the transfer. Returns the
+ * time the DMA has moved the last byte to the TX FIFO.
+ */
+uint64_t sim_uart_send(uint64_t bytes)
+{
+    uint64_t char_ns = (sim_params.uart_baud != 0U) ?
+                       (10U * 1000000000ULL / sim_params.uart_baud) : 0U;
+    uint64_t fifo_ns = sim_params.uart_fifo_size * char_ns;
+
+    sim_clock_add(sim_params.uart_dma_setup_ns);
+    if (sim_uart_idle_ns < sim_clock_ns)
+    {
+        sim_uart_idle_ns = sim_clock_ns;
+    }
+    sim_uart_idle_ns += bytes * char_ns;
+
+    if (sim_cur_phase != NULL)
+    {
+        sim_cur_phase->uart_bytes += bytes;
+    }
+    return (sim_uart_idle_ns > (sim_clock_ns + fifo_ns)) ? (sim_uart_idle_ns - fifo_ns) : sim_clock_ns;
+}
+
+/* Stops the UART once the character in its shifter is out and returns the
+ * characters it had not started.
+ */
+uint64_t sim_uart_stop(void)
+{
+    uint64_t char_ns = (sim_params.uart_baud != 0U) ?
+                       (10U * 1000000000ULL / sim_params.uart_baud) : 0U;
+    uint64_t left;
+    uint64_t unsent;
+
+    if ((sim_uart_idle_ns <= sim_clock_ns) || (char_ns == 0U))
+    {
+        return 0U;
+    }
+
+    left = sim_uart_idle_ns - sim_clock_ns;
+    unsent = left / char_ns;
+    sim_clock_add(left - unsent * char_ns);
+    sim_uart_idle_ns = sim_clock_ns;
+
+    return unsent;
+}
+
+/* Raises one interrupt at the given time; NULL cancels it. The device
+ * models only have one interrupt source.
+ */
+void sim_irq_at(uint64_t ns, void (*isr)(void))
+{
+    sim_irq_ns = ns;
+    sim_irq_isr = isr;
+}
+
+/* Critical sections of the bootloader; they nest. */
+void sim_irq_mask(bool masked)
+{
+    if (masked)
+    {
+        sim_irq_masked++;
+    }
+    else
+    {
+        sim_irq_masked--;
+        sim_irq_check();
+    }
+}
+
+void sim_report_reset(void)
+{
+    memset(&sim_report, 0, sizeof(sim_report));
+    sim_cur_phase = NULL;
+}
+
+/* Closes the current phase (if any) and opens a new one. */
+void sim_phase_begin(const char *name)
+{
+    sim_phase_end();
+
+    if (sim_report.phase_count < SIM_MAX_PHASES)
+    {
+        sim_cur_phase = &sim_report.phase[sim_report.phase_count++];
+        sim_cur_phase->name = name;
+        sim_cur_phase->start_ns = sim_clock_ns;
+    }
+}
+
+void sim_phase_end(void)
+{
+    if (sim_cur_phase != NULL)
+    {
+        sim_cur_phase->end_ns = sim_clock_ns;
+        sim_cur_phase = NULL;
+    }
+}
+
+static double sim_ms(uint64_t ns)
+{
+    return (double)ns / 1000000.0;
+}
+
+static void sim_phase_print(FILE *out, const sim_phase_t *p)
+{
+    fprintf(out, "%-16s %12.3f %12" PRIu64 " %12" PRIu64 " %8" PRIu64
+            " %12" PRIu64 " %12" PRIu64 " %8" PRIu64 " %12" PRIu64 " %8" PRIu64 "\n",
+            p->name, sim_ms(p->end_ns - p->start_ns),
+            p->dev[SIM_DEV_INTERNAL].bytes[SIM_OP_READ],
+            p->dev[SIM_DEV_INTERNAL].bytes[SIM_OP_PROGRAM],
+            p->dev[SIM_DEV_INTERNAL].ops[SIM_OP_ERASE],
+            p->dev[SIM_DEV_EXTERNAL].bytes[SIM_OP_READ],
+            p->dev[SIM_DEV_EXTERNAL].bytes[SIM_OP_PROGRAM],
+            p->dev[SIM_DEV_EXTERNAL].ops[SIM_OP_ERASE],
+            p->hash_bytes, p->uart_bytes);
+}
+
+/*******************************************************************************
+* Function Name: sim_report_print
+********************************************************************************
+* Summary:
+*  Prints the per-phase and per-area statistics of the last boot.
+*
+* Parameters:
+*  out        - Output stream.
+*  area_names - Printable name of each fa_id, NULL for unused ids.
+*
+*******************************************************************************/
+void sim_report_print(FILE *out, const char *const area_names[SIM_MAX_AREAS])
+{
+    sim_phase_t total;
+
+    memset(&total, 0, sizeof(total));
+    total.name = "total";
+
+    fprintf(out, "%-16s %12s %12s %12s %8s %12s %12s %8s %12s %8s\n",
+            "phase", "time [ms]", "int rd [B]", "int prg [B]", "int ers",
+            "ext rd [B]", "ext prg [B]", "ext ers", "hash [B]", "uart [B]");
+
+    for (uint32_t i = 0; i < sim_report.phase_count; i++)
+    {
+        const sim_phase_t *p = &sim_report.phase[i];
+
+        sim_phase_print(out, p);
+
+        if (i == 0)
+        {
+            total.start_ns = p->start_ns;
+        }
+        total.end_ns = p->end_ns;
+        for (uint32_t d = 0; d < SIM_DEV_COUNT; d++)
+        {
+            for (uint32_t op = 0; op < SIM_OP_COUNT; op++)
+            {
+                total.dev[d].ops[op] += p->dev[d].ops[op];
+                total.dev[d].bytes[op] += p->dev[d].bytes[op];
+            }
+        }
+        total.hash_bytes += p->hash_bytes;
+        total.uart_bytes += p->uart_bytes;
+    }
+    sim_phase_print(out, &total);
+
+    fprintf(out, "\n%-12s %-8s %10s %12s %12s\n", "area", "op", "calls", "bytes", "time [ms]");
+    for (uint32_t a = 0; a < SIM_MAX_AREAS; a++)
+    {
+        for (uint32_t op = 0; op < SIM_OP_COUNT; op++)
+        {
+            const sim_stats_t *s = &sim_report.area[a];
+
+            if ((area_names[a] != NULL) && (s->ops[op] != 0U))
+            {
+                fprintf(out, "%-12s %-8s %10" PRIu64 " %12" PRIu64 " %12.3f\n",
+                        area_names[a], sim_op_names[op], s->ops[op], s->bytes[op],
+                        sim_ms(s->time_ns[op]));
+            }
+        }
+    }
+}
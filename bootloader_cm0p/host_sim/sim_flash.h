@@ -0,0 +1,208 @@
+/******************************************************************************
+* File Name:   sim_flash.h
+*
+* Description:
+* This file declares the host (Linux) model of the internal flash and the
+* SMIF/QSPI NOR device used by the bootloader flash backend. Both devices are
+* backed by files mapped at their real addresses, and every access advances a
+* simulated clock according to a configurable latency model.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef SIM_FLASH_H_
+#define SIM_FLASH_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Real location of the PSoC 6 internal flash and of the SMIF XIP window. */
+#define SIM_INT_FLASH_BASE          (0x10000000UL)
+#define SIM_INT_FLASH_SIZE          (0x00200000UL)
+#define SIM_EXT_FLASH_BASE          (0x18000000UL)
+
+/* The work flash, part of the internal flash device, holds the scratch area. */
+#define SIM_WORK_FLASH_BASE         (0x14000000UL)
+#define SIM_WORK_FLASH_SIZE         (0x00008000UL)
+
+/* Upper bound for the fa_id values used by the flash map. */
+#define SIM_MAX_AREAS               (9U)
+
+/* Upper bound for the number of phases recorded during one boot. */
+#define SIM_MAX_PHASES              (16U)
+
+/*******************************************************************************
+* Data types
+********************************************************************************/
+/* Modeled flash devices. */
+typedef enum
+{
+    SIM_DEV_INTERNAL = 0,
+    SIM_DEV_EXTERNAL,
+    SIM_DEV_COUNT
+} sim_dev_t;
+
+/* Operation types accounted in the statistics. */
+typedef enum
+{
+    SIM_OP_READ = 0,
+    SIM_OP_PROGRAM,
+    SIM_OP_ERASE,
+    SIM_OP_COUNT
+} sim_op_t;
+
+/* Latency model. Per-operation costs are in nanoseconds, per-byte costs are
+ * in picoseconds so that transfer rates of tens of MB/s can be expressed.
+ */
+typedef struct
+{
+    uint64_t int_read_ps_per_byte;
+    uint64_t int_row_write_ns;
+    uint64_t int_row_program_ns;
+    uint64_t int_row_erase_ns;
+    uint64_t int_subsector_erase_ns;
+    uint64_t int_sector_erase_ns;
+    uint64_t int_poll_ns;
+
+    uint64_t ext_size;
+    uint64_t ext_cmd_ns;
+    uint64_t ext_read_ps_per_byte;
+    uint64_t ext_write_ps_per_byte;
+    uint64_t ext_page_size;
+    uint64_t ext_page_program_ns;
+    uint64_t ext_sector_size;
+    uint64_t ext_sector_erase_ns;
+    uint64_t ext_erase_4k_ns;
+    uint64_t ext_erase_32k_ns;
+    uint64_t ext_param_size;
+    uint64_t ext_param_top;
+    uint64_t ext_chip_erase_ns;
+    uint64_t ext_sfdp_init_ns;
+    uint64_t ext_smif_init_ns;
+    uint64_t ext_jedec_id;
+    uint64_t ext_xip_ps_per_byte;
+    uint64_t ext_xip_switch_ns;
+    uint64_t ext_dma_setup_ns;
+    uint64_t ext_cont_read;
+    uint64_t ext_xip_cmd_ps_per_byte;
+
+    uint64_t hash_ps_per_byte;
+    uint64_t lz4_ps_per_byte;
+    uint64_t uart_baud;
+    uint64_t uart_fifo_size;
+    uint64_t uart_dma_setup_ns;
+    uint64_t uart_poll_ns;
+    uint64_t irq_ns;
+} sim_params_t;
+
+/* Access counters of one device or one flash area. */
+typedef struct
+{
+    uint64_t ops[SIM_OP_COUNT];
+    uint64_t bytes[SIM_OP_COUNT];
+    uint64_t time_ns[SIM_OP_COUNT];
+} sim_stats_t;
+
+/* One boot phase. */
+typedef struct
+{
+    const char *name;
+    uint64_t start_ns;
+    uint64_t end_ns;
+    sim_stats_t dev[SIM_DEV_COUNT];
+    uint64_t hash_bytes;
+    uint64_t uart_bytes;
+} sim_phase_t;
+
+/* Everything recorded during one simulated boot. */
+typedef struct
+{
+    uint32_t phase_count;
+    sim_phase_t phase[SIM_MAX_PHASES];
+    sim_stats_t area[SIM_MAX_AREAS];
+    sim_stats_t dev[SIM_DEV_COUNT];     /* Whole boot, in or out of a phase */
+} sim_report_t;
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+extern sim_params_t sim_params;
+extern sim_report_t sim_report;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+int sim_flash_init(const char *state_dir, bool reset);
+void sim_flash_deinit(void);
+int sim_param_set(const char *name, const char *value);
+void sim_param_list(void);
+
+uint8_t *sim_flash_ptr(sim_dev_t dev, uint32_t addr, uint32_t len);
+uint8_t sim_flash_erased_val(sim_dev_t dev);
+int sim_flash_load(uint32_t addr, const char *file);
+int sim_flash_poke(uint32_t addr, const void *src, uint32_t len);
+void *sim_flash_save(void);
+void sim_flash_restore(const void *state);
+
+uint64_t sim_now_ns(void);
+void sim_advance_ns(uint64_t ns);
+void sim_power_cut_at(uint64_t ns);
+void sim_power_cut_after(uint64_t ops);
+void sim_account(sim_dev_t dev, sim_op_t op, uint64_t bytes, uint64_t ns);
+void sim_account_wait(sim_dev_t dev, sim_op_t op, uint64_t ns);
+void sim_account_area(uint8_t fa_id, sim_op_t op, uint64_t bytes, uint64_t ns);
+void sim_account_hash(uint64_t bytes);
+void sim_account_lz4(uint64_t bytes);
+void sim_account_uart(uint64_t bytes);
+void sim_uart_flush(uint64_t timeout_ns);
+uint64_t sim_uart_send(uint64_t bytes);
+uint64_t sim_uart_stop(void);
+void sim_irq_at(uint64_t ns, void (*isr)(void));
+void sim_irq_mask(bool masked);
+
+void sim_report_reset(void);
+void sim_phase_begin(const char *name);
+void sim_phase_end(void);
+void sim_report_print(FILE *out, const char *const area_names[SIM_MAX_AREAS]);
+
+/* Implemented by the simulator front end (sim_main.c). */
+extern bool sim_verbose;
+void sim_boot_exit(uint32_t app_addr) __attribute__((noreturn));
+void sim_power_lost(void) __attribute__((noreturn));
+void sim_system_reset(void) __attribute__((noreturn));
+
+#endif /* SIM_FLASH_H_ */
@@ -0,0 +1,1096 @@
+/******************************************************************************
+* File Name:   sim_main.c
+*
+* Description:
+* This file is the front end of the host flash simulator. It installs images
+* into the simulated devices, runs the unmodified bootloader main() for a
+* number of resets and reports the simulated boot time, the bytes moved and
+* the erase counts of every boot phase and flash area.
+*
+* Every reset runs in a forked child process so that the bootloader RAM
+* starts from its initial state, while the flash devices (shared file
+* mappings) keep their contents across resets.
+*
+* With --fault-sweep, the front end instead runs the first boot once per
+* power cut point, after each program or erase operation of an uninterrupted
+* run, and checks that the bootloader then recovers to a valid image.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "flash_map_backend/flash_map_backend.h"
+#include "sysflash.h"
+#include "bootutil/image.h"
+#include "mbedtls/sha256.h"
+#include "ext_flash_map.h"
+#include "ext_flash_cache.h"
+#include "ext_flash_sfdp_cache.h"
+#include "upgrade_journal.h"
+#include "upgrade_patch.h"
+#include "upgrade_compress.h"
+#include "upgrade_concurrent.h"
+#include "upgrade_lz4.h"
+#include "upgrade_slot_flip.h"
+#include "boot_handoff.h"
+#include "boot_log.h"
+#include "boot_validate.h"
+#include "cy_pdl.h"
+
+#include "sim_flash.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define SIM_DEFAULT_STATE_DIR       "sim_state"
+#define SIM_MAX_LOADS               (8U)
+
+/* MCUboot trailer magic, found in the last 16 bytes of a pending slot. */
+#define SIM_BOOT_MAGIC_SZ           (16U)
+
+/* Resets allowed after a cut for the bootloader to start CM4 again. */
+#define SIM_FAULT_MAX_BOOTS         (4U)
+
+/* Primary slots compared after each recovery. */
+#define SIM_FAULT_SLOTS             (2U)
+
+/*******************************************************************************
+* Data types
+********************************************************************************/
+typedef struct
+{
+    const char *name;
+    uint8_t fa_id;
+} sim_area_name_t;
+
+typedef struct
+{
+    uint8_t fa_id;
+    const char *file;
+} sim_load_t;
+
+/* Outcome of one boot, written by the child process. */
+typedef struct
+{
+    bool booted;
+    bool power_lost;
+    bool reset;                 /* The bootloader reset the device */
+    uint32_t app_addr;
+    uint64_t time_ns;
+    uint64_t write_ops;         /* Program and erase operations */
+    uint64_t program_bytes;
+    uint64_t erase_bytes;
+} sim_boot_result_t;
+
+/* Image (header and body) of a primary slot before and after the upgrade. */
+typedef struct
+{
+    uint8_t fa_id;
+    uint32_t old_len;
+    uint32_t new_len;
+    uint8_t *old_image;
+    uint8_t *new_image;
+} sim_fault_slot_t;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+/* main() of the bootloader, renamed at compile time. */
+int sim_bootloader_main(void);
+
+int __real_flash_area_read(const struct flash_area *fa, uint32_t off, void *dst, uint32_t len);
+int __real_flash_area_write(const struct flash_area *fa, uint32_t off, const void *src, uint32_t len);
+int __real_flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t len);
+int __real_flash_area_erase_start(const struct flash_area *fa, uint32_t off, uint32_t len);
+int __real_flash_area_read_is_empty(const struct flash_area *fa, uint32_t off, void *dst, uint32_t len);
+int __real_mbedtls_sha256_update_ret(mbedtls_sha256_context *ctx, const unsigned char *input, size_t ilen);
+int __real_upgrade_lz4_expand(const struct flash_area *src, uint32_t off, uint32_t len,
+                              const struct flash_area *dst, uint32_t size);
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+bool sim_verbose;
+
+static const sim_area_name_t sim_area_names[] =
+{
+    { "bootloader",  FLASH_AREA_BOOTLOADER },
+    { "primary_1",   FLASH_AREA_IMAGE_PRIMARY(0) },
+    { "secondary_1", FLASH_AREA_IMAGE_SECONDARY(0) },
+    { "primary_2",   FLASH_AREA_IMAGE_2 },
+    { "secondary_2", FLASH_AREA_IMAGE_3 },
+    { "scratch",     FLASH_AREA_IMAGE_SCRATCH },
+    { "validation",  FLASH_AREA_VALIDATION },
+    { "sfdp_cache",  FLASH_AREA_SFDP_CACHE },
+};
+
+static const uint32_t sim_boot_magic[SIM_BOOT_MAGIC_SZ / 4U] =
+{
+    0xf395c277, 0x7fefd260, 0x0f505235, 0x8079b62c
+};
+
+static jmp_buf sim_boot_jmp;
+static sim_boot_result_t *sim_result;
+
+/* Destination of the LZ4 decode in progress, see __wrap_upgrade_lz4_expand(). */
+static const struct flash_area *sim_lz4_dst;
+
+/*******************************************************************************
+* Bootloader hooks
+********************************************************************************/
+/* Called when the bootloader starts CM4 (app_addr != 0) or gives up. */
+void sim_boot_exit(uint32_t app_addr)
+{
+    sim_phase_end();
+    sim_result->booted = (app_addr != 0U);
+    sim_result->app_addr = app_addr;
+    sim_result->time_ns = sim_now_ns();
+    longjmp(sim_boot_jmp, 1);
+}
+
+/* Called by the clock model when the power cut set with --cut is reached. */
+void sim_power_lost(void)
+{
+    sim_phase_end();
+    /* The backup domain is supplied from the same rail in this model. */
+    memset((void *)sim_backup, 0, sizeof(*sim_backup));
+    sim_result->power_lost = true;
+    sim_result->time_ns = sim_now_ns();
+    longjmp(sim_boot_jmp, 1);
+}
+
+/* Called when the bootloader resets the device. The backup domain keeps its
+ * registers.
+ */
+void sim_system_reset(void)
+{
+    sim_phase_end();
+    sim_result->reset = true;
+    sim_result->time_ns = sim_now_ns();
+    longjmp(sim_boot_jmp, 1);
+}
+
+/* Bootloader logging goes to the UART model; the text is only shown with
+ * --verbose.
+ */
+int sim_log_fprintf(FILE *stream, const char *fmt, ...)
+{
+    va_list ap;
+    int len;
+
+    va_start(ap, fmt);
+    len = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+
+    if (len > 0)
+    {
+        sim_account_uart((uint64_t)len);
+    }
+
+    if (sim_verbose)
+    {
+        va_start(ap, fmt);
+        vfprintf(stream, fmt, ap);
+        va_end(ap);
+    }
+    return len;
+}
+
+static sim_dev_t sim_area_dev(const struct flash_area *fa)
+{
+    return (fa->fa_device_id == FLASH_DEVICE_INTERNAL_FLASH) ? SIM_DEV_INTERNAL : SIM_DEV_EXTERNAL;
+}
+
+/* The backend reads the internal flash with memcpy(); account for it here. */
+static void sim_account_int_read(const struct flash_area *fa, uint32_t len)
+{
+    if (sim_area_dev(fa) == SIM_DEV_INTERNAL)
+    {
+        sim_account(SIM_DEV_INTERNAL, SIM_OP_READ, len,
+                    len * sim_params.int_read_ps_per_byte / 1000U);
+    }
+}
+
+int __wrap_flash_area_read(const struct flash_area *fa, uint32_t off, void *dst, uint32_t len)
+{
+    uint64_t start = sim_now_ns();
+    int rc;
+
+    sim_account_int_read(fa, len);
+    rc = __real_flash_area_read(fa, off, dst, len);
+    sim_account_area(fa->fa_id, SIM_OP_READ, len, sim_now_ns() - start);
+    return rc;
+}
+
+int __wrap_flash_area_read_is_empty(const struct flash_area *fa, uint32_t off, void *dst, uint32_t len)
+{
+    uint64_t start = sim_now_ns();
+    int rc;
+
+    sim_account_int_read(fa, len);
+    rc = __real_flash_area_read_is_empty(fa, off, dst, len);
+    sim_account_area(fa->fa_id, SIM_OP_READ, len, sim_now_ns() - start);
+    return rc;
+}
+
+int __wrap_flash_area_write(const struct flash_area *fa, uint32_t off, const void *src, uint32_t len)
+{
+    uint64_t start;
+    int rc;
+
+    if (fa == sim_lz4_dst)
+    {
+        sim_account_lz4(len);
+    }
+    start = sim_now_ns();
+    rc = __real_flash_area_write(fa, off, src, len);
+
+    sim_account_area(fa->fa_id, SIM_OP_PROGRAM, len, sim_now_ns() - start);
+    return rc;
+}
+
+int __wrap_flash_area_erase(const struct flash_area *fa, uint32_t off, uint32_t len)
+{
+    uint64_t start = sim_now_ns();
+    int rc = __real_flash_area_erase(fa, off, len);
+
+    sim_account_area(fa->fa_id, SIM_OP_ERASE, len, sim_now_ns() - start);
+    return rc;
+}
+
+/* Only the time to start the erase; waiting for it counts where it happens. */
+int __wrap_flash_area_erase_start(const struct flash_area *fa, uint32_t off, uint32_t len)
+{
+    uint64_t start = sim_now_ns();
+    int rc = __real_flash_area_erase_start(fa, off, len);
+
+    sim_account_area(fa->fa_id, SIM_OP_ERASE, len, sim_now_ns() - start);
+    return rc;
+}
+
+int __wrap_mbedtls_sha256_update_ret(mbedtls_sha256_context *ctx, const unsigned char *input, size_t ilen)
+{
+    sim_account_hash(ilen);
+    return __real_mbedtls_sha256_update_ret(ctx, input, ilen);
+}
+
+/* The host decodes far faster than the CM0+. The modelled CPU time of each
+ * chunk is charged before it is written, so that it overlaps the program of
+ * the previous internal flash row as it would on the device.
+ */
+int __wrap_upgrade_lz4_expand(const struct flash_area *src, uint32_t off, uint32_t len,
+                              const struct flash_area *dst, uint32_t size)
+{
+    int rc;
+
+    sim_lz4_dst = dst;
+    rc = __real_upgrade_lz4_expand(src, off, len, dst, size);
+    sim_lz4_dst = NULL;
+    return rc;
+}
+
+/*******************************************************************************
+* Front end
+********************************************************************************/
+static void sim_usage(const char *prog)
+{
+    printf("Usage: %s [options]\n"
+           "  -s, --state DIR         device state directory (default: " SIM_DEFAULT_STATE_DIR ")\n"
+           "  -r, --reset             start from factory-erased devices\n"
+           "  -l, --load AREA=FILE    copy FILE to the start of AREA before the first boot\n"
+           "  -p, --pending AREA      mark the image in AREA as pending (writes the trailer magic)\n"
+           "  -e, --expect AREA=FILE  fail unless AREA starts with FILE after the last boot\n"
+           "  -c, --cut MS            cut the power MS simulated milliseconds into the first boot\n"
+           "  -F, --fault-sweep STEP  cut the first boot after every STEP-th program or erase\n"
+           "                          operation, and check and time the recovery of each cut\n"
+           "  -n, --boots N           number of resets to simulate (default: 1)\n"
+           "  -P, --param NAME=VALUE  override a latency model parameter\n"
+           "  -L, --list-params       list the latency model parameters\n"
+           "  -v, --verbose           echo the bootloader log\n"
+           "AREA is one of: bootloader, primary_1, secondary_1, primary_2, secondary_2.\n",
+           prog);
+}
+
+static int sim_area_lookup(const char *name, const struct flash_area **fa)
+{
+    for (size_t i = 0; i < sizeof(sim_area_names) / sizeof(sim_area_names[0]); i++)
+    {
+        if (strcmp(sim_area_names[i].name, name) == 0)
+        {
+            return flash_area_open(sim_area_names[i].fa_id, fa);
+        }
+    }
+    fprintf(stderr, "sim: unknown flash area '%s'\n", name);
+    return -1;
+}
+
+static int sim_set_pending(const char *name)
+{
+    const struct flash_area *fa;
+
+    if (sim_area_lookup(name, &fa) != 0)
+    {
+        return -1;
+    }
+    return sim_flash_poke(fa->fa_off + fa->fa_size - SIM_BOOT_MAGIC_SZ,
+                          sim_boot_magic, SIM_BOOT_MAGIC_SZ);
+}
+
+static int sim_load(char *arg)
+{
+    const struct flash_area *fa;
+    char *file = strchr(arg, '=');
+
+    if (file == NULL)
+    {
+        fprintf(stderr, "sim: --load expects AREA=FILE\n");
+        return -1;
+    }
+    *file++ = '\0';
+
+    if (sim_area_lookup(arg, &fa) != 0)
+    {
+        return -1;
+    }
+    return sim_flash_load(fa->fa_off, file);
+}
+
+/* Checks that an area starts with the contents of a file, such as the
+ * image an upgrade should have installed.
+ */
+static int sim_expect(char *arg)
+{
+    const struct flash_area *fa;
+    const uint8_t *data;
+    char *file = strchr(arg, '=');
+    FILE *f;
+    uint8_t buf[4096];
+    uint32_t off = 0;
+    size_t len;
+    int rc = 0;
+
+    if (file == NULL)
+    {
+        fprintf(stderr, "sim: --expect expects AREA=FILE\n");
+        return -1;
+    }
+    *file++ = '\0';
+
+    if (sim_area_lookup(arg, &fa) != 0)
+    {
+        return -1;
+    }
+    f = fopen(file, "rb");
+    if (f == NULL)
+    {
+        fprintf(stderr, "sim: cannot open %s\n", file);
+        return -1;
+    }
+
+    while ((rc == 0) && ((len = fread(buf, 1, sizeof(buf), f)) != 0U))
+    {
+        data = sim_flash_ptr(sim_area_dev(fa), fa->fa_off + off, (uint32_t)len);
+        if ((off + len > fa->fa_size) || (data == NULL))
+        {
+            fprintf(stderr, "sim: %s does not fit in %s\n", file, arg);
+            rc = -1;
+        }
+        else if (memcmp(data, buf, len) != 0)
+        {
+            printf("Expected %s in %s: differs from offset 0x%" PRIx32 "\n", file, arg, off);
+            rc = -1;
+        }
+        off += (uint32_t)len;
+    }
+    fclose(f);
+
+    if (rc == 0)
+    {
+        printf("Expected %s in %s: found\n", file, arg);
+    }
+    return rc;
+}
+
+/* Erase granules the backend erased or found blank during the boot. */
+static void sim_print_erase_stats(void)
+{
+    const flash_erase_stats_t *dev[] =
+    {
+        flash_area_get_erase_stats(FLASH_DEVICE_INTERNAL_FLASH),
+        flash_area_get_erase_stats(FLASH_DEVICE_EXTERNAL_FLASH(0)),
+    };
+    const char *dev_names[] = { "internal", "external" };
+
+    for (size_t i = 0; i < sizeof(dev) / sizeof(dev[0]); i++)
+    {
+        if ((dev[i]->erased + dev[i]->skipped) != 0U)
+        {
+            printf("%-12s erased %" PRIu32 " granules, skipped %" PRIu32
+                   " blank granules (%" PRIu32 " bytes)\n", dev_names[i],
+                   dev[i]->erased, dev[i]->skipped, dev[i]->skipped_bytes);
+        }
+    }
+}
+
+/* External read cache activity during the boot. */
+static void sim_print_cache_stats(void)
+{
+    const ext_flash_cache_stats_t *stats = ext_flash_cache_get_stats();
+
+    printf("%-12s read cache %" PRIu32 " hits, %" PRIu32 " misses, %" PRIu32 " bypassed"
+           " (%" PRIu32 " XIP, %" PRIu32 " streamed)\n", "external", stats->hits,
+           stats->misses, stats->bypassed, stats->xip, stats->streamed);
+}
+
+/* Upgrade progress recorded, and copy work skipped after an interruption. */
+static void sim_print_journal_stats(void)
+{
+    const upgrade_journal_stats_t *stats = upgrade_journal_get_stats();
+
+    if ((stats->records + stats->kept_bytes + stats->elided_bytes) != 0U)
+    {
+        printf("%-12s upgrade journal %" PRIu32 " records, %" PRIu32 " bytes kept, %" PRIu32
+               " bytes not rewritten\n", "scratch", stats->records, stats->kept_bytes,
+               stats->elided_bytes);
+    }
+}
+
+/* Images rebuilt from patches during the boot. */
+static void sim_print_patch_stats(void)
+{
+    const upgrade_patch_stats_t *stats = upgrade_patch_get_stats();
+
+    if ((stats->applied + stats->failed) != 0U)
+    {
+        printf("%-12s patch %" PRIu32 " applied, %" PRIu32 " failed, %" PRIu32 " patch bytes, %"
+               PRIu32 " bytes copied, %" PRIu32 " bytes inserted\n", "secondary", stats->applied,
+               stats->failed, stats->patch_bytes, stats->copied_bytes, stats->inserted_bytes);
+    }
+}
+
+/* Compressed images expanded during the boot. */
+static void sim_print_compress_stats(void)
+{
+    const upgrade_compress_stats_t *stats = upgrade_compress_get_stats();
+
+    if ((stats->expanded + stats->failed) != 0U)
+    {
+        printf("%-12s compressed %" PRIu32 " expanded, %" PRIu32 " failed, %" PRIu32
+               " bytes expanded from %" PRIu32 "\n", "secondary", stats->expanded,
+               stats->failed, stats->expanded_bytes, stats->compressed_bytes);
+    }
+}
+
+/* Images installed by the concurrent upgrade during the boot. */
+static void sim_print_concurrent_stats(void)
+{
+    const upgrade_concurrent_stats_t *stats = upgrade_concurrent_get_stats();
+
+    if ((stats->installed + stats->failed) != 0U)
+    {
+        printf("%-12s concurrent %" PRIu32 " installed, %" PRIu32 " failed, %" PRIu32
+               " bytes copied\n", "primary", stats->installed, stats->failed,
+               stats->copied_bytes);
+    }
+}
+
+/* Image 2 slot handed to the CM4 application in slot flip mode. */
+static void sim_print_slot_flip_stats(void)
+{
+    const upgrade_slot_flip_stats_t *stats = upgrade_slot_flip_get_stats();
+
+    if (boot_handoff.wifi_slot_addr != 0U)
+    {
+        printf("%-12s slot flip: CM4 runs 0x%08" PRIx32 " (%s), version %u.%u.%u+%" PRIu32
+               ", %" PRIu32 " rejected\n", "image 2", boot_handoff.wifi_slot_addr,
+               (boot_handoff.wifi_slot_addr == (CY_FLASH_DEVICE_BASE + CY_BOOT_PRIMARY_2_START)) ?
+               "primary_2" : "secondary_2", stats->ver.iv_major, stats->ver.iv_minor,
+               stats->ver.iv_revision, stats->ver.iv_build_num, stats->rejected);
+    }
+    else if (stats->rejected != 0U)
+    {
+        printf("%-12s slot flip: no valid slot, %" PRIu32 " rejected\n", "image 2",
+               stats->rejected);
+    }
+}
+
+/* Primary slot validation done during the boot. */
+static void sim_print_validate_stats(void)
+{
+    const boot_validate_stats_t *stats = boot_validate_get_stats();
+
+    if ((stats->full + stats->cached + stats->failed) != 0U)
+    {
+        printf("%-12s validated %" PRIu32 " in full, %" PRIu32 " from records (%" PRIu32
+               " bytes sampled), %" PRIu32 " failed, %" PRIu32 " records written\n", "slots",
+               stats->full, stats->cached, stats->sampled_bytes, stats->failed, stats->records);
+    }
+}
+
+/* How the external memory was set up. */
+static void sim_print_sfdp_cache_stats(void)
+{
+    const ext_flash_sfdp_cache_stats_t *stats = ext_flash_sfdp_cache_get_stats();
+
+    printf("%-12s %s, JEDEC ID %02x%02x%02x, %" PRIu32 " stale, %" PRIu32
+           " records written\n", "sfdp", (stats->cached != 0U) ? "from record" : "detected",
+           stats->id[0], stats->id[1], stats->id[2], stats->stale, stats->records);
+}
+
+/* Log output of the boot. With --verbose, also shows what was handed to
+ * CM4 right after the rest, as the application prints it.
+ */
+static void sim_print_log_stats(void)
+{
+    const boot_log_stats_t *stats = boot_log_get_stats();
+
+    if (stats->written == 0U)
+    {
+        return;
+    }
+    printf("%-12s %" PRIu32 " bytes, %" PRIu32 " sent, %" PRIu32 " handed to CM4, %" PRIu32
+           " dropped, %" PRIu32 " waits for room\n", "log", stats->written, stats->sent,
+           stats->handed, stats->dropped, stats->full_waits);
+    if (sim_verbose && (boot_handoff.log_len != 0U))
+    {
+        (void)fwrite(boot_handoff.log, 1U, boot_handoff.log_len, stderr);
+    }
+}
+
+/* Boot phase times handed to the CM4 application, as the bootloader
+ * measured them with SysTick. Phases that took no time are left out.
+ */
+static void sim_print_boot_timing(void)
+{
+    static const char *const names[] =
+    {
+        [BOOT_PHASE_HW_INIT] = "hw_init",       [BOOT_PHASE_SMIF_INIT] = "smif_init",
+        [BOOT_PHASE_PATCH] = "patch",           [BOOT_PHASE_COMPRESS] = "compress",
+        [BOOT_PHASE_CONCURRENT] = "concurrent", [BOOT_PHASE_SLOT_FLIP] = "slot_flip",
+        [BOOT_PHASE_BOOT_GO] = "boot_go",       [BOOT_PHASE_VALIDATE] = "validate",
+        [BOOT_PHASE_UART_FLUSH] = "uart_flush", [BOOT_PHASE_HEADER] = "header",
+        [BOOT_PHASE_IMAGE_CHECK] = "image_check", [BOOT_PHASE_COPY] = "copy",
+        [BOOT_PHASE_FAST_CHECK] = "fast_check",
+    };
+    double tick_ms = 1000.0 / (double)boot_handoff.timer_hz;
+
+    if ((boot_handoff.timer_hz == 0U) || (boot_handoff.boot_ticks == 0U))
+    {
+        return;
+    }
+
+    printf("%-12s %.3f ms to CM4, %" PRIu16 " phases dropped\n", "timing",
+           boot_handoff.boot_ticks * tick_ms, boot_handoff.phase_dropped);
+    for (uint32_t i = 0; i < boot_handoff.phase_count; i++)
+    {
+        const boot_phase_t *entry = &boot_handoff.phases[i];
+
+        if (entry->ticks == 0U)
+        {
+            continue;
+        }
+        printf("%-12s %-12s", "", names[entry->phase]);
+        if (entry->image != BOOT_PHASE_NO_IMAGE)
+        {
+            printf(" image %u", entry->image + 1U);
+        }
+        printf(" at %.3f ms: %.3f ms, %" PRIu16 " calls\n", entry->start * tick_ms,
+               entry->ticks * tick_ms, entry->count);
+    }
+}
+
+/* Program and erase work of the boot, for the fault sweep. */
+static void sim_boot_totals(void)
+{
+    for (uint32_t d = 0; d < SIM_DEV_COUNT; d++)
+    {
+        sim_result->write_ops += sim_report.dev[d].ops[SIM_OP_PROGRAM] +
+                                 sim_report.dev[d].ops[SIM_OP_ERASE];
+        sim_result->program_bytes += sim_report.dev[d].bytes[SIM_OP_PROGRAM];
+        sim_result->erase_bytes += sim_report.dev[d].bytes[SIM_OP_ERASE];
+    }
+}
+
+/* Runs one reset in a child process and, with `report`, prints its report.
+ * The power is cut after `cut_ns` or after `cut_ops` program and erase
+ * operations, if not 0. The outcome is left in *sim_result.
+ */
+static int sim_boot(uint32_t boot, uint64_t cut_ns, uint64_t cut_ops, bool report)
+{
+    const char *names[SIM_MAX_AREAS] = { NULL };
+    pid_t pid;
+    int status;
+
+    for (size_t i = 0; i < sizeof(sim_area_names) / sizeof(sim_area_names[0]); i++)
+    {
+        names[sim_area_names[i].fa_id] = sim_area_names[i].name;
+    }
+
+    memset(sim_result, 0, sizeof(*sim_result));
+    fflush(stdout);
+
+    pid = fork();
+    if (pid < 0)
+    {
+        perror("sim: fork");
+        return -1;
+    }
+
+    if (pid == 0)
+    {
+        sim_report_reset();
+        sim_power_cut_at(cut_ns);
+        sim_power_cut_after(cut_ops);
+        sim_phase_begin("hw_init");
+        if (setjmp(sim_boot_jmp) == 0)
+        {
+            (void)sim_bootloader_main();
+            sim_boot_exit(0U);
+        }
+
+        sim_boot_totals();
+        if (!report)
+        {
+            _exit(0);
+        }
+
+        printf("Boot %" PRIu32 ": ", boot);
+        if (sim_result->power_lost)
+        {
+            printf("power lost");
+        }
+        else if (sim_result->reset)
+        {
+            printf("reset by the bootloader");
+        }
+        else if (sim_result->booted)
+        {
+            printf("started CM4 at 0x%08" PRIx32, sim_result->app_addr);
+        }
+        else
+        {
+            printf("no bootable image");
+        }
+        printf(" after %.3f ms\n", (double)sim_result->time_ns / 1000000.0);
+        sim_report_print(stdout, names);
+        sim_print_sfdp_cache_stats();
+        sim_print_erase_stats();
+        sim_print_cache_stats();
+        sim_print_journal_stats();
+        sim_print_patch_stats();
+        sim_print_compress_stats();
+        sim_print_concurrent_stats();
+        sim_print_slot_flip_stats();
+        sim_print_validate_stats();
+        sim_print_log_stats();
+        sim_print_boot_timing();
+        printf("\n");
+        fflush(stdout);
+        _exit(0);
+    }
+
+    if ((waitpid(pid, &status, 0) != pid) || !WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+    {
+        if (report)
+        {
+            printf("Boot %" PRIu32 ": bootloader crashed\n", boot);
+        }
+        return -1;
+    }
+    return 0;
+}
+
+/* Returns the header and body of the image in a slot, and its length in
+ * *len, 0 if the slot holds no image.
+ */
+static const uint8_t *sim_slot_image(uint8_t fa_id, uint32_t *len)
+{
+    const struct flash_area *fa;
+    const struct image_header *hdr;
+    const uint8_t *image;
+
+    *len = 0U;
+    if (flash_area_open(fa_id, &fa) != 0)
+    {
+        return NULL;
+    }
+
+    image = sim_flash_ptr(sim_area_dev(fa), fa->fa_off, fa->fa_size);
+    hdr = (const struct image_header *)image;
+    if ((image != NULL) && (hdr->ih_magic == IMAGE_MAGIC) &&
+        ((uint32_t)hdr->ih_hdr_size + hdr->ih_img_size <= fa->fa_size))
+    {
+        *len = (uint32_t)hdr->ih_hdr_size + hdr->ih_img_size;
+    }
+    return image;
+}
+
+static uint8_t *sim_slot_copy(uint8_t fa_id, uint32_t *len)
+{
+    const uint8_t *image = sim_slot_image(fa_id, len);
+    uint8_t *copy = malloc((*len != 0U) ? *len : 1U);
+
+    if ((copy != NULL) && (*len != 0U))
+    {
+        memcpy(copy, image, *len);
+    }
+    return copy;
+}
+
+/* Which image a primary slot holds after a recovery: 'n'ew, 'o'ld, or
+ * neither ('X'). A slot that the upgrade does not change counts as new.
+ */
+static char sim_slot_check(const sim_fault_slot_t *slot)
+{
+    uint32_t len;
+    const uint8_t *image = sim_slot_image(slot->fa_id, &len);
+
+    if ((len == slot->new_len) && ((len == 0U) || (memcmp(image, slot->new_image, len) == 0)))
+    {
+        return 'n';
+    }
+    if ((len == slot->old_len) && ((len == 0U) || (memcmp(image, slot->old_image, len) == 0)))
+    {
+        return 'o';
+    }
+    return 'X';
+}
+
+/*******************************************************************************
+* Function Name: sim_fault_sweep
+********************************************************************************
+* Summary:
+*  Runs the first boot without a cut to count its program and erase
+*  operations, then once per cut point: the devices are put back in their
+*  initial state, the power is cut right after the operation, and the
+*  following boots must start CM4 from the same address with each primary
+*  slot holding either its old or its new image. For every cut point it
+*  prints the time the bootloader took to start CM4 after the power came
+*  back, and the bytes programmed and erased on top of the uninterrupted
+*  run; then the worst of them.
+*
+* Parameters:
+*  step - Cut after every step-th operation.
+*
+* Return:
+*  0 if every cut recovered, -1 otherwise.
+*
+*******************************************************************************/
+static int sim_fault_sweep(uint64_t step)
+{
+    sim_fault_slot_t slots[SIM_FAULT_SLOTS] =
+    {
+        { .fa_id = FLASH_AREA_IMAGE_PRIMARY(0) },
+        { .fa_id = FLASH_AREA_IMAGE_2 },
+    };
+    sim_boot_result_t ref;
+    void *state;
+    uint64_t worst_ns = 0;
+    uint64_t worst_ns_at = 0;
+    int64_t worst_bytes = 0;
+    uint64_t worst_bytes_at = 0;
+    uint32_t cuts = 0;
+    uint32_t failures = 0;
+
+    state = sim_flash_save();
+    for (uint32_t i = 0; i < SIM_FAULT_SLOTS; i++)
+    {
+        slots[i].old_image = sim_slot_copy(slots[i].fa_id, &slots[i].old_len);
+    }
+
+    memset((void *)sim_backup, 0, sizeof(*sim_backup));
+    if ((state == NULL) || (sim_boot(1U, 0U, 0U, sim_verbose) != 0) || !sim_result->booted)
+    {
+        fprintf(stderr, "sim: the boot without a power cut did not start CM4\n");
+        free(state);
+        return -1;
+    }
+    ref = *sim_result;
+    for (uint32_t i = 0; i < SIM_FAULT_SLOTS; i++)
+    {
+        slots[i].new_image = sim_slot_copy(slots[i].fa_id, &slots[i].new_len);
+    }
+
+    printf("Without a cut: started CM4 at 0x%08" PRIx32 " after %.3f ms, %" PRIu64
+           " program and erase operations, %" PRIu64 " bytes programmed, %" PRIu64
+           " bytes erased\n\n", ref.app_addr, (double)ref.time_ns / 1000000.0,
+           ref.write_ops, ref.program_bytes, ref.erase_bytes);
+    printf("%10s %12s %6s %14s %14s %14s  %s\n", "cut after", "cut at [ms]", "boots",
+           "recovery [ms]", "extra prg [B]", "extra ers [B]", "primary");
+
+    for (uint64_t ops = step; ops <= ref.write_ops; ops += step)
+    {
+        uint64_t cut_ns;
+        uint64_t recovery_ns = 0;
+        int64_t extra_program;
+        int64_t extra_erase;
+        uint64_t program = 0;
+        uint64_t erase = 0;
+        uint32_t boots = 0;
+        bool ok = false;
+        char result[SIM_FAULT_SLOTS * 2U];
+
+        sim_flash_restore(state);
+        memset((void *)sim_backup, 0, sizeof(*sim_backup));
+
+        if ((sim_boot(1U, 0U, ops, sim_verbose) != 0) || !sim_result->power_lost)
+        {
+            printf("%10" PRIu64 " cut missed, the boot did not repeat the run without a cut\n",
+                   ops);
+            failures++;
+            continue;
+        }
+        cut_ns = sim_result->time_ns;
+        program = sim_result->program_bytes;
+        erase = sim_result->erase_bytes;
+
+        while ((boots < SIM_FAULT_MAX_BOOTS) && !ok)
+        {
+            boots++;
+            if (sim_boot(boots + 1U, 0U, 0U, sim_verbose) != 0)
+            {
+                break;
+            }
+            recovery_ns += sim_result->time_ns;
+            program += sim_result->program_bytes;
+            erase += sim_result->erase_bytes;
+            ok = sim_result->booted && (sim_result->app_addr == ref.app_addr);
+        }
+
+        for (uint32_t i = 0; i < SIM_FAULT_SLOTS; i++)
+        {
+            result[2U * i] = sim_slot_check(&slots[i]);
+            result[2U * i + 1U] = (i + 1U < SIM_FAULT_SLOTS) ? '/' : '\0';
+            ok = ok && (result[2U * i] != 'X');
+        }
+        extra_program = (int64_t)program - (int64_t)ref.program_bytes;
+        extra_erase = (int64_t)erase - (int64_t)ref.erase_bytes;
+
+        printf("%10" PRIu64 " %12.3f %6" PRIu32 " %14.3f %14" PRId64 " %14" PRId64 "  %s%s\n",
+               ops, (double)cut_ns / 1000000.0, boots, (double)recovery_ns / 1000000.0,
+               extra_program, extra_erase, result, ok ? "" : "  FAILED");
+
+        cuts++;
+        if (!ok)
+        {
+            failures++;
+        }
+        if (recovery_ns > worst_ns)
+        {
+            worst_ns = recovery_ns;
+            worst_ns_at = ops;
+        }
+        if (extra_program > worst_bytes)
+        {
+            worst_bytes = extra_program;
+            worst_bytes_at = ops;
+        }
+    }
+
+    printf("\n%" PRIu32 " cuts, %" PRIu32 " failed; worst recovery %.3f ms (cut after %" PRIu64
+           "), worst extra programming %" PRId64 " bytes (cut after %" PRIu64 ")\n", cuts,
+           failures, (double)worst_ns / 1000000.0, worst_ns_at, worst_bytes, worst_bytes_at);
+
+    /* Leave the devices as they were before the sweep. */
+    sim_flash_restore(state);
+    for (uint32_t i = 0; i < SIM_FAULT_SLOTS; i++)
+    {
+        free(slots[i].old_image);
+        free(slots[i].new_image);
+    }
+    free(state);
+    return (failures == 0U) ? 0 : -1;
+}
+
+/******************************************************************************
+ * Function Name: main
+ ******************************************************************************
+ * Summary:
+ *  Parses the command line, prepares the simulated devices and runs the
+ *  requested number of boots.
+ *
+ ******************************************************************************/
+int main(int argc, char *argv[])
+{
+    static const struct option options[] =
+    {
+        { "state",       required_argument, NULL, 's' },
+        { "reset",       no_argument,       NULL, 'r' },
+        { "load",        required_argument, NULL, 'l' },
+        { "pending",     required_argument, NULL, 'p' },
+        { "expect",      required_argument, NULL, 'e' },
+        { "cut",         required_argument, NULL, 'c' },
+        { "fault-sweep", required_argument, NULL, 'F' },
+        { "boots",       required_argument, NULL, 'n' },
+        { "param",       required_argument, NULL, 'P' },
+        { "list-params", no_argument,       NULL, 'L' },
+        { "verbose",     no_argument,       NULL, 'v' },
+        { "help",        no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    const char *state_dir = SIM_DEFAULT_STATE_DIR;
+    char *loads[SIM_MAX_LOADS];
+    char *pending[SIM_MAX_LOADS];
+    char *expects[SIM_MAX_LOADS];
+    uint32_t load_count = 0;
+    uint32_t pending_count = 0;
+    uint32_t expect_count = 0;
+    uint32_t boots = 1;
+    uint64_t cut_ns = 0;
+    uint64_t sweep_step = 0;
+    bool reset = false;
+    int rc = 0;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "s:rl:p:e:c:F:n:P:Lvh", options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 's':
+            state_dir = optarg;
+            break;
+        case 'r':
+            reset = true;
+            break;
+        case 'l':
+        case 'p':
+            if (((opt == 'l') ? load_count : pending_count) >= SIM_MAX_LOADS)
+            {
+                fprintf(stderr, "sim: too many -%c options\n", opt);
+                return EXIT_FAILURE;
+            }
+            if (opt == 'l')
+            {
+                loads[load_count++] = optarg;
+            }
+            else
+            {
+                pending[pending_count++] = optarg;
+            }
+            break;
+        case 'e':
+            if (expect_count >= SIM_MAX_LOADS)
+            {
+                fprintf(stderr, "sim: too many -e options\n");
+                return EXIT_FAILURE;
+            }
+            expects[expect_count++] = optarg;
+            break;
+        case 'c':
+            cut_ns = (uint64_t)(strtod(optarg, NULL) * 1000000.0);
+            break;
+        case 'F':
+            sweep_step = strtoull(optarg, NULL, 0);
+            if (sweep_step == 0U)
+            {
+                fprintf(stderr, "sim: --fault-sweep expects a step of 1 or more\n");
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'n':
+            boots = (uint32_t)strtoul(optarg, NULL, 0);
+            break;
+        case 'P':
+        {
+            char *value = strchr(optarg, '=');
+
+            if (value != NULL)
+            {
+                *value++ = '\0';
+            }
+            if ((value == NULL) || (sim_param_set(optarg, value) != 0))
+            {
+                fprintf(stderr, "sim: bad parameter '%s', see --list-params\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        }
+        case 'L':
+            sim_param_list();
+            return EXIT_SUCCESS;
+        case 'v':
+            sim_verbose = true;
+            break;
+        default:
+            sim_usage(argv[0]);
+            return (opt == 'h') ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+    sim_result = mmap(NULL, sizeof(*sim_result), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    sim_backup = mmap(NULL, sizeof(*sim_backup), PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if ((sim_result == MAP_FAILED) || (sim_backup == MAP_FAILED) ||
+        (sim_flash_init(state_dir, reset) != 0))
+    {
+        return EXIT_FAILURE;
+    }
+
+    for (uint32_t i = 0; (rc == 0) && (i < load_count); i++)
+    {
+        rc = sim_load(loads[i]);
+    }
+    for (uint32_t i = 0; (rc == 0) && (i < pending_count); i++)
+    {
+        rc = sim_set_pending(pending[i]);
+    }
+
+    if ((rc == 0) && (sweep_step != 0U))
+    {
+        rc = sim_fault_sweep(sweep_step);
+        boots = 0;
+    }
+
+    for (uint32_t boot = 1; (rc == 0) && (boot <= boots); boot++)
+    {
+        rc = sim_boot(boot, (boot == 1U) ? cut_ns : 0U, 0U, true);
+    }
+
+    for (uint32_t i = 0; (rc == 0) && (i < expect_count); i++)
+    {
+        rc = sim_expect(expects[i]);
+    }
+
+    sim_flash_deinit();
+    return (rc == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,1160 @@
+/******************************************************************************
+* File Name:   sim_pdl.c
+*
+* Description:
+* This file implements the PDL, retarget-io, QSPI flash PAL and raw SMIF
+* command (ext_flash_smif.h) functions the bootloader calls, on top of the
+* host flash model in sim_flash.c. Boot phase boundaries are derived from the
+* hardware calls main() makes.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cy_pdl.h"
+#include "cycfg.h"
+#include "cy_retarget_io_pdl.h"
+#include "cy_smif_psoc6.h"
+#include "ext_flash_smif.h"
+#include "boot_log_dma.h"
+
+#include "sim_flash.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define SIM_INT_SUBSECTOR_SIZE      (8U * CY_FLASH_SIZEOF_ROW)
+#define SIM_INT_SECTOR_SIZE         (0x40000U)
+
+/* Log text kept until the UART model has sent it, see sim_log_tx_add(). */
+#define SIM_LOG_TX_MAX              (1024U)
+
+/* Location of the Basic Flash Parameter Table and, for hybrid memories, the
+ * Sector Map Parameter Table in the modeled SFDP area.
+ */
+#define SIM_SFDP_BFPT_PTR           (0x30U)
+#define SIM_SFDP_BFPT_DWORDS        (16U)
+#define SIM_SFDP_SMPT_PTR           (SIM_SFDP_BFPT_PTR + 4U * SIM_SFDP_BFPT_DWORDS)
+#define SIM_SFDP_SMPT_DWORDS        (8U)
+#define SIM_SFDP_SIZE               (SIM_SFDP_SMPT_PTR + 4U * SIM_SFDP_SMPT_DWORDS)
+
+/* BFPT DWORD 15 with ext_cont_read: 0-4-4 mode supported, entered with mode
+ * bits A5h and left with Fh on DQ0-DQ3.
+ */
+#define SIM_SFDP_BFPT_044           (0x00010A00UL)
+
+/* Configuration register 1 and its parameter sectors at the top bit, read by
+ * the sector map detection command.
+ */
+#define SIM_SMIF_READ_CR1           (0x35U)
+#define SIM_CR1_TBPARM              (0x04U)
+
+/* Read JEDEC ID instruction. */
+#define SIM_SMIF_READ_ID            (0x9FU)
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+/* Non-blocking row operation in flight. Like the SROM, the model reads the
+ * source data when the operation completes, so a caller that reuses the
+ * buffer too early programs the wrong data.
+ */
+static struct
+{
+    bool busy;
+    bool program_only;
+    uint32_t addr;
+    const uint32_t *data;
+    uint64_t done_ns;
+} sim_int_op;
+
+CySCB_Type sim_uart_hw;
+GPIO_PRT_Type sim_uart_port;
+BACKUP_Type *sim_backup;
+
+/* The CM0+ runs from the 8 MHz IMO until CM4 sets up the clocks. */
+uint32_t SystemCoreClock = 8000000UL;
+
+/* SysTick, counting down from `reload` at SystemCoreClock. Wraps are
+ * reported to the callback when the counter is read.
+ */
+static struct
+{
+    bool enabled;
+    uint32_t reload;
+    uint64_t start_ns;
+    uint64_t wraps;
+    Cy_SysTick_Callback callback;
+} sim_systick;
+
+/*******************************************************************************
+* System
+********************************************************************************/
+void sim_assert_failed(const char *file, int line)
+{
+    fprintf(stderr, "sim: CY_ASSERT failed at %s:%d\n", file, line);
+    abort();
+}
+
+void __enable_irq(void)
+{
+}
+
+void __disable_irq(void)
+{
+}
+
+/* Masks the interrupts the device models raise (sim_irq_at()). */
+uint32_t Cy_SysLib_EnterCriticalSection(void)
+{
+    sim_irq_mask(true);
+    return 0U;
+}
+
+void Cy_SysLib_ExitCriticalSection(uint32_t savedIntrStatus)
+{
+    (void)savedIntrStatus;
+    sim_irq_mask(false);
+}
+
+/* The bootloader only waits for interrupts when it found nothing to boot. */
+void __WFI(void)
+{
+    sim_boot_exit(0U);
+}
+
+void NVIC_SystemReset(void)
+{
+    sim_system_reset();
+}
+
+void Cy_SysEnableCM4(uint32_t vectorTableOffset)
+{
+    sim_boot_exit(vectorTableOffset);
+}
+
+uint32_t Cy_SysPm_CpuEnterDeepSleep(uint32_t waitFor)
+{
+    (void)waitFor;
+    sim_boot_exit(0U);
+}
+
+void Cy_SysLib_Delay(uint32_t milliseconds)
+{
+    sim_advance_ns((uint64_t)milliseconds * 1000000U);
+}
+
+void Cy_SysLib_DelayUs(uint16_t microseconds)
+{
+    sim_advance_ns((uint64_t)microseconds * 1000U);
+}
+
+/* Same value on every run, like one device. */
+uint64_t Cy_SysLib_GetUniqueId(void)
+{
+    return 0x0123456789ABCDEFULL;
+}
+
+void SystemCoreClockUpdate(void)
+{
+}
+
+void Cy_SysTick_Init(cy_en_systick_clock_source_t clockSource, uint32_t interval)
+{
+    (void)clockSource;
+    sim_systick.enabled = true;
+    sim_systick.reload = interval;
+    sim_systick.start_ns = sim_now_ns();
+    sim_systick.wraps = 0U;
+    sim_systick.callback = NULL;
+}
+
+Cy_SysTick_Callback Cy_SysTick_SetCallback(uint32_t number, Cy_SysTick_Callback function)
+{
+    Cy_SysTick_Callback prev = sim_systick.callback;
+
+    (void)number;
+    sim_systick.callback = function;
+    return prev;
+}
+
+uint32_t Cy_SysTick_GetValue(void)
+{
+    uint64_t period = (uint64_t)sim_systick.reload + 1U;
+    uint64_t ticks;
+
+    if (!sim_systick.enabled)
+    {
+        return 0U;
+    }
+
+    ticks = (sim_now_ns() - sim_systick.start_ns) * SystemCoreClock / 1000000000U;
+    while (sim_systick.wraps < (ticks / period))
+    {
+        sim_systick.wraps++;
+        if (sim_systick.callback != NULL)
+        {
+            sim_systick.callback();
+        }
+    }
+    return (uint32_t)(sim_systick.reload - (ticks % period));
+}
+
+void Cy_SysTick_Disable(void)
+{
+    sim_systick.enabled = false;
+}
+
+void Cy_GPIO_Port_Deinit(GPIO_PRT_Type *base)
+{
+    (void)base;
+}
+
+void init_cycfg_clocks(void)
+{
+}
+
+void init_cycfg_peripherals(void)
+{
+}
+
+void init_cycfg_pins(void)
+{
+}
+
+/*******************************************************************************
+* Retarget-io
+********************************************************************************/
+cy_rslt_t cy_retarget_io_pdl_init(uint32_t baudrate)
+{
+    (void)baudrate;
+    return CY_RSLT_SUCCESS;
+}
+
+static void sim_log_tx_sent(void);
+
+/* do_boot() flushes the UART right before handing over to CM4, and
+ * do_reset() before the reset.
+ */
+void cy_retarget_io_wait_tx_complete(CySCB_Type *base, uint32_t tmo_ms)
+{
+    (void)base;
+    sim_phase_begin("handoff");
+    sim_uart_flush((uint64_t)tmo_ms * 1000000U);
+    sim_log_tx_sent();
+}
+
+void cy_retarget_io_pdl_deinit(void)
+{
+}
+
+/*******************************************************************************
+* Log DMA (boot_log_dma.c)
+********************************************************************************/
+/* Transfer started last. */
+static const uint8_t *sim_log_dma_src;
+static uint32_t sim_log_dma_len;
+static uint64_t sim_log_dma_done_ns;
+static boot_log_dma_done_t sim_log_dma_done;
+
+/* Log text the DMA has moved to the UART. With --verbose, it is shown once
+ * the UART has sent it, so what is handed to CM4 is not shown twice.
+ */
+static uint8_t sim_log_tx[SIM_LOG_TX_MAX];
+static uint32_t sim_log_tx_len;
+
+/* Adds len bytes to the UART and shows all but the last keep bytes. */
+static void sim_log_tx_add(const uint8_t *src, uint32_t len, uint32_t keep)
+{
+    uint32_t show;
+
+    if (!sim_verbose)
+    {
+        return;
+    }
+    if ((sim_log_tx_len + len) > SIM_LOG_TX_MAX)
+    {
+        (void)fwrite(sim_log_tx, 1U, sim_log_tx_len, stderr);
+        sim_log_tx_len = 0U;
+    }
+    memcpy(&sim_log_tx[sim_log_tx_len], src, len);
+    sim_log_tx_len += len;
+
+    if (sim_log_tx_len > keep)
+    {
+        show = sim_log_tx_len - keep;
+        (void)fwrite(sim_log_tx, 1U, show, stderr);
+        memmove(sim_log_tx, &sim_log_tx[show], keep);
+        sim_log_tx_len = keep;
+    }
+}
+
+/* Shows the text kept for the TX FIFO once the UART has sent it. */
+static void sim_log_tx_sent(void)
+{
+    if (sim_verbose)
+    {
+        (void)fwrite(sim_log_tx, 1U, sim_log_tx_len, stderr);
+    }
+    sim_log_tx_len = 0U;
+}
+
+static void sim_log_dma_retire(void)
+{
+    uint64_t fifo = sim_params.uart_fifo_size;
+
+    sim_log_tx_add(sim_log_dma_src, sim_log_dma_len,
+                   (fifo < SIM_LOG_TX_MAX / 2U) ? (uint32_t)fifo : (SIM_LOG_TX_MAX / 2U));
+    sim_log_dma_len = 0U;
+    sim_irq_at(0U, NULL);
+}
+
+static void sim_log_dma_isr(void)
+{
+    if (sim_log_dma_len != 0U)
+    {
+        sim_log_dma_retire();
+        sim_log_dma_done();
+    }
+}
+
+int boot_log_dma_init(boot_log_dma_done_t done)
+{
+    sim_log_dma_len = 0U;
+    sim_log_tx_len = 0U;
+    sim_log_dma_done = done;
+    return 0;
+}
+
+int boot_log_dma_start(const uint8_t *src, uint32_t len)
+{
+    if ((len == 0U) || (len > BOOT_LOG_DMA_MAX_LEN) || boot_log_dma_busy())
+    {
+        return -1;
+    }
+    sim_log_dma_src = src;
+    sim_log_dma_len = len;
+    sim_log_dma_done_ns = sim_uart_send(len);
+    sim_irq_at(sim_log_dma_done_ns, sim_log_dma_isr);
+    return 0;
+}
+
+bool boot_log_dma_busy(void)
+{
+    if (sim_log_dma_len == 0U)
+    {
+        return false;
+    }
+    sim_advance_ns(sim_params.uart_poll_ns);
+    if (sim_now_ns() < sim_log_dma_done_ns)
+    {
+        return true;
+    }
+    sim_log_dma_retire();
+    return false;
+}
+
+/* do_boot() stops the log output right before handing over to CM4. */
+uint32_t boot_log_dma_stop(void)
+{
+    uint32_t unsent;
+
+    sim_phase_begin("handoff");
+    unsent = (uint32_t)sim_uart_stop();
+    sim_log_tx_add(sim_log_dma_src, sim_log_dma_len, unsent);
+    sim_log_tx_len = 0U;
+    sim_log_dma_len = 0U;
+    sim_irq_at(0U, NULL);
+    return unsent;
+}
+
+/*******************************************************************************
+* Internal flash
+********************************************************************************/
+/* Validates a flash operation target and returns its host pointer. The flash
+ * controller runs one operation at a time.
+ */
+static uint8_t *sim_int_ptr(uint32_t addr, uint32_t size)
+{
+    if (((addr % size) != 0U) || sim_int_op.busy)
+    {
+        return NULL;
+    }
+    return sim_flash_ptr(SIM_DEV_INTERNAL, addr, size);
+}
+
+cy_en_flashdrv_status_t Cy_Flash_WriteRow(uint32_t rowAddr, const uint32_t *data)
+{
+    uint8_t *row = sim_int_ptr(rowAddr, CY_FLASH_SIZEOF_ROW);
+
+    if (row == NULL)
+    {
+        return CY_FLASH_DRV_INVALID_FLASH_ADDR;
+    }
+
+    memcpy(row, data, CY_FLASH_SIZEOF_ROW);
+    sim_account(SIM_DEV_INTERNAL, SIM_OP_PROGRAM, CY_FLASH_SIZEOF_ROW,
+                sim_params.int_row_write_ns);
+    return CY_FLASH_DRV_SUCCESS;
+}
+
+/* Programming only sets bits: the internal flash erases to 0x00. */
+cy_en_flashdrv_status_t Cy_Flash_ProgramRow(uint32_t rowAddr, const uint32_t *data)
+{
+    uint8_t *row = sim_int_ptr(rowAddr, CY_FLASH_SIZEOF_ROW);
+    const uint8_t *src = (const uint8_t *)data;
+
+    if (row == NULL)
+    {
+        return CY_FLASH_DRV_INVALID_FLASH_ADDR;
+    }
+
+    for (uint32_t i = 0; i < CY_FLASH_SIZEOF_ROW; i++)
+    {
+        row[i] |= src[i];
+    }
+    sim_account(SIM_DEV_INTERNAL, SIM_OP_PROGRAM, CY_FLASH_SIZEOF_ROW,
+                sim_params.int_row_program_ns);
+    return CY_FLASH_DRV_SUCCESS;
+}
+
+static cy_en_flashdrv_status_t sim_int_start(uint32_t rowAddr, const uint32_t *data,
+                                             bool program_only, uint64_t ns)
+{
+    if (sim_int_ptr(rowAddr, CY_FLASH_SIZEOF_ROW) == NULL)
+    {
+        return sim_int_op.busy ? CY_FLASH_DRV_IPC_BUSY : CY_FLASH_DRV_INVALID_FLASH_ADDR;
+    }
+
+    sim_int_op.busy = true;
+    sim_int_op.program_only = program_only;
+    sim_int_op.addr = rowAddr;
+    sim_int_op.data = data;
+    sim_int_op.done_ns = sim_now_ns() + ns;
+    sim_account(SIM_DEV_INTERNAL, SIM_OP_PROGRAM, CY_FLASH_SIZEOF_ROW, 0U);
+    return CY_FLASH_DRV_OPERATION_STARTED;
+}
+
+cy_en_flashdrv_status_t Cy_Flash_StartWrite(uint32_t rowAddr, const uint32_t *data)
+{
+    return sim_int_start(rowAddr, data, false, sim_params.int_row_write_ns);
+}
+
+cy_en_flashdrv_status_t Cy_Flash_StartProgram(uint32_t rowAddr, const uint32_t *data)
+{
+    return sim_int_start(rowAddr, data, true, sim_params.int_row_program_ns);
+}
+
+/* Each poll costs int_poll_ns (0 waits for completion in one poll). The
+ * time spent polling is accounted as programming time, the time hidden
+ * behind other work is not.
+ */
+cy_en_flashdrv_status_t Cy_Flash_IsOperationComplete(void)
+{
+    uint64_t now = sim_now_ns();
+    uint8_t *row;
+    const uint8_t *src;
+
+    if (!sim_int_op.busy)
+    {
+        return CY_FLASH_DRV_SUCCESS;
+    }
+
+    if (now < sim_int_op.done_ns)
+    {
+        uint64_t left = sim_int_op.done_ns - now;
+
+        sim_account_wait(SIM_DEV_INTERNAL, SIM_OP_PROGRAM,
+                         ((sim_params.int_poll_ns == 0U) || (left < sim_params.int_poll_ns)) ?
+                         left : sim_params.int_poll_ns);
+        return CY_FLASH_DRV_OPCODE_BUSY;
+    }
+
+    sim_int_op.busy = false;
+    row = sim_flash_ptr(SIM_DEV_INTERNAL, sim_int_op.addr, CY_FLASH_SIZEOF_ROW);
+    src = (const uint8_t *)sim_int_op.data;
+
+    for (uint32_t i = 0; i < CY_FLASH_SIZEOF_ROW; i++)
+    {
+        row[i] = sim_int_op.program_only ? (uint8_t)(row[i] | src[i]) : src[i];
+    }
+    return CY_FLASH_DRV_SUCCESS;
+}
+
+static cy_en_flashdrv_status_t sim_int_erase(uint32_t addr, uint32_t size, uint64_t ns)
+{
+    uint8_t *p = sim_int_ptr(addr, size);
+
+    if (p == NULL)
+    {
+        return CY_FLASH_DRV_INVALID_FLASH_ADDR;
+    }
+
+    memset(p, sim_flash_erased_val(SIM_DEV_INTERNAL), size);
+    sim_account(SIM_DEV_INTERNAL, SIM_OP_ERASE, size, ns);
+    return CY_FLASH_DRV_SUCCESS;
+}
+
+cy_en_flashdrv_status_t Cy_Flash_EraseRow(uint32_t rowAddr)
+{
+    return sim_int_erase(rowAddr, CY_FLASH_SIZEOF_ROW, sim_params.int_row_erase_ns);
+}
+
+cy_en_flashdrv_status_t Cy_Flash_EraseSubsector(uint32_t subSectorAddr)
+{
+    return sim_int_erase(subSectorAddr, SIM_INT_SUBSECTOR_SIZE,
+                         sim_params.int_subsector_erase_ns);
+}
+
+cy_en_flashdrv_status_t Cy_Flash_EraseSector(uint32_t sectorAddr)
+{
+    return sim_int_erase(sectorAddr, SIM_INT_SECTOR_SIZE, sim_params.int_sector_erase_ns);
+}
+
+/*******************************************************************************
+* External (SMIF/QSPI) flash
+********************************************************************************/
+/* SMIF in memory mode, see ext_flash_smif_xip_read(). */
+static bool sim_ext_xip_on;
+
+/* Memory mode reads keep the memory in continuous read. */
+static bool sim_ext_cont_read;
+
+/* Asynchronous XIP read in flight and the time it completes. */
+static bool sim_ext_dma_busy;
+static uint64_t sim_ext_dma_done_ns;
+
+/* Erase started by ext_flash_smif_erase_start() and the time it completes. */
+static bool sim_ext_erase_busy;
+static uint64_t sim_ext_erase_done_ns;
+
+/* The memory only answers status reads while it erases; the flash map must
+ * wait for the erase first.
+ */
+static int sim_ext_check_ready(const char *op)
+{
+    if (sim_ext_erase_busy && (sim_now_ns() < sim_ext_erase_done_ns))
+    {
+        fprintf(stderr, "sim: %s while the external flash is erasing\n", op);
+        return -1;
+    }
+    sim_ext_erase_busy = false;
+    return 0;
+}
+
+/* Command mode transactions are not possible while the SMIF is in memory
+ * mode; the flash map must switch back first.
+ */
+static int sim_ext_check_cmd_mode(const char *op)
+{
+    if (sim_ext_xip_on)
+    {
+        fprintf(stderr, "sim: %s while the SMIF is in memory mode\n", op);
+        return -1;
+    }
+    return sim_ext_check_ready(op);
+}
+
+cy_en_smif_status_t qspi_init_sfdp(uint32_t smif_id)
+{
+    (void)smif_id;
+
+    sim_phase_begin("qspi_init_sfdp");
+    sim_advance_ns(sim_params.ext_sfdp_init_ns);
+    sim_phase_begin("boot_go");
+    return CY_SMIF_SUCCESS;
+}
+
+uint32_t qspi_get_prog_size(void)
+{
+    return (uint32_t)sim_params.ext_page_size;
+}
+
+uint32_t qspi_get_erase_size(void)
+{
+    return (uint32_t)sim_params.ext_sector_size;
+}
+
+uint32_t qspi_get_mem_size(void)
+{
+    return (uint32_t)sim_params.ext_size;
+}
+
+void qspi_deinit(uint32_t smif_id)
+{
+    (void)smif_id;
+    (void)sim_ext_check_cmd_mode("qspi_deinit");
+}
+
+int psoc6_smif_read(const struct flash_area *fap, off_t addr, void *data, size_t len)
+{
+    const uint8_t *src = sim_flash_ptr(SIM_DEV_EXTERNAL, (uint32_t)addr, (uint32_t)len);
+
+    (void)fap;
+
+    if ((src == NULL) || (sim_ext_check_cmd_mode("psoc6_smif_read") != 0))
+    {
+        return -1;
+    }
+
+    memcpy(data, src, len);
+    sim_account(SIM_DEV_EXTERNAL, SIM_OP_READ, len, sim_params.ext_cmd_ns +
+                len * sim_params.ext_read_ps_per_byte / 1000U);
+    return 0;
+}
+
+/* Programs page by page like Cy_SMIF_MemWrite(). NOR programming can only
+ * clear bits.
+ */
+int psoc6_smif_write(const struct flash_area *fap, off_t addr, const void *data, size_t len)
+{
+    uint8_t *dst = sim_flash_ptr(SIM_DEV_EXTERNAL, (uint32_t)addr, (uint32_t)len);
+    const uint8_t *src = (const uint8_t *)data;
+    uint32_t page = (uint32_t)sim_params.ext_page_size;
+    uint32_t pos = (uint32_t)addr;
+
+    (void)fap;
+
+    if ((dst == NULL) || (sim_ext_check_cmd_mode("psoc6_smif_write") != 0))
+    {
+        return -1;
+    }
+
+    while (len > 0U)
+    {
+        uint32_t chunk = page - (pos % page);
+
+        if (chunk > len)
+        {
+            chunk = (uint32_t)len;
+        }
+
+        for (uint32_t i = 0; i < chunk; i++)
+        {
+            dst[i] &= src[i];
+        }
+        sim_account(SIM_DEV_EXTERNAL, SIM_OP_PROGRAM, chunk, sim_params.ext_cmd_ns +
+                    chunk * sim_params.ext_write_ps_per_byte / 1000U +
+                    sim_params.ext_page_program_ns);
+
+        dst += chunk;
+        src += chunk;
+        pos += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+
+/* Erases every sector overlapping [addr, addr + size) like
+ * Cy_SMIF_MemEraseSector() does with the SFDP erase size.
+ */
+int psoc6_smif_erase(off_t addr, size_t size)
+{
+    uint32_t sector = (uint32_t)sim_params.ext_sector_size;
+    uint32_t start = (uint32_t)addr & ~(sector - 1U);
+    uint32_t end = (uint32_t)addr + (uint32_t)size;
+
+    if (sim_ext_check_cmd_mode("psoc6_smif_erase") != 0)
+    {
+        return -1;
+    }
+
+    for (uint32_t pos = start; pos < end; pos += sector)
+    {
+        uint8_t *p = sim_flash_ptr(SIM_DEV_EXTERNAL, pos, sector);
+
+        if (p == NULL)
+        {
+            return -1;
+        }
+
+        memset(p, sim_flash_erased_val(SIM_DEV_EXTERNAL), sector);
+        sim_account(SIM_DEV_EXTERNAL, SIM_OP_ERASE, sector,
+                    sim_params.ext_cmd_ns + sim_params.ext_sector_erase_ns);
+    }
+    return 0;
+}
+
+/*******************************************************************************
+* External flash commands (ext_flash_smif.c)
+********************************************************************************/
+/* Memories above 16 MB are used with 4-byte addresses. */
+static bool sim_ext_4byte(void)
+{
+    return sim_params.ext_size > 0x1000000U;
+}
+
+static uint32_t sim_log2(uint64_t v)
+{
+    uint32_t n = 0;
+
+    while ((v >>= 1) != 0U)
+    {
+        n++;
+    }
+    return n;
+}
+
+/* Hybrid memories: the parameter region is the only one in which the 4 KB
+ * and 32 KB erases are valid.
+ */
+static bool sim_ext_in_param_region(uint32_t addr)
+{
+    uint32_t start = 0;
+
+    if (sim_params.ext_param_size == 0U)
+    {
+        return true;
+    }
+    if (sim_params.ext_param_top != 0U)
+    {
+        start = (uint32_t)(sim_params.ext_size - sim_params.ext_param_size);
+    }
+    return (addr - start) < sim_params.ext_param_size;
+}
+
+/* Returns the block size and time of an erase instruction at `addr`, 0 if
+ * the modeled memory does not support it there.
+ */
+static uint32_t sim_ext_erase_type(uint8_t cmd, uint32_t addr, uint64_t *ns)
+{
+    switch (cmd)
+    {
+    case 0x20U:
+    case 0x21U:
+        *ns = sim_params.ext_erase_4k_ns;
+        return ((*ns != 0U) && sim_ext_in_param_region(addr)) ? 0x1000U : 0U;
+    case 0x52U:
+    case 0x5CU:
+        *ns = sim_params.ext_erase_32k_ns;
+        return ((*ns != 0U) && sim_ext_in_param_region(addr)) ? 0x8000U : 0U;
+    case 0xD8U:
+    case 0xDCU:
+        *ns = sim_params.ext_sector_erase_ns;
+        return (uint32_t)sim_params.ext_sector_size;
+    default:
+        return 0U;
+    }
+}
+
+int ext_flash_smif_info(ext_flash_smif_info_t *info)
+{
+    info->mem_size = (uint32_t)sim_params.ext_size;
+    info->erase_size = (uint32_t)sim_params.ext_sector_size;
+    info->erase_cmd = sim_ext_4byte() ? 0xDCU : 0xD8U;
+    info->addr_bytes = sim_ext_4byte() ? 4U : 3U;
+    return 0;
+}
+
+/* The configuration the PDL detects for the modeled memory: quad I/O read,
+ * single I/O program and the configured sector erase.
+ */
+int ext_flash_smif_get_cfg(boot_qspi_cfg_t *cfg)
+{
+    static const boot_qspi_cmd_t cmd_3b[BOOT_QSPI_CMD_COUNT] =
+    {
+        [BOOT_QSPI_CMD_READ]         = { 0xEBU, 0x01U, 0xA8U,
+                                         BOOT_QSPI_CMD_PRESENT | BOOT_QSPI_CMD_MODE | 4U },
+        [BOOT_QSPI_CMD_WRITE_EN]     = { 0x06U, 0x00U, 0x00U, BOOT_QSPI_CMD_PRESENT },
+        [BOOT_QSPI_CMD_WRITE_DIS]    = { 0x04U, 0x00U, 0x00U, BOOT_QSPI_CMD_PRESENT },
+        [BOOT_QSPI_CMD_ERASE]        = { 0xD8U, 0x00U, 0x00U, BOOT_QSPI_CMD_PRESENT },
+        [BOOT_QSPI_CMD_CHIP_ERASE]   = { 0x60U, 0x00U, 0x00U, BOOT_QSPI_CMD_PRESENT },
+        [BOOT_QSPI_CMD_PROGRAM]      = { 0x02U, 0x00U, 0x00U, BOOT_QSPI_CMD_PRESENT },
+        [BOOT_QSPI_CMD_READ_STS_WIP] = { 0x05U, 0x00U, 0x00U, BOOT_QSPI_CMD_PRESENT },
+        [BOOT_QSPI_CMD_READ_STS_QE]  = { 0x35U, 0x00U, 0x00U, BOOT_QSPI_CMD_PRESENT },
+        [BOOT_QSPI_CMD_WRITE_STS_QE] = { 0x01U, 0x00U, 0x00U, BOOT_QSPI_CMD_PRESENT },
+        [BOOT_QSPI_CMD_READ_SFDP]    = { 0x5AU, 0x00U, 0x00U, BOOT_QSPI_CMD_PRESENT | 8U },
+    };
+
+    memset(cfg, 0, sizeof(*cfg));
+    memcpy(cfg->cmd, cmd_3b, sizeof(cfg->cmd));
+    if (sim_ext_4byte())
+    {
+        cfg->cmd[BOOT_QSPI_CMD_READ].cmd = 0xECU;
+        cfg->cmd[BOOT_QSPI_CMD_ERASE].cmd = 0xDCU;
+        cfg->cmd[BOOT_QSPI_CMD_PROGRAM].cmd = 0x12U;
+    }
+    cfg->addr_bytes = sim_ext_4byte() ? 4U : 3U;
+    cfg->slave_select = 1U;
+    cfg->base_addr = CY_XIP_BASE;
+    cfg->mapped_size = (uint32_t)sim_params.ext_size;
+    cfg->mem_size = (uint32_t)sim_params.ext_size;
+    cfg->erase_size = (uint32_t)sim_params.ext_sector_size;
+    cfg->program_size = (uint32_t)sim_params.ext_page_size;
+    cfg->busy_mask = 0x01U;
+    cfg->quad_enable_mask = 0x02U;
+    return 0;
+}
+
+/* Sets the SMIF up without the SFDP detection. */
+int ext_flash_smif_init_cfg(const boot_qspi_cfg_t *cfg)
+{
+    if (cfg->mem_size == 0U)
+    {
+        return -1;
+    }
+
+    sim_ext_cont_read = false;
+    sim_phase_begin("qspi_init");
+    sim_advance_ns(sim_params.ext_smif_init_ns);
+    sim_phase_begin("boot_go");
+    return 0;
+}
+
+int ext_flash_smif_read_id(uint8_t id[BOOT_QSPI_ID_SIZE])
+{
+    return ext_flash_smif_read_cmd(SIM_SMIF_READ_ID, 0U, 0U, 0U, id, BOOT_QSPI_ID_SIZE);
+}
+
+static void sim_put_u32(uint8_t *p, uint32_t v)
+{
+    memcpy(p, &v, sizeof(v));
+}
+
+/* Sector map region DWORD: size and the BFPT erase types valid in it. */
+static uint32_t sim_smpt_region(uint64_t size, uint32_t types)
+{
+    return ((uint32_t)(size / 256U - 1U) << 8) | types;
+}
+
+/* Builds the SFDP area: one Basic Flash Parameter Table describing the
+ * modeled density and erase types and, with ext_param_size set, a Sector Map
+ * Parameter Table with one detection command (CR1 TBPARM) selecting between
+ * the bottom and top parameter region maps.
+ */
+static void sim_sfdp_build(uint8_t *sfdp)
+{
+    static const uint8_t hdr[] = { 'S', 'F', 'D', 'P', 0x06, 0x01, 0x00, 0xFF,
+                                   0x00, 0x06, 0x01, SIM_SFDP_BFPT_DWORDS,
+                                   SIM_SFDP_BFPT_PTR, 0x00, 0x00, 0xFF,
+                                   0x81, 0x00, 0x01, SIM_SFDP_SMPT_DWORDS,
+                                   SIM_SFDP_SMPT_PTR, 0x00, 0x00, 0xFF };
+    uint8_t *bfpt = &sfdp[SIM_SFDP_BFPT_PTR];
+    uint8_t *smpt = &sfdp[SIM_SFDP_SMPT_PTR];
+    uint32_t density = (uint32_t)(sim_params.ext_size * 8U - 1U);
+    uint32_t param_types = 0;
+    uint32_t type = 0;
+
+    memset(sfdp, 0xFF, SIM_SFDP_SIZE);
+    memcpy(sfdp, hdr, sizeof(hdr));
+    memcpy(&bfpt[4], &density, sizeof(density));
+    memset(&bfpt[28], 0, 4U * (SIM_SFDP_BFPT_DWORDS - 7U));
+    if (sim_params.ext_cont_read != 0U)
+    {
+        sim_put_u32(&bfpt[56], SIM_SFDP_BFPT_044);
+    }
+
+    if (sim_params.ext_erase_4k_ns != 0U)
+    {
+        bfpt[28 + 2U * type] = 12U;
+        bfpt[29 + 2U * type] = 0x20U;
+        param_types |= 1UL << type;
+        type++;
+    }
+    if (sim_params.ext_erase_32k_ns != 0U)
+    {
+        bfpt[28 + 2U * type] = 15U;
+        bfpt[29 + 2U * type] = 0x52U;
+        param_types |= 1UL << type;
+        type++;
+    }
+    bfpt[28 + 2U * type] = (uint8_t)sim_log2(sim_params.ext_sector_size);
+    bfpt[29 + 2U * type] = 0xD8U;
+
+    if (sim_params.ext_param_size == 0U)
+    {
+        return;
+    }
+
+    sfdp[6] = 0x01U;    /* Second parameter header: sector map */
+    param_types |= 1UL << type;
+    sim_put_u32(&smpt[0], ((uint32_t)SIM_CR1_TBPARM << 24) | ((uint32_t)SIM_SMIF_READ_CR1 << 8));
+    sim_put_u32(&smpt[4], 0U);
+    /* Configuration 0: parameter region at the bottom. */
+    sim_put_u32(&smpt[8], (1UL << 16) | (0UL << 8) | 0x02U);
+    sim_put_u32(&smpt[12], sim_smpt_region(sim_params.ext_param_size, param_types));
+    sim_put_u32(&smpt[16], sim_smpt_region(sim_params.ext_size - sim_params.ext_param_size,
+                                           1UL << type));
+    /* Configuration 1: parameter region at the top, last descriptor. */
+    sim_put_u32(&smpt[20], (1UL << 16) | (1UL << 8) | 0x03U);
+    sim_put_u32(&smpt[24], sim_smpt_region(sim_params.ext_size - sim_params.ext_param_size,
+                                           1UL << type));
+    sim_put_u32(&smpt[28], sim_smpt_region(sim_params.ext_param_size, param_types));
+}
+
+int ext_flash_smif_read_sfdp(uint32_t addr, void *buf, uint32_t len)
+{
+    uint8_t sfdp[SIM_SFDP_SIZE];
+
+    if ((addr > SIM_SFDP_SIZE) || (len > (SIM_SFDP_SIZE - addr)))
+    {
+        return -1;
+    }
+
+    sim_sfdp_build(sfdp);
+    memcpy(buf, &sfdp[addr], len);
+    sim_account(SIM_DEV_EXTERNAL, SIM_OP_READ, len, sim_params.ext_cmd_ns +
+                len * sim_params.ext_read_ps_per_byte / 1000U);
+    return 0;
+}
+
+/* Models the read SFDP, read CR1 and read JEDEC ID instructions. */
+int ext_flash_smif_read_cmd(uint8_t cmd, uint32_t addr, uint32_t addr_bytes,
+                            uint32_t dummy_cycles, void *buf, uint32_t len)
+{
+    uint8_t cr1 = (sim_params.ext_param_top != 0U) ? SIM_CR1_TBPARM : 0U;
+
+    ext_flash_smif_cmd_mode();
+
+    if ((cmd == 0x5AU) && (addr_bytes == 3U) && (dummy_cycles == 8U))
+    {
+        return ext_flash_smif_read_sfdp(addr, buf, len);
+    }
+    if ((cmd == SIM_SMIF_READ_CR1) && (addr_bytes == 0U) && (dummy_cycles == 0U))
+    {
+        memset(buf, cr1, len);
+        sim_account(SIM_DEV_EXTERNAL, SIM_OP_READ, len, sim_params.ext_cmd_ns);
+        return 0;
+    }
+    if ((cmd == SIM_SMIF_READ_ID) && (addr_bytes == 0U) && (dummy_cycles == 0U))
+    {
+        for (uint32_t i = 0; i < len; i++)
+        {
+            ((uint8_t *)buf)[i] = (i < 3U) ? (uint8_t)(sim_params.ext_jedec_id >> (16U - 8U * i)) :
+                                             0xFFU;
+        }
+        sim_account(SIM_DEV_EXTERNAL, SIM_OP_READ, len, sim_params.ext_cmd_ns);
+        return 0;
+    }
+
+    fprintf(stderr, "sim: unsupported read 0x%02x\n", cmd);
+    return -1;
+}
+
+/* The block reads as erased at once; the memory stays busy for the erase
+ * time, of which only the part spent in ext_flash_smif_wait() or polling
+ * counts as erase time.
+ */
+int ext_flash_smif_erase_start(uint8_t cmd, uint32_t addr)
+{
+    uint64_t ns = 0;
+    uint32_t size = sim_ext_erase_type(cmd, addr, &ns);
+    uint8_t *p;
+
+    ext_flash_smif_cmd_mode();
+
+    if ((size == 0U) || ((addr % size) != 0U))
+    {
+        fprintf(stderr, "sim: bad erase 0x%02x at 0x%08x\n", cmd, (unsigned int)addr);
+        return -1;
+    }
+
+    p = sim_flash_ptr(SIM_DEV_EXTERNAL, (uint32_t)SIM_EXT_FLASH_BASE + addr, size);
+    if ((p == NULL) || (sim_ext_check_ready("ext_flash_smif_erase_start") != 0))
+    {
+        return -1;
+    }
+
+    memset(p, sim_flash_erased_val(SIM_DEV_EXTERNAL), size);
+    sim_account(SIM_DEV_EXTERNAL, SIM_OP_ERASE, size, sim_params.ext_cmd_ns);
+    sim_ext_erase_busy = true;
+    sim_ext_erase_done_ns = sim_now_ns() + ns;
+    return 0;
+}
+
+/* One status register read. */
+bool ext_flash_smif_busy(void)
+{
+    ext_flash_smif_cmd_mode();
+    sim_account_wait(SIM_DEV_EXTERNAL, SIM_OP_ERASE, sim_params.ext_cmd_ns);
+    sim_ext_erase_busy = sim_ext_erase_busy && (sim_now_ns() < sim_ext_erase_done_ns);
+    return sim_ext_erase_busy;
+}
+
+int ext_flash_smif_wait(void)
+{
+    if (sim_ext_erase_busy && (sim_now_ns() < sim_ext_erase_done_ns))
+    {
+        sim_account_wait(SIM_DEV_EXTERNAL, SIM_OP_ERASE, sim_ext_erase_done_ns - sim_now_ns());
+    }
+    sim_ext_erase_busy = false;
+    return 0;
+}
+
+int ext_flash_smif_erase(uint8_t cmd, uint32_t addr)
+{
+    if (ext_flash_smif_erase_start(cmd, addr) != 0)
+    {
+        return -1;
+    }
+    return ext_flash_smif_wait();
+}
+
+int ext_flash_smif_erase_chip(void)
+{
+    uint8_t *p = sim_flash_ptr(SIM_DEV_EXTERNAL, (uint32_t)SIM_EXT_FLASH_BASE,
+                               (uint32_t)sim_params.ext_size);
+
+    ext_flash_smif_cmd_mode();
+
+    if ((p == NULL) || (sim_ext_check_ready("ext_flash_smif_erase_chip") != 0))
+    {
+        return -1;
+    }
+
+    memset(p, sim_flash_erased_val(SIM_DEV_EXTERNAL), sim_params.ext_size);
+    sim_account(SIM_DEV_EXTERNAL, SIM_OP_ERASE, sim_params.ext_size,
+                sim_params.ext_cmd_ns + sim_params.ext_chip_erase_ns);
+    return 0;
+}
+
+/* Stalls the CPU until the asynchronous read in flight completes. */
+static void sim_ext_dma_complete(void)
+{
+    if (sim_ext_dma_busy && (sim_now_ns() < sim_ext_dma_done_ns))
+    {
+        sim_account_wait(SIM_DEV_EXTERNAL, SIM_OP_READ, sim_ext_dma_done_ns - sim_now_ns());
+    }
+    sim_ext_dma_busy = false;
+}
+
+/* Switches to memory mode, returning the switch time. In continuous read,
+ * a command mode read of one byte puts the memory into it first.
+ */
+static uint64_t sim_ext_xip_enter(void)
+{
+    if (sim_ext_xip_on)
+    {
+        return 0;
+    }
+    sim_ext_xip_on = true;
+    if (sim_ext_cont_read)
+    {
+        return sim_params.ext_xip_switch_ns + sim_params.ext_cmd_ns +
+               sim_params.ext_read_ps_per_byte / 1000U;
+    }
+    return sim_params.ext_xip_switch_ns;
+}
+
+/* XIP read time per byte; continuous reads omit the instruction. */
+static uint64_t sim_ext_xip_ps_per_byte(void)
+{
+    if (sim_ext_cont_read && (sim_params.ext_xip_cmd_ps_per_byte < sim_params.ext_xip_ps_per_byte))
+    {
+        return sim_params.ext_xip_ps_per_byte - sim_params.ext_xip_cmd_ps_per_byte;
+    }
+    return sim_params.ext_xip_ps_per_byte;
+}
+
+/* Memory mode reads of the XIP window. The first read after command mode
+ * pays for the mode switch; ext_xip_ps_per_byte = 0 models a memory that
+ * cannot be memory mapped. The CPU and the DMA share the bus, so a CPU read
+ * waits for the DMA.
+ */
+int ext_flash_smif_xip_read(uint32_t addr, void *dst, uint32_t len)
+{
+    const uint8_t *src = sim_flash_ptr(SIM_DEV_EXTERNAL, addr, len);
+
+    if ((sim_params.ext_xip_ps_per_byte == 0U) || (src == NULL) ||
+        (sim_ext_check_ready("ext_flash_smif_xip_read") != 0))
+    {
+        return -1;
+    }
+
+    sim_ext_dma_complete();
+    memcpy(dst, src, len);
+    sim_account(SIM_DEV_EXTERNAL, SIM_OP_READ, len,
+                sim_ext_xip_enter() + len * sim_ext_xip_ps_per_byte() / 1000U);
+    return 0;
+}
+
+/* DMA reads of the XIP window: the CPU only pays for the mode switch and the
+ * setup, the transfer runs until ext_flash_smif_xip_read_wait().
+ */
+int ext_flash_smif_xip_read_start(uint32_t addr, void *dst, uint32_t len)
+{
+    const uint8_t *src = sim_flash_ptr(SIM_DEV_EXTERNAL, addr, len);
+
+    if ((sim_params.ext_xip_ps_per_byte == 0U) || (src == NULL) || sim_ext_dma_busy ||
+        (sim_ext_check_ready("ext_flash_smif_xip_read_start") != 0))
+    {
+        return -1;
+    }
+
+    memcpy(dst, src, len);
+    sim_account(SIM_DEV_EXTERNAL, SIM_OP_READ, len,
+                sim_ext_xip_enter() + sim_params.ext_dma_setup_ns);
+    sim_ext_dma_busy = true;
+    sim_ext_dma_done_ns = sim_now_ns() + len * sim_ext_xip_ps_per_byte() / 1000U;
+    return 0;
+}
+
+int ext_flash_smif_xip_read_wait(void)
+{
+    sim_ext_dma_complete();
+    return 0;
+}
+
+void ext_flash_smif_cmd_mode(void)
+{
+    sim_ext_dma_complete();
+    if (sim_ext_xip_on && sim_ext_cont_read)
+    {
+        sim_ext_xip_on = false;
+        (void)ext_flash_smif_mode_reset();
+    }
+    sim_ext_xip_on = false;
+}
+
+/* The modeled read instruction (quad I/O with mode bits) allows continuous
+ * read whenever the SFDP tables advertise it.
+ */
+int ext_flash_smif_set_cont_read(uint8_t mode)
+{
+    ext_flash_smif_cmd_mode();
+    sim_ext_cont_read = (mode != 0U);
+    return 0;
+}
+
+/* The continuous read exit sequence: one short transaction. */
+int ext_flash_smif_mode_reset(void)
+{
+    if (sim_ext_check_cmd_mode("ext_flash_smif_mode_reset") != 0)
+    {
+        return -1;
+    }
+    sim_account(SIM_DEV_EXTERNAL, SIM_OP_READ, 0U, sim_params.ext_cmd_ns);
+    return 0;
+}
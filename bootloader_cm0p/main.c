@@ -61,6 +61,21 @@
 
 /*  Flash access headers. */
 #include "flash_map_backend/flash_map_backend.h"
+#include "ext_flash_map.h"
+#include "ext_flash_cache.h"
+#include "ext_flash_smif.h"
+#include "ext_flash_sfdp_cache.h"
+#include "upgrade_journal.h"
+#include "upgrade_patch.h"
+#include "upgrade_compress.h"
+#include "upgrade_concurrent.h"
+#include "upgrade_slot_flip.h"
+#include "boot_crypto.h"
+#include "boot_fast.h"
+#include "boot_handoff.h"
+#include "boot_log.h"
+#include "boot_timing.h"
+#include "boot_validate.h"
 #include "cy_smif_psoc6.h"
 #include "sysflash.h"
 
@@ -84,7 +99,18 @@
 * Function Prototypes
 ********************************************************************************/
 static void do_boot(struct boot_rsp *rsp, char *msg);
+static void do_reset(void);
 static void deinit_hw(void);
+static void log_erase_stats(void);
+static void log_cache_stats(void);
+static void log_journal_stats(void);
+static void log_patch_stats(void);
+static void log_compress_stats(void);
+static void log_concurrent_stats(void);
+static void log_slot_flip_stats(void);
+static void log_validate_stats(void);
+static void log_sfdp_cache_stats(void);
+static void log_fast_stats(void);
 
 /******************************************************************************
  * Function Name: deinit_hw
@@ -97,7 +123,228 @@ static void deinit_hw(void)
     cy_retarget_io_pdl_deinit();
     Cy_GPIO_Port_Deinit(CYBSP_UART_RX_PORT);
     Cy_GPIO_Port_Deinit(CYBSP_UART_TX_PORT);
+    ext_flash_smif_cmd_mode();
     qspi_deinit(QSPI_SLAVE_SELECT_LINE);
+    boot_timing_deinit();
+}
+
+/******************************************************************************
+ * Function Name: log_erase_stats
+ ******************************************************************************
+ * Summary:
+ *  Prints how many erase granules the upgrade erased and how many it skipped
+ *  because they were already blank. Prints nothing if nothing was erased.
+ *
+ ******************************************************************************/
+static void log_erase_stats(void)
+{
+    const flash_erase_stats_t *int_stats = flash_area_get_erase_stats(FLASH_DEVICE_INTERNAL_FLASH);
+    const flash_erase_stats_t *ext_stats = flash_area_get_erase_stats(FLASH_DEVICE_EXTERNAL_FLASH(0));
+
+    if ((int_stats->erased + int_stats->skipped + ext_stats->erased + ext_stats->skipped) != 0U)
+    {
+        BOOT_LOG_INF("Erase: internal %u done, %u blank; external %u done, %u blank",
+                     (unsigned int)int_stats->erased, (unsigned int)int_stats->skipped,
+                     (unsigned int)ext_stats->erased, (unsigned int)ext_stats->skipped);
+    }
+}
+
+/******************************************************************************
+ * Function Name: log_cache_stats
+ ******************************************************************************
+ * Summary:
+ *  Prints the external flash read cache counters at debug level.
+ *
+ ******************************************************************************/
+static void log_cache_stats(void)
+{
+#if (MCUBOOT_LOG_LEVEL >= MCUBOOT_LOG_LEVEL_DEBUG)
+    const ext_flash_cache_stats_t *stats = ext_flash_cache_get_stats();
+
+    BOOT_LOG_DBG("SMIF read cache: %u hits, %u misses, %u bypassed (%u XIP, %u streamed)",
+                 (unsigned int)stats->hits, (unsigned int)stats->misses,
+                 (unsigned int)stats->bypassed, (unsigned int)stats->xip,
+                 (unsigned int)stats->streamed);
+#endif
+}
+
+/******************************************************************************
+ * Function Name: log_journal_stats
+ ******************************************************************************
+ * Summary:
+ *  Prints the upgrade journal activity: progress records written and, when
+ *  an interrupted upgrade was resumed, how much of the copy was kept.
+ *  Prints nothing if no upgrade ran.
+ *
+ ******************************************************************************/
+static void log_journal_stats(void)
+{
+    const upgrade_journal_stats_t *stats = upgrade_journal_get_stats();
+
+    if ((stats->records + stats->kept_bytes) != 0U)
+    {
+        BOOT_LOG_INF("Upgrade journal: %u records, %u bytes kept, %u bytes not rewritten",
+                     (unsigned int)stats->records, (unsigned int)stats->kept_bytes,
+                     (unsigned int)stats->elided_bytes);
+    }
+}
+
+/******************************************************************************
+ * Function Name: log_patch_stats
+ ******************************************************************************
+ * Summary:
+ *  Prints how the images rebuilt from patches were made up. Prints nothing
+ *  if no patch was pending.
+ *
+ ******************************************************************************/
+static void log_patch_stats(void)
+{
+    const upgrade_patch_stats_t *stats = upgrade_patch_get_stats();
+
+    if ((stats->applied + stats->failed) != 0U)
+    {
+        BOOT_LOG_INF("Patch upgrade: %u applied, %u failed, %u patch bytes,"
+                     " %u bytes copied, %u bytes inserted",
+                     (unsigned int)stats->applied, (unsigned int)stats->failed,
+                     (unsigned int)stats->patch_bytes, (unsigned int)stats->copied_bytes,
+                     (unsigned int)stats->inserted_bytes);
+    }
+}
+
+/******************************************************************************
+ * Function Name: log_compress_stats
+ ******************************************************************************
+ * Summary:
+ *  Prints the compressed images expanded into primary slots. Prints nothing
+ *  if no compressed image was pending.
+ *
+ ******************************************************************************/
+static void log_compress_stats(void)
+{
+    const upgrade_compress_stats_t *stats = upgrade_compress_get_stats();
+
+    if ((stats->expanded + stats->failed) != 0U)
+    {
+        BOOT_LOG_INF("Compressed upgrade: %u expanded, %u failed, %u bytes expanded"
+                     " from %u bytes",
+                     (unsigned int)stats->expanded, (unsigned int)stats->failed,
+                     (unsigned int)stats->expanded_bytes, (unsigned int)stats->compressed_bytes);
+    }
+}
+
+/******************************************************************************
+ * Function Name: log_concurrent_stats
+ ******************************************************************************
+ * Summary:
+ *  Prints the images installed by the concurrent upgrade. Prints nothing if
+ *  the two images did not both have a pending upgrade.
+ *
+ ******************************************************************************/
+static void log_concurrent_stats(void)
+{
+    const upgrade_concurrent_stats_t *stats = upgrade_concurrent_get_stats();
+
+    if ((stats->installed + stats->failed) != 0U)
+    {
+        BOOT_LOG_INF("Concurrent upgrade: %u installed, %u failed, %u bytes copied",
+                     (unsigned int)stats->installed, (unsigned int)stats->failed,
+                     (unsigned int)stats->copied_bytes);
+    }
+}
+
+/******************************************************************************
+ * Function Name: log_slot_flip_stats
+ ******************************************************************************
+ * Summary:
+ *  Prints the image 2 slot chosen for the CM4 application. Prints nothing
+ *  if slot flip is not enabled.
+ *
+ ******************************************************************************/
+static void log_slot_flip_stats(void)
+{
+    const upgrade_slot_flip_stats_t *stats = upgrade_slot_flip_get_stats();
+
+    if (stats->slot_addr != 0U)
+    {
+        BOOT_LOG_INF("Image 2: slot at 0x%08x, version %u.%u.%u+%u, %u rejected",
+                     (unsigned int)stats->slot_addr, (unsigned int)stats->ver.iv_major,
+                     (unsigned int)stats->ver.iv_minor, (unsigned int)stats->ver.iv_revision,
+                     (unsigned int)stats->ver.iv_build_num, (unsigned int)stats->rejected);
+    }
+}
+
+/******************************************************************************
+ * Function Name: log_validate_stats
+ ******************************************************************************
+ * Summary:
+ *  Prints how the primary slot images were validated: in full, or against
+ *  the record of an earlier full validation, which is the usual case and
+ *  is printed at debug level only.
+ *
+ ******************************************************************************/
+static void log_validate_stats(void)
+{
+    const boot_validate_stats_t *stats = boot_validate_get_stats();
+
+    if ((stats->full + stats->failed) != 0U)
+    {
+        BOOT_LOG_INF("Image slots: %u validated in full, %u from records, %u failed",
+                     (unsigned int)stats->full, (unsigned int)stats->cached,
+                     (unsigned int)stats->failed);
+    }
+    else
+    {
+        BOOT_LOG_DBG("Image slots: %u validated from records, %u bytes sampled",
+                     (unsigned int)stats->cached, (unsigned int)stats->sampled_bytes);
+    }
+}
+
+/******************************************************************************
+ * Function Name: log_sfdp_cache_stats
+ ******************************************************************************
+ * Summary:
+ *  Prints whether the external memory was detected through SFDP or set up
+ *  from the record of an earlier detection, which is the usual case and is
+ *  printed at debug level only.
+ *
+ ******************************************************************************/
+static void log_sfdp_cache_stats(void)
+{
+    const ext_flash_sfdp_cache_stats_t *stats = ext_flash_sfdp_cache_get_stats();
+
+    if (stats->detected != 0U)
+    {
+        BOOT_LOG_INF("External memory %02x%02x%02x detected using SFDP, %u records written",
+                     stats->id[0], stats->id[1], stats->id[2], (unsigned int)stats->records);
+    }
+    else
+    {
+        BOOT_LOG_DBG("External memory %02x%02x%02x set up from its SFDP record",
+                     stats->id[0], stats->id[1], stats->id[2]);
+    }
+}
+
+/******************************************************************************
+ * Function Name: log_fast_stats
+ ******************************************************************************
+ * Summary:
+ *  Prints whether the upgrade passes and boot_go() were left out because no
+ *  upgrade was pending, which is the usual case and is printed at debug
+ *  level only.
+ *
+ ******************************************************************************/
+static void log_fast_stats(void)
+{
+    const boot_fast_stats_t *stats = boot_fast_get_stats();
+
+    if (stats->taken != 0U)
+    {
+        BOOT_LOG_DBG("No upgrade pending: MCUboot left out");
+    }
+    else
+    {
+        BOOT_LOG_DBG("%u secondary slots with an upgrade pending", (unsigned int)stats->pending);
+    }
 }
 
 /******************************************************************************
@@ -115,18 +362,47 @@ static void deinit_hw(void)
 static void do_boot(struct boot_rsp *rsp, char *msg)
 {
     uint32_t app_addr = (rsp->br_image_off + rsp->br_hdr->ih_hdr_size);
+    uint32_t t;
 
     CY_ASSERT(msg != NULL);
 
     BOOT_LOG_INF("Starting %s on CM4. Please wait...", msg);
 
+    /* Leave the log output the UART has not sent to the application, or
+     * wait for it.
+     */
+    t = boot_timing_now();
+#if (CY_BOOT_LOG_ASYNC != 0)
+    boot_log_handoff();
+#else
     cy_retarget_io_wait_tx_complete(CYBSP_UART_HW, CM4_BOOT_DELAY_MS);
+#endif
+    boot_timing_add(BOOT_PHASE_UART_FLUSH, BOOT_PHASE_NO_IMAGE, t);
 
     deinit_hw();
 
     Cy_SysEnableCM4(app_addr);
 }
 
+/******************************************************************************
+ * Function Name: do_reset
+ ******************************************************************************
+ * Summary:
+ *  Resets the device once the log output is sent and the internal flash
+ *  write in progress is complete.
+ *
+ ******************************************************************************/
+static void do_reset(void)
+{
+    boot_log_flush();
+    cy_retarget_io_wait_tx_complete(CYBSP_UART_HW, CM4_BOOT_DELAY_MS);
+    (void)flash_area_sync();
+
+    deinit_hw();
+
+    NVIC_SystemReset();
+}
+
 /******************************************************************************
  * Function Name: main
  ******************************************************************************
@@ -140,37 +416,113 @@ int main(void)
 {
     struct boot_rsp rsp;
     cy_rslt_t result = CY_RSLT_SUCCESS;
+    int boot_rc;
+    int slot_rc;
+    int valid_rc;
+    uint32_t t;
+
+    /* Nothing is handed to CM4 yet; the boot phases are timed from here. */
+    boot_handoff_init();
+    boot_timing_init();
+    boot_crypto_init();
 
     /* Initialize system resources and peripherals.
      * Do not call init_cycfg_system() as the system clocks and resources will
      * be initialized by CM4.
      */
+    t = boot_timing_now();
     init_cycfg_clocks();
     init_cycfg_peripherals();
     init_cycfg_pins();
 
     /* Initialize retarget-io to redirect the printf output. */
     cy_retarget_io_pdl_init(CY_RETARGET_IO_BAUDRATE);
+    boot_log_init();
+    boot_timing_add(BOOT_PHASE_HW_INIT, BOOT_PHASE_NO_IMAGE, t);
 
     /* Enable interrupts. */
     __enable_irq();
 
-    /* Initialize QSPI NOR flash using SFDP. */
-    result = qspi_init_sfdp(QSPI_SLAVE_SELECT_LINE);
+    /* Initialize QSPI NOR flash using SFDP, or the configuration SFDP gave
+     * on an earlier boot.
+     */
+    t = boot_timing_now();
+    result = ext_flash_sfdp_cache_init(QSPI_SLAVE_SELECT_LINE);
+    boot_timing_add(BOOT_PHASE_SMIF_INIT, BOOT_PHASE_NO_IMAGE, t);
     if( result == CY_RSLT_SUCCESS)
     {
-        BOOT_LOG_INF("External Memory initialization using SFDP mode.");
+        log_sfdp_cache_stats();
     }
     else
     {
         BOOT_LOG_ERR("External Memory initialization using SFDP Failed 0x%08x", (int)result);
+        boot_log_flush();
 
         /* Critical error: asserting. */
         CY_ASSERT(0);
     }
 
-    /* Perform a pending upgrade (if any) and validate images on primary slot */
-    if (boot_go(&rsp) == 0)
+    /* On a normal reset no secondary slot has an upgrade pending: that is
+     * checked first, and then there is nothing for the upgrade passes and
+     * boot_go() to do.
+     */
+    t = boot_timing_now();
+    boot_rc = boot_fast_go(&rsp);
+    boot_timing_add(BOOT_PHASE_FAST_CHECK, BOOT_PHASE_NO_IMAGE, t);
+    log_fast_stats();
+
+    /* Otherwise rebuild the images of pending patches and expand pending
+     * compressed images, install pending upgrades of both images together,
+     * then perform a pending upgrade (if any).
+     */
+    if (boot_rc != 0)
+    {
+        t = boot_timing_now();
+        upgrade_patch_apply();
+        boot_timing_add(BOOT_PHASE_PATCH, BOOT_PHASE_NO_IMAGE, t);
+        log_patch_stats();
+        t = boot_timing_now();
+        boot_rc = upgrade_compress_apply();
+        boot_timing_add(BOOT_PHASE_COMPRESS, BOOT_PHASE_NO_IMAGE, t);
+        log_compress_stats();
+
+        /* A failed expansion is tried again from a reset. Once the retries
+         * are used up it leaves its compressed image pending, which MCUboot
+         * would install as it is.
+         */
+        if (boot_rc == UPGRADE_COMPRESS_RETRY)
+        {
+            do_reset();
+        }
+        if (boot_rc == 0)
+        {
+            t = boot_timing_now();
+            upgrade_concurrent_apply();
+            boot_timing_add(BOOT_PHASE_CONCURRENT, BOOT_PHASE_NO_IMAGE, t);
+            log_concurrent_stats();
+            t = boot_timing_now();
+            boot_rc = boot_go(&rsp);
+            boot_timing_add(BOOT_PHASE_BOOT_GO, BOOT_PHASE_NO_IMAGE, t);
+        }
+    }
+
+    /* Pick the Wi-Fi firmware slot in slot flip mode, and validate images on
+     * primary slot, in full only the first time they are booted. The last
+     * internal flash row written may still be programming.
+     */
+    t = boot_timing_now();
+    slot_rc = upgrade_slot_flip_select();
+    boot_timing_add(BOOT_PHASE_SLOT_FLIP, BOOT_PHASE_NO_IMAGE, t);
+    log_slot_flip_stats();
+    t = boot_timing_now();
+    valid_rc = boot_validate_primaries();
+    boot_timing_add(BOOT_PHASE_VALIDATE, BOOT_PHASE_NO_IMAGE, t);
+    log_validate_stats();
+    log_erase_stats();
+    log_cache_stats();
+    log_journal_stats();
+
+    if ((boot_rc == 0) && (slot_rc == 0) && (valid_rc == 0) && (flash_area_sync() == 0))
     {
         BOOT_LOG_INF("Application validated successfully !");
 
@@ -185,6 +537,7 @@ int main(void)
     else
     {
        /* Put MCU in WFI mode when application for CM4 is invalid. */
+        boot_log_flush();
         while (true)
         {
             __WFI();
@@ -0,0 +1,134 @@
+# (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+# Licensed under the Apache License, Version 2.0 (the "License").
+# You may not use this file except in compliance with the License.
+# A copy of the License is located at
+#     http://www.apache.org/licenses/LICENSE-2.0
+# or in the "license" file accompanying this file. This file is distributed
+# on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+# express or implied. See the License for the specific language governing
+# permissions and limitations under the License.
+#
+
+
+# Turns the tokenized log output of the bootloader (CY_BOOT_LOG_TOKENIZED,
+# bootloader_cm0p/boot_log.c) back into text. The format strings are taken
+# from the boot_log_fmt section of the bootloader ELF file of the same build;
+# a token is the offset of its string in the section. Text that is not a
+# token, such as the application output that follows, is passed through.
+#
+#   cat /dev/ttyACM0 | python3 boot_log_decode.py --elf build/.../mcuboot.elf
+
+import sys
+import argparse
+import re
+import struct
+
+TOKEN_MARK = 0xC0
+TOKEN_SECTION = "boot_log_fmt"
+
+CONVERSION = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(?:hh|h|ll|l|z|j|t)?([diouxXcsp%])")
+
+def read_formats(path):
+    with open(path, "rb") as f:
+        elf = f.read()
+    if elf[:4] != b"\x7fELF":
+        sys.exit("boot_log_decode: %s is not an ELF file" % path)
+
+    is_64 = (elf[4] == 2)
+    endian = "<" if elf[5] == 1 else ">"
+    if is_64:
+        shoff, = struct.unpack_from(endian + "Q", elf, 0x28)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", elf, 0x3A)
+        header = endian + "IIQQQQIIQQ"
+    else:
+        shoff, = struct.unpack_from(endian + "I", elf, 0x20)
+        shentsize, shnum, shstrndx = struct.unpack_from(endian + "HHH", elf, 0x2E)
+        header = endian + "IIIIIIIIII"
+
+    sections = [struct.unpack_from(header, elf, shoff + i * shentsize) for i in range(shnum)]
+    names_off = sections[shstrndx][4]
+    for name, _, _, _, offset, size, _, _, _, _ in sections:
+        end = elf.index(b"\0", names_off + name)
+        if elf[names_off + name:end].decode() == TOKEN_SECTION:
+            return elf[offset:offset + size]
+
+    sys.exit("boot_log_decode: no %s section in %s, build with BOOT_LOG_TOKENIZED=1" %
+             (TOKEN_SECTION, path))
+
+def read_byte(stream):
+    byte = stream.read(1)
+    if not byte:
+        raise EOFError
+    return byte[0]
+
+def read_varint(stream):
+    value = 0
+    shift = 0
+    while True:
+        byte = read_byte(stream)
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if (byte & 0x80) == 0:
+            return value
+
+def read_string(stream):
+    out = bytearray()
+    while True:
+        byte = read_byte(stream)
+        if byte == 0:
+            return out.decode("utf-8", "replace")
+        out.append(byte)
+
+def decode_line(stream, formats):
+    token = read_varint(stream)
+    if token >= len(formats):
+        return "[boot_log_decode: unknown token %d]\n" % token
+    fmt = formats[token:formats.index(b"\0", token)].decode("utf-8", "replace")
+
+    def convert(match):
+        flags, width, precision, conv = match.groups()
+        if conv == "%":
+            return "%"
+        spec = "%" + flags + width + (("." + precision) if precision else "")
+        if conv == "s":
+            return (spec + "s") % read_string(stream)
+        value = read_varint(stream) & 0xFFFFFFFF
+        if conv in "di":
+            return (spec + "d") % (value - (1 << 32) if value & 0x80000000 else value)
+        if conv == "u":
+            return (spec + "d") % value
+        if conv == "c":
+            return (spec + "c") % chr(value)
+        if conv == "p":
+            return "0x" + (spec + "x") % value
+        return (spec + conv) % value
+
+    return CONVERSION.sub(convert, fmt)
+
+def main():
+    parser = argparse.ArgumentParser(description="Script to decode the tokenized bootloader log output")
+
+    parser.add_argument("--elf", required=True, metavar="Bootloader ELF file of the build that logged")
+
+    parser.add_argument("--input", metavar="Captured UART output (default: standard input)")
+
+    # Start arg parser.
+    args = parser.parse_args()
+
+    formats = read_formats(args.elf)
+    stream = open(args.input, "rb") if args.input else sys.stdin.buffer
+    out = sys.stdout
+
+    try:
+        while True:
+            byte = read_byte(stream)
+            if byte == TOKEN_MARK:
+                out.write(decode_line(stream, formats))
+            else:
+                out.write(chr(byte))
+            out.flush()
+    except EOFError:
+        pass
+
+if __name__ == "__main__":
+    main()
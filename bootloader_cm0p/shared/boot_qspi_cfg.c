@@ -0,0 +1,263 @@
+/******************************************************************************
+* File Name:   boot_qspi_cfg.c
+*
+* Description:
+* This file converts the PDL SMIF memory configuration found by the SFDP
+* detection to boot_qspi_cfg_t and back. It is built into both the bootloader
+* and the CM4 application, which must use the same PDL.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "cy_pdl.h"
+#include "boot_qspi_cfg.h"
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static uint8_t qspi_cfg_width(cy_en_smif_txfr_width_t width, uint32_t pos);
+static int qspi_cfg_pack_cmd(const cy_stc_smif_mem_cmd_t *src, boot_qspi_cmd_t *dst);
+static cy_stc_smif_mem_cmd_t *qspi_cfg_unpack_cmd(const boot_qspi_cfg_t *cfg,
+                                                  boot_qspi_mem_t *out, uint32_t i);
+
+/******************************************************************************
+ * Function Name: qspi_cfg_width
+ ******************************************************************************
+ * Summary:
+ *  Returns `width` in its field at `pos` of boot_qspi_cmd_t.width.
+ *
+ ******************************************************************************/
+static uint8_t qspi_cfg_width(cy_en_smif_txfr_width_t width, uint32_t pos)
+{
+    return (uint8_t)(((uint32_t)width & BOOT_QSPI_WIDTH_MASK) << pos);
+}
+
+/******************************************************************************
+ * Function Name: qspi_cfg_pack_cmd
+ ******************************************************************************
+ * Summary:
+ *  Packs the memory command `src`, or marks it absent if NULL.
+ *
+ * Return:
+ *  0 on success, -1 if the command does not fit in boot_qspi_cmd_t.
+ *
+ ******************************************************************************/
+static int qspi_cfg_pack_cmd(const cy_stc_smif_mem_cmd_t *src, boot_qspi_cmd_t *dst)
+{
+    (void)memset(dst, 0, sizeof(*dst));
+    if (src == NULL)
+    {
+        return 0;
+    }
+
+    if ((src->command > 0xFFUL) || (src->dummyCycles > BOOT_QSPI_CMD_DUMMY_MASK) ||
+        ((src->mode != CY_SMIF_NO_COMMAND_OR_MODE) && (src->mode > 0xFFUL)))
+    {
+        return -1;
+    }
+
+    dst->cmd = (uint8_t)src->command;
+    dst->width = qspi_cfg_width(src->cmdWidth, BOOT_QSPI_WIDTH_CMD_POS) |
+                 qspi_cfg_width(src->addrWidth, BOOT_QSPI_WIDTH_ADDR_POS) |
+                 qspi_cfg_width(src->modeWidth, BOOT_QSPI_WIDTH_MODE_POS) |
+                 qspi_cfg_width(src->dataWidth, BOOT_QSPI_WIDTH_DATA_POS);
+    dst->flags = (uint8_t)(BOOT_QSPI_CMD_PRESENT | src->dummyCycles);
+    if (src->mode != CY_SMIF_NO_COMMAND_OR_MODE)
+    {
+        dst->mode = (uint8_t)src->mode;
+        dst->flags |= BOOT_QSPI_CMD_MODE;
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: qspi_cfg_unpack_cmd
+ ******************************************************************************
+ * Summary:
+ *  Rebuilds command `i` of `cfg` in `out`.
+ *
+ * Return:
+ *  The command, or NULL if the memory has none.
+ *
+ ******************************************************************************/
+static cy_stc_smif_mem_cmd_t *qspi_cfg_unpack_cmd(const boot_qspi_cfg_t *cfg,
+                                                  boot_qspi_mem_t *out, uint32_t i)
+{
+    const boot_qspi_cmd_t *src = &cfg->cmd[i];
+    cy_stc_smif_mem_cmd_t *dst = &out->cmd[i];
+
+    if ((src->flags & BOOT_QSPI_CMD_PRESENT) == 0U)
+    {
+        return NULL;
+    }
+
+    dst->command = src->cmd;
+    dst->cmdWidth = (cy_en_smif_txfr_width_t)
+                    ((src->width >> BOOT_QSPI_WIDTH_CMD_POS) & BOOT_QSPI_WIDTH_MASK);
+    dst->addrWidth = (cy_en_smif_txfr_width_t)
+                     ((src->width >> BOOT_QSPI_WIDTH_ADDR_POS) & BOOT_QSPI_WIDTH_MASK);
+    dst->mode = ((src->flags & BOOT_QSPI_CMD_MODE) != 0U) ? src->mode : CY_SMIF_NO_COMMAND_OR_MODE;
+    dst->modeWidth = (cy_en_smif_txfr_width_t)
+                     ((src->width >> BOOT_QSPI_WIDTH_MODE_POS) & BOOT_QSPI_WIDTH_MASK);
+    dst->dummyCycles = src->flags & BOOT_QSPI_CMD_DUMMY_MASK;
+    dst->dataWidth = (cy_en_smif_txfr_width_t)
+                     ((src->width >> BOOT_QSPI_WIDTH_DATA_POS) & BOOT_QSPI_WIDTH_MASK);
+    return dst;
+}
+
+/******************************************************************************
+ * Function Name: boot_qspi_cfg_pack
+ ******************************************************************************
+ * Summary:
+ *  Packs the memory configuration `mem` into `cfg`. The JEDEC ID is left
+ *  for the caller to fill in.
+ *
+ * Return:
+ *  0 on success, -1 if `mem` cannot be packed: no device configuration, a
+ *  dual quad pair, or a hybrid sector memory, whose region table is not kept.
+ *
+ ******************************************************************************/
+int boot_qspi_cfg_pack(const cy_stc_smif_mem_config_t *mem, boot_qspi_cfg_t *cfg)
+{
+    const cy_stc_smif_mem_device_cfg_t *dev = (mem != NULL) ? mem->deviceCfg : NULL;
+    const cy_stc_smif_mem_cmd_t *cmds[BOOT_QSPI_CMD_COUNT];
+
+    (void)memset(cfg, 0, sizeof(*cfg));
+    if ((dev == NULL) || (dev->readCmd == NULL) || (mem->dualQuadSlots != 0U))
+    {
+        return -1;
+    }
+#if (CY_SMIF_DRV_VERSION_MAJOR > 1) || (CY_SMIF_DRV_VERSION_MINOR >= 50)
+    if (dev->hybridRegionCount != 0U)
+    {
+        return -1;
+    }
+#endif
+
+    cmds[BOOT_QSPI_CMD_READ] = dev->readCmd;
+    cmds[BOOT_QSPI_CMD_WRITE_EN] = dev->writeEnCmd;
+    cmds[BOOT_QSPI_CMD_WRITE_DIS] = dev->writeDisCmd;
+    cmds[BOOT_QSPI_CMD_ERASE] = dev->eraseCmd;
+    cmds[BOOT_QSPI_CMD_CHIP_ERASE] = dev->chipEraseCmd;
+    cmds[BOOT_QSPI_CMD_PROGRAM] = dev->programCmd;
+    cmds[BOOT_QSPI_CMD_READ_STS_WIP] = dev->readStsRegWipCmd;
+    cmds[BOOT_QSPI_CMD_READ_STS_QE] = dev->readStsRegQeCmd;
+    cmds[BOOT_QSPI_CMD_WRITE_STS_QE] = dev->writeStsRegQeCmd;
+    cmds[BOOT_QSPI_CMD_READ_SFDP] = dev->readSfdpCmd;
+    for (uint32_t i = 0; i < BOOT_QSPI_CMD_COUNT; i++)
+    {
+        if (qspi_cfg_pack_cmd(cmds[i], &cfg->cmd[i]) != 0)
+        {
+            return -1;
+        }
+    }
+
+    cfg->addr_bytes = (uint8_t)dev->numOfAddrBytes;
+    cfg->slave_select = (uint8_t)mem->slaveSelect;
+    cfg->data_select = (uint8_t)mem->dataSelect;
+    cfg->flags = mem->flags & ~CY_SMIF_FLAG_DETECT_SFDP;
+    cfg->base_addr = mem->baseAddress;
+    cfg->mapped_size = mem->memMappedSize;
+    cfg->mem_size = dev->memSize;
+    cfg->erase_size = dev->eraseSize;
+    cfg->program_size = dev->programSize;
+    cfg->busy_mask = dev->stsRegBusyMask;
+    cfg->quad_enable_mask = dev->stsRegQuadEnableMask;
+    cfg->erase_time = dev->eraseTime;
+    cfg->chip_erase_time = dev->chipEraseTime;
+    cfg->program_time = dev->programTime;
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: boot_qspi_cfg_unpack
+ ******************************************************************************
+ * Summary:
+ *  Rebuilds the PDL memory configuration of `cfg` in `out`, as a block
+ *  configuration with that one memory for Cy_SMIF_Memslot_Init(). The
+ *  memory is not detected again.
+ *
+ * Return:
+ *  The block configuration, or NULL if `cfg` holds no configuration.
+ *
+ ******************************************************************************/
+cy_stc_smif_block_config_t *boot_qspi_cfg_unpack(const boot_qspi_cfg_t *cfg,
+                                                  boot_qspi_mem_t *out)
+{
+    cy_stc_smif_mem_device_cfg_t *dev = &out->dev;
+
+    if ((cfg->mem_size == 0U) ||
+        ((cfg->cmd[BOOT_QSPI_CMD_READ].flags & BOOT_QSPI_CMD_PRESENT) == 0U))
+    {
+        return NULL;
+    }
+
+    (void)memset(out, 0, sizeof(*out));
+    dev->numOfAddrBytes = cfg->addr_bytes;
+    dev->memSize = cfg->mem_size;
+    dev->readCmd = qspi_cfg_unpack_cmd(cfg, out, BOOT_QSPI_CMD_READ);
+    dev->writeEnCmd = qspi_cfg_unpack_cmd(cfg, out, BOOT_QSPI_CMD_WRITE_EN);
+    dev->writeDisCmd = qspi_cfg_unpack_cmd(cfg, out, BOOT_QSPI_CMD_WRITE_DIS);
+    dev->eraseCmd = qspi_cfg_unpack_cmd(cfg, out, BOOT_QSPI_CMD_ERASE);
+    dev->eraseSize = cfg->erase_size;
+    dev->chipEraseCmd = qspi_cfg_unpack_cmd(cfg, out, BOOT_QSPI_CMD_CHIP_ERASE);
+    dev->programCmd = qspi_cfg_unpack_cmd(cfg, out, BOOT_QSPI_CMD_PROGRAM);
+    dev->programSize = cfg->program_size;
+    dev->readStsRegWipCmd = qspi_cfg_unpack_cmd(cfg, out, BOOT_QSPI_CMD_READ_STS_WIP);
+    dev->readStsRegQeCmd = qspi_cfg_unpack_cmd(cfg, out, BOOT_QSPI_CMD_READ_STS_QE);
+    dev->writeStsRegQeCmd = qspi_cfg_unpack_cmd(cfg, out, BOOT_QSPI_CMD_WRITE_STS_QE);
+    dev->readSfdpCmd = qspi_cfg_unpack_cmd(cfg, out, BOOT_QSPI_CMD_READ_SFDP);
+    dev->stsRegBusyMask = cfg->busy_mask;
+    dev->stsRegQuadEnableMask = cfg->quad_enable_mask;
+    dev->eraseTime = cfg->erase_time;
+    dev->chipEraseTime = cfg->chip_erase_time;
+    dev->programTime = cfg->program_time;
+
+    out->mem.slaveSelect = (cy_en_smif_slave_select_t)cfg->slave_select;
+    out->mem.flags = cfg->flags;
+    out->mem.dataSelect = (cy_en_smif_data_select_t)cfg->data_select;
+    out->mem.baseAddress = cfg->base_addr;
+    out->mem.memMappedSize = cfg->mapped_size;
+    out->mem.deviceCfg = dev;
+
+    out->mem_list[0] = &out->mem;
+    out->block.memCount = 1U;
+    out->block.memConfig = out->mem_list;
+    out->block.majorVersion = CY_SMIF_DRV_VERSION_MAJOR;
+    out->block.minorVersion = CY_SMIF_DRV_VERSION_MINOR;
+    return &out->block;
+}
+
+/* [] END OF FILE */
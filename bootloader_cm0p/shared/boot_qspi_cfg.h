@@ -0,0 +1,63 @@
+/******************************************************************************
+* File Name:   boot_qspi_cfg.h
+*
+* Description:
+* This file declares the conversion between the PDL SMIF memory configuration
+* and its packed form boot_qspi_cfg_t, which the bootloader keeps in flash and
+* hands to the CM4 application.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef BOOT_QSPI_CFG_H_
+#define BOOT_QSPI_CFG_H_
+
+#include "cy_pdl.h"
+#include "boot_shared.h"
+
+/* PDL memory configuration rebuilt from a boot_qspi_cfg_t. The driver keeps
+ * pointers into it, so it must stay allocated while the memory is in use.
+ */
+typedef struct
+{
+    cy_stc_smif_mem_cmd_t cmd[BOOT_QSPI_CMD_COUNT];
+    cy_stc_smif_mem_device_cfg_t dev;
+    cy_stc_smif_mem_config_t mem;
+    cy_stc_smif_mem_config_t *mem_list[1];
+    cy_stc_smif_block_config_t block;
+} boot_qspi_mem_t;
+
+int boot_qspi_cfg_pack(const cy_stc_smif_mem_config_t *mem, boot_qspi_cfg_t *cfg);
+cy_stc_smif_block_config_t *boot_qspi_cfg_unpack(const boot_qspi_cfg_t *cfg,
+                                                  boot_qspi_mem_t *out);
+
+#endif /* BOOT_QSPI_CFG_H_ */
@@ -0,0 +1,186 @@
+/******************************************************************************
+* File Name:   boot_shared.h
+*
+* Description:
+* This file describes the block of RAM the bootloader leaves for the CM4
+* application. It sits in the last bytes of the bootloader RAM, which the CM4
+* application does not use, so the block survives the start of CM4.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef BOOT_SHARED_H_
+#define BOOT_SHARED_H_
+
+#include <stdint.h>
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#define BOOT_SHARED_MAGIC                       (0x48534243UL)  /* "CBSH" */
+#define BOOT_SHARED_VERSION                     (1U)
+
+/* Address of the block. CY_BOOT_BOOTLOADER_RAM_SIZE and CY_BOOT_SHARED_RAM_SIZE
+ * come from config.mk; the bootloader linker script places the block at the
+ * same address.
+ */
+#define BOOT_SHARED_ADDR                        (CY_SRAM_BASE + CY_BOOT_BOOTLOADER_RAM_SIZE - \
+                                                 CY_BOOT_SHARED_RAM_SIZE)
+
+/* Entries of boot_shared_t.phases. */
+#define BOOT_SHARED_PHASES_MAX                  (16U)
+
+/* Boot phases timed by the bootloader. */
+#define BOOT_PHASE_HW_INIT                      (1U)    /* Clocks, peripherals, pins, UART */
+#define BOOT_PHASE_SMIF_INIT                    (2U)    /* qspi_init_sfdp() */
+#define BOOT_PHASE_PATCH                        (3U)    /* Patch upgrades */
+#define BOOT_PHASE_COMPRESS                     (4U)    /* Compressed upgrades */
+#define BOOT_PHASE_CONCURRENT                   (5U)    /* Concurrent upgrade */
+#define BOOT_PHASE_SLOT_FLIP                    (6U)    /* Wi-Fi firmware slot choice */
+#define BOOT_PHASE_BOOT_GO                      (7U)    /* MCUboot boot_go() */
+#define BOOT_PHASE_VALIDATE                     (8U)    /* Primary slot validation */
+#define BOOT_PHASE_UART_FLUSH                   (9U)    /* Hand over or wait for the log output */
+#define BOOT_PHASE_HEADER                       (10U)   /* Image header reads, per image */
+#define BOOT_PHASE_IMAGE_CHECK                  (11U)   /* Hash and signature checks, per image */
+#define BOOT_PHASE_COPY                         (12U)   /* Primary slot erases and writes, per image */
+#define BOOT_PHASE_FAST_CHECK                   (13U)   /* Pending upgrade check */
+
+/* boot_phase_t.image of the phases that are not about one image. */
+#define BOOT_PHASE_NO_IMAGE                     (0xFFU)
+
+/* Bytes of boot_shared_t.log. The bootloader hands over at most this much of
+ * its log output that the UART had not sent when CM4 was started.
+ */
+#define BOOT_SHARED_LOG_SIZE                    (1536U)
+
+/* Bytes of the JEDEC ID (manufacturer, memory type, density). */
+#define BOOT_QSPI_ID_SIZE                       (3U)
+
+/* Entries of boot_qspi_cfg_t.cmd. */
+#define BOOT_QSPI_CMD_READ                      (0U)
+#define BOOT_QSPI_CMD_WRITE_EN                  (1U)
+#define BOOT_QSPI_CMD_WRITE_DIS                 (2U)
+#define BOOT_QSPI_CMD_ERASE                     (3U)
+#define BOOT_QSPI_CMD_CHIP_ERASE                (4U)
+#define BOOT_QSPI_CMD_PROGRAM                   (5U)
+#define BOOT_QSPI_CMD_READ_STS_WIP              (6U)
+#define BOOT_QSPI_CMD_READ_STS_QE               (7U)
+#define BOOT_QSPI_CMD_WRITE_STS_QE              (8U)
+#define BOOT_QSPI_CMD_READ_SFDP                 (9U)
+#define BOOT_QSPI_CMD_COUNT                     (10U)
+
+/* boot_qspi_cmd_t.flags: the command exists, it sends a mode byte, and its
+ * dummy cycles.
+ */
+#define BOOT_QSPI_CMD_PRESENT                   (0x80U)
+#define BOOT_QSPI_CMD_MODE                      (0x40U)
+#define BOOT_QSPI_CMD_DUMMY_MASK                (0x1FU)
+
+/* boot_qspi_cmd_t.width: cy_en_smif_txfr_width_t of each part, two bits each. */
+#define BOOT_QSPI_WIDTH_CMD_POS                 (0U)
+#define BOOT_QSPI_WIDTH_ADDR_POS                (2U)
+#define BOOT_QSPI_WIDTH_MODE_POS                (4U)
+#define BOOT_QSPI_WIDTH_DATA_POS                (6U)
+#define BOOT_QSPI_WIDTH_MASK                    (0x03U)
+
+/*******************************************************************************
+* Data structures
+********************************************************************************/
+/* Time spent in one boot phase, in ticks of boot_shared_t.timer_hz counted
+ * from the start of the bootloader's main(). A phase that runs several times
+ * has one entry with the total time.
+ */
+typedef struct
+{
+    uint8_t phase;              /* BOOT_PHASE_* */
+    uint8_t image;              /* Image 0 or 1, or BOOT_PHASE_NO_IMAGE */
+    uint16_t count;             /* Times the phase ran */
+    uint32_t start;             /* Tick count when it first started */
+    uint32_t ticks;             /* Ticks spent in it */
+} boot_phase_t;
+
+/* One SMIF memory command, a packed cy_stc_smif_mem_cmd_t. */
+typedef struct
+{
+    uint8_t cmd;                /* Instruction */
+    uint8_t mode;               /* Mode byte, if BOOT_QSPI_CMD_MODE */
+    uint8_t width;              /* BOOT_QSPI_WIDTH_* fields */
+    uint8_t flags;              /* BOOT_QSPI_CMD_* */
+} boot_qspi_cmd_t;
+
+/* External memory configuration found by the SFDP detection of the PDL, a
+ * packed cy_stc_smif_mem_config_t and its device configuration. The
+ * bootloader keeps it across boots (ext_flash_sfdp_cache.c) and hands it to
+ * the application, which can then skip the detection.
+ */
+typedef struct
+{
+    uint8_t id[BOOT_QSPI_ID_SIZE];  /* JEDEC ID of the memory */
+    uint8_t addr_bytes;         /* Address bytes of the memory commands */
+    uint8_t slave_select;       /* cy_en_smif_slave_select_t */
+    uint8_t data_select;        /* cy_en_smif_data_select_t */
+    uint16_t reserved;
+    uint32_t flags;             /* CY_SMIF_FLAG_*, without CY_SMIF_FLAG_DETECT_SFDP */
+    uint32_t base_addr;         /* XIP address of the memory */
+    uint32_t mapped_size;       /* Size of its XIP window */
+    uint32_t mem_size;          /* Memory size in bytes, 0 if no configuration */
+    uint32_t erase_size;
+    uint32_t program_size;
+    uint32_t busy_mask;         /* Status register bit set while busy */
+    uint32_t quad_enable_mask;  /* Status register bit enabling quad I/O */
+    uint32_t erase_time;        /* Maximum times, in the units of the PDL */
+    uint32_t chip_erase_time;
+    uint32_t program_time;
+    boot_qspi_cmd_t cmd[BOOT_QSPI_CMD_COUNT];
+} boot_qspi_cfg_t;
+
+/* Written by the bootloader before it starts CM4. Fields are only added at
+ * the end; `size` tells the application which of them the bootloader wrote.
+ */
+typedef struct
+{
+    uint32_t magic;             /* BOOT_SHARED_MAGIC */
+    uint16_t version;           /* BOOT_SHARED_VERSION */
+    uint16_t size;              /* sizeof(boot_shared_t) of the bootloader */
+    uint32_t wifi_slot_addr;    /* XIP address of the image 2 slot in use, 0 if not chosen */
+    uint32_t timer_hz;          /* Rate of the tick counts below, 0 if not timed */
+    uint32_t boot_ticks;        /* Ticks from main() to starting CM4 */
+    uint16_t phase_count;       /* Entries of `phases` used */
+    uint16_t phase_dropped;     /* Phases not recorded for lack of entries */
+    boot_phase_t phases[BOOT_SHARED_PHASES_MAX];
+    boot_qspi_cfg_t qspi;       /* External memory configuration, mem_size 0 if none */
+    uint16_t log_len;           /* Bytes of `log` the UART had not sent */
+    uint16_t log_dropped;       /* Log bytes lost for lack of room */
+    uint8_t log[BOOT_SHARED_LOG_SIZE];  /* Log output for the application to print */
+} boot_shared_t;
+
+#endif /* BOOT_SHARED_H_ */
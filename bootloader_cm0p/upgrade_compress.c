@@ -0,0 +1,283 @@
+/******************************************************************************
+* File Name:   upgrade_compress.c
+*
+* Description:
+* This file implements the compressed image upgrade. A compressed image is a
+* signed image whose payload is an upgrade_lz4_hdr_t and an LZ4 block that
+* expands to the signed image to install; app_cm4/script/image_compress.py
+* makes the payload and the sign scripts sign it like an image. The OTA agent
+* writes it to the secondary slot and marks it pending like an image.
+*
+* Before MCUboot runs, the bootloader validates the compressed image, erases
+* the primary slot and expands the block into it, and validates the result.
+* It then clears the pending state by erasing the trailer of the secondary
+* slot, so MCUboot finds no upgrade and validates the primary slot as usual.
+* A reset while expanding leaves the secondary slot pending, and the next
+* boot expands the image again from the start. So does a failed expansion:
+* the secondary slot stays pending and the device is reset to try again,
+* up to CY_BOOT_COMPRESS_RETRIES times in a row counted in a backup register.
+* The boot then stops before MCUboot, which would otherwise install the
+* compressed image as it is.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "flash_map_backend/flash_map_backend.h"
+#include "sysflash.h"
+#include "mcuboot_config/mcuboot_config.h"
+#include "bootutil/bootutil.h"
+#include "bootutil/image.h"
+#include "bootutil/bootutil_log.h"
+
+#include "cy_pdl.h"
+#include "ext_flash_map.h"
+#include "boot_validate.h"
+#include "upgrade_lz4.h"
+#include "upgrade_compress.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#ifndef CY_BOOT_UPGRADE_COMPRESS
+#if defined(MCUBOOT_OVERWRITE_ONLY) && defined(MCUBOOT_USE_FLASH_AREA_GET_SECTORS)
+#define CY_BOOT_UPGRADE_COMPRESS                (1)
+#else
+#define CY_BOOT_UPGRADE_COMPRESS                (0)
+#endif
+#endif
+
+#ifndef CY_BOOT_COMPRESS_RETRIES
+/* Resets in a row that retry a failed expansion before the boot stops. */
+#define CY_BOOT_COMPRESS_RETRIES                (3U)
+#endif
+
+#ifndef CY_BOOT_COMPRESS_BREG
+/* Backup register counting the retries. It keeps its value across the
+ * resets; a power loss restarts the count.
+ */
+#define CY_BOOT_COMPRESS_BREG                   (14U)
+#endif
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+static upgrade_compress_stats_t compress_stats;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+#if (CY_BOOT_UPGRADE_COMPRESS != 0)
+static bool compress_hdr_valid(const upgrade_lz4_hdr_t *lz, const struct image_header *hdr,
+                               const struct flash_area *pri);
+static void compress_clear_pending(const struct flash_area *sec);
+static int compress_apply_image(int image);
+#endif
+
+#if (CY_BOOT_UPGRADE_COMPRESS != 0)
+/******************************************************************************
+ * Function Name: compress_hdr_valid
+ ******************************************************************************
+ * Summary:
+ *  Returns true if `lz` starts the payload of the image `hdr` and describes
+ *  a block inside the payload that expands to fit the primary slot `pri`.
+ *
+ ******************************************************************************/
+static bool compress_hdr_valid(const upgrade_lz4_hdr_t *lz, const struct image_header *hdr,
+                               const struct flash_area *pri)
+{
+    return (lz->magic == UPGRADE_LZ4_MAGIC) && (lz->version == UPGRADE_LZ4_VERSION) &&
+           (lz->hdr_size >= sizeof(upgrade_lz4_hdr_t)) && (lz->hdr_size <= hdr->ih_img_size) &&
+           (lz->block_size != 0U) && (lz->block_size <= (hdr->ih_img_size - lz->hdr_size)) &&
+           (lz->size != 0U) && (lz->size < pri->fa_size);
+}
+
+/******************************************************************************
+ * Function Name: compress_clear_pending
+ ******************************************************************************
+ * Summary:
+ *  Erases the last sector of the secondary slot, which holds the trailer
+ *  that marks the slot pending, so that MCUboot never installs the
+ *  compressed image itself.
+ *
+ ******************************************************************************/
+static void compress_clear_pending(const struct flash_area *sec)
+{
+    uint32_t start;
+    uint32_t size;
+
+    if ((flash_area_sector_of(sec, sec->fa_size - 1U, &start, &size) != 0) ||
+        (flash_area_erase(sec, start, size) != 0))
+    {
+        BOOT_LOG_ERR("Secondary slot trailer could not be erased");
+    }
+}
+
+/******************************************************************************
+ * Function Name: compress_apply_image
+ ******************************************************************************
+ * Summary:
+ *  Expands a pending compressed image in the secondary slot of `image` into
+ *  its primary slot.
+ *
+ * Return:
+ *  0, or -1 if the primary slot was erased but no valid image was expanded
+ *  into it. The secondary slot is then left pending.
+ *
+ ******************************************************************************/
+static int compress_apply_image(int image)
+{
+    const struct flash_area *pri;
+    const struct flash_area *sec;
+    struct image_header hdr;
+    upgrade_lz4_hdr_t lz;
+    int swap_type = boot_swap_type_multi(image);
+
+    if (((swap_type != BOOT_SWAP_TYPE_TEST) && (swap_type != BOOT_SWAP_TYPE_PERM)) ||
+        (flash_area_open(FLASH_AREA_IMAGE_PRIMARY(image), &pri) != 0) ||
+        (flash_area_open(FLASH_AREA_IMAGE_SECONDARY(image), &sec) != 0))
+    {
+        return 0;
+    }
+
+    if ((flash_area_read(sec, 0U, &hdr, sizeof(hdr)) != 0) || (hdr.ih_magic != IMAGE_MAGIC) ||
+        (flash_area_read(sec, hdr.ih_hdr_size, &lz, sizeof(lz)) != 0) ||
+        !compress_hdr_valid(&lz, &hdr, pri))
+    {
+        return 0;
+    }
+
+    /* An invalid image is left to MCUboot, which rejects it. */
+    if (boot_image_validate(image, sec) != 0)
+    {
+        BOOT_LOG_ERR("Image %d compressed image is not valid", image);
+        compress_stats.failed++;
+        return 0;
+    }
+
+    BOOT_LOG_INF("Image %d expanding %u bytes from a %u byte compressed image", image,
+                 (unsigned int)lz.size, (unsigned int)lz.block_size);
+    compress_stats.compressed_bytes += lz.block_size;
+
+    if ((flash_area_erase(pri, 0U, pri->fa_size) != 0) ||
+        (upgrade_lz4_expand(sec, (uint32_t)hdr.ih_hdr_size + lz.hdr_size, lz.block_size,
+                            pri, lz.size) != 0))
+    {
+        BOOT_LOG_ERR("Image %d compressed image could not be expanded", image);
+        compress_stats.failed++;
+        return -1;
+    }
+    if (boot_image_validate(image, pri) != 0)
+    {
+        BOOT_LOG_ERR("Image %d expanded image is not valid", image);
+        compress_stats.failed++;
+        return -1;
+    }
+
+    compress_stats.expanded++;
+    compress_stats.expanded_bytes += lz.size;
+    compress_clear_pending(sec);
+    return 0;
+}
+#endif
+
+/******************************************************************************
+ * Function Name: upgrade_compress_apply
+ ******************************************************************************
+ * Summary:
+ *  Called before boot_go(). Installs each pending compressed image in a
+ *  secondary slot by expanding it into the primary slot.
+ *
+ *  If an expansion fails after erasing its primary slot, the compressed
+ *  image stays pending and the caller resets the device to expand it again,
+ *  up to CY_BOOT_COMPRESS_RETRIES times in a row. The count is kept in
+ *  backup register CY_BOOT_COMPRESS_BREG and restarts after a pass without
+ *  failures, a power loss or the last retry.
+ *
+ * Return:
+ *  0, UPGRADE_COMPRESS_RETRY if an expansion failed and the caller must
+ *  reset the device, or -1 if it failed on the last retry too. The caller
+ *  must then not run boot_go(), which would install the compressed image as
+ *  it is; the primary slot stays empty until the next reset tries again.
+ *
+ ******************************************************************************/
+int upgrade_compress_apply(void)
+{
+    int rc = 0;
+
+#if (CY_BOOT_UPGRADE_COMPRESS != 0)
+    for (int image = 0; image < MCUBOOT_IMAGE_NUMBER; image++)
+    {
+        if (compress_apply_image(image) != 0)
+        {
+            rc = -1;
+        }
+    }
+
+    if (rc == 0)
+    {
+        BACKUP->BREG[CY_BOOT_COMPRESS_BREG] = 0U;
+    }
+    else if (BACKUP->BREG[CY_BOOT_COMPRESS_BREG] < CY_BOOT_COMPRESS_RETRIES)
+    {
+        BACKUP->BREG[CY_BOOT_COMPRESS_BREG]++;
+        BOOT_LOG_ERR("Compressed upgrade failed, resetting to retry (%u of %u)",
+                     (unsigned int)BACKUP->BREG[CY_BOOT_COMPRESS_BREG],
+                     (unsigned int)CY_BOOT_COMPRESS_RETRIES);
+        rc = UPGRADE_COMPRESS_RETRY;
+    }
+    else
+    {
+        BACKUP->BREG[CY_BOOT_COMPRESS_BREG] = 0U;
+        BOOT_LOG_ERR("Compressed upgrade failed after %u retries, giving up",
+                     (unsigned int)CY_BOOT_COMPRESS_RETRIES);
+    }
+#endif
+    return rc;
+}
+
+/******************************************************************************
+ * Function Name: upgrade_compress_get_stats
+ ******************************************************************************
+ * Summary:
+ *  Returns the compressed upgrade counters since reset.
+ *
+ ******************************************************************************/
+const upgrade_compress_stats_t *upgrade_compress_get_stats(void)
+{
+    return &compress_stats;
+}
+
+/* [] END OF FILE */
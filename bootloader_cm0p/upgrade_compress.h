@@ -0,0 +1,60 @@
+/******************************************************************************
+* File Name:   upgrade_compress.h
+*
+* Description:
+* This file declares the compressed image upgrade, which expands a compressed
+* image in a secondary slot into its primary slot before MCUboot runs.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef UPGRADE_COMPRESS_H_
+#define UPGRADE_COMPRESS_H_
+
+#include <stdint.h>
+
+/* upgrade_compress_apply() result: reset the device to expand again. */
+#define UPGRADE_COMPRESS_RETRY                  (1)
+
+/* Compressed upgrade activity since reset. */
+typedef struct
+{
+    uint32_t expanded;          /* Images expanded into a primary slot */
+    uint32_t failed;            /* Compressed images rejected or not expanding */
+    uint32_t compressed_bytes;  /* Size of the LZ4 blocks read */
+    uint32_t expanded_bytes;    /* Image bytes written */
+} upgrade_compress_stats_t;
+
+int upgrade_compress_apply(void);
+const upgrade_compress_stats_t *upgrade_compress_get_stats(void);
+
+#endif /* UPGRADE_COMPRESS_H_ */
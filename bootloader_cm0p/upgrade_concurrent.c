@@ -0,0 +1,485 @@
+/******************************************************************************
+* File Name:   upgrade_concurrent.c
+*
+* Description:
+* This file implements the concurrent upgrade. With pending upgrades of both
+* images, MCUboot copies image 1 into the internal flash and then image 2
+* into the external flash, so the downtime is the sum of the two copies, and
+* each device idles while the other one works. This pass runs before
+* boot_go() and interleaves the two overwrite-only copies instead: the
+* external sector erases run in the background while the internal flash
+* erases or programs rows, and the external copy is done while an internal
+* row programs. As the external memory cannot be read while it erases, the
+* secondary slot data of the internal image is read ahead into a RAM ring.
+*
+* Each copy is validated and its secondary slot header and trailer erased
+* the way MCUboot does, which leaves MCUboot nothing to install. A reset
+* before that leaves the upgrade pending, and the progress journal lets the
+* next boot resume it. An image whose copy fails is left to MCUboot.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "flash_map_backend/flash_map_backend.h"
+#include "sysflash.h"
+#include "mcuboot_config/mcuboot_config.h"
+#include "bootutil/bootutil.h"
+#include "bootutil/image.h"
+#include "bootutil/bootutil_log.h"
+
+#include "cy_pdl.h"
+#include "ext_flash_map.h"
+#include "boot_validate.h"
+#include "upgrade_concurrent.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#ifndef CY_BOOT_UPGRADE_CONCURRENT
+#if defined(MCUBOOT_OVERWRITE_ONLY) && defined(MCUBOOT_USE_FLASH_AREA_GET_SECTORS) && \
+    defined(CY_BOOT_USE_EXTERNAL_FLASH) && (MCUBOOT_IMAGE_NUMBER > 1)
+#define CY_BOOT_UPGRADE_CONCURRENT              (1)
+#else
+#define CY_BOOT_UPGRADE_CONCURRENT              (0)
+#endif
+#endif
+
+#ifndef CY_BOOT_CONCURRENT_BUF_SIZE
+/* Secondary slot data of the internal flash image read ahead into RAM, a
+ * multiple of the row size. An external sector erase takes about as long
+ * as programming 100 erased rows (50 KB); the default covers most of it.
+ */
+#define CY_BOOT_CONCURRENT_BUF_SIZE             (0x8000U)
+#endif
+
+#if ((CY_BOOT_CONCURRENT_BUF_SIZE % CY_FLASH_SIZEOF_ROW) != 0U) || \
+    (CY_BOOT_CONCURRENT_BUF_SIZE == 0U)
+#error "CY_BOOT_CONCURRENT_BUF_SIZE must be a non-zero multiple of the row size"
+#endif
+
+/* Bytes of the external flash image copied per step, like MCUboot. */
+#define CONCURRENT_CHUNK_SIZE                   (1024U)
+
+/* Secondary slot sectors erased after the copy: the header and the trailer. */
+#define CONCURRENT_CLEAR_SECTORS                (2U)
+
+/*******************************************************************************
+* Data types
+********************************************************************************/
+/* Where the upgrade of one image stands. */
+typedef enum
+{
+    CONCURRENT_ERASE,           /* Erasing the primary slot */
+    CONCURRENT_COPY,            /* Writing the primary slot */
+    CONCURRENT_CLEAR,           /* Validating it, erasing the secondary slot */
+    CONCURRENT_DONE
+} concurrent_step_t;
+
+/* Upgrade of one image. */
+typedef struct
+{
+    int image;
+    const struct flash_area *pri;
+    const struct flash_area *sec;
+    concurrent_step_t step;
+    uint32_t size;              /* Bytes to copy: the image and its TLVs */
+    uint32_t erased;            /* Primary slot bytes erased */
+    uint32_t copied;            /* Primary slot bytes written */
+    uint32_t staged;            /* Secondary slot bytes read into the ring */
+    uint32_t cleared;           /* Secondary slot sectors erased */
+} concurrent_copy_t;
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+#if (CY_BOOT_UPGRADE_CONCURRENT != 0)
+static uint32_t concurrent_ring[CY_BOOT_CONCURRENT_BUF_SIZE / sizeof(uint32_t)];
+static uint32_t concurrent_chunk[CONCURRENT_CHUNK_SIZE / sizeof(uint32_t)];
+#endif
+static upgrade_concurrent_stats_t concurrent_stats;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+#if (CY_BOOT_UPGRADE_CONCURRENT != 0)
+static int concurrent_open(concurrent_copy_t *copy, int image);
+static void concurrent_fail(concurrent_copy_t *copy, const char *what);
+static void concurrent_erase(concurrent_copy_t *copy);
+static void concurrent_stage(concurrent_copy_t *copy);
+static void concurrent_write_row(concurrent_copy_t *copy);
+static void concurrent_write_chunk(concurrent_copy_t *copy);
+static void concurrent_clear(concurrent_copy_t *copy);
+static void concurrent_run(concurrent_copy_t *in, concurrent_copy_t *ex);
+#endif
+
+#if (CY_BOOT_UPGRADE_CONCURRENT != 0)
+/******************************************************************************
+ * Function Name: concurrent_open
+ ******************************************************************************
+ * Summary:
+ *  Sets up the upgrade of `image` if it has a pending upgrade with an image
+ *  that fits its primary slot. The image is not validated yet.
+ *
+ * Return:
+ *  0 if the image is to be upgraded.
+ *
+ ******************************************************************************/
+static int concurrent_open(concurrent_copy_t *copy, int image)
+{
+    int swap_type = boot_swap_type_multi(image);
+    struct image_header hdr;
+    uint32_t align;
+
+    memset(copy, 0, sizeof(*copy));
+    copy->image = image;
+
+    if (((swap_type != BOOT_SWAP_TYPE_TEST) && (swap_type != BOOT_SWAP_TYPE_PERM)) ||
+        (flash_area_open(FLASH_AREA_IMAGE_PRIMARY(image), &copy->pri) != 0) ||
+        (flash_area_open(FLASH_AREA_IMAGE_SECONDARY(image), &copy->sec) != 0) ||
+        (boot_image_tlv(copy->sec, &hdr, &copy->size, 0U, NULL, 0U) != 0))
+    {
+        return -1;
+    }
+
+    align = (copy->pri->fa_device_id == FLASH_DEVICE_INTERNAL_FLASH) ?
+            CY_FLASH_SIZEOF_ROW : (uint32_t)flash_area_align(copy->pri);
+    copy->size = ((copy->size + align - 1U) / align) * align;
+
+    return ((copy->size <= copy->pri->fa_size) && (copy->size <= copy->sec->fa_size)) ? 0 : -1;
+}
+
+/******************************************************************************
+ * Function Name: concurrent_fail
+ ******************************************************************************
+ * Summary:
+ *  Stops the upgrade of `copy` after `what` failed. Its secondary slot stays
+ *  pending, so that MCUboot installs it.
+ *
+ ******************************************************************************/
+static void concurrent_fail(concurrent_copy_t *copy, const char *what)
+{
+    BOOT_LOG_ERR("Image %d concurrent upgrade: %s failed", copy->image, what);
+    concurrent_stats.failed++;
+    copy->step = CONCURRENT_DONE;
+}
+
+/******************************************************************************
+ * Function Name: concurrent_erase
+ ******************************************************************************
+ * Summary:
+ *  Erases the next erase granule of the primary slot of `copy`, the whole
+ *  slot like MCUboot. An external erase is left running.
+ *
+ ******************************************************************************/
+static void concurrent_erase(concurrent_copy_t *copy)
+{
+    uint32_t size;
+
+    if ((flash_area_erase_granule(copy->pri, copy->erased, &size) != 0) ||
+        (flash_area_erase_start(copy->pri, copy->erased, size) != 0))
+    {
+        concurrent_fail(copy, "erase");
+        return;
+    }
+
+    copy->erased += size;
+    if (copy->erased >= copy->pri->fa_size)
+    {
+        copy->step = CONCURRENT_COPY;
+    }
+}
+
+/******************************************************************************
+ * Function Name: concurrent_stage
+ ******************************************************************************
+ * Summary:
+ *  Fills the ring with the secondary slot data of `copy` that follows what
+ *  it already holds, as far as the rows not written yet leave room.
+ *
+ ******************************************************************************/
+static void concurrent_stage(concurrent_copy_t *copy)
+{
+    while (((copy->step == CONCURRENT_ERASE) || (copy->step == CONCURRENT_COPY)) &&
+           (copy->staged < copy->size) &&
+           ((copy->staged - copy->copied) < CY_BOOT_CONCURRENT_BUF_SIZE))
+    {
+        uint32_t pos = copy->staged % CY_BOOT_CONCURRENT_BUF_SIZE;
+        uint32_t len = CY_BOOT_CONCURRENT_BUF_SIZE - pos;
+
+        if (len > (CY_BOOT_CONCURRENT_BUF_SIZE - (copy->staged - copy->copied)))
+        {
+            len = CY_BOOT_CONCURRENT_BUF_SIZE - (copy->staged - copy->copied);
+        }
+        if (len > (copy->size - copy->staged))
+        {
+            len = copy->size - copy->staged;
+        }
+
+        if (flash_area_read(copy->sec, copy->staged, (uint8_t *)concurrent_ring + pos, len) != 0)
+        {
+            concurrent_fail(copy, "read");
+            return;
+        }
+        copy->staged += len;
+    }
+}
+
+/******************************************************************************
+ * Function Name: concurrent_write_row
+ ******************************************************************************
+ * Summary:
+ *  Starts programming the next internal flash row of `copy` from the ring.
+ *  The row data is staged by the flash map, so its ring space is free once
+ *  this returns.
+ *
+ ******************************************************************************/
+static void concurrent_write_row(concurrent_copy_t *copy)
+{
+    uint32_t pos = copy->copied % CY_BOOT_CONCURRENT_BUF_SIZE;
+
+    if (flash_area_write(copy->pri, copy->copied, (uint8_t *)concurrent_ring + pos,
+                         CY_FLASH_SIZEOF_ROW) != 0)
+    {
+        concurrent_fail(copy, "write");
+        return;
+    }
+
+    copy->copied += CY_FLASH_SIZEOF_ROW;
+    concurrent_stats.copied_bytes += CY_FLASH_SIZEOF_ROW;
+    if (copy->copied >= copy->size)
+    {
+        copy->step = CONCURRENT_CLEAR;
+    }
+}
+
+/******************************************************************************
+ * Function Name: concurrent_write_chunk
+ ******************************************************************************
+ * Summary:
+ *  Copies the next chunk of the external flash image of `copy`.
+ *
+ ******************************************************************************/
+static void concurrent_write_chunk(concurrent_copy_t *copy)
+{
+    uint32_t len = copy->size - copy->copied;
+
+    if (len > CONCURRENT_CHUNK_SIZE)
+    {
+        len = CONCURRENT_CHUNK_SIZE;
+    }
+
+    if ((flash_area_read(copy->sec, copy->copied, concurrent_chunk, len) != 0) ||
+        (flash_area_write(copy->pri, copy->copied, concurrent_chunk, len) != 0))
+    {
+        concurrent_fail(copy, "copy");
+        return;
+    }
+
+    copy->copied += len;
+    concurrent_stats.copied_bytes += len;
+    if (copy->copied >= copy->size)
+    {
+        copy->step = CONCURRENT_CLEAR;
+    }
+}
+
+/******************************************************************************
+ * Function Name: concurrent_clear
+ ******************************************************************************
+ * Summary:
+ *  Once the primary slot of `copy` holds a valid image, erases the first
+ *  and the last sector of the secondary slot, one per call, like MCUboot
+ *  after an overwrite. The erase is left running.
+ *
+ ******************************************************************************/
+static void concurrent_clear(concurrent_copy_t *copy)
+{
+    uint32_t start;
+    uint32_t size;
+
+    if ((copy->cleared == 0U) && ((flash_area_sync() != 0) ||
+                                  (boot_image_validate(copy->image, copy->pri) != 0)))
+    {
+        concurrent_fail(copy, "validation");
+        return;
+    }
+
+    if ((flash_area_sector_of(copy->sec, (copy->cleared == 0U) ? 0U : (copy->sec->fa_size - 1U),
+                              &start, &size) != 0) ||
+        (flash_area_erase_start(copy->sec, start, size) != 0))
+    {
+        concurrent_fail(copy, "secondary slot erase");
+        return;
+    }
+
+    copy->cleared++;
+    if (copy->cleared >= CONCURRENT_CLEAR_SECTORS)
+    {
+        concurrent_stats.installed++;
+        copy->step = CONCURRENT_DONE;
+    }
+}
+
+/******************************************************************************
+ * Function Name: concurrent_run
+ ******************************************************************************
+ * Summary:
+ *  Upgrades the internal flash image `in` and the external flash image `ex`
+ *  together. The internal flash is erased, then programmed row by row from
+ *  the ring in the background. Whenever the external memory is not busy,
+ *  the ring is filled first, then the next external step is started: an
+ *  erase of the external primary slot, a chunk of its copy, or the erase of
+ *  a secondary slot once its copy is validated.
+ *
+ ******************************************************************************/
+static void concurrent_run(concurrent_copy_t *in, concurrent_copy_t *ex)
+{
+    while ((in->step != CONCURRENT_DONE) || (ex->step != CONCURRENT_DONE))
+    {
+        if (in->step == CONCURRENT_ERASE)
+        {
+            concurrent_erase(in);
+        }
+        else if ((in->step == CONCURRENT_COPY) && (in->copied < in->staged) &&
+                 !flash_area_busy(in->pri))
+        {
+            concurrent_write_row(in);
+        }
+
+        if (!flash_area_busy(ex->pri))
+        {
+            concurrent_stage(in);
+
+            if (ex->step == CONCURRENT_ERASE)
+            {
+                concurrent_erase(ex);
+            }
+            else if (ex->step == CONCURRENT_COPY)
+            {
+                concurrent_write_chunk(ex);
+            }
+            else if (ex->step == CONCURRENT_CLEAR)
+            {
+                concurrent_clear(ex);
+            }
+            else if (in->step == CONCURRENT_CLEAR)
+            {
+                concurrent_clear(in);
+            }
+        }
+        else if ((in->step != CONCURRENT_ERASE) &&
+                 ((in->step != CONCURRENT_COPY) || (in->copied >= in->staged)) &&
+                 (flash_area_wait(ex->pri) != 0))
+        {
+            /* Nothing to overlap with the external erase, so it is waited
+             * for with the timeout of the memory.
+             */
+            if (in->step != CONCURRENT_DONE)
+            {
+                concurrent_fail(in, "external flash wait");
+            }
+            if (ex->step != CONCURRENT_DONE)
+            {
+                concurrent_fail(ex, "external flash wait");
+            }
+        }
+    }
+
+    /* The last secondary slot erase. If it did not complete, the slot may
+     * still be pending, and MCUboot installs the image again.
+     */
+    if (flash_area_wait(ex->pri) != 0)
+    {
+        BOOT_LOG_ERR("Concurrent upgrade: secondary slot erase did not complete");
+        concurrent_stats.failed++;
+    }
+}
+#endif
+
+/******************************************************************************
+ * Function Name: upgrade_concurrent_apply
+ ******************************************************************************
+ * Summary:
+ *  Called before boot_go(). If both images have a valid pending upgrade,
+ *  one in the internal flash and one in the external flash, installs them
+ *  with interleaved copies.
+ *
+ ******************************************************************************/
+void upgrade_concurrent_apply(void)
+{
+#if (CY_BOOT_UPGRADE_CONCURRENT != 0)
+    concurrent_copy_t copy[2];
+    concurrent_copy_t *in;
+    concurrent_copy_t *ex;
+
+    if ((concurrent_open(&copy[0], 0) != 0) || (concurrent_open(&copy[1], 1) != 0))
+    {
+        return;
+    }
+
+    in = (copy[0].pri->fa_device_id == FLASH_DEVICE_INTERNAL_FLASH) ? &copy[0] : &copy[1];
+    ex = (in == &copy[0]) ? &copy[1] : &copy[0];
+    if ((in->pri->fa_device_id != FLASH_DEVICE_INTERNAL_FLASH) ||
+        ((ex->pri->fa_device_id & FLASH_DEVICE_EXTERNAL_FLAG) != FLASH_DEVICE_EXTERNAL_FLAG))
+    {
+        return;
+    }
+
+    /* An invalid image is left to MCUboot, which rejects it. */
+    if ((boot_image_validate(in->image, in->sec) != 0) ||
+        (boot_image_validate(ex->image, ex->sec) != 0))
+    {
+        return;
+    }
+
+    BOOT_LOG_INF("Images %d and %d upgrading concurrently", in->image, ex->image);
+    concurrent_run(in, ex);
+#endif
+}
+
+/******************************************************************************
+ * Function Name: upgrade_concurrent_get_stats
+ ******************************************************************************
+ * Summary:
+ *  Returns the concurrent upgrade counters since reset.
+ *
+ ******************************************************************************/
+const upgrade_concurrent_stats_t *upgrade_concurrent_get_stats(void)
+{
+    return &concurrent_stats;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,57 @@
+/******************************************************************************
+* File Name:   upgrade_concurrent.h
+*
+* Description:
+* This file declares the concurrent upgrade, which installs pending upgrades of
+* the internal flash image and the external flash image at the same time
+* before MCUboot runs.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef UPGRADE_CONCURRENT_H_
+#define UPGRADE_CONCURRENT_H_
+
+#include <stdint.h>
+
+/* Concurrent upgrade activity since reset. */
+typedef struct
+{
+    uint32_t installed;         /* Images copied, validated and cleared */
+    uint32_t failed;            /* Images left to MCUboot after an error */
+    uint32_t copied_bytes;      /* Bytes written to the primary slots */
+} upgrade_concurrent_stats_t;
+
+void upgrade_concurrent_apply(void);
+const upgrade_concurrent_stats_t *upgrade_concurrent_get_stats(void);
+
+#endif /* UPGRADE_CONCURRENT_H_ */
@@ -0,0 +1,598 @@
+/******************************************************************************
+* File Name:   upgrade_journal.c
+*
+* Description:
+* This file implements a progress journal for the overwrite-only upgrade.
+* MCUboot erases the whole primary slot and copies the secondary slot into
+* it; after a reset or power loss it starts over, so on unstable power a
+* large image may never finish. The journal records in the scratch area how
+* far the copy has got, at sector boundaries at least
+* CY_BOOT_UPGRADE_JOURNAL_STEP bytes apart. When the same upgrade runs again,
+* the erase of the recorded part is skipped once it is verified against the
+* secondary slot, and the writes of data the slot already holds are
+* dropped, so that at most one step or sector is programmed twice.
+*
+* Records are written to the scratch rows in turn, each with a sequence
+* number and a CRC, so that a power loss while writing one leaves the
+* previous record intact.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "flash_map_backend/flash_map_backend.h"
+#include "sysflash.h"
+#include "mcuboot_config/mcuboot_config.h"
+#include "bootutil/bootutil_log.h"
+
+#include "cy_pdl.h"
+#include "ext_flash_map.h"
+#include "upgrade_journal.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#ifndef CY_BOOT_UPGRADE_JOURNAL
+#if defined(MCUBOOT_OVERWRITE_ONLY) && defined(MCUBOOT_USE_FLASH_AREA_GET_SECTORS)
+/* Journal the copy of overwrite-only upgrades. Relies on the primary slot
+ * being erased and written only by that copy.
+ */
+#define CY_BOOT_UPGRADE_JOURNAL                 (1)
+#else
+#define CY_BOOT_UPGRADE_JOURNAL                 (0)
+#endif
+#endif
+
+#ifndef CY_BOOT_UPGRADE_JOURNAL_STEP
+/* Least progress between two records. Each record costs one row write of
+ * the scratch area; the copy redone after a power loss is at most one step
+ * or, where sectors are larger, one sector.
+ */
+#define CY_BOOT_UPGRADE_JOURNAL_STEP            (0x10000UL)
+#endif
+
+#define JOURNAL_MAGIC                           (0x4C4E524AUL)
+
+/* Part of the secondary slot that identifies the upgrade: the image header. */
+#define JOURNAL_IDENT_SIZE                      (32U)
+
+/* Chunk in which slot contents are compared. */
+#define JOURNAL_CMP_BUF_SIZE                    (256U)
+
+/* Primary slots tracked: one per image. */
+#define JOURNAL_SLOTS                           (2U)
+
+/* Row index meaning no record. */
+#define JOURNAL_NO_ROW                          (0xFFFFFFFFUL)
+
+/*******************************************************************************
+* Data types
+********************************************************************************/
+/* One progress record, stored at the start of a scratch row. */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t seq;                                   /* Incremented per record */
+    uint32_t fa_id;                                 /* Primary slot being written */
+    uint32_t done;                                  /* Bytes of it holding the copy */
+    uint32_t ident[JOURNAL_IDENT_SIZE / sizeof(uint32_t)];
+    uint32_t crc;                                   /* CRC-32 of the fields above */
+} journal_rec_t;
+
+/* Upgrade of one primary slot. The slots are tracked apart, so that the
+ * copies of both images can be interleaved (see upgrade_concurrent.c).
+ */
+typedef struct
+{
+    bool begun;                 /* Slot erased or written this boot */
+    journal_rec_t rec;          /* Latest record of the slot, magic 0 if none */
+    uint32_t row;               /* Scratch row holding it */
+    uint32_t ident[JOURNAL_IDENT_SIZE / sizeof(uint32_t)];
+    uint32_t kept;              /* Verified prefix of the slot left unerased */
+    uint32_t written;           /* Prefix of the slot written (or kept) this boot */
+} journal_slot_t;
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+#if (CY_BOOT_UPGRADE_JOURNAL != 0)
+static struct
+{
+    bool loaded;                /* Records read from the scratch area */
+    uint32_t seq;               /* Sequence number of the latest record */
+    uint32_t row;               /* Scratch row holding it */
+    journal_slot_t slot[JOURNAL_SLOTS];
+} journal;
+
+static uint32_t journal_row_buf[CY_FLASH_SIZEOF_ROW / sizeof(uint32_t)];
+#endif
+static upgrade_journal_stats_t journal_stats;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+#if (CY_BOOT_UPGRADE_JOURNAL != 0)
+static uint32_t journal_crc(const void *data, uint32_t len);
+static bool journal_rec_valid(const journal_rec_t *rec);
+static int journal_image(uint32_t fa_id);
+static void journal_load(void);
+static journal_slot_t *journal_begin(const struct flash_area *fa);
+static uint32_t journal_done(const journal_slot_t *slot);
+static bool journal_same(const struct flash_area *fa, uint32_t off, uint32_t len);
+static bool journal_row_used(uint32_t row);
+static void journal_record(journal_slot_t *slot, uint8_t fa_id, uint32_t done);
+#endif
+
+#if (CY_BOOT_UPGRADE_JOURNAL != 0)
+/******************************************************************************
+ * Function Name: journal_crc
+ ******************************************************************************
+ * Summary:
+ *  Returns the CRC-32 (IEEE 802.3) of `len` bytes at `data`.
+ *
+ ******************************************************************************/
+static uint32_t journal_crc(const void *data, uint32_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t crc = 0xFFFFFFFFUL;
+
+    while (len-- > 0U)
+    {
+        crc ^= *p++;
+        for (uint32_t bit = 0; bit < 8U; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0UL - (crc & 1UL)));
+        }
+    }
+    return ~crc;
+}
+
+/******************************************************************************
+ * Function Name: journal_rec_valid
+ ******************************************************************************
+ * Summary:
+ *  Returns true if `rec` is a complete record.
+ *
+ ******************************************************************************/
+static bool journal_rec_valid(const journal_rec_t *rec)
+{
+    return (rec->magic == JOURNAL_MAGIC) &&
+           (rec->crc == journal_crc(rec, offsetof(journal_rec_t, crc)));
+}
+
+/******************************************************************************
+ * Function Name: journal_image
+ ******************************************************************************
+ * Summary:
+ *  Returns the image whose primary slot is the area `fa_id`, -1 if it is
+ *  not a primary slot.
+ *
+ ******************************************************************************/
+static int journal_image(uint32_t fa_id)
+{
+    if (fa_id == FLASH_AREA_IMAGE_PRIMARY(0))
+    {
+        return 0;
+    }
+    if (fa_id == FLASH_AREA_IMAGE_PRIMARY(1))
+    {
+        return 1;
+    }
+    return -1;
+}
+
+/******************************************************************************
+ * Function Name: journal_load
+ ******************************************************************************
+ * Summary:
+ *  Finds the latest valid record in the scratch rows, and the latest one of
+ *  each primary slot, once per boot.
+ *
+ ******************************************************************************/
+static void journal_load(void)
+{
+    const struct flash_area *scratch;
+    journal_rec_t rec;
+
+    if (journal.loaded)
+    {
+        return;
+    }
+    journal.loaded = true;
+    journal.seq = 0U;
+    journal.row = JOURNAL_NO_ROW;
+    for (uint32_t i = 0; i < JOURNAL_SLOTS; i++)
+    {
+        journal.slot[i].rec.magic = 0U;
+        journal.slot[i].row = JOURNAL_NO_ROW;
+    }
+
+    if (flash_area_open(FLASH_AREA_IMAGE_SCRATCH, &scratch) != 0)
+    {
+        return;
+    }
+
+    for (uint32_t row = 0; row < (scratch->fa_size / CY_FLASH_SIZEOF_ROW); row++)
+    {
+        journal_slot_t *slot;
+        int image;
+
+        if ((flash_area_read(scratch, row * CY_FLASH_SIZEOF_ROW, &rec, sizeof(rec)) != 0) ||
+            !journal_rec_valid(&rec))
+        {
+            continue;
+        }
+
+        if ((journal.row == JOURNAL_NO_ROW) || ((int32_t)(rec.seq - journal.seq) > 0))
+        {
+            journal.seq = rec.seq;
+            journal.row = row;
+        }
+
+        image = journal_image(rec.fa_id);
+        if (image < 0)
+        {
+            continue;
+        }
+        slot = &journal.slot[image];
+        if ((slot->rec.magic == 0U) || ((int32_t)(rec.seq - slot->rec.seq) > 0))
+        {
+            slot->rec = rec;
+            slot->row = row;
+        }
+    }
+    flash_area_close(scratch);
+}
+
+/******************************************************************************
+ * Function Name: journal_begin
+ ******************************************************************************
+ * Summary:
+ *  Starts tracking the upgrade of the primary slot `fa` on its first erase
+ *  or write this boot: reads the image header of the matching secondary
+ *  slot, which tells the interrupted upgrade the journal describes apart
+ *  from a new one.
+ *
+ * Return:
+ *  The tracked slot, NULL if `fa` is not a primary slot.
+ *
+ ******************************************************************************/
+static journal_slot_t *journal_begin(const struct flash_area *fa)
+{
+    const struct flash_area *secondary;
+    journal_slot_t *slot;
+    int image = journal_image(fa->fa_id);
+    int rc;
+
+    if (image < 0)
+    {
+        return NULL;
+    }
+
+    slot = &journal.slot[image];
+    if (slot->begun)
+    {
+        return slot;
+    }
+
+    if (flash_area_open(FLASH_AREA_IMAGE_SECONDARY(image), &secondary) != 0)
+    {
+        return NULL;
+    }
+    rc = flash_area_read(secondary, 0U, slot->ident, sizeof(slot->ident));
+    flash_area_close(secondary);
+    if (rc != 0)
+    {
+        return NULL;
+    }
+
+    journal_load();
+    slot->begun = true;
+    slot->kept = 0U;
+    slot->written = 0U;
+    return slot;
+}
+
+/******************************************************************************
+ * Function Name: journal_done
+ ******************************************************************************
+ * Summary:
+ *  Returns how many bytes of the tracked slot its latest record says hold
+ *  the copy, 0 if the record describes another upgrade.
+ *
+ ******************************************************************************/
+static uint32_t journal_done(const journal_slot_t *slot)
+{
+    if ((slot->rec.magic == JOURNAL_MAGIC) &&
+        (memcmp(slot->rec.ident, slot->ident, sizeof(slot->ident)) == 0))
+    {
+        return slot->rec.done;
+    }
+    return 0U;
+}
+
+/******************************************************************************
+ * Function Name: journal_same
+ ******************************************************************************
+ * Summary:
+ *  Returns true if `len` bytes at `off` of the primary slot `fa` equal the
+ *  same range of its secondary slot. This guards against a record that
+ *  matches the image header but not the image, e.g. a rebuilt image with
+ *  the same version, and against images that are not copied verbatim.
+ *
+ ******************************************************************************/
+static bool journal_same(const struct flash_area *fa, uint32_t off, uint32_t len)
+{
+    const struct flash_area *secondary;
+    uint32_t a[JOURNAL_CMP_BUF_SIZE / sizeof(uint32_t)];
+    uint32_t b[JOURNAL_CMP_BUF_SIZE / sizeof(uint32_t)];
+    bool same;
+    int image = (fa->fa_id == FLASH_AREA_IMAGE_PRIMARY(0)) ? 0 : 1;
+
+    if (flash_area_open(FLASH_AREA_IMAGE_SECONDARY(image), &secondary) != 0)
+    {
+        return false;
+    }
+
+    same = true;
+    while ((len > 0U) && same)
+    {
+        uint32_t chunk = (len < sizeof(a)) ? len : sizeof(a);
+
+        same = (flash_area_read(fa, off, a, chunk) == 0) &&
+               (flash_area_read(secondary, off, b, chunk) == 0) &&
+               (memcmp(a, b, chunk) == 0);
+        off += chunk;
+        len -= chunk;
+    }
+    flash_area_close(secondary);
+    return same;
+}
+
+/******************************************************************************
+ * Function Name: journal_row_used
+ ******************************************************************************
+ * Summary:
+ *  Returns true if the scratch row `row` holds the latest record of a slot.
+ *
+ ******************************************************************************/
+static bool journal_row_used(uint32_t row)
+{
+    for (uint32_t i = 0; i < JOURNAL_SLOTS; i++)
+    {
+        if (journal.slot[i].row == row)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/******************************************************************************
+ * Function Name: journal_record
+ ******************************************************************************
+ * Summary:
+ *  Records that the first `done` bytes of the tracked slot `fa_id` hold the
+ *  copy. The record goes to the scratch row after the one holding the latest
+ *  record, skipping the latest record of each slot, once the slot writes
+ *  before it have completed.
+ *
+ ******************************************************************************/
+static void journal_record(journal_slot_t *slot, uint8_t fa_id, uint32_t done)
+{
+    const struct flash_area *scratch;
+    journal_rec_t *rec = (journal_rec_t *)journal_row_buf;
+    uint32_t rows;
+    uint32_t row;
+
+    if ((flash_area_sync() != 0) || (flash_area_open(FLASH_AREA_IMAGE_SCRATCH, &scratch) != 0))
+    {
+        return;
+    }
+
+    rows = scratch->fa_size / CY_FLASH_SIZEOF_ROW;
+    row = (journal.row == JOURNAL_NO_ROW) ? 0U : ((journal.row + 1U) % rows);
+    for (uint32_t i = 0; (i < rows) && journal_row_used(row); i++)
+    {
+        row = (row + 1U) % rows;
+    }
+
+    memset(journal_row_buf, flash_area_erased_val(scratch), sizeof(journal_row_buf));
+    rec->magic = JOURNAL_MAGIC;
+    rec->seq = journal.seq + 1U;
+    rec->fa_id = fa_id;
+    rec->done = done;
+    memcpy(rec->ident, slot->ident, sizeof(rec->ident));
+    rec->crc = journal_crc(rec, offsetof(journal_rec_t, crc));
+
+    if (flash_area_write(scratch, row * CY_FLASH_SIZEOF_ROW, journal_row_buf,
+                         CY_FLASH_SIZEOF_ROW) == 0)
+    {
+        slot->rec = *rec;
+        slot->row = row;
+        journal.seq = rec->seq;
+        journal.row = row;
+        journal_stats.records++;
+    }
+    flash_area_close(scratch);
+}
+#endif
+
+/******************************************************************************
+ * Function Name: upgrade_journal_kept
+ ******************************************************************************
+ * Summary:
+ *  Called by flash_area_erase(). Returns how many bytes at the start of
+ *  [off, off + len) of `fa` must not be erased because they already hold
+ *  the copy of the upgrade in progress, as recorded by an interrupted boot
+ *  and verified against the secondary slot.
+ *
+ ******************************************************************************/
+uint32_t upgrade_journal_kept(const struct flash_area *fa, uint32_t off, uint32_t len)
+{
+#if (CY_BOOT_UPGRADE_JOURNAL != 0)
+    journal_slot_t *slot = journal_begin(fa);
+    uint32_t done;
+    uint32_t keep;
+
+    if (slot == NULL)
+    {
+        return 0U;
+    }
+
+    done = journal_done(slot);
+    if ((off >= done) || (off > slot->kept))
+    {
+        return 0U;
+    }
+
+    keep = ((done - off) < len) ? (done - off) : len;
+    if (!journal_same(fa, off, keep))
+    {
+        return 0U;
+    }
+
+    if (off == 0U)
+    {
+        BOOT_LOG_INF("Resuming the copy to area %d at offset 0x%x",
+                     (int)fa->fa_id, (unsigned int)done);
+    }
+    slot->kept = off + keep;
+    journal_stats.kept_bytes += keep;
+    return keep;
+#else
+    (void)fa;
+    (void)off;
+    (void)len;
+    return 0U;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: upgrade_journal_holds
+ ******************************************************************************
+ * Summary:
+ *  Called by flash_area_write(). Returns true if [off, off + len) of `fa`
+ *  lies in the part kept from an interrupted upgrade and already holds
+ *  `src`, in which case the write is skipped and counts as progress.
+ *
+ ******************************************************************************/
+bool upgrade_journal_holds(const struct flash_area *fa, uint32_t off, const void *src, uint32_t len)
+{
+#if (CY_BOOT_UPGRADE_JOURNAL != 0)
+    const uint8_t *p = (const uint8_t *)src;
+    uint32_t buf[JOURNAL_CMP_BUF_SIZE / sizeof(uint32_t)];
+    uint32_t pos = 0;
+    int image = journal_image(fa->fa_id);
+    const journal_slot_t *slot = (image < 0) ? NULL : &journal.slot[image];
+
+    if ((slot == NULL) || !slot->begun || (off > slot->kept) || (len > (slot->kept - off)))
+    {
+        return false;
+    }
+
+    while (pos < len)
+    {
+        uint32_t chunk = ((len - pos) < sizeof(buf)) ? (len - pos) : sizeof(buf);
+
+        if ((flash_area_read(fa, off + pos, buf, chunk) != 0) ||
+            (memcmp(buf, &p[pos], chunk) != 0))
+        {
+            return false;
+        }
+        pos += chunk;
+    }
+
+    journal_stats.elided_bytes += len;
+    upgrade_journal_progress(fa, off, len);
+    return true;
+#else
+    (void)fa;
+    (void)off;
+    (void)src;
+    (void)len;
+    return false;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: upgrade_journal_progress
+ ******************************************************************************
+ * Summary:
+ *  Called after every successful flash_area_write(). While the writes of a
+ *  primary slot continue from its start, records the progress each time it
+ *  reaches a sector boundary at least CY_BOOT_UPGRADE_JOURNAL_STEP bytes past
+ *  the last record.
+ *
+ ******************************************************************************/
+void upgrade_journal_progress(const struct flash_area *fa, uint32_t off, uint32_t len)
+{
+#if (CY_BOOT_UPGRADE_JOURNAL != 0)
+    journal_slot_t *slot = journal_begin(fa);
+    uint32_t end = off + len;
+    uint32_t done;
+
+    if ((slot == NULL) || (off > slot->written) || (end <= slot->written))
+    {
+        return;
+    }
+    slot->written = end;
+
+    done = journal_done(slot);
+    if ((end >= (done + CY_BOOT_UPGRADE_JOURNAL_STEP)) && flash_area_is_sector_boundary(fa, end))
+    {
+        journal_record(slot, fa->fa_id, end);
+    }
+#else
+    (void)fa;
+    (void)off;
+    (void)len;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: upgrade_journal_get_stats
+ ******************************************************************************
+ * Summary:
+ *  Returns the journal counters since reset.
+ *
+ ******************************************************************************/
+const upgrade_journal_stats_t *upgrade_journal_get_stats(void)
+{
+    return &journal_stats;
+}
+
+/* [] END OF FILE */
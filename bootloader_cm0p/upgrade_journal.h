@@ -0,0 +1,63 @@
+/******************************************************************************
+* File Name:   upgrade_journal.h
+*
+* Description:
+* This file declares the progress journal of the overwrite-only upgrade. The
+* flash map reports every primary slot write to the journal, and asks it
+* which part of a primary slot erase already holds the copy an interrupted
+* upgrade made, so that the copy resumes instead of starting over.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef UPGRADE_JOURNAL_H_
+#define UPGRADE_JOURNAL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "flash_map_backend/flash_map_backend.h"
+
+/* Journal activity since reset. */
+typedef struct
+{
+    uint32_t records;           /* Progress records written */
+    uint32_t kept_bytes;        /* Primary slot bytes not erased on resume */
+    uint32_t elided_bytes;      /* Writes skipped because the slot held the data */
+} upgrade_journal_stats_t;
+
+uint32_t upgrade_journal_kept(const struct flash_area *fa, uint32_t off, uint32_t len);
+bool upgrade_journal_holds(const struct flash_area *fa, uint32_t off, const void *src, uint32_t len);
+void upgrade_journal_progress(const struct flash_area *fa, uint32_t off, uint32_t len);
+const upgrade_journal_stats_t *upgrade_journal_get_stats(void);
+
+#endif /* UPGRADE_JOURNAL_H_ */
@@ -0,0 +1,383 @@
+/******************************************************************************
+* File Name:   upgrade_lz4.c
+*
+* Description:
+* This file implements a streaming LZ4 block decoder for compressed upgrade
+* images. It reads the block from one flash area and writes the expanded
+* bytes to another, holding only the last CY_BOOT_LZ4_WINDOW bytes of output
+* in RAM. That window doubles as the write buffer. Matches that reach further
+* back are read again from the bytes already written, so the RAM use does not
+* depend on the 64 KB match distance of the format.
+*
+* The block format is the one of the LZ4 reference implementation: each
+* sequence is a token holding the literal length and the match length minus
+* four, the literals, a little-endian 16-bit match offset and the extra
+* length bytes of the match. The last sequence has literals only.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "flash_map_backend/flash_map_backend.h"
+
+#include "upgrade_lz4.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+/* Output kept in RAM; a multiple of LZ4_OUT_CHUNK, at least two of them. */
+#ifndef CY_BOOT_LZ4_WINDOW
+#define CY_BOOT_LZ4_WINDOW                      (4096U)
+#endif
+
+#define LZ4_IN_BUF_SIZE                         (256U)
+#define LZ4_FAR_BUF_SIZE                        (64U)
+
+/* Bytes per flash write. */
+#define LZ4_OUT_CHUNK                           (512U)
+
+#define LZ4_MIN_MATCH                           (4U)
+#define LZ4_RUN_MASK                            (15U)
+
+#if ((CY_BOOT_LZ4_WINDOW % LZ4_OUT_CHUNK) != 0U) || (CY_BOOT_LZ4_WINDOW < (2U * LZ4_OUT_CHUNK))
+#error "CY_BOOT_LZ4_WINDOW must be a multiple of 512, at least 1024"
+#endif
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+static struct
+{
+    const struct flash_area *src;
+    const struct flash_area *dst;
+    uint32_t in_off;                    /* Area offset of the next block bytes */
+    uint32_t in_end;
+    uint32_t in_pos;                    /* Next byte in lz4_in_buf */
+    uint32_t in_len;                    /* Bytes in lz4_in_buf */
+    uint32_t out;                       /* Bytes expanded */
+    uint32_t flushed;                   /* Bytes written to dst */
+    uint32_t size;
+} lz4;
+
+static uint8_t lz4_in_buf[LZ4_IN_BUF_SIZE];
+static uint8_t lz4_window[CY_BOOT_LZ4_WINDOW];
+static uint8_t lz4_far_buf[LZ4_FAR_BUF_SIZE];
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+static int lz4_in_fill(void);
+static int lz4_in(uint8_t *byte);
+static int lz4_length(uint32_t *len);
+static int lz4_flush(bool last);
+static int lz4_put(uint8_t byte);
+static int lz4_literals(uint32_t len);
+static int lz4_match(uint32_t offset, uint32_t len);
+
+/******************************************************************************
+ * Function Name: lz4_in_fill
+ ******************************************************************************
+ * Summary:
+ *  Reads the next part of the block into lz4_in_buf.
+ *
+ ******************************************************************************/
+static int lz4_in_fill(void)
+{
+    uint32_t chunk = lz4.in_end - lz4.in_off;
+
+    if (chunk == 0U)
+    {
+        return -1;
+    }
+    if (chunk > sizeof(lz4_in_buf))
+    {
+        chunk = sizeof(lz4_in_buf);
+    }
+    if (flash_area_read(lz4.src, lz4.in_off, lz4_in_buf, chunk) != 0)
+    {
+        return -1;
+    }
+    lz4.in_off += chunk;
+    lz4.in_pos = 0U;
+    lz4.in_len = chunk;
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: lz4_in
+ ******************************************************************************
+ * Summary:
+ *  Reads the next byte of the block.
+ *
+ ******************************************************************************/
+static int lz4_in(uint8_t *byte)
+{
+    if ((lz4.in_pos == lz4.in_len) && (lz4_in_fill() != 0))
+    {
+        return -1;
+    }
+    *byte = lz4_in_buf[lz4.in_pos];
+    lz4.in_pos++;
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: lz4_length
+ ******************************************************************************
+ * Summary:
+ *  Adds the extra length bytes that follow a 4-bit length of 15.
+ *
+ ******************************************************************************/
+static int lz4_length(uint32_t *len)
+{
+    uint8_t byte;
+
+    if (*len != LZ4_RUN_MASK)
+    {
+        return 0;
+    }
+    do
+    {
+        if ((lz4_in(&byte) != 0) || (*len > lz4.size))
+        {
+            return -1;
+        }
+        *len += byte;
+    } while (byte == 0xFFU);
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: lz4_flush
+ ******************************************************************************
+ * Summary:
+ *  Writes a full chunk of the window, or with `last` the rest of the output
+ *  padded with the erased value to the write alignment of the area.
+ *
+ ******************************************************************************/
+static int lz4_flush(bool last)
+{
+    uint32_t pos = lz4.flushed % CY_BOOT_LZ4_WINDOW;
+    uint32_t len = lz4.out - lz4.flushed;
+
+    if (last)
+    {
+        uint32_t align = flash_area_align(lz4.dst);
+
+        if ((align > 1U) && ((len % align) != 0U))
+        {
+            uint32_t pad = align - (len % align);
+
+            /* The window ends on a chunk and the write alignment is at most
+             * a chunk, so the padding fits after the unwritten bytes.
+             */
+            memset(&lz4_window[pos + len], flash_area_erased_val(lz4.dst), pad);
+            len += pad;
+        }
+    }
+    if (len == 0U)
+    {
+        return 0;
+    }
+    if (flash_area_write(lz4.dst, lz4.flushed, &lz4_window[pos], len) != 0)
+    {
+        return -1;
+    }
+    lz4.flushed += len;
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: lz4_put
+ ******************************************************************************
+ * Summary:
+ *  Appends one byte to the output.
+ *
+ ******************************************************************************/
+static int lz4_put(uint8_t byte)
+{
+    lz4_window[lz4.out % CY_BOOT_LZ4_WINDOW] = byte;
+    lz4.out++;
+    return ((lz4.out - lz4.flushed) == LZ4_OUT_CHUNK) ? lz4_flush(false) : 0;
+}
+
+/******************************************************************************
+ * Function Name: lz4_literals
+ ******************************************************************************
+ * Summary:
+ *  Copies `len` literal bytes from the block to the output.
+ *
+ ******************************************************************************/
+static int lz4_literals(uint32_t len)
+{
+    if (len > (lz4.size - lz4.out))
+    {
+        return -1;
+    }
+    while (len > 0U)
+    {
+        uint32_t chunk;
+
+        if ((lz4.in_pos == lz4.in_len) && (lz4_in_fill() != 0))
+        {
+            return -1;
+        }
+        chunk = lz4.in_len - lz4.in_pos;
+        if (chunk > len)
+        {
+            chunk = len;
+        }
+        len -= chunk;
+        while (chunk > 0U)
+        {
+            if (lz4_put(lz4_in_buf[lz4.in_pos]) != 0)
+            {
+                return -1;
+            }
+            lz4.in_pos++;
+            chunk--;
+        }
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: lz4_match
+ ******************************************************************************
+ * Summary:
+ *  Copies `len` bytes from `offset` bytes back in the output. Those still
+ *  in the window come from RAM, the others from the destination area.
+ *
+ ******************************************************************************/
+static int lz4_match(uint32_t offset, uint32_t len)
+{
+    if ((offset == 0U) || (offset > lz4.out) || (len > (lz4.size - lz4.out)))
+    {
+        return -1;
+    }
+
+    /* Fewer than a chunk of bytes are unwritten, so a match reaching past
+     * the window starts in written bytes and can be read back in pieces.
+     */
+    while ((len > 0U) && (offset > CY_BOOT_LZ4_WINDOW))
+    {
+        uint32_t chunk = (len < sizeof(lz4_far_buf)) ? len : sizeof(lz4_far_buf);
+
+        if (flash_area_read(lz4.dst, lz4.out - offset, lz4_far_buf, chunk) != 0)
+        {
+            return -1;
+        }
+        len -= chunk;
+        for (uint32_t i = 0; i < chunk; i++)
+        {
+            if (lz4_put(lz4_far_buf[i]) != 0)
+            {
+                return -1;
+            }
+        }
+    }
+
+    while (len > 0U)
+    {
+        if (lz4_put(lz4_window[(lz4.out - offset) % CY_BOOT_LZ4_WINDOW]) != 0)
+        {
+            return -1;
+        }
+        len--;
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: upgrade_lz4_expand
+ ******************************************************************************
+ * Summary:
+ *  Expands the LZ4 block of `len` bytes at `off` in `src` to the start of
+ *  `dst`, which must be erased.
+ *
+ * Return:
+ *  0 if the block expanded to exactly `size` bytes and they were written,
+ *  -1 if the block is malformed or a flash operation failed.
+ *
+ ******************************************************************************/
+int upgrade_lz4_expand(const struct flash_area *src, uint32_t off, uint32_t len,
+                       const struct flash_area *dst, uint32_t size)
+{
+    lz4.src = src;
+    lz4.dst = dst;
+    lz4.in_off = off;
+    lz4.in_end = off + len;
+    lz4.in_pos = 0U;
+    lz4.in_len = 0U;
+    lz4.out = 0U;
+    lz4.flushed = 0U;
+    lz4.size = size;
+
+    for (;;)
+    {
+        uint8_t token;
+        uint8_t lo;
+        uint8_t hi;
+        uint32_t literals;
+        uint32_t match;
+
+        if (lz4_in(&token) != 0)
+        {
+            return -1;
+        }
+        literals = (uint32_t)token >> 4;
+        if ((lz4_length(&literals) != 0) || (lz4_literals(literals) != 0))
+        {
+            return -1;
+        }
+
+        /* The last sequence ends with its literals. */
+        if ((lz4.in_pos == lz4.in_len) && (lz4.in_off == lz4.in_end))
+        {
+            break;
+        }
+
+        match = (uint32_t)token & LZ4_RUN_MASK;
+        if ((lz4_in(&lo) != 0) || (lz4_in(&hi) != 0) || (lz4_length(&match) != 0) ||
+            (lz4_match(((uint32_t)hi << 8) | lo, match + LZ4_MIN_MATCH) != 0))
+        {
+            return -1;
+        }
+    }
+
+    return ((lz4.out == size) && (lz4_flush(true) == 0)) ? 0 : -1;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,66 @@
+/******************************************************************************
+* File Name:   upgrade_lz4.h
+*
+* Description:
+* This file declares the streaming LZ4 decoder that expands a compressed
+* image payload from one flash area into another.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef UPGRADE_LZ4_H_
+#define UPGRADE_LZ4_H_
+
+#include <stdint.h>
+
+#include "flash_map_backend/flash_map_backend.h"
+
+#define UPGRADE_LZ4_MAGIC       (0x5A4C5943UL)  /* "CYLZ" */
+#define UPGRADE_LZ4_VERSION     (1U)
+
+/* Header at the start of the payload of a compressed image. The payload of
+ * the signed container image is this header followed by an LZ4 block that
+ * expands to the signed image to install.
+ */
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t hdr_size;          /* Offset of the LZ4 block in the payload */
+    uint32_t size;              /* Size of the expanded image */
+    uint32_t block_size;        /* Size of the LZ4 block */
+} upgrade_lz4_hdr_t;
+
+int upgrade_lz4_expand(const struct flash_area *src, uint32_t off, uint32_t len,
+                       const struct flash_area *dst, uint32_t size);
+
+#endif /* UPGRADE_LZ4_H_ */
@@ -0,0 +1,643 @@
+/******************************************************************************
+* File Name:   upgrade_patch.c
+*
+* Description:
+* This file implements the patch upgrade. Most releases change a small part
+* of the image, so the OTA agent may download a patch against the image in
+* the primary slot instead of the full signed image. The patch lands in the
+* secondary slot like an image would. Before MCUboot runs, the bootloader
+* moves the patch to the end of the slot, streams the new image into the
+* start of the slot from the patch and the primary slot, and compares its
+* SHA-256 with the one the patch names. MCUboot then validates the
+* signature of the rebuilt image and installs it as usual, so the patch
+* itself needs no signature.
+*
+* A patch is a header (patch_hdr_t) and a body of operations. Each starts
+* with a varint holding the length shifted left by one and, in bit 0,
+* whether it copies from the primary slot. A copy is followed by a signed
+* (zigzag) varint that moves the primary slot read position before the
+* copy; an insert is followed by the bytes to insert. The patches are made
+* by app_cm4/script/image_patch.py.
+*
+* The move leaves a copy of the header at the end of the area it uses, with
+* a state word that is programmed once the image is rebuilt. A reset while
+* rebuilding finds the state word erased and rebuilds again from the moved
+* patch, as the primary slot is not written until MCUboot installs the
+* image. The OTA agent erases the slot before it writes a new image, which
+* also erases that copy.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "flash_map_backend/flash_map_backend.h"
+#include "sysflash.h"
+#include "mcuboot_config/mcuboot_config.h"
+#include "bootutil/bootutil.h"
+#include "bootutil/image.h"
+#include "bootutil/bootutil_log.h"
+
+#include "ext_flash_map.h"
+#include "boot_crypto.h"
+#include "boot_validate.h"
+#include "upgrade_patch.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#ifndef CY_BOOT_UPGRADE_PATCH
+#if defined(MCUBOOT_OVERWRITE_ONLY) && defined(MCUBOOT_USE_FLASH_AREA_GET_SECTORS) && \
+    defined(CY_BOOT_USE_EXTERNAL_FLASH)
+#define CY_BOOT_UPGRADE_PATCH                   (1)
+#else
+#define CY_BOOT_UPGRADE_PATCH                   (0)
+#endif
+#endif
+
+#define PATCH_MAGIC                             (0x48435450UL)  /* "PTCH" */
+#define PATCH_VERSION                           (1U)
+#define PATCH_HASH_SIZE                         (32U)
+
+/* Size reserved for patch_tail_t in front of the last sector of the slot. */
+#define PATCH_TAIL_SIZE                         (128U)
+
+#define PATCH_STATE_DONE                        (0x454E4F44UL)  /* "DONE" */
+#define PATCH_STATE_FAILED                      (0x4C494146UL)  /* "FAIL" */
+
+/* Longest varint of a 32-bit value. */
+#define PATCH_VARINT_MAX                        (5U)
+
+#define PATCH_IN_BUF_SIZE                       (256U)
+#define PATCH_OUT_BUF_SIZE                      (512U)
+
+/*******************************************************************************
+* Data types
+********************************************************************************/
+/* Patch header, at the start of the patch. */
+typedef struct
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t hdr_size;                  /* Offset of the body in the patch */
+    uint32_t body_size;
+    uint32_t src_size;                  /* Primary slot bytes the body may copy */
+    uint32_t dst_size;                  /* Size of the image it rebuilds */
+    uint32_t reserved;
+    uint8_t src_hash[PATCH_HASH_SIZE];  /* SHA-256 TLV of the primary slot image */
+    uint8_t dst_hash[PATCH_HASH_SIZE];  /* SHA-256 of the rebuilt dst_size bytes */
+} patch_hdr_t;
+
+/* Header copy that the move leaves in front of the last sector. */
+typedef struct
+{
+    patch_hdr_t hdr;
+    uint32_t state;                     /* Erased while rebuilding */
+} patch_tail_t;
+
+/* Where the move puts the patch in the secondary slot. */
+typedef struct
+{
+    uint32_t tail_off;                  /* patch_tail_t */
+    uint32_t body_off;                  /* Body, ending at tail_off */
+    uint32_t area_off;                  /* Start of the sectors the two use */
+    uint32_t area_end;                  /* Start of the last sector */
+    uint32_t dst_end;                   /* End of the sectors the image uses */
+} patch_layout_t;
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+#if (CY_BOOT_UPGRADE_PATCH != 0)
+static struct
+{
+    const struct flash_area *src;       /* Primary slot */
+    const struct flash_area *dst;       /* Secondary slot */
+    uint32_t in_off;                    /* Slot offset of the next body bytes */
+    uint32_t in_end;
+    uint32_t in_pos;                    /* Next byte in patch_in_buf */
+    uint32_t in_len;                    /* Bytes in patch_in_buf */
+    uint32_t out_off;                   /* Image bytes written */
+    uint32_t out_len;                   /* Bytes in patch_out_buf */
+    boot_sha256_context sha;
+} patch;
+
+static uint8_t patch_in_buf[PATCH_IN_BUF_SIZE];
+static uint8_t patch_out_buf[PATCH_OUT_BUF_SIZE];
+#endif
+static upgrade_patch_stats_t patch_stats;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+#if (CY_BOOT_UPGRADE_PATCH != 0)
+static bool patch_hdr_valid(const patch_hdr_t *hdr, const struct flash_area *fa);
+static int patch_tail_off(const struct flash_area *fa, uint32_t *tail_off);
+static int patch_layout(const struct flash_area *fa, const patch_hdr_t *hdr,
+                        patch_layout_t *layout);
+static int patch_move(const patch_hdr_t *hdr, const patch_layout_t *layout);
+static int patch_in(void *dst, uint32_t len);
+static int patch_varint(uint32_t *value);
+static int patch_flush(void);
+static int patch_rebuild(const patch_hdr_t *hdr, const patch_layout_t *layout);
+static void patch_set_state(const patch_layout_t *layout, uint32_t state);
+static void patch_apply_image(int image);
+#endif
+
+#if (CY_BOOT_UPGRADE_PATCH != 0)
+/******************************************************************************
+ * Function Name: patch_hdr_valid
+ ******************************************************************************
+ * Summary:
+ *  Returns true if `hdr` is a patch header whose sizes fit the secondary
+ *  slot `fa`.
+ *
+ ******************************************************************************/
+static bool patch_hdr_valid(const patch_hdr_t *hdr, const struct flash_area *fa)
+{
+    return (hdr->magic == PATCH_MAGIC) && (hdr->version == PATCH_VERSION) &&
+           (hdr->hdr_size >= sizeof(patch_hdr_t)) &&
+           (hdr->body_size < fa->fa_size) && (hdr->src_size < fa->fa_size) &&
+           (hdr->dst_size != 0U) && (hdr->dst_size < fa->fa_size);
+}
+
+/******************************************************************************
+ * Function Name: patch_tail_off
+ ******************************************************************************
+ * Summary:
+ *  Finds the place of the patch_tail_t of a moved patch: in front of the
+ *  last sector of the secondary slot `fa`, which holds the MCUboot trailer.
+ *
+ ******************************************************************************/
+static int patch_tail_off(const struct flash_area *fa, uint32_t *tail_off)
+{
+    uint32_t start;
+    uint32_t size;
+
+    if ((flash_area_sector_of(fa, fa->fa_size - 1U, &start, &size) != 0) ||
+        (start < PATCH_TAIL_SIZE))
+    {
+        return -1;
+    }
+    *tail_off = start - PATCH_TAIL_SIZE;
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: patch_layout
+ ******************************************************************************
+ * Summary:
+ *  Places the moved patch body in front of its patch_tail_t, and checks
+ *  that the sectors the two use overlap neither the patch where it was
+ *  written nor the image it rebuilds.
+ *
+ * Return:
+ *  0 on success, -1 if the image and the patch do not both fit.
+ *
+ ******************************************************************************/
+static int patch_layout(const struct flash_area *fa, const patch_hdr_t *hdr,
+                        patch_layout_t *layout)
+{
+    uint32_t start;
+    uint32_t size;
+
+    if ((patch_tail_off(fa, &layout->tail_off) != 0) ||
+        (layout->tail_off < hdr->body_size))
+    {
+        return -1;
+    }
+    layout->area_end = layout->tail_off + PATCH_TAIL_SIZE;
+    layout->body_off = layout->tail_off - hdr->body_size;
+
+    if (flash_area_sector_of(fa, layout->body_off, &start, &size) != 0)
+    {
+        return -1;
+    }
+    layout->area_off = start;
+
+    /* The sectors are erased before the body is moved into them. */
+    if (((uint32_t)hdr->hdr_size + hdr->body_size) > layout->area_off)
+    {
+        return -1;
+    }
+
+    if (flash_area_sector_of(fa, hdr->dst_size - 1U, &start, &size) != 0)
+    {
+        return -1;
+    }
+    layout->dst_end = start + size;
+
+    return (layout->dst_end <= layout->area_off) ? 0 : -1;
+}
+
+/******************************************************************************
+ * Function Name: patch_move
+ ******************************************************************************
+ * Summary:
+ *  Copies the patch from the start of the secondary slot to the place
+ *  chosen by patch_layout(), the header last.
+ *
+ ******************************************************************************/
+static int patch_move(const patch_hdr_t *hdr, const patch_layout_t *layout)
+{
+    uint32_t off = 0;
+
+    if (flash_area_erase(patch.dst, layout->area_off,
+                         layout->area_end - layout->area_off) != 0)
+    {
+        return -1;
+    }
+
+    while (off < hdr->body_size)
+    {
+        uint32_t chunk = hdr->body_size - off;
+
+        if (chunk > sizeof(patch_in_buf))
+        {
+            chunk = sizeof(patch_in_buf);
+        }
+        if ((flash_area_read(patch.dst, hdr->hdr_size + off, patch_in_buf, chunk) != 0) ||
+            (flash_area_write(patch.dst, layout->body_off + off, patch_in_buf, chunk) != 0))
+        {
+            return -1;
+        }
+        off += chunk;
+    }
+
+    return flash_area_write(patch.dst, layout->tail_off, hdr, sizeof(*hdr));
+}
+
+/******************************************************************************
+ * Function Name: patch_in
+ ******************************************************************************
+ * Summary:
+ *  Reads the next `len` bytes of the patch body.
+ *
+ ******************************************************************************/
+static int patch_in(void *dst, uint32_t len)
+{
+    uint8_t *p = (uint8_t *)dst;
+
+    while (len > 0U)
+    {
+        uint32_t chunk;
+
+        if (patch.in_pos == patch.in_len)
+        {
+            chunk = patch.in_end - patch.in_off;
+            if (chunk == 0U)
+            {
+                return -1;
+            }
+            if (chunk > sizeof(patch_in_buf))
+            {
+                chunk = sizeof(patch_in_buf);
+            }
+            if (flash_area_read(patch.dst, patch.in_off, patch_in_buf, chunk) != 0)
+            {
+                return -1;
+            }
+            patch.in_off += chunk;
+            patch.in_pos = 0U;
+            patch.in_len = chunk;
+        }
+
+        chunk = patch.in_len - patch.in_pos;
+        if (chunk > len)
+        {
+            chunk = len;
+        }
+        memcpy(p, &patch_in_buf[patch.in_pos], chunk);
+        patch.in_pos += chunk;
+        p += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: patch_varint
+ ******************************************************************************
+ * Summary:
+ *  Reads an unsigned LEB128 varint of at most 32 bits from the patch body.
+ *  A value that does not fit in 32 bits is an error.
+ *
+ ******************************************************************************/
+static int patch_varint(uint32_t *value)
+{
+    uint8_t byte = 0x80U;
+
+    *value = 0U;
+    for (uint32_t i = 0; (i < PATCH_VARINT_MAX) && ((byte & 0x80U) != 0U); i++)
+    {
+        if (patch_in(&byte, 1U) != 0)
+        {
+            return -1;
+        }
+        /* The last byte holds bits 28 to 31 only. */
+        if ((i == (PATCH_VARINT_MAX - 1U)) && ((byte & 0x70U) != 0U))
+        {
+            return -1;
+        }
+        *value |= (uint32_t)(byte & 0x7FU) << (7U * i);
+    }
+    return ((byte & 0x80U) == 0U) ? 0 : -1;
+}
+
+/******************************************************************************
+ * Function Name: patch_flush
+ ******************************************************************************
+ * Summary:
+ *  Hashes and writes the buffered image bytes.
+ *
+ ******************************************************************************/
+static int patch_flush(void)
+{
+    if (patch.out_len == 0U)
+    {
+        return 0;
+    }
+    if ((boot_sha256_update(&patch.sha, patch_out_buf, patch.out_len) != 0) ||
+        (flash_area_write(patch.dst, patch.out_off, patch_out_buf, patch.out_len) != 0))
+    {
+        return -1;
+    }
+    patch.out_off += patch.out_len;
+    patch.out_len = 0U;
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: patch_rebuild
+ ******************************************************************************
+ * Summary:
+ *  Erases the start of the secondary slot and writes the image the moved
+ *  patch describes there.
+ *
+ * Return:
+ *  0 if the image was written and matches the hash of the patch.
+ *
+ ******************************************************************************/
+static int patch_rebuild(const patch_hdr_t *hdr, const patch_layout_t *layout)
+{
+    uint8_t hash[PATCH_HASH_SIZE];
+    uint32_t src_pos = 0;
+    uint32_t end = 0;
+    int rc;
+
+    if (flash_area_erase(patch.dst, 0U, layout->dst_end) != 0)
+    {
+        return -1;
+    }
+
+    patch.in_off = layout->body_off;
+    patch.in_end = layout->tail_off;
+    patch.in_pos = 0U;
+    patch.in_len = 0U;
+    patch.out_off = 0U;
+    patch.out_len = 0U;
+    rc = boot_sha256_start(&patch.sha);
+
+    while ((rc == 0) && (end < hdr->dst_size))
+    {
+        uint32_t op;
+        uint32_t len;
+        bool copy;
+
+        rc = patch_varint(&op);
+        len = op >> 1;
+        copy = ((op & 1U) != 0U);
+        if ((rc != 0) || (len > (hdr->dst_size - end)))
+        {
+            rc = -1;
+            break;
+        }
+
+        if (copy)
+        {
+            uint32_t delta;
+
+            /* Zigzag: bit 0 holds the sign. */
+            rc = patch_varint(&delta);
+            src_pos += ((delta & 1U) != 0U) ? ~(delta >> 1) : (delta >> 1);
+            if ((rc != 0) || (src_pos > hdr->src_size) || (len > (hdr->src_size - src_pos)))
+            {
+                rc = -1;
+                break;
+            }
+            patch_stats.copied_bytes += len;
+        }
+        else
+        {
+            patch_stats.inserted_bytes += len;
+        }
+        end += len;
+
+        while ((rc == 0) && (len > 0U))
+        {
+            uint32_t chunk = sizeof(patch_out_buf) - patch.out_len;
+
+            if (chunk > len)
+            {
+                chunk = len;
+            }
+            if (copy)
+            {
+                rc = flash_area_read(patch.src, src_pos, &patch_out_buf[patch.out_len], chunk);
+                src_pos += chunk;
+            }
+            else
+            {
+                rc = patch_in(&patch_out_buf[patch.out_len], chunk);
+            }
+            patch.out_len += chunk;
+            len -= chunk;
+
+            if ((rc == 0) && (patch.out_len == sizeof(patch_out_buf)))
+            {
+                rc = patch_flush();
+            }
+        }
+    }
+
+    if (rc == 0)
+    {
+        rc = patch_flush();
+    }
+    if (rc == 0)
+    {
+        rc = boot_sha256_finish(&patch.sha, hash);
+    }
+    boot_sha256_free(&patch.sha);
+
+    if ((rc == 0) && (memcmp(hash, hdr->dst_hash, sizeof(hash)) != 0))
+    {
+        rc = -1;
+    }
+    return rc;
+}
+
+/******************************************************************************
+ * Function Name: patch_set_state
+ ******************************************************************************
+ * Summary:
+ *  Programs the state word of the moved patch, so that later boots leave
+ *  the secondary slot to MCUboot.
+ *
+ ******************************************************************************/
+static void patch_set_state(const patch_layout_t *layout, uint32_t state)
+{
+    (void)flash_area_write(patch.dst, layout->tail_off + offsetof(patch_tail_t, state),
+                           &state, sizeof(state));
+}
+
+/******************************************************************************
+ * Function Name: patch_apply_image
+ ******************************************************************************
+ * Summary:
+ *  Rebuilds the image of a pending patch in the secondary slot of `image`,
+ *  or finishes the rebuild a reset interrupted.
+ *
+ ******************************************************************************/
+static void patch_apply_image(int image)
+{
+    patch_tail_t tail;
+    patch_layout_t layout;
+    struct image_header src_hdr;
+    uint8_t hash[PATCH_HASH_SIZE];
+    uint32_t src_size;
+    uint32_t tail_off;
+    uint32_t erased;
+    bool move = true;
+    int swap_type = boot_swap_type_multi(image);
+
+    if (((swap_type != BOOT_SWAP_TYPE_TEST) && (swap_type != BOOT_SWAP_TYPE_PERM)) ||
+        (flash_area_open(FLASH_AREA_IMAGE_PRIMARY(image), &patch.src) != 0) ||
+        (flash_area_open(FLASH_AREA_IMAGE_SECONDARY(image), &patch.dst) != 0))
+    {
+        return;
+    }
+
+    memset(&erased, flash_area_erased_val(patch.dst), sizeof(erased));
+
+    /* A new patch at the start of the slot, or one already moved whose
+     * rebuild has not finished.
+     */
+    if ((flash_area_read(patch.dst, 0U, &tail.hdr, sizeof(tail.hdr)) == 0) &&
+        patch_hdr_valid(&tail.hdr, patch.dst))
+    {
+        if (patch_layout(patch.dst, &tail.hdr, &layout) != 0)
+        {
+            BOOT_LOG_ERR("Image %d patch does not fit the secondary slot", image);
+            patch_stats.failed++;
+            return;
+        }
+    }
+    else if ((patch_tail_off(patch.dst, &tail_off) != 0) ||
+             (flash_area_read(patch.dst, tail_off, &tail, sizeof(tail)) != 0) ||
+             !patch_hdr_valid(&tail.hdr, patch.dst) || (tail.state != erased) ||
+             (patch_layout(patch.dst, &tail.hdr, &layout) != 0))
+    {
+        return;
+    }
+    else
+    {
+        BOOT_LOG_INF("Image %d resuming the interrupted patch", image);
+        move = false;
+    }
+
+    if ((boot_image_tlv(patch.src, &src_hdr, &src_size, IMAGE_TLV_SHA256, hash,
+                        sizeof(hash)) != 0) ||
+        (memcmp(hash, tail.hdr.src_hash, sizeof(hash)) != 0))
+    {
+        BOOT_LOG_ERR("Image %d patch does not apply to the primary slot image", image);
+        patch_stats.failed++;
+        return;
+    }
+
+    BOOT_LOG_INF("Image %d rebuilding %u bytes from a %u byte patch", image,
+                 (unsigned int)tail.hdr.dst_size, (unsigned int)tail.hdr.body_size);
+    patch_stats.patch_bytes += tail.hdr.hdr_size + tail.hdr.body_size;
+
+    if (move && (patch_move(&tail.hdr, &layout) != 0))
+    {
+        BOOT_LOG_ERR("Image %d patch could not be moved", image);
+        patch_stats.failed++;
+    }
+    else if (patch_rebuild(&tail.hdr, &layout) != 0)
+    {
+        BOOT_LOG_ERR("Image %d patch result does not match its hash", image);
+        patch_set_state(&layout, PATCH_STATE_FAILED);
+        patch_stats.failed++;
+    }
+    else
+    {
+        patch_set_state(&layout, PATCH_STATE_DONE);
+        patch_stats.applied++;
+    }
+}
+#endif
+
+/******************************************************************************
+ * Function Name: upgrade_patch_apply
+ ******************************************************************************
+ * Summary:
+ *  Called before boot_go(). Replaces each pending patch in a secondary slot
+ *  with the image it describes, for MCUboot to validate and install.
+ *
+ ******************************************************************************/
+void upgrade_patch_apply(void)
+{
+#if (CY_BOOT_UPGRADE_PATCH != 0)
+    for (int image = 0; image < MCUBOOT_IMAGE_NUMBER; image++)
+    {
+        patch_apply_image(image);
+    }
+#endif
+}
+
+/******************************************************************************
+ * Function Name: upgrade_patch_get_stats
+ ******************************************************************************
+ * Summary:
+ *  Returns the patch counters since reset.
+ *
+ ******************************************************************************/
+const upgrade_patch_stats_t *upgrade_patch_get_stats(void)
+{
+    return &patch_stats;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,60 @@
+/******************************************************************************
+* File Name:   upgrade_patch.h
+*
+* Description:
+* This file declares the patch upgrade. A secondary slot may hold a patch
+* instead of a signed image; before MCUboot runs, the bootloader rebuilds the
+* new image from the patch and the primary slot image into the secondary slot,
+* where MCUboot validates and installs it like a full image.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef UPGRADE_PATCH_H_
+#define UPGRADE_PATCH_H_
+
+#include <stdint.h>
+
+/* Patch activity since reset. */
+typedef struct
+{
+    uint32_t applied;           /* Images rebuilt from a patch */
+    uint32_t failed;            /* Patches rejected or not matching their hash */
+    uint32_t patch_bytes;       /* Size of the patches read */
+    uint32_t copied_bytes;      /* Image bytes taken from the primary slot */
+    uint32_t inserted_bytes;    /* Image bytes taken from the patch */
+} upgrade_patch_stats_t;
+
+void upgrade_patch_apply(void);
+const upgrade_patch_stats_t *upgrade_patch_get_stats(void);
+
+#endif /* UPGRADE_PATCH_H_ */
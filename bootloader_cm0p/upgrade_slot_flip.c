@@ -0,0 +1,222 @@
+/******************************************************************************
+* File Name:   upgrade_slot_flip.c
+*
+* Description:
+* This file implements the slot flip of the Wi-Fi firmware (image 2). Both
+* image 2 slots are on the external memory, which the CM4 application reads
+* the firmware from through XIP, so an upgrade does not have to be copied:
+* the bootloader picks the newest valid image of the two slots and passes its
+* address to the application (boot_handoff.c). MCUboot is built for image 1
+* only in this mode; the application writes upgrades to the other slot.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "flash_map_backend/flash_map_backend.h"
+#include "sysflash.h"
+#include "mcuboot_config/mcuboot_config.h"
+#include "bootutil/bootutil.h"
+#include "bootutil/image.h"
+#include "bootutil/bootutil_log.h"
+
+#include "boot_handoff.h"
+#include "boot_timing.h"
+#include "boot_validate.h"
+#include "upgrade_lz4.h"
+#include "upgrade_slot_flip.h"
+
+/*******************************************************************************
+* Macros
+********************************************************************************/
+#if defined(CY_BOOT_WIFI_SLOT_FLIP) && (MCUBOOT_IMAGE_NUMBER != 1)
+#error "CY_BOOT_WIFI_SLOT_FLIP requires MCUBOOT_IMAGE_NUMBER=1"
+#endif
+
+/* primary_2 and secondary_2. */
+#define SLOT_FLIP_SLOTS                         (2U)
+
+/*******************************************************************************
+* Global variables
+********************************************************************************/
+#if defined(CY_BOOT_WIFI_SLOT_FLIP)
+static const uint8_t slot_flip_ids[SLOT_FLIP_SLOTS] = { FLASH_AREA_IMAGE_2, FLASH_AREA_IMAGE_3 };
+#endif
+static upgrade_slot_flip_stats_t slot_flip_stats;
+
+/*******************************************************************************
+* Function Prototypes
+********************************************************************************/
+#if defined(CY_BOOT_WIFI_SLOT_FLIP)
+static int slot_flip_compare(const struct image_version *a, const struct image_version *b);
+static bool slot_flip_valid(const struct flash_area *fa, struct image_header *hdr);
+#endif
+
+#if defined(CY_BOOT_WIFI_SLOT_FLIP)
+/******************************************************************************
+ * Function Name: slot_flip_compare
+ ******************************************************************************
+ * Summary:
+ *  Compares two image versions field by field, build number last.
+ *
+ * Return:
+ *  Less than, equal to or greater than 0 if `a` is older than, the same as
+ *  or newer than `b`.
+ *
+ ******************************************************************************/
+static int slot_flip_compare(const struct image_version *a, const struct image_version *b)
+{
+    if (a->iv_major != b->iv_major)
+    {
+        return (a->iv_major > b->iv_major) ? 1 : -1;
+    }
+    if (a->iv_minor != b->iv_minor)
+    {
+        return (a->iv_minor > b->iv_minor) ? 1 : -1;
+    }
+    if (a->iv_revision != b->iv_revision)
+    {
+        return (a->iv_revision > b->iv_revision) ? 1 : -1;
+    }
+    if (a->iv_build_num != b->iv_build_num)
+    {
+        return (a->iv_build_num > b->iv_build_num) ? 1 : -1;
+    }
+    return 0;
+}
+
+/******************************************************************************
+ * Function Name: slot_flip_valid
+ ******************************************************************************
+ * Summary:
+ *  Checks that the image in `fa` is not compressed, and its hash and
+ *  signature against the validation record of the slot (boot_validate.c),
+ *  so that it is hashed in full only once. `hdr` holds the header already
+ *  read from the slot.
+ *
+ ******************************************************************************/
+static bool slot_flip_valid(const struct flash_area *fa, struct image_header *hdr)
+{
+    uint32_t magic;
+
+    /* A compressed image validates, but is not firmware the Wi-Fi chip can
+     * load in place.
+     */
+    if ((flash_area_read(fa, hdr->ih_hdr_size, &magic, sizeof(magic)) != 0) ||
+        (magic == UPGRADE_LZ4_MAGIC))
+    {
+        return false;
+    }
+    return boot_validate_image(0, fa) == 0;
+}
+#endif
+
+/******************************************************************************
+ * Function Name: upgrade_slot_flip_select
+ ******************************************************************************
+ * Summary:
+ *  Called after boot_go(). Picks the image 2 slot holding the newest image
+ *  that validates, falling back to the older image if the newer one does
+ *  not, and records the slot address for the CM4 application. Nothing is
+ *  written to the slots, so an interrupted boot repeats the same choice.
+ *
+ * Return:
+ *  0 if a slot was chosen or slot flip is not enabled, -1 if neither slot
+ *  holds a valid image.
+ *
+ ******************************************************************************/
+int upgrade_slot_flip_select(void)
+{
+#if defined(CY_BOOT_WIFI_SLOT_FLIP)
+    const struct flash_area *fa[SLOT_FLIP_SLOTS];
+    struct image_header hdr[SLOT_FLIP_SLOTS];
+    bool present[SLOT_FLIP_SLOTS];
+    uint32_t first = 0U;
+    uint32_t start = boot_timing_now();
+
+    for (uint32_t i = 0U; i < SLOT_FLIP_SLOTS; i++)
+    {
+        present[i] = (flash_area_open(slot_flip_ids[i], &fa[i]) == 0) &&
+                     (flash_area_read(fa[i], 0U, &hdr[i], sizeof(hdr[i])) == 0) &&
+                     (hdr[i].ih_magic == IMAGE_MAGIC);
+    }
+    boot_timing_add(BOOT_PHASE_HEADER, boot_timing_image(FLASH_AREA_IMAGE_2), start);
+
+    /* Try the newer image first; primary_2 wins a tie. */
+    if (present[1] && (!present[0] || (slot_flip_compare(&hdr[1].ih_ver, &hdr[0].ih_ver) > 0)))
+    {
+        first = 1U;
+    }
+
+    for (uint32_t n = 0U; n < SLOT_FLIP_SLOTS; n++)
+    {
+        uint32_t i = (first + n) % SLOT_FLIP_SLOTS;
+
+        if (!present[i])
+        {
+            continue;
+        }
+        if (!slot_flip_valid(fa[i], &hdr[i]))
+        {
+            BOOT_LOG_ERR("Image 2 in slot at 0x%08x is not valid", (unsigned int)fa[i]->fa_off);
+            slot_flip_stats.rejected++;
+            continue;
+        }
+
+        slot_flip_stats.slot_addr = fa[i]->fa_off;
+        slot_flip_stats.ver = hdr[i].ih_ver;
+        boot_handoff.wifi_slot_addr = fa[i]->fa_off;
+        return 0;
+    }
+
+    BOOT_LOG_ERR("Image 2: no valid image in either slot");
+    return -1;
+#else
+    return 0;
+#endif
+}
+
+/******************************************************************************
+ * Function Name: upgrade_slot_flip_get_stats
+ ******************************************************************************
+ * Summary:
+ *  Returns the image 2 slot choice of this boot.
+ *
+ ******************************************************************************/
+const upgrade_slot_flip_stats_t *upgrade_slot_flip_get_stats(void)
+{
+    return &slot_flip_stats;
+}
+
+/* [] END OF FILE */
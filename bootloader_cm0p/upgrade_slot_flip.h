@@ -0,0 +1,59 @@
+/******************************************************************************
+* File Name:   upgrade_slot_flip.h
+*
+* Description:
+* This file declares the slot flip of the Wi-Fi firmware (image 2), which runs
+* the newest valid image in either external slot instead of copying upgrades
+* into primary_2.
+*
+*******************************************************************************
+* (c) 2021, Cypress Semiconductor Corporation. All rights reserved.
+*******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software"), is owned by Cypress Semiconductor Corporation or one of its
+* subsidiaries ("Cypress") and is protected by and subject to worldwide patent
+* protection (United States and foreign), United States copyright laws and
+* international treaty provisions. Therefore, you may use this Software only
+* as provided in the license agreement accompanying the software package from
+* which you obtained this Software ("EULA").
+*
+* If no EULA applies, Cypress hereby grants you a personal, non-exclusive,
+* non-transferable license to copy, modify, and compile the Software source
+* code solely for use in connection with Cypress's integrated circuit products.
+* Any reproduction, modification, translation, compilation, or representation
+* of this Software except as specified above is prohibited without the express
+* written permission of Cypress.
+*
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND,
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE. Cypress
+* reserves the right to make changes to the Software without notice. Cypress
+* does not assume any liability arising out of the application or use of the
+* Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use in any products where a malfunction or
+* failure of the Cypress product may reasonably be expected to result in
+* significant property damage, injury or death ("High Risk Product"). By
+* including Cypress's product in a High Risk Product, the manufacturer of such
+* system or application assumes all risk of such use and in doing so agrees to
+* indemnify Cypress against all liability.
+*******************************************************************************/
+
+#ifndef UPGRADE_SLOT_FLIP_H_
+#define UPGRADE_SLOT_FLIP_H_
+
+#include <stdint.h>
+
+#include "bootutil/image.h"
+
+/* Outcome of the image 2 slot choice of this boot. */
+typedef struct
+{
+    uint32_t slot_addr;         /* XIP address of the chosen slot, 0 if none */
+    struct image_version ver;   /* Version of the chosen image */
+    uint32_t rejected;          /* Slots with an image that failed validation */
+} upgrade_slot_flip_stats_t;
+
+int upgrade_slot_flip_select(void);
+const upgrade_slot_flip_stats_t *upgrade_slot_flip_get_stats(void);
+
+#endif /* UPGRADE_SLOT_FLIP_H_ */